@@ -0,0 +1,288 @@
+#define _GNU_SOURCE
+#include "admission.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *level_names[TASK_PRIORITY_LEVELS] = { "LOW", "NORMAL", "HIGH", "CRITICAL" };
+
+// Shard the calling producer counts into, assigned round-robin on first use
+static _Atomic unsigned next_shard = 0;
+static _Thread_local int producer_shard = -1;
+
+static void count_verdict(admission_controller_t *ctrl, int level, admission_verdict_t verdict) {
+    if (producer_shard < 0) {
+        producer_shard = (int)(atomic_fetch_add_explicit(&next_shard, 1, memory_order_relaxed) %
+                               ADMISSION_COUNTER_SHARDS);
+    }
+    atomic_fetch_add_explicit(&ctrl->shards[producer_shard].counts[verdict][level], 1,
+                              memory_order_relaxed);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(ns / 1000000000ULL),
+        .tv_nsec = (long)(ns % 1000000000ULL)
+    };
+    nanosleep(&ts, NULL);
+}
+
+void admission_config_init(admission_config_t *config) {
+    if (!config) return;
+    
+    static const double queue_share[TASK_PRIORITY_LEVELS] = { 0.75, 0.85, 0.95, 1.0 };
+    static const double cpu_shed[TASK_PRIORITY_LEVELS] = { 90.0, 98.0, 0.0, 0.0 };
+    static const double memory_shed[TASK_PRIORITY_LEVELS] = { 85.0, 90.0, 95.0, 0.0 };
+    
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        config->rate[level] = 0.0;
+        config->burst[level] = 8.0;
+        config->queue_share[level] = queue_share[level];
+        config->cpu_shed[level] = cpu_shed[level];
+        config->memory_shed[level] = memory_shed[level];
+    }
+}
+
+admission_controller_t* admission_controller_create(const admission_config_t *config,
+                                                    task_queue_t *queue,
+                                                    resource_monitor_t *monitor) {
+    if (!config || !queue) return NULL;
+    
+    admission_controller_t *ctrl = (admission_controller_t*)aligned_alloc(
+        CACHE_LINE_SIZE, sizeof(admission_controller_t));
+    if (!ctrl) return NULL;
+    memset(ctrl, 0, sizeof(*ctrl));
+    
+    ctrl->config = *config;
+    ctrl->queue = queue;
+    ctrl->monitor = monitor;
+    
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        double share = config->queue_share[level];
+        if (share <= 0.0 || share > 1.0) share = 1.0;
+        size_t limit = (size_t)(share * (double)queue->max_size);
+        ctrl->depth_limit[level] = limit ? limit : 1;
+        
+        if (config->rate[level] > 0.0) {
+            double burst = config->burst[level] < 1.0 ? 1.0 : config->burst[level];
+            ctrl->interval_ns[level] = (uint64_t)(1e9 / config->rate[level]);
+            if (ctrl->interval_ns[level] == 0) ctrl->interval_ns[level] = 1;
+            ctrl->burst_ns[level] = (uint64_t)(burst * (double)ctrl->interval_ns[level]);
+        }
+        
+        atomic_init(&ctrl->next_token_ns[level], 0);
+        for (int shard = 0; shard < ADMISSION_COUNTER_SHARDS; shard++) {
+            for (int verdict = 0; verdict < ADMISSION_VERDICTS; verdict++) {
+                atomic_init(&ctrl->shards[shard].counts[verdict][level], 0);
+            }
+        }
+    }
+    
+    return ctrl;
+}
+
+void admission_controller_destroy(admission_controller_t *ctrl) {
+    free(ctrl);
+}
+
+static bool should_shed(admission_controller_t *ctrl, int level) {
+    if (!ctrl->monitor) return false;
+    
+    double cpu_limit = ctrl->config.cpu_shed[level];
+    double memory_limit = ctrl->config.memory_shed[level];
+    if (cpu_limit <= 0.0 && memory_limit <= 0.0) return false;
+    
+    double cpu_percent, memory_percent;
+    resource_monitor_get_usage(ctrl->monitor, &cpu_percent, &memory_percent);
+    return (cpu_limit > 0.0 && cpu_percent >= cpu_limit) ||
+           (memory_limit > 0.0 && memory_percent >= memory_limit);
+}
+
+// GCRA: a token is free when the bucket's deadline lies no more than one
+// burst ahead of now. *wait_ns gets the time until the next one.
+static admission_verdict_t take_token(admission_controller_t *ctrl, int level, uint64_t now,
+                                      uint64_t *wait_ns) {
+    uint64_t interval = ctrl->interval_ns[level];
+    if (interval == 0) return ADMISSION_ACCEPTED;
+    
+    uint64_t deadline = atomic_load_explicit(&ctrl->next_token_ns[level], memory_order_relaxed);
+    for (;;) {
+        uint64_t next = (deadline > now ? deadline : now) + interval;
+        if (next - now > ctrl->burst_ns[level]) {
+            *wait_ns = next - now - ctrl->burst_ns[level];
+            return ADMISSION_RATE_LIMITED;
+        }
+        if (atomic_compare_exchange_weak_explicit(&ctrl->next_token_ns[level], &deadline, next,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            return ADMISSION_ACCEPTED;
+        }
+    }
+}
+
+static void refund_token(admission_controller_t *ctrl, int level) {
+    if (ctrl->interval_ns[level] != 0) {
+        atomic_fetch_sub_explicit(&ctrl->next_token_ns[level], ctrl->interval_ns[level],
+                                  memory_order_relaxed);
+    }
+}
+
+static admission_verdict_t check(admission_controller_t *ctrl, int level, uint64_t now,
+                                 uint64_t *wait_ns, size_t *depth) {
+    size_t queued = task_queue_size(ctrl->queue);
+    if (depth) *depth = queued;
+    
+    if (should_shed(ctrl, level)) return ADMISSION_SHED;
+    if (queued >= ctrl->depth_limit[level]) return ADMISSION_QUEUE_FULL;
+    return take_token(ctrl, level, now, wait_ns);
+}
+
+admission_verdict_t admission_enqueue(admission_controller_t *ctrl, task_t *task,
+                                      uint64_t timeout_us, size_t *depth) {
+    if (!ctrl || !task || (int)task->priority < 0 || task->priority >= TASK_PRIORITY_LEVELS) {
+        return ADMISSION_QUEUE_FULL;
+    }
+    
+    int level = (int)task->priority;
+    uint64_t deadline = now_ns() + timeout_us * 1000ULL;
+    admission_verdict_t verdict;
+    
+    for (;;) {
+        uint64_t now = now_ns();
+        uint64_t wait_ns = 0;
+        verdict = check(ctrl, level, now, &wait_ns, depth);
+        if (verdict == ADMISSION_ACCEPTED) {
+            if (task_queue_enqueue(ctrl->queue, task) == 0) {
+                count_verdict(ctrl, level, ADMISSION_ACCEPTED);
+                return ADMISSION_ACCEPTED;
+            }
+            // Another producer took the last slot
+            refund_token(ctrl, level);
+            verdict = ADMISSION_QUEUE_FULL;
+        }
+        
+        if (verdict == ADMISSION_SHED || now >= deadline ||
+            atomic_load(&ctrl->queue->shutdown)) {
+            break;
+        }
+        
+        if (verdict == ADMISSION_QUEUE_FULL) {
+            task_queue_wait_for_room(ctrl->queue, ctrl->depth_limit[level],
+                                     (deadline - now) / 1000);
+        } else {
+            sleep_ns(wait_ns < deadline - now ? wait_ns : deadline - now);
+        }
+    }
+    
+    count_verdict(ctrl, level, verdict);
+    return verdict;
+}
+
+size_t admission_enqueue_batch(admission_controller_t *ctrl, task_t **tasks, size_t count,
+                               admission_verdict_t *verdicts) {
+    if (!ctrl || !tasks || !verdicts) return 0;
+    
+    size_t admitted = 0;
+    for (size_t start = 0; start < count; start += ADMISSION_BATCH_MAX) {
+        size_t chunk = count - start < ADMISSION_BATCH_MAX ? count - start : ADMISSION_BATCH_MAX;
+        task_t *accepted[ADMISSION_BATCH_MAX];
+        size_t index[ADMISSION_BATCH_MAX];
+        int levels[ADMISSION_BATCH_MAX];
+        size_t pending = 0;
+        
+        // Tasks accepted earlier in the chunk count against the queue limits
+        size_t queued = task_queue_size(ctrl->queue);
+        uint64_t now = now_ns();
+        for (size_t i = start; i < start + chunk; i++) {
+            int level = tasks[i] ? (int)tasks[i]->priority : -1;
+            levels[i - start] = level;
+            uint64_t wait_ns;
+            if (level < 0 || level >= TASK_PRIORITY_LEVELS) {
+                verdicts[i] = ADMISSION_QUEUE_FULL;
+                continue;
+            }
+            if (should_shed(ctrl, level)) {
+                verdicts[i] = ADMISSION_SHED;
+            } else if (queued + pending >= ctrl->depth_limit[level]) {
+                verdicts[i] = ADMISSION_QUEUE_FULL;
+            } else {
+                verdicts[i] = take_token(ctrl, level, now, &wait_ns);
+            }
+            if (verdicts[i] == ADMISSION_ACCEPTED) {
+                index[pending] = i;
+                accepted[pending++] = tasks[i];
+            }
+        }
+        
+        size_t enqueued = task_queue_enqueue_batch(ctrl->queue, accepted, pending);
+        for (size_t j = enqueued; j < pending; j++) {
+            // Other producers filled the queue in between
+            refund_token(ctrl, levels[index[j] - start]);
+            verdicts[index[j]] = ADMISSION_QUEUE_FULL;
+        }
+        for (size_t i = start; i < start + chunk; i++) {
+            if (levels[i - start] >= 0 && levels[i - start] < TASK_PRIORITY_LEVELS) {
+                count_verdict(ctrl, levels[i - start], verdicts[i]);
+            }
+        }
+        admitted += enqueued;
+    }
+    return admitted;
+}
+
+const char* admission_verdict_name(admission_verdict_t verdict) {
+    switch (verdict) {
+        case ADMISSION_ACCEPTED:
+            return "accepted";
+        case ADMISSION_QUEUE_FULL:
+            return "queue full";
+        case ADMISSION_RATE_LIMITED:
+            return "rate limited";
+        case ADMISSION_SHED:
+            return "shed";
+    }
+    return "unknown";
+}
+
+void admission_get_stats(admission_controller_t *ctrl, admission_stats_t *stats) {
+    if (!ctrl || !stats) return;
+    
+    uint64_t *totals[ADMISSION_VERDICTS] = {
+        [ADMISSION_ACCEPTED] = stats->accepted,
+        [ADMISSION_QUEUE_FULL] = stats->queue_full,
+        [ADMISSION_RATE_LIMITED] = stats->rate_limited,
+        [ADMISSION_SHED] = stats->shed
+    };
+    memset(stats, 0, sizeof(*stats));
+    
+    for (int shard = 0; shard < ADMISSION_COUNTER_SHARDS; shard++) {
+        for (int verdict = 0; verdict < ADMISSION_VERDICTS; verdict++) {
+            for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+                totals[verdict][level] += atomic_load_explicit(
+                    &ctrl->shards[shard].counts[verdict][level], memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void admission_print_stats(admission_controller_t *ctrl, FILE *out) {
+    if (!ctrl || !out) return;
+    
+    admission_stats_t stats;
+    admission_get_stats(ctrl, &stats);
+    
+    for (int level = TASK_PRIORITY_LEVELS - 1; level >= 0; level--) {
+        fprintf(out, "  %-8s accepted %llu, queue full %llu, rate limited %llu, shed %llu\n",
+                level_names[level],
+                (unsigned long long)stats.accepted[level],
+                (unsigned long long)stats.queue_full[level],
+                (unsigned long long)stats.rate_limited[level],
+                (unsigned long long)stats.shed[level]);
+    }
+}
+
@@ -0,0 +1,85 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include "task_queue.h"
+#include "resource_monitor.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    ADMISSION_ACCEPTED = 0,
+    ADMISSION_QUEUE_FULL,       // queue at the level's share of capacity
+    ADMISSION_RATE_LIMITED,     // level's token bucket empty
+    ADMISSION_SHED              // resource watermark crossed for the level
+} admission_verdict_t;
+
+#define ADMISSION_VERDICTS 4
+
+// Producer threads count verdicts into one of these shards each (threads
+// share one only past ADMISSION_COUNTER_SHARDS producers); readers sum them
+#define ADMISSION_COUNTER_SHARDS 16
+
+#define ADMISSION_BATCH_MAX 64
+
+// Per-priority limits, indexed by task_priority_t
+typedef struct {
+    double rate[TASK_PRIORITY_LEVELS];          // tasks per second, 0 = unlimited
+    double burst[TASK_PRIORITY_LEVELS];         // bucket depth in tasks
+    double queue_share[TASK_PRIORITY_LEVELS];   // fraction of the queue a level may fill
+    double cpu_shed[TASK_PRIORITY_LEVELS];      // shed above this CPU%, 0 = never
+    double memory_shed[TASK_PRIORITY_LEVELS];   // shed above this memory%, 0 = never
+} admission_config_t;
+
+typedef struct {
+    uint64_t accepted[TASK_PRIORITY_LEVELS];
+    uint64_t queue_full[TASK_PRIORITY_LEVELS];
+    uint64_t rate_limited[TASK_PRIORITY_LEVELS];
+    uint64_t shed[TASK_PRIORITY_LEVELS];
+} admission_stats_t;
+
+// Aligned so that shards never share a cache line
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t counts[ADMISSION_VERDICTS][TASK_PRIORITY_LEVELS];
+} admission_shard_t;
+
+// Gate in front of the task queue. Lower priorities may only fill part of
+// the queue and are shed first as CPU or memory climbs, so room is always
+// left for CRITICAL work. Each level's token bucket is kept as a GCRA
+// deadline (the time the bucket next has a token free), so taking a token
+// is one CAS.
+typedef struct {
+    admission_shard_t shards[ADMISSION_COUNTER_SHARDS];
+    admission_config_t config;
+    task_queue_t *queue;
+    resource_monitor_t *monitor;                    // NULL disables shedding
+    size_t depth_limit[TASK_PRIORITY_LEVELS];
+    uint64_t interval_ns[TASK_PRIORITY_LEVELS];     // 0 = unlimited
+    uint64_t burst_ns[TASK_PRIORITY_LEVELS];
+    _Atomic uint64_t next_token_ns[TASK_PRIORITY_LEVELS];
+} admission_controller_t;
+
+void admission_config_init(admission_config_t *config);
+admission_controller_t* admission_controller_create(const admission_config_t *config,
+                                                    task_queue_t *queue,
+                                                    resource_monitor_t *monitor);
+void admission_controller_destroy(admission_controller_t *ctrl);
+// Enqueues task if admitted. With timeout_us > 0 a full queue or empty
+// bucket is waited out until the deadline; shedding always rejects at
+// once. On rejection the task is untouched. *depth, if given, receives
+// the queue depth seen by the last check.
+admission_verdict_t admission_enqueue(admission_controller_t *ctrl, task_t *task,
+                                      uint64_t timeout_us, size_t *depth);
+// Never blocks. Admits each task as admission_enqueue() would with no
+// timeout, counting those accepted ahead of it in the batch, and enqueues
+// the admitted ones together (per ADMISSION_BATCH_MAX chunk). verdicts[i]
+// receives task i's verdict; rejected tasks are untouched. Returns the
+// number enqueued.
+size_t admission_enqueue_batch(admission_controller_t *ctrl, task_t **tasks, size_t count,
+                               admission_verdict_t *verdicts);
+const char* admission_verdict_name(admission_verdict_t verdict);
+void admission_get_stats(admission_controller_t *ctrl, admission_stats_t *stats);
+void admission_print_stats(admission_controller_t *ctrl, FILE *out);
+
+#endif // ADMISSION_H
+
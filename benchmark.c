@@ -0,0 +1,723 @@
+#define _GNU_SOURCE
+#include "task_queue.h"
+#include "thread_pool.h"
+#include "task_slab.h"
+#include "task_journal.h"
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+
+// Microbenchmarks for the task queue, thread pool and journal. Results go to stdout
+// as CSV (default) or JSON, one record per configuration, so runs can be
+// diffed between releases. Runs are repeatable: the priority mix comes
+// from a fixed seed, warmup iterations are discarded, and the spread over
+// the measured iterations is reported.
+
+#define BENCH_MAX_THREADS 8
+#define BENCH_SAMPLE_EVERY 8        // queue residence is sampled on every 8th task
+#define BENCH_JOURNAL_PAYLOAD 64
+#define BENCH_JOURNAL_UNFINISHED 10 // every 10th journaled task is left unfinished
+
+// Heap allocations made by the benchmark and the code under test. Counted
+// only when linked with -Wl,--wrap=malloc,... (see the Makefile bench
+// target); -1 in the output otherwise.
+static _Atomic uint64_t g_allocs = 0;
+
+#ifdef BENCH_COUNT_ALLOCS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    atomic_fetch_add_explicit(&g_allocs, 1, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    atomic_fetch_add_explicit(&g_allocs, 1, memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    atomic_fetch_add_explicit(&g_allocs, 1, memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+#endif
+
+typedef enum {
+    MIX_SINGLE = 0,     // every task NORMAL
+    MIX_UNIFORM = 1,    // priorities drawn uniformly
+    MIX_SKEWED = 2      // mostly LOW/NORMAL, a few HIGH/CRITICAL
+} priority_mix_t;
+
+static const char *mix_names[] = { "single", "uniform", "skewed" };
+static const char *queue_mode_names[] = { "locked", "lock-free", "deadline" };
+static const char *pool_mode_names[] = { "shared", "stealing" };
+
+typedef struct {
+    size_t tasks;
+    int iterations;
+    int warmup;
+    uint64_t seed;
+    bool json;
+    const char *filter;     // run only benchmarks whose name starts with this
+} bench_options_t;
+
+typedef struct {
+    double mean;
+    double stddev;
+    double min;
+    double max;
+} bench_spread_t;
+
+typedef struct {
+    const char *benchmark;
+    const char *mode;
+    size_t producers;
+    size_t consumers;
+    const char *mix;
+    size_t tasks;
+    int iterations;
+    bench_spread_t ops_per_sec;
+    bench_spread_t ns_per_task;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    double allocs_per_task;
+} bench_result_t;
+
+static double allocs_per_task(uint64_t allocs, size_t tasks) {
+#ifdef BENCH_COUNT_ALLOCS
+    return (double)allocs / (double)tasks;
+#else
+    (void)allocs;
+    (void)tasks;
+    return -1.0;
+#endif
+}
+
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static task_priority_t draw_priority(priority_mix_t mix, uint64_t *rng) {
+    switch (mix) {
+        case MIX_SINGLE:
+            return TASK_PRIORITY_NORMAL;
+        case MIX_UNIFORM:
+            return (task_priority_t)(xorshift64(rng) % TASK_PRIORITY_LEVELS);
+        case MIX_SKEWED: {
+            uint64_t r = xorshift64(rng) % 100;
+            return r < 60 ? TASK_PRIORITY_LOW : r < 90 ? TASK_PRIORITY_NORMAL :
+                   r < 98 ? TASK_PRIORITY_HIGH : TASK_PRIORITY_CRITICAL;
+        }
+    }
+    return TASK_PRIORITY_NORMAL;
+}
+
+static bench_spread_t spread(const double *values, int count) {
+    bench_spread_t s = { 0.0, 0.0, values[0], values[0] };
+    for (int i = 0; i < count; i++) {
+        s.mean += values[i];
+        if (values[i] < s.min) s.min = values[i];
+        if (values[i] > s.max) s.max = values[i];
+    }
+    s.mean /= count;
+    for (int i = 0; i < count; i++) {
+        s.stddev += (values[i] - s.mean) * (values[i] - s.mean);
+    }
+    s.stddev = count > 1 ? sqrt(s.stddev / (count - 1)) : 0.0;
+    return s;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t sorted_percentile(const uint64_t *sorted, size_t count, double fraction) {
+    if (count == 0) return 0;
+    size_t rank = (size_t)(fraction * (double)count);
+    return sorted[rank < count ? rank : count - 1];
+}
+
+/* ---- task queue: enqueue/dequeue throughput and queue residence ---- */
+
+typedef struct {
+    task_queue_t *queue;
+    task_t *tasks;              // this producer's slice
+    size_t count;
+    priority_mix_t mix;
+    uint64_t seed;
+} queue_producer_t;
+
+typedef struct {
+    task_queue_t *queue;
+    _Atomic size_t *consumed;
+    size_t total;
+    uint64_t *samples;
+    size_t sample_count;
+    size_t sample_capacity;
+} queue_consumer_t;
+
+static _Atomic bool g_go = false;
+
+static void wait_for_go(void) {
+    while (!atomic_load_explicit(&g_go, memory_order_acquire)) {
+        sched_yield();
+    }
+}
+
+static void* queue_producer(void *arg) {
+    queue_producer_t *p = (queue_producer_t*)arg;
+    uint64_t rng = p->seed;
+    for (size_t i = 0; i < p->count; i++) {
+        p->tasks[i].priority = draw_priority(p->mix, &rng);
+    }
+    
+    wait_for_go();
+    for (size_t i = 0; i < p->count; i++) {
+        while (task_queue_enqueue(p->queue, &p->tasks[i]) != 0) {
+            sched_yield();  // full
+        }
+    }
+    return NULL;
+}
+
+static void* queue_consumer(void *arg) {
+    queue_consumer_t *c = (queue_consumer_t*)arg;
+    size_t taken = 0;
+    
+    wait_for_go();
+    while (atomic_load_explicit(c->consumed, memory_order_relaxed) < c->total) {
+        task_t *task = task_queue_try_dequeue(c->queue);
+        if (!task) {
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_add_explicit(c->consumed, 1, memory_order_relaxed);
+        
+        if (++taken % BENCH_SAMPLE_EVERY == 0 && c->sample_count < c->sample_capacity) {
+            c->samples[c->sample_count++] = task_now_ns() - task->enqueue_ns;
+        }
+    }
+    return NULL;
+}
+
+// One timed run; returns elapsed ns, appends residence samples and adds
+// the allocations made inside the timed section to *allocs
+static uint64_t run_queue_once(task_queue_mode_t mode, size_t producers, size_t consumers,
+                               priority_mix_t mix, const bench_options_t *opt,
+                               uint64_t *samples, size_t *sample_count, size_t sample_capacity,
+                               uint64_t *allocs) {
+    task_queue_t *queue = task_queue_create_ex(1024, mode);
+    task_t *tasks = (task_t*)calloc(opt->tasks, sizeof(task_t));
+    if (!queue || !tasks) {
+        fprintf(stderr, "benchmark: out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < opt->tasks; i++) {
+        task_init(&tasks[i], "bench", TASK_PRIORITY_NORMAL, NULL, 0, NULL, NULL);
+    }
+    
+    pthread_t threads[2 * BENCH_MAX_THREADS];
+    queue_producer_t prod[BENCH_MAX_THREADS];
+    queue_consumer_t cons[BENCH_MAX_THREADS];
+    _Atomic size_t consumed = 0;
+    size_t per_producer = opt->tasks / producers;
+    size_t per_consumer_samples = sample_capacity / consumers;
+    
+    for (size_t i = 0; i < producers; i++) {
+        prod[i] = (queue_producer_t){
+            .queue = queue,
+            .tasks = tasks + i * per_producer,
+            .count = (i == producers - 1) ? opt->tasks - i * per_producer : per_producer,
+            .mix = mix,
+            .seed = opt->seed + 0x9E3779B97F4A7C15ULL * (i + 1)
+        };
+        pthread_create(&threads[i], NULL, queue_producer, &prod[i]);
+    }
+    for (size_t i = 0; i < consumers; i++) {
+        cons[i] = (queue_consumer_t){
+            .queue = queue,
+            .consumed = &consumed,
+            .total = opt->tasks,
+            .samples = samples + *sample_count + i * per_consumer_samples,
+            .sample_count = 0,
+            .sample_capacity = per_consumer_samples
+        };
+        pthread_create(&threads[producers + i], NULL, queue_consumer, &cons[i]);
+    }
+    
+    uint64_t allocs_before = atomic_load(&g_allocs);
+    uint64_t start = task_now_ns();
+    atomic_store_explicit(&g_go, true, memory_order_release);
+    for (size_t i = 0; i < producers + consumers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t elapsed = task_now_ns() - start;
+    *allocs += atomic_load(&g_allocs) - allocs_before;
+    atomic_store(&g_go, false);
+    
+    // Compact the consumers' sample slices
+    size_t n = *sample_count;
+    for (size_t i = 0; i < consumers; i++) {
+        memmove(samples + n, cons[i].samples, cons[i].sample_count * sizeof(uint64_t));
+        n += cons[i].sample_count;
+    }
+    *sample_count = n;
+    
+    task_queue_destroy(queue);
+    free(tasks);
+    return elapsed;
+}
+
+static void bench_queue(task_queue_mode_t mode, size_t producers, size_t consumers,
+                        priority_mix_t mix, const bench_options_t *opt, bench_result_t *result) {
+    size_t per_run = opt->tasks / BENCH_SAMPLE_EVERY + 1;
+    size_t capacity = per_run * (size_t)opt->iterations;
+    uint64_t *samples = (uint64_t*)malloc(sizeof(uint64_t) * (capacity + per_run));
+    double ops[64], ns[64];
+    size_t sample_count = 0;
+    uint64_t allocs = 0;
+    
+    for (int i = 0; i < opt->warmup; i++) {
+        size_t discard = 0;
+        uint64_t discard_allocs = 0;
+        run_queue_once(mode, producers, consumers, mix, opt, samples, &discard, per_run,
+                       &discard_allocs);
+    }
+    
+    for (int i = 0; i < opt->iterations; i++) {
+        uint64_t elapsed = run_queue_once(mode, producers, consumers, mix, opt,
+                                          samples, &sample_count, per_run, &allocs);
+        ops[i] = (double)opt->tasks * 1e9 / (double)elapsed;
+        ns[i] = (double)elapsed / (double)opt->tasks;
+    }
+    
+    qsort(samples, sample_count, sizeof(uint64_t), compare_u64);
+    *result = (bench_result_t){
+        .benchmark = "queue",
+        .mode = queue_mode_names[mode],
+        .producers = producers,
+        .consumers = consumers,
+        .mix = mix_names[mix],
+        .tasks = opt->tasks,
+        .iterations = opt->iterations,
+        .ops_per_sec = spread(ops, opt->iterations),
+        .ns_per_task = spread(ns, opt->iterations),
+        .p50_ns = sorted_percentile(samples, sample_count, 0.50),
+        .p99_ns = sorted_percentile(samples, sample_count, 0.99),
+        .allocs_per_task = allocs_per_task(allocs, opt->tasks * (size_t)opt->iterations)
+    };
+    free(samples);
+}
+
+/* ---- thread pool: dispatch overhead of no-op tasks ---- */
+
+static _Atomic size_t g_executed = 0;
+
+static int noop_execute(void *data) {
+    (void)data;
+    atomic_fetch_add_explicit(&g_executed, 1, memory_order_relaxed);
+    return 0;
+}
+
+// Submit, dispatch, run and free opt->tasks slab tasks; returns elapsed ns
+static uint64_t run_pool_once(thread_pool_mode_t mode, size_t workers, priority_mix_t mix,
+                              const bench_options_t *opt, uint64_t *allocs,
+                              latency_snapshot_t *latency) {
+    task_slab_t *slab = task_slab_create();
+    task_queue_t *queue = task_queue_create_ex(1024, TASK_QUEUE_MODE_LOCKED);
+    thread_pool_t *pool = thread_pool_create_ex(workers, queue, mode);
+    if (!slab || !queue || !pool || thread_pool_start(pool) != 0) {
+        fprintf(stderr, "benchmark: failed to set up thread pool\n");
+        exit(1);
+    }
+    
+    uint64_t rng = opt->seed;
+    atomic_store(&g_executed, 0);
+    uint64_t allocs_before = atomic_load(&g_allocs);
+    uint64_t start = task_now_ns();
+    
+    for (size_t i = 0; i < opt->tasks; i++) {
+        task_t *task = task_slab_alloc(slab);
+        task_init(task, "bench", draw_priority(mix, &rng), NULL, 0, noop_execute, NULL);
+        task->data_free = NULL;
+        while (thread_pool_submit(pool, task) != 0) {
+            sched_yield();  // full
+        }
+    }
+    while (atomic_load_explicit(&g_executed, memory_order_relaxed) < opt->tasks) {
+        sched_yield();
+    }
+    
+    uint64_t elapsed = task_now_ns() - start;
+    *allocs += atomic_load(&g_allocs) - allocs_before;
+    thread_pool_get_latency(pool, latency);
+    
+    thread_pool_destroy(pool);
+    task_queue_destroy(queue);
+    task_slab_destroy(slab);
+    return elapsed;
+}
+
+static void bench_pool(thread_pool_mode_t mode, size_t workers, priority_mix_t mix,
+                       const bench_options_t *opt, bench_result_t *result) {
+    double ops[64], ns[64];
+    uint64_t allocs = 0;
+    uint64_t p50[64], p99[64];
+    latency_snapshot_t latency;
+    
+    for (int i = 0; i < opt->warmup; i++) {
+        uint64_t discard = 0;
+        run_pool_once(mode, workers, mix, opt, &discard, &latency);
+    }
+    
+    for (int i = 0; i < opt->iterations; i++) {
+        uint64_t elapsed = run_pool_once(mode, workers, mix, opt, &allocs, &latency);
+        ops[i] = (double)opt->tasks * 1e9 / (double)elapsed;
+        ns[i] = (double)elapsed / (double)opt->tasks;
+        p50[i] = latency.overall[LATENCY_END_TO_END].p50;
+        p99[i] = latency.overall[LATENCY_END_TO_END].p99;
+    }
+    
+    // Median of the per-iteration percentiles
+    qsort(p50, (size_t)opt->iterations, sizeof(uint64_t), compare_u64);
+    qsort(p99, (size_t)opt->iterations, sizeof(uint64_t), compare_u64);
+    *result = (bench_result_t){
+        .benchmark = "pool",
+        .mode = pool_mode_names[mode],
+        .producers = 1,
+        .consumers = workers,
+        .mix = mix_names[mix],
+        .tasks = opt->tasks,
+        .iterations = opt->iterations,
+        .ops_per_sec = spread(ops, opt->iterations),
+        .ns_per_task = spread(ns, opt->iterations),
+        .p50_ns = p50[opt->iterations / 2],
+        .p99_ns = p99[opt->iterations / 2],
+        .allocs_per_task = allocs_per_task(allocs, opt->tasks * (size_t)opt->iterations)
+    };
+}
+
+/* ---- journal: append throughput and recovery time ---- */
+
+typedef struct {
+    task_journal_t *journal;
+    size_t tasks;
+} journal_producer_t;
+
+static void* journal_producer(void *arg) {
+    journal_producer_t *p = (journal_producer_t*)arg;
+    unsigned char payload[BENCH_JOURNAL_PAYLOAD];
+    memset(payload, 0x5a, sizeof(payload));
+    wait_for_go();
+    
+    for (size_t i = 0; i < p->tasks; i++) {
+        task_t task;
+        task_init(&task, "bench", TASK_PRIORITY_NORMAL, payload, sizeof(payload), NULL, NULL);
+        if (task_journal_append(p->journal, &task) != 0) {
+            fprintf(stderr, "benchmark: journal append failed\n");
+            exit(1);
+        }
+        if (i % BENCH_JOURNAL_UNFINISHED == 0) {
+            task_journal_detach(&task);
+        } else {
+            task.status = TASK_STATUS_COMPLETED;
+            task_journal_complete(&task);
+        }
+    }
+    return NULL;
+}
+
+static void remove_journal(const char *dir) {
+    DIR *d = opendir(dir);
+    if (d) {
+        struct dirent *entry;
+        char path[TASK_JOURNAL_PATH_MAX + 256];
+        while ((entry = readdir(d)) != NULL) {
+            if (entry->d_name[0] == '.') continue;
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            unlink(path);
+        }
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+// Journals opt->tasks submissions from producers threads, completing all
+// but every BENCH_JOURNAL_UNFINISHED-th; returns elapsed ns, syncs included
+static uint64_t run_journal_once(const char *dir, size_t producers, const bench_options_t *opt,
+                                 uint64_t *allocs) {
+    task_journal_t *journal = task_journal_open(dir, NULL);
+    if (!journal) {
+        fprintf(stderr, "benchmark: failed to open a journal in %s\n", dir);
+        exit(1);
+    }
+    
+    pthread_t threads[BENCH_MAX_THREADS];
+    journal_producer_t prod[BENCH_MAX_THREADS];
+    atomic_store(&g_go, false);
+    for (size_t i = 0; i < producers; i++) {
+        prod[i].journal = journal;
+        prod[i].tasks = opt->tasks / producers + (i < opt->tasks % producers ? 1 : 0);
+        pthread_create(&threads[i], NULL, journal_producer, &prod[i]);
+    }
+    
+    uint64_t allocs_before = atomic_load(&g_allocs);
+    uint64_t start = task_now_ns();
+    atomic_store(&g_go, true);
+    for (size_t i = 0; i < producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    task_journal_sync(journal);
+    uint64_t elapsed = task_now_ns() - start;
+    *allocs += atomic_load(&g_allocs) - allocs_before;
+    
+    task_journal_close(journal);
+    return elapsed;
+}
+
+static void bench_journal_append(size_t producers, const bench_options_t *opt,
+                                 bench_result_t *result) {
+    double ops[64], ns[64];
+    uint64_t allocs = 0;
+    char dir[] = "/tmp/orchestrator_bench_XXXXXX";
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "benchmark: failed to create a journal directory\n");
+        exit(1);
+    }
+    
+    for (int i = 0; i < opt->warmup; i++) {
+        uint64_t discard = 0;
+        run_journal_once(dir, producers, opt, &discard);
+        remove_journal(dir);
+    }
+    
+    for (int i = 0; i < opt->iterations; i++) {
+        uint64_t elapsed = run_journal_once(dir, producers, opt, &allocs);
+        remove_journal(dir);
+        ops[i] = (double)opt->tasks * 1e9 / (double)elapsed;
+        ns[i] = (double)elapsed / (double)opt->tasks;
+    }
+    
+    *result = (bench_result_t){
+        .benchmark = "journal",
+        .mode = "append",
+        .producers = producers,
+        .consumers = 1,
+        .mix = mix_names[MIX_SINGLE],
+        .tasks = opt->tasks,
+        .iterations = opt->iterations,
+        .ops_per_sec = spread(ops, opt->iterations),
+        .ns_per_task = spread(ns, opt->iterations),
+        .allocs_per_task = allocs_per_task(allocs, opt->tasks * (size_t)opt->iterations)
+    };
+}
+
+// Opens a journal of opt->tasks submissions, a tenth of them unfinished;
+// tasks is the submission count and ns_per_task the scan cost of each
+static void bench_journal_recover(const bench_options_t *opt, bench_result_t *result) {
+    double ops[64], ns[64];
+    uint64_t allocs = 0;
+    char dir[] = "/tmp/orchestrator_bench_XXXXXX";
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "benchmark: failed to create a journal directory\n");
+        exit(1);
+    }
+    uint64_t discard = 0;
+    run_journal_once(dir, 1, opt, &discard);
+    
+    size_t expected = (opt->tasks + BENCH_JOURNAL_UNFINISHED - 1) / BENCH_JOURNAL_UNFINISHED;
+    for (int i = -opt->warmup; i < opt->iterations; i++) {
+        uint64_t allocs_before = atomic_load(&g_allocs);
+        task_journal_t *journal = task_journal_open(dir, NULL);
+        if (!journal) {
+            fprintf(stderr, "benchmark: failed to reopen the journal\n");
+            exit(1);
+        }
+        task_journal_stats_t stats;
+        task_journal_get_stats(journal, &stats);
+        if (stats.recovered != expected) {
+            fprintf(stderr, "benchmark: recovered %zu of %zu unfinished tasks\n",
+                    stats.recovered, expected);
+            exit(1);
+        }
+        // Nothing was replayed, so close leaves the files as they were
+        task_journal_close(journal);
+        if (i < 0) continue;
+        
+        allocs += atomic_load(&g_allocs) - allocs_before;
+        ops[i] = (double)opt->tasks * 1e9 / (double)stats.recovery_ns;
+        ns[i] = (double)stats.recovery_ns / (double)opt->tasks;
+    }
+    remove_journal(dir);
+    
+    *result = (bench_result_t){
+        .benchmark = "journal",
+        .mode = "recover",
+        .producers = 1,
+        .consumers = 1,
+        .mix = mix_names[MIX_SINGLE],
+        .tasks = opt->tasks,
+        .iterations = opt->iterations,
+        .ops_per_sec = spread(ops, opt->iterations),
+        .ns_per_task = spread(ns, opt->iterations),
+        .allocs_per_task = allocs_per_task(allocs, opt->tasks * (size_t)opt->iterations)
+    };
+}
+
+/* ---- output ---- */
+
+static void print_csv_header(void) {
+    printf("benchmark,mode,producers,consumers,mix,tasks,iterations,"
+           "ops_per_sec_mean,ops_per_sec_stddev,ops_per_sec_min,ops_per_sec_max,"
+           "ns_per_task_mean,ns_per_task_stddev,p50_ns,p99_ns,allocs_per_task\n");
+}
+
+static void print_csv(const bench_result_t *r) {
+    printf("%s,%s,%zu,%zu,%s,%zu,%d,%.0f,%.0f,%.0f,%.0f,%.1f,%.1f,%llu,%llu,%.3f\n",
+           r->benchmark, r->mode, r->producers, r->consumers, r->mix, r->tasks, r->iterations,
+           r->ops_per_sec.mean, r->ops_per_sec.stddev, r->ops_per_sec.min, r->ops_per_sec.max,
+           r->ns_per_task.mean, r->ns_per_task.stddev,
+           (unsigned long long)r->p50_ns, (unsigned long long)r->p99_ns, r->allocs_per_task);
+}
+
+static void print_json(const bench_result_t *r, bool first) {
+    printf("%s\n  {\"benchmark\": \"%s\", \"mode\": \"%s\", \"producers\": %zu, \"consumers\": %zu, "
+           "\"mix\": \"%s\", \"tasks\": %zu, \"iterations\": %d, "
+           "\"ops_per_sec\": {\"mean\": %.0f, \"stddev\": %.0f, \"min\": %.0f, \"max\": %.0f}, "
+           "\"ns_per_task\": {\"mean\": %.1f, \"stddev\": %.1f}, "
+           "\"p50_ns\": %llu, \"p99_ns\": %llu, \"allocs_per_task\": %.3f}",
+           first ? "" : ",",
+           r->benchmark, r->mode, r->producers, r->consumers, r->mix, r->tasks, r->iterations,
+           r->ops_per_sec.mean, r->ops_per_sec.stddev, r->ops_per_sec.min, r->ops_per_sec.max,
+           r->ns_per_task.mean, r->ns_per_task.stddev,
+           (unsigned long long)r->p50_ns, (unsigned long long)r->p99_ns, r->allocs_per_task);
+}
+
+static void emit(const bench_options_t *opt, const bench_result_t *result, size_t *emitted) {
+    if (opt->json) {
+        print_json(result, *emitted == 0);
+    } else {
+        print_csv(result);
+    }
+    fflush(stdout);
+    (*emitted)++;
+}
+
+static bool selected(const bench_options_t *opt, const char *name) {
+    return !opt->filter || strncmp(name, opt->filter, strlen(opt->filter)) == 0;
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("Options:\n");
+    printf("  --tasks <n>       Tasks per iteration (default: 100000)\n");
+    printf("  --iterations <n>  Measured iterations, 1-64 (default: 5)\n");
+    printf("  --warmup <n>      Discarded warmup iterations (default: 1)\n");
+    printf("  --seed <n>        Seed for the priority mix (default: 42)\n");
+    printf("  --json            JSON output instead of CSV\n");
+    printf("  --only <name>     Run only queue, pool or journal benchmarks\n");
+}
+
+int main(int argc, char *argv[]) {
+    bench_options_t opt = {
+        .tasks = 100000,
+        .iterations = 5,
+        .warmup = 1,
+        .seed = 42,
+        .json = false,
+        .filter = NULL
+    };
+    
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--json") == 0) {
+            opt.json = true;
+        } else if (strcmp(arg, "--tasks") == 0 && value) {
+            opt.tasks = (size_t)strtoull(value, NULL, 10);
+            i++;
+        } else if (strcmp(arg, "--iterations") == 0 && value) {
+            opt.iterations = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--warmup") == 0 && value) {
+            opt.warmup = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--seed") == 0 && value) {
+            opt.seed = strtoull(value, NULL, 10);
+            i++;
+        } else if (strcmp(arg, "--only") == 0 && value) {
+            opt.filter = value;
+            i++;
+        } else {
+            print_usage(argv[0]);
+            return strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+    if (opt.tasks < BENCH_MAX_THREADS || opt.iterations < 1 || opt.iterations > 64 ||
+        opt.warmup < 0 || opt.seed == 0) {
+        fprintf(stderr, "benchmark: invalid options\n");
+        return 1;
+    }
+    
+    static const size_t thread_counts[][2] = { { 1, 1 }, { 2, 2 }, { 4, 4 }, { 1, 4 }, { 4, 1 } };
+    static const size_t worker_counts[] = { 1, 2, 4 };
+    static const size_t journal_producers[] = { 1, 4 };
+    bench_result_t result;
+    size_t emitted = 0;
+    
+    if (opt.json) {
+        printf("[");
+    } else {
+        print_csv_header();
+    }
+    
+    if (selected(&opt, "queue")) {
+        for (int mode = TASK_QUEUE_MODE_LOCKED; mode <= TASK_QUEUE_MODE_DEADLINE; mode++) {
+            for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+                for (int mix = MIX_SINGLE; mix <= MIX_SKEWED; mix++) {
+                    bench_queue((task_queue_mode_t)mode, thread_counts[t][0], thread_counts[t][1],
+                                (priority_mix_t)mix, &opt, &result);
+                    emit(&opt, &result, &emitted);
+                }
+            }
+        }
+    }
+    
+    if (selected(&opt, "pool")) {
+        for (int mode = THREAD_POOL_MODE_SHARED_QUEUE; mode <= THREAD_POOL_MODE_WORK_STEALING; mode++) {
+            for (size_t w = 0; w < sizeof(worker_counts) / sizeof(worker_counts[0]); w++) {
+                bench_pool((thread_pool_mode_t)mode, worker_counts[w], MIX_UNIFORM, &opt, &result);
+                emit(&opt, &result, &emitted);
+            }
+        }
+    }
+    
+    if (selected(&opt, "journal")) {
+        for (size_t p = 0; p < sizeof(journal_producers) / sizeof(journal_producers[0]); p++) {
+            bench_journal_append(journal_producers[p], &opt, &result);
+            emit(&opt, &result, &emitted);
+        }
+        bench_journal_recover(&opt, &result);
+        emit(&opt, &result, &emitted);
+    }
+    
+    if (opt.json) {
+        printf("\n]\n");
+    }
+    
+    return 0;
+}
+
@@ -4,13 +4,85 @@ Communication layer for C-Python interprocess communication
 Supports shared memory, pipes, and message passing
 """
 
+import ctypes
+import ctypes.util
 import json
 import sys
 import os
+import platform
+import select
 import struct
-import mmap
 import time
-from typing import Dict, Any, Optional
+from multiprocessing import resource_tracker, shared_memory
+from typing import Dict, Any, List, Optional, Tuple
+
+
+# Shared ring layout, must match python_worker_pool.h
+RING_MAGIC = 0x524f4941
+RING_VERSION = 2
+RING_HEADER = struct.Struct('<IIII')
+RING_CURSOR = struct.Struct('<Q')
+SUB_HEAD_OFFSET = 64
+SUB_TAIL_OFFSET = 128
+COMP_HEAD_OFFSET = 192
+COMP_TAIL_OFFSET = 256
+RING_DATA_OFFSET = 4096
+SLOT_HEADER = struct.Struct('<QII')
+MODEL_LENGTH = struct.Struct('<H')
+BATCH_LENGTH = struct.Struct('<I')
+BATCH_RESULT = struct.Struct('<II')
+TASK_ID_LEN = 64
+
+# __ATOMIC_* orders taken by libatomic's sized load/store
+ATOMIC_ACQUIRE = 2
+ATOMIC_RELEASE = 3
+
+
+def load_cursor_atomics() -> Tuple[Optional[Any], Optional[Any]]:
+    """
+    Find libatomic's 8-byte load and store
+    
+    The ring cursors are C11 atomics; the C side publishes with release and
+    reads with acquire, so we must do the same or weakly ordered CPUs (ARM)
+    can see a cursor move before the slot it covers.
+    
+    Returns:
+        (load, store), or (None, None) when libatomic is missing
+    """
+    path = ctypes.util.find_library('atomic')
+    if not path:
+        return None, None
+    lib = ctypes.CDLL(path)
+    load = lib.__atomic_load_8
+    load.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    load.restype = ctypes.c_uint64
+    store = lib.__atomic_store_8
+    store.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_int]
+    store.restype = None
+    return load, store
+
+
+def open_named_segment(name: str, size: int = 0, create: bool = False) -> shared_memory.SharedMemory:
+    """
+    Create or attach a POSIX named shared memory segment
+    
+    Args:
+        name: Segment name, with or without the leading '/'
+        size: Size in bytes (only used when creating)
+        create: Create the segment instead of attaching to it
+        
+    Returns:
+        SharedMemory object backed by the named segment
+    """
+    segment = shared_memory.SharedMemory(name=name.lstrip('/'), create=create, size=size)
+    if not create:
+        # The creator owns the segment; keep Python's resource tracker from
+        # unlinking it when this process exits
+        try:
+            resource_tracker.unregister(segment._name, 'shared_memory')
+        except Exception:
+            pass
+    return segment
 
 
 class CPythonCommunicator:
@@ -28,6 +100,7 @@ class CPythonCommunicator:
         self.shared_mem_name = shared_mem_name
         self.shared_mem_size = shared_mem_size
         self.shared_mem = None
+        self.owns_shared_mem = False
     
     def send_task_via_stdin(self, task_data: Dict[str, Any]) -> bool:
         """
@@ -67,20 +140,38 @@ class CPythonCommunicator:
     
     def create_shared_memory(self) -> bool:
         """
-        Create shared memory segment (Unix only)
+        Create the named shared memory segment (Unix only)
+        
+        Other processes can attach to it by name with attach_shared_memory().
         
         Returns:
             True if created successfully
         """
         try:
-            # This is a simplified version
-            # In production, use proper shared memory with semaphores
-            self.shared_mem = mmap.mmap(-1, self.shared_mem_size)
+            self.shared_mem = open_named_segment(self.shared_mem_name,
+                                                 self.shared_mem_size, create=True)
+            self.owns_shared_mem = True
             return True
         except Exception as e:
             print(f"Error creating shared memory: {e}", file=sys.stderr)
             return False
     
+    def attach_shared_memory(self) -> bool:
+        """
+        Attach to a named shared memory segment created by another process
+        
+        Returns:
+            True if attached successfully
+        """
+        try:
+            self.shared_mem = open_named_segment(self.shared_mem_name)
+            self.shared_mem_size = self.shared_mem.size
+            self.owns_shared_mem = False
+            return True
+        except Exception as e:
+            print(f"Error attaching shared memory: {e}", file=sys.stderr)
+            return False
+    
     def write_to_shared_memory(self, data: bytes) -> bool:
         """
         Write data to shared memory
@@ -98,8 +189,7 @@ class CPythonCommunicator:
             if len(data) > self.shared_mem_size:
                 return False
             
-            self.shared_mem.seek(0)
-            self.shared_mem.write(data)
+            self.shared_mem.buf[:len(data)] = data
             return True
         except Exception as e:
             print(f"Error writing to shared memory: {e}", file=sys.stderr)
@@ -119,8 +209,7 @@ class CPythonCommunicator:
             return None
         
         try:
-            self.shared_mem.seek(0)
-            return self.shared_mem.read(size)
+            return bytes(self.shared_mem.buf[:size])
         except Exception as e:
             print(f"Error reading from shared memory: {e}", file=sys.stderr)
             return None
@@ -129,9 +218,164 @@ class CPythonCommunicator:
         """Close communication channels"""
         if self.shared_mem:
             self.shared_mem.close()
+            if self.owns_shared_mem:
+                self.shared_mem.unlink()
             self.shared_mem = None
 
 
+class ShmRing:
+    """Worker side of a C-owned submission/completion ring in shared memory"""
+    
+    def __init__(self, shm_name: str, sub_fd: int, comp_fd: int):
+        """
+        Attach to a ring created by the orchestrator
+        
+        Args:
+            shm_name: Name of the shared memory segment
+            sub_fd: eventfd the orchestrator rings when it submits
+            comp_fd: eventfd we ring after posting a completion
+        """
+        self.segment = open_named_segment(shm_name)
+        self.buf = self.segment.buf
+        magic, version, self.slot_count, self.slot_size = RING_HEADER.unpack_from(self.buf, 0)
+        if magic != RING_MAGIC or version != RING_VERSION:
+            raise ValueError(f"{shm_name} is not a version {RING_VERSION} orchestrator ring")
+        self.payload_size = self.slot_size - SLOT_HEADER.size
+        self.atomic_load, self.atomic_store = load_cursor_atomics()
+        if self.atomic_load is None and platform.machine().lower() not in ('x86_64', 'amd64', 'i386', 'i686'):
+            # Plain accesses are only ordered strongly enough on x86
+            self.segment.close()
+            raise RuntimeError("libatomic is required to share the ring on " + platform.machine())
+        # Address of the mapping; the temporary export is dropped at once so
+        # close() can still release the buffer
+        self.base = ctypes.addressof(ctypes.c_char.from_buffer(self.buf))
+        self.sub_fd = sub_fd
+        self.comp_fd = comp_fd
+        self.poller = select.poll()
+        self.poller.register(sub_fd, select.POLLIN)
+    
+    def _cursor(self, offset: int) -> int:
+        """Read a cursor with acquire, so slot reads cannot move before it"""
+        if self.atomic_load is None:
+            return RING_CURSOR.unpack_from(self.buf, offset)[0]
+        return self.atomic_load(self.base + offset, ATOMIC_ACQUIRE)
+    
+    def _set_cursor(self, offset: int, value: int):
+        """Publish a cursor with release, after the slot it covers"""
+        if self.atomic_store is None:
+            RING_CURSOR.pack_into(self.buf, offset, value)
+            return
+        self.atomic_store(self.base + offset, value, ATOMIC_RELEASE)
+    
+    def _slot_offset(self, index: int) -> int:
+        return RING_DATA_OFFSET + index * self.slot_size
+    
+    def next_submission(self, timeout_ms: Optional[int] = None) -> Optional[Tuple[int, str, List[Tuple[str, memoryview]], bool]]:
+        """
+        Wait for the next submission
+        
+        Returns:
+            (request_id, model, [(task_id, payload view), ...], batched) or
+            None on timeout. model is '' for the worker's default model.
+            Views are only valid until release_submission().
+        """
+        while True:
+            head = self._cursor(SUB_HEAD_OFFSET)
+            if head != self._cursor(SUB_TAIL_OFFSET):
+                request_id, count, body = self._submission(head)
+                model, pos = self._model(body)
+                if count == 0:
+                    return request_id, model, [(self._task_id(body[pos:]), body[pos + TASK_ID_LEN:])], False
+                
+                # Batched: count records of id, uint32 length, data
+                records = []
+                for _ in range(count):
+                    task_id = self._task_id(body[pos:])
+                    size = BATCH_LENGTH.unpack_from(body, pos + TASK_ID_LEN)[0]
+                    pos += TASK_ID_LEN + BATCH_LENGTH.size
+                    records.append((task_id, body[pos:pos + size]))
+                    pos += size
+                return request_id, model, records, True
+            
+            if not self.poller.poll(timeout_ms if timeout_ms is not None else -1):
+                return None
+            try:
+                os.read(self.sub_fd, 8)
+            except BlockingIOError:
+                pass
+    
+    def queued_models(self) -> List[str]:
+        """Models named by submissions queued behind the current one"""
+        head = self._cursor(SUB_HEAD_OFFSET)
+        tail = self._cursor(SUB_TAIL_OFFSET)
+        return [self._model(self._submission(pos)[2])[0] for pos in range(head + 1, tail)]
+    
+    def _submission(self, pos: int) -> Tuple[int, int, memoryview]:
+        offset = self._slot_offset(pos % self.slot_count)
+        request_id, count, length = SLOT_HEADER.unpack_from(self.buf, offset)
+        return request_id, count, self.buf[offset + SLOT_HEADER.size:offset + SLOT_HEADER.size + length]
+    
+    @staticmethod
+    def _model(body: memoryview) -> Tuple[str, int]:
+        length = MODEL_LENGTH.unpack_from(body, 0)[0]
+        end = MODEL_LENGTH.size + length
+        return bytes(body[MODEL_LENGTH.size:end]).decode('utf-8', 'replace'), end
+    
+    @staticmethod
+    def _task_id(body: memoryview) -> str:
+        return bytes(body[:TASK_ID_LEN]).split(b'\0', 1)[0].decode('utf-8', 'replace')
+    
+    def release_submission(self):
+        """Hand the oldest submission slot back to the orchestrator"""
+        self._set_cursor(SUB_HEAD_OFFSET, self._cursor(SUB_HEAD_OFFSET) + 1)
+    
+    def post_completion(self, request_id: int, status: int, payload: bytes):
+        """
+        Publish a completion and ring the orchestrator's doorbell
+        
+        Args:
+            request_id: Id of the submission being answered
+            status: 0 on success
+            payload: Result bytes; if they overflow the slot, the request
+                fails instead (never a truncated success)
+        """
+        if len(payload) > self.payload_size:
+            print(f"Result of {len(payload)} bytes for request {request_id} exceeds the "
+                  f"{self.payload_size} byte slot", file=sys.stderr)
+            status, payload = 1, b''
+        tail = self._cursor(COMP_TAIL_OFFSET)
+        while tail - self._cursor(COMP_HEAD_OFFSET) >= self.slot_count:
+            time.sleep(0.0001)  # Orchestrator has not drained yet
+        
+        offset = self._slot_offset(self.slot_count + tail % self.slot_count)
+        SLOT_HEADER.pack_into(self.buf, offset, request_id, status, len(payload))
+        self.buf[offset + SLOT_HEADER.size:offset + SLOT_HEADER.size + len(payload)] = payload
+        # Released: the slot is visible before the C side sees the tail move
+        self._set_cursor(COMP_TAIL_OFFSET, tail + 1)
+        os.write(self.comp_fd, struct.pack('<Q', 1))
+    
+    def post_batch_completion(self, request_id: int, results: List[Tuple[int, bytes]]):
+        """
+        Publish the results of a batched submission, one per record in order
+        
+        Args:
+            request_id: Id of the batched submission
+            results: (status, payload) per task
+        """
+        reply = b''.join(BATCH_RESULT.pack(status, len(payload)) + payload
+                         for status, payload in results)
+        if len(reply) > self.payload_size:
+            # Too big to scatter back; fail the batch as a whole
+            self.post_completion(request_id, 1, b'')
+            return
+        self.post_completion(request_id, 0, reply)
+    
+    def close(self):
+        """Detach from the ring (the orchestrator unlinks it)"""
+        self.buf.release()
+        self.segment.close()
+
+
 def main():
     """Test communication layer"""
     comm = CPythonCommunicator()
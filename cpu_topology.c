@@ -0,0 +1,352 @@
+#define _GNU_SOURCE
+#include "cpu_topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#define CPU_SYSFS "/sys/devices/system/cpu"
+
+#ifdef __linux__
+static int read_int(const char *path, int fallback) {
+    FILE *file = fopen(path, "r");
+    if (!file) return fallback;
+    int value;
+    if (fscanf(file, "%d", &value) != 1) value = fallback;
+    fclose(file);
+    return value;
+}
+
+// Kernel CPU list such as "0-3,8-11"
+static int read_cpu_list(const char *path, bool *cpus) {
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+    
+    char text[4096];
+    bool ok = fgets(text, sizeof(text), file) != NULL;
+    fclose(file);
+    if (!ok) return -1;
+    
+    char *p = text;
+    while (*p && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) return -1;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1) return -1;
+            p = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+            if (cpu >= 0) cpus[cpu] = true;
+        }
+        if (*p == ',') p++;
+    }
+    return 0;
+}
+
+// Names a CPU's core by the lowest-numbered thread on it. core_id is no
+// key: it repeats across dies and clusters of one package, so siblings
+// come from core_cpus_list (thread_siblings_list on older kernels).
+static int read_core(int cpu) {
+    bool siblings[CPU_TOPOLOGY_MAX_CPUS] = { false };
+    char path[128];
+    snprintf(path, sizeof(path), CPU_SYSFS "/cpu%d/topology/core_cpus_list", cpu);
+    if (read_cpu_list(path, siblings) != 0) {
+        snprintf(path, sizeof(path), CPU_SYSFS "/cpu%d/topology/thread_siblings_list", cpu);
+        if (read_cpu_list(path, siblings) != 0) return cpu;
+    }
+    
+    for (int sibling = 0; sibling < CPU_TOPOLOGY_MAX_CPUS; sibling++) {
+        if (siblings[sibling]) return sibling;
+    }
+    return cpu;
+}
+
+cpu_topology_t* cpu_topology_create(void) {
+    cpu_topology_t *topo = (cpu_topology_t*)calloc(1, sizeof(cpu_topology_t));
+    if (!topo) return NULL;
+    
+    bool online[CPU_TOPOLOGY_MAX_CPUS] = { false };
+    if (read_cpu_list(CPU_SYSFS "/online", online) != 0) {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = 0; cpu < count && cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+            online[cpu] = true;
+        }
+    }
+    
+    cpu_set_t allowed;
+    bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    
+    for (int cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+        if (!online[cpu] || (have_mask && !CPU_ISSET(cpu, &allowed))) continue;
+        
+        char path[128];
+        cpu_info_t *info = &topo->cpus[topo->num_cpus];
+        info->cpu = cpu;
+        info->core = read_core(cpu);
+        snprintf(path, sizeof(path), CPU_SYSFS "/cpu%d/topology/physical_package_id", cpu);
+        info->package = read_int(path, 0);
+        
+        info->primary = true;
+        for (size_t i = 0; i < topo->num_cpus; i++) {
+            if (topo->cpus[i].core == info->core) {
+                info->primary = false;
+                break;
+            }
+        }
+        if (info->primary) topo->num_cores++;
+        topo->num_cpus++;
+    }
+    
+    if (topo->num_cpus == 0) {
+        free(topo);
+        return NULL;
+    }
+    return topo;
+}
+#else
+cpu_topology_t* cpu_topology_create(void) {
+    return NULL;
+}
+#endif
+
+void cpu_topology_destroy(cpu_topology_t *topo) {
+    free(topo);
+}
+
+void cpu_placement_config_init(cpu_placement_config_t *config) {
+    if (!config) return;
+    
+    config->pin = false;
+    config->workload = CPU_WORKLOAD_DEFAULT;
+    config->core_budget = 0;
+    config->reserved_cores = 0;
+    config->use_smt = false;
+}
+
+const char* cpu_workload_name(cpu_workload_t workload) {
+    switch (workload) {
+        case CPU_WORKLOAD_LATENCY: return "latency";
+        case CPU_WORKLOAD_THROUGHPUT: return "throughput";
+        default: return "default";
+    }
+}
+
+int cpu_workload_parse(const char *name, cpu_workload_t *workload) {
+    if (!name || !workload) return -1;
+    
+    if (strcmp(name, "latency") == 0) {
+        *workload = CPU_WORKLOAD_LATENCY;
+    } else if (strcmp(name, "throughput") == 0) {
+        *workload = CPU_WORKLOAD_THROUGHPUT;
+    } else if (strcmp(name, "default") == 0) {
+        *workload = CPU_WORKLOAD_DEFAULT;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Appends the CPUs of the core whose primary thread is topo->cpus[primary]:
+// all of them, or only the SMT siblings
+static void add_core_cpus(const cpu_topology_t *topo, size_t primary, bool siblings_only,
+                          int *cpus, size_t *count) {
+    const cpu_info_t *core = &topo->cpus[primary];
+    for (size_t i = 0; i < topo->num_cpus; i++) {
+        const cpu_info_t *info = &topo->cpus[i];
+        if (info->core != core->core) continue;
+        if (!info->primary || !siblings_only) {
+            cpus[(*count)++] = info->cpu;
+        }
+    }
+}
+
+cpu_plan_t* cpu_plan_create(const cpu_topology_t *topo, const cpu_placement_config_t *config,
+                            size_t num_threads, size_t python_workers) {
+    if (!topo || !config || topo->num_cores == 0) return NULL;
+    
+    cpu_plan_t *plan = (cpu_plan_t*)calloc(1, sizeof(cpu_plan_t));
+    if (!plan) return NULL;
+    
+    size_t budget = topo->num_cores;
+    if (config->core_budget > 0 && config->core_budget < budget) {
+        budget = config->core_budget;
+    }
+    // At least one core is always left for inference
+    size_t reserved = config->reserved_cores < budget ? config->reserved_cores : budget - 1;
+    plan->pin = config->pin;
+    plan->budget_cores = budget;
+    plan->reserved_cores = reserved;
+    
+    // Cores in topology order: reserved ones first, then inference
+    size_t core_index = 0;
+    for (size_t i = 0; i < topo->num_cpus && core_index < budget; i++) {
+        if (!topo->cpus[i].primary) continue;
+        if (core_index < reserved) {
+            add_core_cpus(topo, i, false, plan->service_cpus, &plan->num_service_cpus);
+        } else {
+            plan->inference_core[plan->num_inference_cpus] = plan->num_inference_cpus;
+            plan->inference_cpus[plan->num_inference_cpus++] = topo->cpus[i].cpu;
+        }
+        core_index++;
+    }
+    plan->num_inference_cores = plan->num_inference_cpus;
+    if (config->use_smt) {
+        core_index = 0;
+        for (size_t i = 0; i < topo->num_cpus && core_index < budget; i++) {
+            if (!topo->cpus[i].primary) continue;
+            if (core_index++ < reserved) continue;
+            size_t first = plan->num_inference_cpus;
+            add_core_cpus(topo, i, true, plan->inference_cpus, &plan->num_inference_cpus);
+            for (size_t j = first; j < plan->num_inference_cpus; j++) {
+                plan->inference_core[j] = core_index - reserved - 1;
+            }
+        }
+    }
+    
+    size_t cores = plan->num_inference_cores;
+    size_t lanes;
+    switch (config->workload) {
+        case CPU_WORKLOAD_LATENCY:
+            // Sessions get whole cores; siblings would only slow intra-op work
+            lanes = cores / CPU_LATENCY_CORES_PER_SESSION;
+            if (lanes == 0) lanes = 1;
+            plan->intra_op_threads = cores / lanes;
+            plan->workers = lanes;
+            plan->python_workers = python_workers > 0 ? lanes : 0;
+            break;
+        case CPU_WORKLOAD_THROUGHPUT:
+            lanes = plan->num_inference_cpus;
+            plan->intra_op_threads = 1;
+            plan->workers = lanes;
+            plan->python_workers = python_workers > 0 ? lanes : 0;
+            break;
+        default:
+            plan->workers = num_threads;
+            plan->python_workers = python_workers;
+            plan->intra_op_threads = python_workers > 0 && cores > python_workers
+                                   ? cores / python_workers : 1;
+            break;
+    }
+    
+    return plan;
+}
+
+void cpu_plan_destroy(cpu_plan_t *plan) {
+    free(plan);
+}
+
+size_t cpu_plan_worker_cpus(const cpu_plan_t *plan, size_t index, int *cpus) {
+    if (!plan || plan->num_inference_cpus == 0) return 0;
+    
+    if (plan->python_workers > 0) {
+        memcpy(cpus, plan->inference_cpus, plan->num_inference_cpus * sizeof(int));
+        return plan->num_inference_cpus;
+    }
+    cpus[0] = plan->inference_cpus[index % plan->num_inference_cpus];
+    return 1;
+}
+
+size_t cpu_plan_python_cpus(const cpu_plan_t *plan, size_t index, int *cpus) {
+    if (!plan || plan->num_inference_cores == 0) return 0;
+    
+    if (plan->intra_op_threads <= 1) {
+        cpus[0] = plan->inference_cpus[index % plan->num_inference_cpus];
+        return 1;
+    }
+    
+    // A run of intra_op_threads cores, wrapping when sessions outnumber them
+    size_t cores = plan->num_inference_cores;
+    size_t slice = plan->intra_op_threads < cores ? plan->intra_op_threads : cores;
+    size_t first = (index * slice) % cores;
+    size_t count = 0;
+    for (size_t i = 0; i < plan->num_inference_cpus; i++) {
+        if ((plan->inference_core[i] + cores - first) % cores < slice) {
+            cpus[count++] = plan->inference_cpus[i];
+        }
+    }
+    return count;
+}
+
+#ifdef __linux__
+static int pin_thread(pthread_t thread, const int *cpus, size_t count) {
+    if (count == 0) return 0;
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < count; i++) {
+        CPU_SET(cpus[i], &set);
+    }
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+int cpu_pin_process(const int *cpus, size_t count) {
+    if (count == 0) return 0;
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < count; i++) {
+        CPU_SET(cpus[i], &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0 ? 0 : -1;
+}
+#else
+static int pin_thread(pthread_t thread, const int *cpus, size_t count) {
+    (void)thread;
+    (void)cpus;
+    return count == 0 ? 0 : -1;
+}
+
+int cpu_pin_process(const int *cpus, size_t count) {
+    (void)cpus;
+    return count == 0 ? 0 : -1;
+}
+#endif
+
+int cpu_plan_pin_worker(const cpu_plan_t *plan, size_t index, pthread_t thread) {
+    if (!plan || !plan->pin) return 0;
+    
+    int cpus[CPU_TOPOLOGY_MAX_CPUS];
+    size_t count = cpu_plan_worker_cpus(plan, index, cpus);
+    return pin_thread(thread, cpus, count);
+}
+
+int cpu_plan_pin_service(const cpu_plan_t *plan, pthread_t thread) {
+    if (!plan || !plan->pin) return 0;
+    return pin_thread(thread, plan->service_cpus, plan->num_service_cpus);
+}
+
+static void print_cpus(const int *cpus, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        printf("%s%d", i ? "," : "", cpus[i]);
+    }
+}
+
+void cpu_plan_print(const cpu_plan_t *plan) {
+    if (!plan) return;
+    
+    printf("CPU plan: %zu cores (%zu reserved), %zu workers", plan->budget_cores,
+           plan->reserved_cores, plan->workers);
+    if (plan->python_workers > 0) {
+        printf(", %zu Python workers x %zu intra-op threads", plan->python_workers,
+               plan->intra_op_threads);
+    }
+    printf("%s\n", plan->pin ? ", pinned" : "");
+    if (plan->pin) {
+        printf("  inference CPUs ");
+        print_cpus(plan->inference_cpus, plan->num_inference_cpus);
+        if (plan->num_service_cpus > 0) {
+            printf(", service CPUs ");
+            print_cpus(plan->service_cpus, plan->num_service_cpus);
+        }
+        printf("\n");
+    }
+}
+
@@ -0,0 +1,88 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CPU_TOPOLOGY_MAX_CPUS 1024          // CPU_SETSIZE
+#define CPU_LATENCY_CORES_PER_SESSION 4     // intra-op cores per session when latency-bound
+
+typedef struct {
+    int cpu;                    // logical CPU number
+    int core;                   // lowest-numbered CPU on the same core
+    int package;
+    bool primary;               // lowest-numbered thread of its core
+} cpu_info_t;
+
+// CPUs this process may run on, ordered by number; read from
+// /sys/devices/system/cpu and the process affinity mask
+typedef struct {
+    cpu_info_t cpus[CPU_TOPOLOGY_MAX_CPUS];
+    size_t num_cpus;
+    size_t num_cores;           // physical cores among them
+} cpu_topology_t;
+
+typedef enum {
+    CPU_WORKLOAD_DEFAULT = 0,   // keep the configured thread counts
+    CPU_WORKLOAD_LATENCY,       // few sessions, several intra-op threads each
+    CPU_WORKLOAD_THROUGHPUT     // one single-threaded session per core
+} cpu_workload_t;
+
+typedef struct {
+    bool pin;                   // pin threads and Python workers to their cores
+    cpu_workload_t workload;
+    size_t core_budget;         // physical cores shared by everything, 0 = all usable
+    size_t reserved_cores;      // of the budget, kept for ingest, monitor and metrics threads
+    bool use_smt;               // inference may use SMT siblings as well
+} cpu_placement_config_t;
+
+// How the core budget is split. Cores are taken in topology order: the
+// first reserved_cores go to service threads, the rest to inference.
+// Inference CPUs list every inference core's primary thread, then (with
+// use_smt) the siblings.
+typedef struct {
+    bool pin;
+    size_t workers;             // orchestrator worker threads
+    size_t python_workers;      // 0 when inference is simulated
+    size_t intra_op_threads;    // per ONNX Runtime session
+    size_t budget_cores;
+    size_t reserved_cores;
+    int service_cpus[CPU_TOPOLOGY_MAX_CPUS];
+    size_t num_service_cpus;    // 0: service threads stay unpinned
+    int inference_cpus[CPU_TOPOLOGY_MAX_CPUS];
+    size_t inference_core[CPU_TOPOLOGY_MAX_CPUS];   // core index of each inference CPU
+    size_t num_inference_cpus;
+    size_t num_inference_cores; // primary threads at the front of inference_cpus
+} cpu_plan_t;
+
+cpu_topology_t* cpu_topology_create(void);
+void cpu_topology_destroy(cpu_topology_t *topo);
+void cpu_placement_config_init(cpu_placement_config_t *config);
+const char* cpu_workload_name(cpu_workload_t workload);
+// -1 for an unknown name
+int cpu_workload_parse(const char *name, cpu_workload_t *workload);
+
+// Splits the budget between workers and intra-op threads. num_threads
+// and python_workers are the configured counts, used as they are for
+// CPU_WORKLOAD_DEFAULT.
+cpu_plan_t* cpu_plan_create(const cpu_topology_t *topo, const cpu_placement_config_t *config,
+                            size_t num_threads, size_t python_workers);
+void cpu_plan_destroy(cpu_plan_t *plan);
+// CPUs for worker index: one CPU when inference is simulated, the whole
+// inference set when workers only dispatch to Python. Returns the count.
+size_t cpu_plan_worker_cpus(const cpu_plan_t *plan, size_t index, int *cpus);
+// CPUs for Python worker index: its slice of intra_op_threads cores,
+// plus their siblings with use_smt
+size_t cpu_plan_python_cpus(const cpu_plan_t *plan, size_t index, int *cpus);
+
+// No-ops returning 0 when plan is NULL or not pinning; -1 on failure or
+// where affinity is unsupported
+int cpu_plan_pin_worker(const cpu_plan_t *plan, size_t index, pthread_t thread);
+int cpu_plan_pin_service(const cpu_plan_t *plan, pthread_t thread);
+// Pins the calling process; only a syscall, so safe between fork and exec
+int cpu_pin_process(const int *cpus, size_t count);
+void cpu_plan_print(const cpu_plan_t *plan);
+
+#endif // CPU_TOPOLOGY_H
+
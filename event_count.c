@@ -0,0 +1,149 @@
+#define _GNU_SOURCE
+#include "event_count.h"
+#include <limits.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static void futex_wait(_Atomic uint32_t *addr, uint32_t expected) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wait_timeout(_Atomic uint32_t *addr, uint32_t expected,
+                               const struct timespec *timeout) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *addr, int count) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+#endif
+
+int event_count_init(event_count_t *ec) {
+    if (!ec) return -1;
+    
+    atomic_init(&ec->epoch, 0);
+    atomic_init(&ec->waiters, 0);
+    
+#ifndef __linux__
+    if (pthread_mutex_init(&ec->mutex, NULL) != 0) {
+        return -1;
+    }
+    if (pthread_cond_init(&ec->cond, NULL) != 0) {
+        pthread_mutex_destroy(&ec->mutex);
+        return -1;
+    }
+#endif
+    
+    return 0;
+}
+
+void event_count_destroy(event_count_t *ec) {
+    if (!ec) return;
+    
+#ifndef __linux__
+    pthread_mutex_destroy(&ec->mutex);
+    pthread_cond_destroy(&ec->cond);
+#endif
+}
+
+uint32_t event_count_prepare(event_count_t *ec) {
+    atomic_fetch_add(&ec->waiters, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    return atomic_load(&ec->epoch);
+}
+
+void event_count_cancel(event_count_t *ec) {
+    atomic_fetch_sub(&ec->waiters, 1);
+}
+
+void event_count_wait(event_count_t *ec, uint32_t key) {
+#ifdef __linux__
+    // The kernel re-checks the epoch, so a notify racing with us is never lost
+    while (atomic_load(&ec->epoch) == key) {
+        futex_wait(&ec->epoch, key);
+    }
+#else
+    pthread_mutex_lock(&ec->mutex);
+    while (atomic_load(&ec->epoch) == key) {
+        pthread_cond_wait(&ec->cond, &ec->mutex);
+    }
+    pthread_mutex_unlock(&ec->mutex);
+#endif
+    
+    atomic_fetch_sub(&ec->waiters, 1);
+}
+
+bool event_count_wait_timeout(event_count_t *ec, uint32_t key, uint64_t timeout_ns) {
+    struct timespec now;
+#ifdef __linux__
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t deadline = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec + timeout_ns;
+    
+    while (atomic_load(&ec->epoch) == key) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+        if (now_ns >= deadline) break;
+        
+        // FUTEX_WAIT takes a relative timeout
+        uint64_t left = deadline - now_ns;
+        struct timespec timeout = {
+            .tv_sec = (time_t)(left / 1000000000ULL),
+            .tv_nsec = (long)(left % 1000000000ULL)
+        };
+        futex_wait_timeout(&ec->epoch, key, &timeout);
+    }
+#else
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t abs_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec + timeout_ns;
+    struct timespec deadline = {
+        .tv_sec = (time_t)(abs_ns / 1000000000ULL),
+        .tv_nsec = (long)(abs_ns % 1000000000ULL)
+    };
+    
+    pthread_mutex_lock(&ec->mutex);
+    while (atomic_load(&ec->epoch) == key) {
+        if (pthread_cond_timedwait(&ec->cond, &ec->mutex, &deadline) != 0) break;
+    }
+    pthread_mutex_unlock(&ec->mutex);
+#endif
+    
+    atomic_fetch_sub(&ec->waiters, 1);
+    return atomic_load(&ec->epoch) != key;
+}
+
+static void notify(event_count_t *ec, int count) {
+    // Pairs with the fence in event_count_prepare(): either the waiter sees
+    // the caller's state change on its re-check, or we see the waiter here.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&ec->waiters) == 0) return;
+    
+#ifdef __linux__
+    atomic_fetch_add(&ec->epoch, 1);
+    futex_wake(&ec->epoch, count);
+#else
+    pthread_mutex_lock(&ec->mutex);
+    atomic_fetch_add(&ec->epoch, 1);
+    if (count == 1) {
+        pthread_cond_signal(&ec->cond);
+    } else {
+        pthread_cond_broadcast(&ec->cond);
+    }
+    pthread_mutex_unlock(&ec->mutex);
+#endif
+}
+
+void event_count_notify_one(event_count_t *ec) {
+    notify(ec, 1);
+}
+
+void event_count_notify_all(event_count_t *ec) {
+    notify(ec, INT_MAX);
+}
+
+void event_count_notify_many(event_count_t *ec, int count) {
+    if (count > 0) notify(ec, count);
+}
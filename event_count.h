@@ -0,0 +1,35 @@
+#ifndef EVENT_COUNT_H
+#define EVENT_COUNT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// Event count used to park idle threads without holding a lock.
+// Waiters call event_count_prepare(), re-check their condition, then
+// event_count_wait() with the returned key. Notifiers only enter the
+// kernel when someone is actually parked. On Linux waiters sleep on a
+// futex; elsewhere a mutex/condvar pair stands in for it.
+typedef struct {
+    _Atomic uint32_t epoch;
+    _Atomic uint32_t waiters;
+#ifndef __linux__
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+} event_count_t;
+
+int event_count_init(event_count_t *ec);
+void event_count_destroy(event_count_t *ec);
+uint32_t event_count_prepare(event_count_t *ec);
+void event_count_cancel(event_count_t *ec);
+void event_count_wait(event_count_t *ec, uint32_t key);
+// Like event_count_wait() but gives up after timeout_ns; false on timeout
+bool event_count_wait_timeout(event_count_t *ec, uint32_t key, uint64_t timeout_ns);
+void event_count_notify_one(event_count_t *ec);
+void event_count_notify_all(event_count_t *ec);
+// Wakes up to count waiters
+void event_count_notify_many(event_count_t *ec, int count);
+
+#endif // EVENT_COUNT_H
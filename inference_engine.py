@@ -6,23 +6,193 @@ Handles model loading, inference execution, and result processing
 
 import sys
 import json
+import signal
+import argparse
 import numpy as np
 import onnxruntime as ort
-from typing import Dict, Any, Optional
+from typing import Dict, Any, List, Optional
 import os
 import time
+import threading
+from collections import OrderedDict
+from concurrent.futures import Future, ThreadPoolExecutor
+
+from communication import ShmRing
+from tensor_codec import FRAME_HEADER, decode_frame, encode_frame, is_frame
+
+
+class LoadedModel:
+    """A warm ONNX Runtime session and what it costs to keep around"""
+    
+    def __init__(self, model_path: str, session: 'ort.InferenceSession', size_bytes: int):
+        self.model_path = model_path
+        self.session = session
+        self.input_name = session.get_inputs()[0].name
+        self.output_name = session.get_outputs()[0].name
+        self.size_bytes = size_bytes
+
+
+def resident_bytes() -> int:
+    """Resident set size of this process, 0 where /proc is unavailable"""
+    try:
+        with open('/proc/self/statm') as statm:
+            return int(statm.read().split()[1]) * os.sysconf('SC_PAGE_SIZE')
+    except (OSError, ValueError, IndexError):
+        return 0
+
+
+class ModelRegistry:
+    """
+    Keeps several inference sessions warm, keyed by model path
+    
+    Sessions load on a background thread the first time a model is
+    requested. Once the resident size of all sessions exceeds the budget,
+    the least recently used ones are evicted.
+    """
+    
+    def __init__(self, budget_bytes: int = 0, intra_op_threads: int = 1):
+        """
+        Initialize the registry
+        
+        Args:
+            budget_bytes: Memory allowed for warm sessions (0 = unlimited)
+            intra_op_threads: ONNX Runtime threads per session, from the
+                orchestrator's core budget
+        """
+        self.budget_bytes = budget_bytes
+        self.intra_op_threads = max(1, intra_op_threads)
+        self.models: 'OrderedDict[str, LoadedModel]' = OrderedDict()  # LRU first
+        self.loading: Dict[str, Future] = {}
+        self.lock = threading.Lock()
+        self.executor = ThreadPoolExecutor(max_workers=1, thread_name_prefix='model-loader')
+        self.hits = 0
+        self.loads = 0
+        self.evictions = 0
+    
+    def prefetch(self, model_path: str) -> Future:
+        """
+        Start loading a model in the background unless it is warm or loading
+        
+        Returns:
+            Future resolving to the LoadedModel
+        """
+        with self.lock:
+            model = self.models.get(model_path)
+            if model is not None:
+                future = Future()
+                future.set_result(model)
+                return future
+            
+            future = self.loading.get(model_path)
+            if future is None:
+                future = self.executor.submit(self._load, model_path)
+                self.loading[model_path] = future
+            return future
+    
+    def get(self, model_path: str) -> Optional[LoadedModel]:
+        """
+        Return the session for a model, waiting for it to load if needed
+        
+        Returns:
+            LoadedModel, or None if the model failed to load
+        """
+        with self.lock:
+            model = self.models.get(model_path)
+            if model is not None:
+                self.models.move_to_end(model_path)
+                self.hits += 1
+                return model
+        
+        try:
+            return self.prefetch(model_path).result()
+        except Exception as e:
+            print(f"Error loading model: {e}", file=sys.stderr)
+            return None
+    
+    def _load(self, model_path: str) -> LoadedModel:
+        try:
+            if not os.path.exists(model_path):
+                raise FileNotFoundError(f"Model file not found: {model_path}")
+            
+            sess_options = ort.SessionOptions()
+            sess_options.intra_op_num_threads = self.intra_op_threads
+            sess_options.inter_op_num_threads = 1
+            
+            # RSS growth is the real cost; the file size stands in when
+            # concurrent activity makes the delta meaningless
+            before = resident_bytes()
+            session = ort.InferenceSession(
+                model_path,
+                sess_options=sess_options,
+                providers=['CPUExecutionProvider']
+            )
+            size_bytes = resident_bytes() - before
+            if size_bytes <= 0:
+                size_bytes = os.path.getsize(model_path)
+            
+            model = LoadedModel(model_path, session, size_bytes)
+            with self.lock:
+                self.models[model_path] = model
+                self.loads += 1
+                self._evict_locked(keep=model_path)
+            
+            print(f"Model loaded successfully: {model_path} "
+                  f"({size_bytes / (1024 * 1024):.1f} MiB)", file=sys.stderr)
+            return model
+        finally:
+            with self.lock:
+                self.loading.pop(model_path, None)
+    
+    def _evict_locked(self, keep: str):
+        if self.budget_bytes <= 0:
+            return
+        
+        while self.resident_size() > self.budget_bytes and len(self.models) > 1:
+            model_path = next(iter(self.models))
+            if model_path == keep:
+                self.models.move_to_end(model_path)
+                continue
+            
+            del self.models[model_path]
+            self.evictions += 1
+            print(f"Evicted model: {model_path}", file=sys.stderr)
+    
+    def resident_size(self) -> int:
+        """Bytes attributed to warm sessions"""
+        return sum(model.size_bytes for model in self.models.values())
+    
+    def get_stats(self) -> Dict[str, Any]:
+        """Warm models, hit/load/eviction counts and resident bytes"""
+        with self.lock:
+            return {
+                'models': list(self.models),
+                'hits': self.hits,
+                'loads': self.loads,
+                'evictions': self.evictions,
+                'resident_bytes': self.resident_size()
+            }
+    
+    def close(self):
+        """Stop the loader thread and drop every session"""
+        self.executor.shutdown(wait=True)
+        with self.lock:
+            self.models.clear()
 
 
 class InferenceEngine:
     """Manages AI model loading and inference execution"""
     
-    def __init__(self, model_path: Optional[str] = None):
+    def __init__(self, model_path: Optional[str] = None,
+                 registry: Optional[ModelRegistry] = None):
         """
         Initialize the inference engine
         
         Args:
             model_path: Path to ONNX model file (optional, can load later)
+            registry: Registry of warm sessions to draw from (a private,
+                      unbounded one if omitted)
         """
+        self.registry = registry if registry is not None else ModelRegistry()
         self.model_path = model_path
         self.session = None
         self.input_name = None
@@ -34,7 +204,10 @@ class InferenceEngine:
     
     def load_model(self, model_path: str) -> bool:
         """
-        Load an ONNX model
+        Make a model the active one, loading it unless it is already warm
+        
+        Previously loaded models stay in the registry, so switching back
+        to them is cheap.
         
         Args:
             model_path: Path to ONNX model file
@@ -42,36 +215,19 @@ class InferenceEngine:
         Returns:
             True if model loaded successfully, False otherwise
         """
-        try:
-            if not os.path.exists(model_path):
-                print(f"Error: Model file not found: {model_path}", file=sys.stderr)
-                return False
-            
-            # Create ONNX Runtime session
-            sess_options = ort.SessionOptions()
-            sess_options.intra_op_num_threads = 1
-            sess_options.inter_op_num_threads = 1
-            
-            self.session = ort.InferenceSession(
-                model_path,
-                sess_options=sess_options,
-                providers=['CPUExecutionProvider']
-            )
-            
-            # Get input/output names
-            self.input_name = self.session.get_inputs()[0].name
-            self.output_name = self.session.get_outputs()[0].name
-            
-            self.model_path = model_path
-            self.model_loaded = True
-            
-            print(f"Model loaded successfully: {model_path}")
-            return True
-            
-        except Exception as e:
-            print(f"Error loading model: {e}", file=sys.stderr)
+        # Always go through the registry, even for the active model, so it
+        # counts as a hit and stays most recently used
+        model = self.registry.get(model_path)
+        if model is None:
             self.model_loaded = False
             return False
+        
+        self.session = model.session
+        self.input_name = model.input_name
+        self.output_name = model.output_name
+        self.model_path = model_path
+        self.model_loaded = True
+        return True
     
     def create_dummy_input(self, shape: tuple) -> np.ndarray:
         """
@@ -116,6 +272,38 @@ class InferenceEngine:
             print(f"Error during inference: {e}", file=sys.stderr)
             return None
     
+    def run_batch(self, inputs: List[Optional[np.ndarray]]) -> Optional[List[np.ndarray]]:
+        """
+        Run one inference over several inputs stacked along the batch axis
+        
+        Args:
+            inputs: Input tensors of identical shape (None entries get
+                    dummy input)
+            
+        Returns:
+            One output tensor per input, or None if the batched run failed
+        """
+        if not self.model_loaded or self.session is None:
+            print("Error: Model not loaded", file=sys.stderr)
+            return None
+        
+        try:
+            input_shape = self.session.get_inputs()[0].shape
+            input_shape = tuple([1 if dim is None or not isinstance(dim, int) or dim < 0 else dim
+                                 for dim in input_shape])
+            inputs = [self.create_dummy_input(input_shape) if x is None else x for x in inputs]
+            
+            # Each input already carries its own batch dimension
+            sizes = [x.shape[0] for x in inputs]
+            batch = np.concatenate(inputs, axis=0)
+            output = self.session.run([self.output_name], {self.input_name: batch})[0]
+            
+            return np.split(output, np.cumsum(sizes)[:-1], axis=0)
+            
+        except Exception as e:
+            print(f"Error during batched inference: {e}", file=sys.stderr)
+            return None
+    
     def process_task(self, task_data: Dict[str, Any]) -> Dict[str, Any]:
         """
         Process a task from the orchestrator
@@ -124,7 +312,7 @@ class InferenceEngine:
             task_data: Task data dictionary containing task information
             
         Returns:
-            Result dictionary with inference output
+            Result dictionary with the full output tensor under 'output'
         """
         start_time = time.time()
         
@@ -146,23 +334,209 @@ class InferenceEngine:
             'status': 'completed' if output is not None else 'failed',
             'inference_time': inference_time,
             'output_shape': list(output.shape) if output is not None else None,
-            'output_sample': output.flatten()[:10].tolist() if output is not None else None
+            'output': output
         }
         
         return result
+    
+    def process_batch(self, tasks: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
+        """
+        Process compatible tasks with a single batched inference
+        
+        Falls back to one inference per task if the model cannot take the
+        stacked batch (e.g. a fixed batch dimension).
+        
+        Args:
+            tasks: Task data dictionaries with inputs of identical shape
+            
+        Returns:
+            One result dictionary per task, in order
+        """
+        start_time = time.time()
+        
+        inputs = []
+        for task_data in tasks:
+            input_data = task_data.get('input_data', None)
+            if input_data is not None and isinstance(input_data, list):
+                input_data = np.array(input_data, dtype=np.float32)
+            inputs.append(input_data)
+        
+        outputs = self.run_batch(inputs) if len(tasks) > 1 else None
+        if outputs is None:
+            return [self.process_task(task_data) for task_data in tasks]
+        
+        inference_time = time.time() - start_time
+        
+        return [{
+            'task_id': task_data.get('task_id', 'unknown'),
+            'status': 'completed',
+            'inference_time': inference_time,
+            'batch_size': len(tasks),
+            'output_shape': list(output.shape),
+            'output': output
+        } for task_data, output in zip(tasks, outputs)]
+
+
+def result_to_json(result: Dict[str, Any]) -> str:
+    """Serialize a result dictionary, expanding the output tensor to lists"""
+    result = dict(result)
+    if isinstance(result.get('output'), np.ndarray):
+        result['output'] = result['output'].tolist()
+    return json.dumps(result)
+
+
+def encode_result(result: Dict[str, Any], binary: bool) -> bytes:
+    """Encode a result the way its task arrived: tensor frame or JSON"""
+    status = 0 if result.get('status') == 'completed' else 1
+    if binary:
+        return encode_frame(result.get('task_id', 'unknown'), result.get('output'), status)
+    return result_to_json(result).encode('utf-8')
+
+
+def decode_task(task_id: str, payload: memoryview) -> Dict[str, Any]:
+    """
+    Turn a ring payload into a task dictionary
+    
+    Tensor frames become a zero-copy array over the payload, JSON objects
+    are used as-is; anything else is passed through as an opaque
+    description with the model's default input.
+    """
+    if is_frame(payload):
+        frame_task_id, _status, array = decode_frame(payload)
+        return {'task_id': frame_task_id or task_id, 'input_data': array, 'binary': True}
+    
+    raw = bytes(payload).rstrip(b'\0')
+    try:
+        task_data = json.loads(raw)
+        if isinstance(task_data, dict):
+            task_data.setdefault('task_id', task_id)
+            return task_data
+    except (ValueError, UnicodeDecodeError):
+        pass
+    return {'task_id': task_id, 'input_data': None}
+
+
+def run_worker(argv) -> int:
+    """
+    Long-lived worker mode, spawned by the orchestrator's Python worker pool
+    
+    Models are loaded once and kept warm in a budgeted registry; requests
+    arrive through the shared memory ring until the orchestrator
+    terminates us.
+    """
+    parser = argparse.ArgumentParser(prog='inference_engine.py --worker')
+    parser.add_argument('--worker', action='store_true')
+    parser.add_argument('--shm', required=True)
+    parser.add_argument('--sub-fd', type=int, required=True)
+    parser.add_argument('--comp-fd', type=int, required=True)
+    parser.add_argument('--model')
+    parser.add_argument('--model-budget-mb', type=int, default=0)
+    parser.add_argument('--intra-op-threads', type=int, default=1)
+    args = parser.parse_args(argv)
+    
+    # Ctrl-C reaches the whole process group; the orchestrator decides
+    # when workers stop
+    signal.signal(signal.SIGINT, signal.SIG_IGN)
+    
+    registry = ModelRegistry(args.model_budget_mb * 1024 * 1024, args.intra_op_threads)
+    engine = InferenceEngine(registry=registry)
+    if args.model and not engine.load_model(args.model):
+        print("Worker running in mock mode (model failed to load)", file=sys.stderr)
+    
+    ring = ShmRing(args.shm, args.sub_fd, args.comp_fd)
+    parent = os.getppid()
+    
+    while True:
+        request = ring.next_submission(timeout_ms=1000)
+        if request is None:
+            if os.getppid() != parent:
+                break  # Orchestrator died without stopping us
+            continue
+        
+        # Binary inputs stay views into the ring slot, so the slot is only
+        # handed back once the results have been encoded
+        request_id, model_path, records, batched = request
+        tasks = [decode_task(task_id, payload) for task_id, payload in records]
+        del records
+        
+        # Overlap loads for queued requests with this one's inference
+        for queued in ring.queued_models():
+            if queued:
+                engine.registry.prefetch(queued)
+        
+        model_path = model_path or args.model
+        if model_path and not engine.load_model(model_path):
+            print(f"Model {model_path} unavailable, running in mock mode", file=sys.stderr)
+        
+        try:
+            results = engine.process_batch(tasks)
+        except Exception as e:
+            results = [{'task_id': task['task_id'], 'status': 'failed', 'error': str(e)}
+                       for task in tasks]
+        
+        replies = [(0 if result.get('status') == 'completed' else 1,
+                    encode_result(result, task.get('binary', False)))
+                   for task, result in zip(tasks, results)]
+        del tasks, results
+        ring.release_submission()
+        
+        if batched:
+            ring.post_batch_completion(request_id, replies)
+        else:
+            ring.post_completion(request_id, *replies[0])
+    
+    ring.close()
+    engine.registry.close()
+    return 0
+
+
+def run_binary(engine: InferenceEngine) -> int:
+    """
+    Binary stdin/stdout mode: tensor frames in, tensor frames out
+    
+    Each input frame is answered with one frame holding the full output
+    tensor and a nonzero status on failure.
+    """
+    stdin = sys.stdin.buffer
+    stdout = sys.stdout.buffer
+    
+    while True:
+        header = stdin.read(FRAME_HEADER.size)
+        if not header:
+            return 0
+        if len(header) < FRAME_HEADER.size or not is_frame(header):
+            print("Error: Malformed tensor frame", file=sys.stderr)
+            return 1
+        
+        byte_length = FRAME_HEADER.unpack(header)[-1]
+        frame = header + stdin.read(byte_length)
+        task_id, _status, array = decode_frame(frame)
+        
+        result = engine.process_task({'task_id': task_id, 'input_data': array})
+        stdout.write(encode_result(result, binary=True))
+        stdout.flush()
 
 
 def main():
     """Main entry point for inference engine"""
+    if '--worker' in sys.argv[1:]:
+        sys.exit(run_worker(sys.argv[1:]))
+    
+    binary = '--binary' in sys.argv[1:]
+    args = [arg for arg in sys.argv[1:] if arg != '--binary']
+    
     engine = InferenceEngine()
     
     # For testing without a model, create a simple mock inference
-    if len(sys.argv) > 1:
-        model_path = sys.argv[1]
+    if args:
+        model_path = args[0]
         if not engine.load_model(model_path):
-            print("Running in mock mode (no model loaded)")
+            print("Running in mock mode (no model loaded)", file=sys.stderr)
     else:
-        print("Running in mock mode (no model provided)")
+        print("Running in mock mode (no model provided)", file=sys.stderr)
+    
+    if binary:
+        sys.exit(run_binary(engine))
     
     # Read task from stdin (JSON format)
     try:
@@ -170,7 +544,7 @@ def main():
         if line:
             task_data = json.loads(line.strip())
             result = engine.process_task(task_data)
-            print(json.dumps(result))
+            print(result_to_json(result))
         else:
             # Run a test inference
             test_task = {
@@ -178,7 +552,7 @@ def main():
                 'input_data': None
             }
             result = engine.process_task(test_task)
-            print(json.dumps(result))
+            print(result_to_json(result))
     except json.JSONDecodeError as e:
         print(f"Error parsing JSON: {e}", file=sys.stderr)
         sys.exit(1)
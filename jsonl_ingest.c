@@ -0,0 +1,462 @@
+#define _GNU_SOURCE
+#include "jsonl_ingest.h"
+#include "payload_arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define JSON_MAX_DEPTH 32
+
+typedef struct {
+    orchestrator_t *orch;
+    bool wait_for_room;
+    payload_arena_t *arena;
+    jsonl_ingest_stats_t *stats;
+    // Lines parsed since the last submission; data points into the input
+    task_submission_t batch[ADMISSION_BATCH_MAX];
+    char ids[ADMISSION_BATCH_MAX][MAX_TASK_ID_LEN];
+    size_t count;
+    bool stopped;               // the orchestrator went away mid-stream
+} ingest_t;
+
+static char* skip_space(char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    return p;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool parse_hex4(const char *p, const char *end, uint32_t *value) {
+    if (end - p < 4) return false;
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_value(p[i]);
+        if (digit < 0) return false;
+        *value = (*value << 4) | (uint32_t)digit;
+    }
+    return true;
+}
+
+static char* put_utf8(char *w, uint32_t code) {
+    if (code < 0x80) {
+        *w++ = (char)code;
+    } else if (code < 0x800) {
+        *w++ = (char)(0xC0 | (code >> 6));
+        *w++ = (char)(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        *w++ = (char)(0xE0 | (code >> 12));
+        *w++ = (char)(0x80 | ((code >> 6) & 0x3F));
+        *w++ = (char)(0x80 | (code & 0x3F));
+    } else {
+        *w++ = (char)(0xF0 | (code >> 18));
+        *w++ = (char)(0x80 | ((code >> 12) & 0x3F));
+        *w++ = (char)(0x80 | ((code >> 6) & 0x3F));
+        *w++ = (char)(0x80 | (code & 0x3F));
+    }
+    return w;
+}
+
+// p is at the opening quote. Escapes are decoded in place (the decoded
+// text is never longer), so a string without them costs one scan.
+// Returns the position after the closing quote, or NULL.
+static char* parse_string(char *p, const char *end, char **text, size_t *length) {
+    char *start = ++p;
+    while (p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20) p++;
+    if (p >= end || (unsigned char)*p < 0x20) return NULL;
+    if (*p == '"') {
+        *text = start;
+        *length = (size_t)(p - start);
+        return p + 1;
+    }
+    
+    char *w = p;
+    while (p < end && *p != '"') {
+        if ((unsigned char)*p < 0x20) return NULL;
+        if (*p != '\\') {
+            *w++ = *p++;
+            continue;
+        }
+        if (++p >= end) return NULL;
+        char c = *p++;
+        switch (c) {
+            case '"': case '\\': case '/': *w++ = c; break;
+            case 'b': *w++ = '\b'; break;
+            case 'f': *w++ = '\f'; break;
+            case 'n': *w++ = '\n'; break;
+            case 'r': *w++ = '\r'; break;
+            case 't': *w++ = '\t'; break;
+            case 'u': {
+                uint32_t code;
+                if (!parse_hex4(p, end, &code)) return NULL;
+                p += 4;
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    uint32_t low;
+                    if (end - p < 6 || p[0] != '\\' || p[1] != 'u' ||
+                        !parse_hex4(p + 2, end, &low) || low < 0xDC00 || low > 0xDFFF) {
+                        return NULL;
+                    }
+                    p += 6;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return NULL;
+                }
+                w = put_utf8(w, code);
+                break;
+            }
+            default:
+                return NULL;
+        }
+    }
+    if (p >= end) return NULL;
+    *text = start;
+    *length = (size_t)(w - start);
+    return p + 1;
+}
+
+// Non-negative integer; returns the position after it, or NULL
+static char* parse_uint(char *p, const char *end, uint64_t *value) {
+    if (p >= end || *p < '0' || *p > '9') return NULL;
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        uint64_t digit = (uint64_t)(*p - '0');
+        if (v > (UINT64_MAX - digit) / 10) return NULL;
+        v = v * 10 + digit;
+        p++;
+    }
+    *value = v;
+    return p;
+}
+
+// Skips any JSON value; returns the position after it, or NULL
+static char* skip_value(char *p, const char *end, int depth) {
+    if (p >= end || depth > JSON_MAX_DEPTH) return NULL;
+    
+    if (*p == '"') {
+        char *text;
+        size_t length;
+        return parse_string(p, end, &text, &length);
+    }
+    if (*p == '{' || *p == '[') {
+        char close = (*p == '{') ? '}' : ']';
+        p = skip_space(p + 1, end);
+        if (p < end && *p == close) return p + 1;
+        for (;;) {
+            if (close == '}') {
+                if (p >= end || *p != '"') return NULL;
+                p = skip_value(p, end, depth + 1);
+                if (!p) return NULL;
+                p = skip_space(p, end);
+                if (p >= end || *p != ':') return NULL;
+                p = skip_space(p + 1, end);
+            }
+            p = skip_value(p, end, depth + 1);
+            if (!p) return NULL;
+            p = skip_space(p, end);
+            if (p >= end) return NULL;
+            if (*p == close) return p + 1;
+            if (*p != ',') return NULL;
+            p = skip_space(p + 1, end);
+        }
+    }
+    
+    // Number or literal
+    char *start = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+           *p != ' ' && *p != '\t' && *p != '\r') {
+        p++;
+    }
+    return p > start ? p : NULL;
+}
+
+static bool key_is(const char *key, size_t length, const char *name) {
+    return strlen(name) == length && memcmp(key, name, length) == 0;
+}
+
+static bool parse_priority(char *p, const char *end, char **next, task_priority_t *priority) {
+    static const char *names[TASK_PRIORITY_LEVELS] = { "low", "normal", "high", "critical" };
+    
+    if (p < end && *p == '"') {
+        char *name;
+        size_t length;
+        *next = parse_string(p, end, &name, &length);
+        if (!*next) return false;
+        for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+            if (key_is(name, length, names[level])) {
+                *priority = (task_priority_t)level;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    uint64_t value;
+    *next = parse_uint(p, end, &value);
+    if (!*next || value >= TASK_PRIORITY_LEVELS) return false;
+    *priority = (task_priority_t)value;
+    return true;
+}
+
+// Fills submission from one line's object; false if the line is malformed
+static bool parse_line(char *p, const char *end, task_submission_t *submission,
+                       char id[MAX_TASK_ID_LEN]) {
+    memset(submission, 0, sizeof(*submission));
+    submission->priority = TASK_PRIORITY_NORMAL;
+    bool have_id = false;
+    
+    p = skip_space(p, end);
+    if (p >= end || *p != '{') return false;
+    p = skip_space(p + 1, end);
+    if (p < end && *p == '}') return false;
+    
+    for (;;) {
+        char *key;
+        size_t key_length;
+        if (p >= end || *p != '"') return false;
+        p = parse_string(p, end, &key, &key_length);
+        if (!p) return false;
+        p = skip_space(p, end);
+        if (p >= end || *p != ':') return false;
+        p = skip_space(p + 1, end);
+        if (p >= end) return false;
+        
+        char *text;
+        size_t length;
+        uint64_t value;
+        if (key_is(key, key_length, "task_id") || key_is(key, key_length, "id") ||
+            key_is(key, key_length, "request_id")) {
+            if (*p != '"') return false;
+            p = parse_string(p, end, &text, &length);
+            if (!p || length == 0 || length >= MAX_TASK_ID_LEN || memchr(text, '\0', length)) {
+                return false;
+            }
+            memcpy(id, text, length);
+            id[length] = '\0';
+            have_id = true;
+        } else if (key_is(key, key_length, "data") || key_is(key, key_length, "body") ||
+                   key_is(key, key_length, "payload")) {
+            if (*p != '"') return false;
+            p = parse_string(p, end, &text, &length);
+            if (!p) return false;
+            submission->data = text;
+            submission->data_size = length;
+        } else if (key_is(key, key_length, "priority")) {
+            if (!parse_priority(p, end, &p, &submission->priority)) return false;
+        } else if (key_is(key, key_length, "model_id")) {
+            p = parse_uint(p, end, &value);
+            if (!p || value > UINT32_MAX) return false;
+            submission->model_id = (uint32_t)value;
+        } else if (key_is(key, key_length, "deadline_ms")) {
+            p = parse_uint(p, end, &value);
+            if (!p || value > UINT64_MAX / 1000000ULL / 2) return false;
+            submission->deadline_ns = value ? task_now_ns() + value * 1000000ULL : 0;
+        } else if (key_is(key, key_length, "timeout_ms")) {
+            p = parse_uint(p, end, &value);
+            if (!p || value > UINT64_MAX / 1000000ULL) return false;
+            submission->timeout_ns = value * 1000000ULL;
+        } else if (key_is(key, key_length, "memory_mb")) {
+            p = parse_uint(p, end, &value);
+            if (!p || value > UINT64_MAX / (1024ULL * 1024ULL)) return false;
+            submission->memory_bytes = value * 1024ULL * 1024ULL;
+        } else {
+            p = skip_value(p, end, 1);
+            if (!p) return false;
+        }
+        
+        p = skip_space(p, end);
+        if (p >= end) return false;
+        if (*p == '}') break;
+        if (*p != ',') return false;
+        p = skip_space(p + 1, end);
+    }
+    
+    if (skip_space(p + 1, end) != end || !have_id) return false;
+    submission->task_id = id;
+    return true;
+}
+
+static bool await_room(ingest_t *in, task_priority_t level) {
+    admission_controller_t *ctrl = in->orch->admission;
+    while (orchestrator_is_running(in->orch)) {
+        if (task_queue_wait_for_room(ctrl->queue, ctrl->depth_limit[level], JSONL_INGEST_WAIT_US)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Submits the pending lines. Before returning, every one is either
+// submitted or counted as rejected, so the input they point into may be
+// reused.
+static void flush(ingest_t *in) {
+    task_submission_t *pending = in->batch;
+    size_t count = in->count;
+    int results[ADMISSION_BATCH_MAX];
+    
+    while (count > 0) {
+        orchestrator_submit_batch(in->orch, pending, count, in->arena, results);
+        
+        // Queue-full refusals move to the front, in order, for a retry;
+        // the ids they point to stay put until the next batch is parsed
+        size_t retry = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (results[i] == ADMISSION_ACCEPTED) {
+                in->stats->submitted++;
+            } else if (results[i] == ADMISSION_QUEUE_FULL && in->wait_for_room && !in->stopped) {
+                pending[retry++] = pending[i];
+            } else {
+                in->stats->rejected++;
+            }
+        }
+        count = retry;
+        
+        if (count > 0 && !await_room(in, pending[0].priority)) {
+            in->stopped = true;
+            in->stats->rejected += count;
+            count = 0;
+        }
+    }
+    in->count = 0;
+}
+
+// Parses every complete line in [p, end), plus a final unterminated one
+// when at_eof; returns where the unparsed tail starts
+static char* ingest_lines(ingest_t *in, char *p, char *end, bool at_eof) {
+    while (p < end && !in->stopped) {
+        char *newline = memchr(p, '\n', (size_t)(end - p));
+        if (!newline && !at_eof) break;
+        char *line_end = newline ? newline : end;
+        
+        char *first = skip_space(p, line_end);
+        if (first < line_end) {
+            in->stats->lines++;
+            if (parse_line(first, line_end, &in->batch[in->count], in->ids[in->count])) {
+                if (++in->count == ADMISSION_BATCH_MAX) flush(in);
+            } else {
+                in->stats->malformed++;
+            }
+        }
+        p = newline ? newline + 1 : end;
+    }
+    return p;
+}
+
+static int ingest_mapped(ingest_t *in, int fd, size_t size) {
+    if (size == 0) return 0;
+    
+    // Private and writable so escapes can be decoded in place
+    char *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) return -1;
+    madvise(data, size, MADV_SEQUENTIAL);
+    
+    ingest_lines(in, data, data + size, true);
+    flush(in);
+    in->stats->bytes = size;
+    
+    munmap(data, size);
+    return 0;
+}
+
+static int ingest_stream(ingest_t *in, int fd) {
+    size_t capacity = JSONL_INGEST_READ_SIZE;
+    char *buffer = malloc(capacity);
+    if (!buffer) return -1;
+    
+    size_t length = 0;
+    int result = 0;
+    bool at_eof = false;
+    while (!at_eof && !in->stopped) {
+        // A line longer than the buffer grows it
+        if (capacity - length < JSONL_INGEST_READ_SIZE / 2) {
+            char *grown = realloc(buffer, capacity * 2);
+            if (!grown) {
+                result = -1;
+                break;
+            }
+            buffer = grown;
+            capacity *= 2;
+        }
+        
+        ssize_t got = read(fd, buffer + length, capacity - length);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            result = -1;
+            break;
+        }
+        at_eof = (got == 0);
+        length += (size_t)got;
+        in->stats->bytes += (uint64_t)got;
+        
+        char *tail = ingest_lines(in, buffer, buffer + length, at_eof);
+        flush(in);
+        length -= (size_t)(tail - buffer);
+        memmove(buffer, tail, length);
+        
+        if (!orchestrator_is_running(in->orch)) in->stopped = true;
+    }
+    
+    free(buffer);
+    return result;
+}
+
+int jsonl_ingest(orchestrator_t *orch, const char *path, bool wait_for_room,
+                 jsonl_ingest_stats_t *stats) {
+    if (!orch || !path || !stats) return -1;
+    memset(stats, 0, sizeof(*stats));
+    
+    bool use_stdin = strcmp(path, "-") == 0;
+    int fd = use_stdin ? STDIN_FILENO : open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    
+    ingest_t *in = (ingest_t*)calloc(1, sizeof(ingest_t));
+    payload_arena_t *arena = payload_arena_create(0);
+    if (!in || !arena) {
+        free(in);
+        payload_arena_destroy(arena);
+        if (!use_stdin) close(fd);
+        return -1;
+    }
+    in->orch = orch;
+    in->wait_for_room = wait_for_room;
+    in->arena = arena;
+    in->stats = stats;
+    
+    uint64_t start = task_now_ns();
+    struct stat st;
+    int result;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        ingest_mapped(in, fd, (size_t)st.st_size) == 0) {
+        result = 0;
+    } else {
+        result = ingest_stream(in, fd);
+    }
+    stats->elapsed_ns = task_now_ns() - start;
+    
+    payload_arena_destroy(arena);  // blocks still held by queued tasks outlive it
+    free(in);
+    if (!use_stdin) close(fd);
+    return result;
+}
+
+void jsonl_ingest_print_stats(const jsonl_ingest_stats_t *stats, FILE *out) {
+    if (!stats || !out) return;
+    
+    double seconds = stats->elapsed_ns / 1e9;
+    double lines_per_second = seconds > 0.0 ? stats->lines / seconds : 0.0;
+    double mb_per_second = seconds > 0.0 ? stats->bytes / seconds / 1e6 : 0.0;
+    fprintf(out, "Ingested %llu lines (%llu bytes) in %.3f s: %.0f lines/s, %.1f MB/s\n",
+            (unsigned long long)stats->lines, (unsigned long long)stats->bytes,
+            seconds, lines_per_second, mb_per_second);
+    fprintf(out, "  submitted %llu, rejected %llu, malformed %llu\n",
+            (unsigned long long)stats->submitted, (unsigned long long)stats->rejected,
+            (unsigned long long)stats->malformed);
+}
+
@@ -0,0 +1,42 @@
+#ifndef JSONL_INGEST_H
+#define JSONL_INGEST_H
+
+#include "orchestrator.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define JSONL_INGEST_READ_SIZE (1024 * 1024)    // stdin/pipe read chunk
+#define JSONL_INGEST_WAIT_US 100000             // re-checks shutdown while waiting for room
+
+// One task per line, as a JSON object:
+//   {"task_id": "t1", "priority": 2, "data": "text", "model_id": 0, "deadline_ms": 50}
+// task_id (or "id", "request_id") is required, at most MAX_TASK_ID_LEN - 1
+// bytes. priority is 0-3 or "low", "normal", "high", "critical" (default
+// normal). data (or "body", "payload") is the payload, without a
+// terminating NUL. deadline_ms counts from when the line is read;
+// timeout_ms caps the task's run once it starts; memory_mb is its peak
+// footprint for memory-aware dispatch. Other keys are skipped, blank lines
+// ignored.
+typedef struct {
+    uint64_t lines;             // non-blank lines
+    uint64_t submitted;
+    uint64_t malformed;         // not a task object; nothing submitted
+    uint64_t rejected;          // refused by admission, or an unknown model_id
+    uint64_t bytes;
+    uint64_t elapsed_ns;
+} jsonl_ingest_stats_t;
+
+// Streams path ("-" for stdin) into orch with orchestrator_submit_batch().
+// Regular files are mmap'd and parsed in place; anything else is read in
+// JSONL_INGEST_READ_SIZE chunks. With wait_for_room, tasks refused for a
+// full queue are retried once it drains, so a file larger than the queue
+// is loaded whole; otherwise they count as rejected. Stops early if the
+// orchestrator stops. Returns -1 if path cannot be read, 0 otherwise;
+// stats is filled either way.
+int jsonl_ingest(orchestrator_t *orch, const char *path, bool wait_for_room,
+                 jsonl_ingest_stats_t *stats);
+void jsonl_ingest_print_stats(const jsonl_ingest_stats_t *stats, FILE *out);
+
+#endif // JSONL_INGEST_H
+
@@ -0,0 +1,55 @@
+#define _GNU_SOURCE
+#include "listen_socket.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define LISTEN_BACKLOG 64
+
+static int bind_and_listen(int fd, const struct sockaddr *addr, socklen_t length) {
+    if (bind(fd, addr, length) != 0 || listen(fd, LISTEN_BACKLOG) != 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+int listen_socket_unix(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (!path || !path[0] || strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, path);
+    
+    // Left behind by a previous run; never remove anything but a socket
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) return -1;
+        unlink(path);
+    }
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    return bind_and_listen(fd, (struct sockaddr*)&addr, sizeof(addr));
+}
+
+int listen_socket_tcp_loopback(uint16_t port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    return bind_and_listen(fd, (struct sockaddr*)&addr, sizeof(addr));
+}
+
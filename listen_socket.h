@@ -0,0 +1,16 @@
+#ifndef LISTEN_SOCKET_H
+#define LISTEN_SOCKET_H
+
+#include <stdint.h>
+
+// Listening sockets for local endpoints, close-on-exec. Both return the
+// descriptor or -1.
+
+// A stale socket file at path is replaced; any other file is left alone
+// and the call fails.
+int listen_socket_unix(const char *path);
+// Bound to 127.0.0.1 only
+int listen_socket_tcp_loopback(uint16_t port);
+
+#endif // LISTEN_SOCKET_H
+
@@ -1,4 +1,6 @@
 #include "orchestrator.h"
+#include "task_server.h"
+#include "jsonl_ingest.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +13,38 @@ void print_usage(const char *program_name) {
     printf("  -t <num>     Number of worker threads (default: 4)\n");
     printf("  -q <size>    Task queue size (default: 100)\n");
     printf("  -p <path>    Path to Python inference script (default: python/inference_engine.py)\n");
+    printf("  -l           Use the lock-free task queue\n");
+    printf("  -e           Earliest-deadline-first task queue with priority aging\n");
+    printf("  -A <ms>      Wait that lifts a queued task one priority with -e (default: %d, 0 = off)\n",
+           DEFAULT_AGING_MS);
+    printf("  -s           Work-stealing scheduler (per-worker deques)\n");
+    printf("  -E <min:max> Grow and shrink the workers between min and max, starting from -t\n");
+    printf("  -O <ms>      Stop a task that runs longer than this (default: 0, no limit)\n");
+    printf("  -r <mb>      Cache results of repeated inputs in this much memory (default: 0, off)\n");
+    printf("  -J <dir>     Journal submissions in dir and replay unfinished ones on start\n");
+    printf("  -G <ms>[:n]  Journal group commit: sync every ms, or every n records (default: %d:%d)\n",
+           TASK_JOURNAL_DEFAULT_SYNC_MS, TASK_JOURNAL_DEFAULT_SYNC_RECORDS);
+    printf("  -x <mb|auto> Start tasks only while their footprints fit in mb, or in %d%%\n"
+           "               of available memory with auto\n", (int)(MEMORY_BUDGET_DEFAULT_HEADROOM * 100));
+    printf("  -F <mb>      Footprint of tasks that declare none, with -x (default: 0, untracked)\n");
+    printf("  -w <num>     Persistent Python inference workers (default: 0, simulated)\n");
+    printf("  -m <path>    Model file loaded by each Python worker\n");
+    printf("  -M <mb>      Warm model memory budget per Python worker (default: %d)\n",
+           PY_DEFAULT_MODEL_BUDGET_MB);
+    printf("  -b <num>     Micro-batch up to num compatible tasks (default: 1, off)\n");
+    printf("  -T <usec>    Longest a partial batch waits (default: %d)\n", TASK_BATCH_DEFAULT_WAIT_US);
+    printf("  -B <0-3>     Priority at or above which tasks skip batching (default: 3)\n");
+    printf("  -c           Pin workers and Python workers to their cores\n");
+    printf("  -C <cores>   Physical cores the orchestrator may use (default: all)\n");
+    printf("  -R <cores>   Cores of that budget reserved for ingest and monitoring threads\n");
+    printf("  -k <profile> Split the budget for 'latency' or 'throughput' (sets -t and -w)\n");
+    printf("  -H           Let inference use SMT siblings too\n");
+    printf("  -S <path>    Serve Prometheus metrics on this UNIX socket\n");
+    printf("  -P <port>    Serve Prometheus metrics on this loopback TCP port\n");
+    printf("  -U <path>    Accept task submissions on this UNIX socket\n");
+    printf("  -L <port>    Accept task submissions on this loopback TCP port\n");
+    printf("  -j <path>    Stream JSONL tasks from a file, or - for stdin\n");
+    printf("  -D           With -j, reject tasks the queue has no room for instead of waiting\n");
     printf("  -i           Interactive mode - submit tasks manually\n");
     printf("  -n           No sample tasks - skip default test tasks\n");
     printf("  -h           Show this help message\n");
@@ -36,6 +70,31 @@ void submit_sample_tasks(orchestrator_t *orch) {
     }
 }
 
+// Three tasks, each stage running on the output of the one before
+static void submit_pipeline(orchestrator_t *orch, const char *task_id, const char *data) {
+    static const char *stages[] = { "preprocess", "infer", "postprocess" };
+    char ids[3][MAX_TASK_ID_LEN + 16];
+    task_graph_node_t nodes[3];
+    memset(nodes, 0, sizeof(nodes));
+    
+    for (int i = 0; i < 3; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "%s.%s", task_id, stages[i]);
+        nodes[i].task.task_id = ids[i];
+        nodes[i].task.priority = TASK_PRIORITY_NORMAL;
+        nodes[i].input_from = i - 1;
+        if (i > 0) {
+            nodes[i].parents[0] = i - 1;
+            nodes[i].num_parents = 1;
+        }
+    }
+    nodes[0].task.data = data;
+    nodes[0].task.data_size = strlen(data) + 1;
+    
+    if (orchestrator_submit_graph(orch, nodes, 3, NULL) != 1) {
+        printf("Error: Failed to submit pipeline '%s'\n", task_id);
+    }
+}
+
 void interactive_mode(orchestrator_t *orch) {
     char line[512];
     char task_id[64];
@@ -46,7 +105,9 @@ void interactive_mode(orchestrator_t *orch) {
     printf("Enter tasks (format: task_id priority data)\n");
     printf("Priority: 0=Low, 1=Normal, 2=High, 3=Critical\n");
     printf("Type 'quit' or 'exit' to stop submitting tasks\n");
-    printf("Type 'status' to check queue status\n\n");
+    printf("Type 'status' to check queue status\n");
+    printf("Type 'cancel <task_id>' to cancel a queued or running task\n");
+    printf("Type 'pipeline <task_id> <data>' to run preprocess, infer and postprocess in turn\n\n");
     
     while (1) {
         printf("orchestrator> ");
@@ -76,6 +137,18 @@ void interactive_mode(orchestrator_t *orch) {
             continue;
         }
         
+        if (sscanf(line, "cancel %63s", task_id) == 1) {
+            if (orchestrator_cancel(orch, task_id) <= 0) {
+                printf("No live task '%s'\n", task_id);
+            }
+            continue;
+        }
+        
+        if (sscanf(line, "pipeline %63s %255[^\n]", task_id, task_data) == 2) {
+            submit_pipeline(orch, task_id, task_data);
+            continue;
+        }
+        
         // Parse input: task_id priority data
         if (sscanf(line, "%63s %d %255[^\n]", task_id, &priority, task_data) == 3) {
             if (priority < 0 || priority > 3) {
@@ -98,25 +171,139 @@ void interactive_mode(orchestrator_t *orch) {
 }
 
 int main(int argc, char *argv[]) {
-    size_t num_threads = DEFAULT_NUM_THREADS;
-    size_t queue_size = DEFAULT_QUEUE_SIZE;
-    const char *python_path = NULL;
+    orchestrator_config_t config;
+    orchestrator_config_init(&config);
     bool interactive = false;
     bool no_samples = false;
+    const char *ingest_socket = NULL;
+    uint16_t ingest_port = 0;
+    const char *jsonl_path = NULL;
+    bool jsonl_wait = true;
     
     int opt;
-    while ((opt = getopt(argc, argv, "t:q:p:inh")) != -1) {
+    while ((opt = getopt(argc, argv, "t:q:p:leA:sE:O:r:J:G:x:F:w:m:M:b:T:B:cC:R:k:HS:P:U:L:j:Dinh")) != -1) {
         switch (opt) {
             case 't':
-                num_threads = (size_t)atoi(optarg);
-                if (num_threads == 0) num_threads = DEFAULT_NUM_THREADS;
+                config.num_threads = (size_t)atoi(optarg);
+                if (config.num_threads == 0) config.num_threads = DEFAULT_NUM_THREADS;
                 break;
             case 'q':
-                queue_size = (size_t)atoi(optarg);
-                if (queue_size == 0) queue_size = DEFAULT_QUEUE_SIZE;
+                config.queue_size = (size_t)atoi(optarg);
+                if (config.queue_size == 0) config.queue_size = DEFAULT_QUEUE_SIZE;
                 break;
             case 'p':
-                python_path = optarg;
+                config.python_script_path = optarg;
+                break;
+            case 'l':
+                config.queue_mode = TASK_QUEUE_MODE_LOCK_FREE;
+                break;
+            case 'e':
+                config.queue_mode = TASK_QUEUE_MODE_DEADLINE;
+                break;
+            case 'A':
+                config.aging_ms = (uint64_t)atoll(optarg);
+                break;
+            case 's':
+                config.pool_mode = THREAD_POOL_MODE_WORK_STEALING;
+                break;
+            case 'E':
+                // "max" alone keeps at least one worker
+                if (sscanf(optarg, "%zu:%zu", &config.scaler.min_threads,
+                           &config.scaler.max_threads) != 2) {
+                    config.scaler.min_threads = 1;
+                    config.scaler.max_threads = (size_t)atoi(optarg);
+                }
+                if (config.scaler.max_threads == 0 ||
+                    config.scaler.min_threads > config.scaler.max_threads) {
+                    fprintf(stderr, "Invalid worker range: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'O':
+                config.task_timeout_ms = (uint64_t)atoll(optarg);
+                break;
+            case 'r':
+                config.result_cache_mb = (size_t)atoi(optarg);
+                break;
+            case 'J':
+                config.journal_dir = optarg;
+                break;
+            case 'G':
+                if (sscanf(optarg, "%u:%u", &config.journal.sync_interval_ms,
+                           &config.journal.sync_records) < 1) {
+                    fprintf(stderr, "Invalid group commit: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'x':
+                config.memory_aware = true;
+                config.memory.limit_mb = strcmp(optarg, "auto") == 0 ? 0 : (size_t)atoi(optarg);
+                break;
+            case 'F':
+                config.task_memory_mb = (size_t)atoi(optarg);
+                break;
+            case 'w':
+                config.python_workers = (size_t)atoi(optarg);
+                break;
+            case 'm':
+                config.model_path = optarg;
+                break;
+            case 'M':
+                config.model_budget_mb = (size_t)atoi(optarg);
+                break;
+            case 'b':
+                config.batch.max_batch = (size_t)atoi(optarg);
+                if (config.batch.max_batch == 0) config.batch.max_batch = 1;
+                break;
+            case 'T':
+                config.batch.max_wait_us = (uint64_t)atoll(optarg);
+                break;
+            case 'B': {
+                int priority;
+                char extra;
+                if (sscanf(optarg, "%d%c", &priority, &extra) != 1 ||
+                    priority < TASK_PRIORITY_LOW || priority > TASK_PRIORITY_CRITICAL) {
+                    fprintf(stderr, "Invalid batch bypass priority: %s (0-3)\n", optarg);
+                    return 1;
+                }
+                config.batch.bypass_priority = (task_priority_t)priority;
+                break;
+            }
+            case 'c':
+                config.placement.pin = true;
+                break;
+            case 'C':
+                config.placement.core_budget = (size_t)atoi(optarg);
+                break;
+            case 'R':
+                config.placement.reserved_cores = (size_t)atoi(optarg);
+                break;
+            case 'k':
+                if (cpu_workload_parse(optarg, &config.placement.workload) != 0) {
+                    fprintf(stderr, "Unknown workload profile: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'H':
+                config.placement.use_smt = true;
+                break;
+            case 'S':
+                config.metrics_socket = optarg;
+                break;
+            case 'P':
+                config.metrics_port = (uint16_t)atoi(optarg);
+                break;
+            case 'U':
+                ingest_socket = optarg;
+                break;
+            case 'L':
+                ingest_port = (uint16_t)atoi(optarg);
+                break;
+            case 'j':
+                jsonl_path = optarg;
+                break;
+            case 'D':
+                jsonl_wait = false;
                 break;
             case 'i':
                 interactive = true;
@@ -134,22 +321,77 @@ int main(int argc, char *argv[]) {
     }
     
     printf("=== On-Device AI Task Orchestrator ===\n");
-    printf("Threads: %zu, Queue Size: %zu\n", num_threads, queue_size);
+    printf("Threads: %zu, Queue Size: %zu, Queue Mode: %s, Scheduler: %s\n",
+           config.num_threads, config.queue_size,
+           config.queue_mode == TASK_QUEUE_MODE_LOCK_FREE ? "lock-free" :
+           config.queue_mode == TASK_QUEUE_MODE_DEADLINE ? "deadline" : "locked",
+           config.pool_mode == THREAD_POOL_MODE_WORK_STEALING ? "work-stealing" : "shared queue");
+    if (config.python_workers > 0) {
+        printf("Python Workers: %zu\n", config.python_workers);
+    }
+    if (config.metrics_socket) {
+        printf("Metrics: unix:%s\n", config.metrics_socket);
+    }
+    if (config.metrics_port) {
+        printf("Metrics: http://127.0.0.1:%u/metrics\n", config.metrics_port);
+    }
+    if (config.batch.max_batch > 1) {
+        printf("Micro-batching: up to %zu tasks, %llu us wait\n", config.batch.max_batch,
+               (unsigned long long)config.batch.max_wait_us);
+    }
+    if (config.journal_dir) {
+        printf("Journal: %s, sync every %u ms or %u records\n", config.journal_dir,
+               config.journal.sync_interval_ms, config.journal.sync_records);
+    }
+    if (config.memory_aware) {
+        if (config.memory.limit_mb) {
+            printf("Memory budget: %zu MB", config.memory.limit_mb);
+        } else {
+            printf("Memory budget: %d%% of available memory", (int)(config.memory.headroom_share * 100));
+        }
+        printf(", %zu MB per task by default\n", config.task_memory_mb);
+    }
     
-    orchestrator_t *orch = orchestrator_create(num_threads, queue_size, python_path);
+    orchestrator_t *orch = orchestrator_create_with_config(&config);
     if (!orch) {
         fprintf(stderr, "Failed to create orchestrator\n");
         return 1;
     }
+    cpu_plan_print(orch->cpu_plan);
     
     if (orchestrator_start(orch) != 0) {
         fprintf(stderr, "Failed to start orchestrator\n");
         orchestrator_destroy(orch);
         return 1;
     }
+    // Before new work, so what an earlier run accepted goes first
+    orchestrator_replay_journal(orch);
+    
+    // Network clients keep the orchestrator up until SIGINT or SIGTERM
+    task_server_t *server = NULL;
+    if (ingest_socket || ingest_port) {
+        server = task_server_create(orch, ingest_socket, ingest_port);
+        if (!server) {
+            fprintf(stderr, "Failed to start the task server\n");
+            orchestrator_destroy(orch);
+            return 1;
+        }
+        orchestrator_pin_service_thread(orch, server->thread);
+        if (ingest_socket) printf("Accepting tasks on unix:%s\n", ingest_socket);
+        if (ingest_port) printf("Accepting tasks on 127.0.0.1:%u\n", ingest_port);
+    }
+    
+    // This thread ingests tasks and then monitors
+    orchestrator_pin_service_thread(orch, pthread_self());
     
     // Submit tasks based on mode
-    if (interactive) {
+    if (jsonl_path) {
+        jsonl_ingest_stats_t ingest;
+        if (jsonl_ingest(orch, jsonl_path, jsonl_wait, &ingest) != 0) {
+            fprintf(stderr, "Failed to read tasks from %s\n", jsonl_path);
+        }
+        jsonl_ingest_print_stats(&ingest, stdout);
+    } else if (interactive) {
         interactive_mode(orch);
     } else if (!no_samples) {
         submit_sample_tasks(orch);
@@ -166,14 +408,26 @@ int main(int argc, char *argv[]) {
         size_t queue_size = orchestrator_get_queue_size(orch);
         system_resources_t resources;
         
+        latency_snapshot_t latency;
+        orchestrator_get_latency(orch, &latency);
+        
         if (resource_monitor_get_resources(orch->resource_monitor, &resources) == 0) {
-            printf("Queue: %zu tasks | CPU: %.1f%% | Memory: %.1f%% used\n",
-                   queue_size,
+            printf("Queue: %zu tasks | Workers: %zu | CPU: %.1f%% | Memory: %.1f%% used",
+                   queue_size, thread_pool_active_threads(orch->thread_pool),
                    resources.cpu_usage,
                    (double)resources.memory_used / resources.memory_total * 100.0);
+            if (resources.cpu_pressure >= 0.0) {
+                printf(" | PSI cpu %.2f mem %.2f/%.2f",
+                       resources.cpu_pressure,
+                       resources.memory_pressure,
+                       resources.memory_pressure_full);
+            }
+            const latency_summary_t *e2e = &latency.overall[LATENCY_END_TO_END];
+            printf(" | e2e p50/p99/p999 %.1f/%.1f/%.1f ms | %.1f tasks/s\n",
+                   e2e->p50 / 1e6, e2e->p99 / 1e6, e2e->p999 / 1e6, latency.throughput);
         }
         
-        if (queue_size == 0) {
+        if (queue_size == 0 && !server) {
             empty_count++;
             if (empty_count >= EMPTY_THRESHOLD) {
                 printf("All tasks completed. Exiting...\n");
@@ -188,7 +442,18 @@ int main(int argc, char *argv[]) {
         sleep(2);
     }
     
+    task_server_stop(server);
+    orchestrator_stop(orch);
+    task_server_print_stats(server, stdout);
+    orchestrator_print_batch_stats(orch);
+    orchestrator_print_admission_stats(orch);
+    orchestrator_print_latency_stats(orch);
+    orchestrator_print_worker_stats(orch);
+    orchestrator_print_cache_stats(orch);
+    orchestrator_print_journal_stats(orch);
+    orchestrator_print_memory_stats(orch);
     orchestrator_destroy(orch);
+    task_server_destroy(server);   // after the last task holding a connection
     printf("Orchestrator terminated\n");
     
     return 0;
@@ -0,0 +1,355 @@
+#include "memory_budget.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define MIB (1024ULL * 1024ULL)
+
+void memory_budget_config_init(memory_budget_config_t *config) {
+    if (!config) return;
+    
+    config->limit_mb = 0;
+    config->headroom_share = MEMORY_BUDGET_DEFAULT_HEADROOM;
+    config->max_wait_ms = MEMORY_BUDGET_DEFAULT_MAX_WAIT_MS;
+    config->max_parked = MEMORY_BUDGET_DEFAULT_MAX_PARKED;
+}
+
+// Room for running tasks in one view of memory (system or cgroup): what
+// is free plus what running tasks were seen to use, never more than they
+// claimed. Their use is usage above the baseline, the usage of the last
+// sample taken with nothing running, so a task that has not allocated
+// yet is not credited, and one admitted after the sample not at all.
+static uint64_t room_in(uint64_t free, uint64_t used, uint64_t baseline, uint64_t reserved) {
+    uint64_t measured = used > baseline ? used - baseline : 0;
+    return free + (measured < reserved ? measured : reserved);
+}
+
+// Takes up a new sample; the cgroup applies when it is the tighter view
+static void refresh_limit_locked(memory_budget_t *budget, uint64_t now) {
+    if (!budget->monitor || now < budget->next_refresh_ns) return;
+    budget->next_refresh_ns = now + MEMORY_BUDGET_REFRESH_MS * 1000000ULL;
+    
+    system_resources_t resources;
+    if (resource_monitor_get_resources(budget->monitor, &resources) != 0 ||
+        resources.memory_total == 0) {
+        budget->limit = UINT64_MAX;     // nothing to go by
+        return;
+    }
+    if (resources.sample_time_ms == budget->sample_ms) return;
+    budget->sample_ms = resources.sample_time_ms;
+    
+    uint64_t used = resources.memory_total > resources.memory_available
+                  ? resources.memory_total - resources.memory_available : 0;
+    uint64_t cgroup_used = resources.cgroup_memory_used;
+    if (budget->running == 0 && budget->idle_since_ns <= resources.sample_time_ms * 1000000ULL) {
+        budget->baseline_used = used;
+        budget->baseline_cgroup_used = cgroup_used;
+    }
+    
+    uint64_t room = room_in(resources.memory_available, used, budget->baseline_used, budget->reserved);
+    if (resources.cgroup_memory_limit > 0) {
+        uint64_t free = resources.cgroup_memory_limit > cgroup_used
+                      ? resources.cgroup_memory_limit - cgroup_used : 0;
+        uint64_t cgroup_room = room_in(free, cgroup_used, budget->baseline_cgroup_used, budget->reserved);
+        if (cgroup_room < room) room = cgroup_room;
+    }
+    budget->limit = (uint64_t)(budget->config.headroom_share * (double)room);
+}
+
+static bool can_start(const memory_budget_t *budget, const task_t *task) {
+    return budget->running == 0 || (budget->reserved <= budget->limit &&
+                                     task->memory_bytes <= budget->limit - budget->reserved);
+}
+
+// The parked task waiting longest, once it has waited max_wait_ms
+static task_t* overdue_locked(memory_budget_t *budget, uint64_t now) {
+    if (!budget->config.max_wait_ms || atomic_load_explicit(&budget->waiting, memory_order_relaxed) == 0) {
+        return NULL;
+    }
+    
+    // Each level is FIFO, so its head is its oldest
+    task_t *oldest = NULL;
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        task_t *head = budget->parked_head[level];
+        if (head && (!oldest || head->dequeue_ns < oldest->dequeue_ns)) {
+            oldest = head;
+        }
+    }
+    return (now - oldest->dequeue_ns > budget->config.max_wait_ms * 1000000ULL) ? oldest : NULL;
+}
+
+// The task to start next, most urgent first: within a level, parked tasks
+// were dequeued before task (may be NULL). A task that does not fit is
+// passed over for one that does, unless it is overdue.
+static task_t* pick_locked(memory_budget_t *budget, task_t *task, uint64_t now) {
+    task_t *overdue = overdue_locked(budget, now);
+    if (overdue) {
+        return can_start(budget, overdue) ? overdue : NULL;
+    }
+    
+    for (int level = TASK_PRIORITY_LEVELS - 1; level >= 0; level--) {
+        for (task_t *parked = budget->parked_head[level]; parked; parked = parked->next) {
+            if (can_start(budget, parked)) return parked;
+        }
+        if (task && (int)task->priority == level && can_start(budget, task)) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static void park_locked(memory_budget_t *budget, task_t *task) {
+    int level = (int)task->priority;
+    task->next = NULL;
+    if (budget->parked_tail[level]) {
+        budget->parked_tail[level]->next = task;
+    } else {
+        budget->parked_head[level] = task;
+    }
+    budget->parked_tail[level] = task;
+    atomic_store_explicit(&budget->waiting,
+                          atomic_load_explicit(&budget->waiting, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    budget->stats.parked++;
+}
+
+static void unpark_locked(memory_budget_t *budget, task_t *task) {
+    int level = (int)task->priority;
+    task_t **link = &budget->parked_head[level];
+    task_t *prev = NULL;
+    while (*link != task) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    *link = task->next;
+    if (budget->parked_tail[level] == task) {
+        budget->parked_tail[level] = prev;
+    }
+    task->next = NULL;
+    atomic_store_explicit(&budget->waiting,
+                          atomic_load_explicit(&budget->waiting, memory_order_relaxed) - 1,
+                          memory_order_relaxed);
+}
+
+// Whether task (not parked) starts ahead of a more urgent parked task, or
+// of one of its own priority dequeued before it
+static bool backfills_locked(const memory_budget_t *budget, const task_t *task) {
+    for (int level = TASK_PRIORITY_LEVELS - 1; level > (int)task->priority; level--) {
+        if (budget->parked_head[level]) return true;
+    }
+    const task_t *head = budget->parked_head[task->priority];
+    return head && head->dequeue_ns <= task->dequeue_ns;
+}
+
+static void start_locked(memory_budget_t *budget, task_t *task, bool backfill) {
+    if (budget->running > 0 || task->memory_bytes <= budget->limit) {
+        budget->stats.admitted++;
+    } else {
+        budget->stats.overcommitted++;
+    }
+    if (backfill) {
+        budget->stats.backfilled++;
+    }
+    
+    budget->reserved += task->memory_bytes;
+    budget->running++;
+    if (budget->reserved > budget->stats.peak_reserved_bytes) {
+        budget->stats.peak_reserved_bytes = budget->reserved;
+    }
+    task->memory_budget = budget;
+}
+
+memory_budget_t* memory_budget_create(const memory_budget_config_t *config,
+                                      resource_monitor_t *monitor) {
+    if (!config || (!monitor && config->limit_mb == 0) ||
+        config->headroom_share <= 0.0 || config->headroom_share > 1.0) {
+        return NULL;
+    }
+    
+    memory_budget_t *budget = (memory_budget_t*)calloc(1, sizeof(memory_budget_t));
+    if (!budget) return NULL;
+    
+    if (pthread_mutex_init(&budget->mutex, NULL) != 0) {
+        free(budget);
+        return NULL;
+    }
+    if (pthread_cond_init(&budget->room, NULL) != 0) {
+        pthread_mutex_destroy(&budget->mutex);
+        free(budget);
+        return NULL;
+    }
+    
+    budget->config = *config;
+    if (budget->config.max_parked == 0) {
+        budget->config.max_parked = 1;
+    }
+    // A fixed limit never looks at the monitor
+    budget->monitor = config->limit_mb ? NULL : monitor;
+    budget->limit = config->limit_mb ? config->limit_mb * MIB : UINT64_MAX;
+    atomic_init(&budget->waiting, 0);
+    atomic_init(&budget->releases, 0);
+    refresh_limit_locked(budget, task_now_ns());
+    
+    return budget;
+}
+
+void memory_budget_destroy(memory_budget_t *budget) {
+    if (!budget) return;
+    
+    // Only left behind when workers never started; nothing holds a
+    // reservation to release them
+    memory_budget_drain(budget);
+    
+    pthread_cond_destroy(&budget->room);
+    pthread_mutex_destroy(&budget->mutex);
+    free(budget);
+}
+
+task_t* memory_budget_admit(memory_budget_t *budget, task_t *task) {
+    if (!budget || !task) return task;
+    
+    bool stalled = false;
+    pthread_mutex_lock(&budget->mutex);
+    for (;;) {
+        uint64_t now = task_now_ns();
+        refresh_limit_locked(budget, now);
+        
+        task_t *chosen = pick_locked(budget, task, now);
+        if (chosen == task) {
+            start_locked(budget, task, backfills_locked(budget, task));
+            pthread_mutex_unlock(&budget->mutex);
+            return task;
+        }
+        if (chosen) {
+            // Swap places: the parked task goes, task waits in its stead
+            unpark_locked(budget, chosen);
+            start_locked(budget, chosen, backfills_locked(budget, chosen) ||
+                                         task->priority > chosen->priority);
+            park_locked(budget, task);
+            pthread_mutex_unlock(&budget->mutex);
+            return chosen;
+        }
+        if (atomic_load_explicit(&budget->waiting, memory_order_relaxed) < budget->config.max_parked) {
+            park_locked(budget, task);
+            pthread_mutex_unlock(&budget->mutex);
+            return NULL;
+        }
+        
+        // Something is running, or task could start; a release wakes us
+        if (!stalled) {
+            budget->stats.stalled++;
+            stalled = true;
+        }
+        pthread_cond_wait(&budget->room, &budget->mutex);
+    }
+}
+
+task_t* memory_budget_take(memory_budget_t *budget) {
+    if (!budget || atomic_load_explicit(&budget->waiting, memory_order_relaxed) == 0) return NULL;
+    
+    pthread_mutex_lock(&budget->mutex);
+    uint64_t now = task_now_ns();
+    refresh_limit_locked(budget, now);
+    task_t *task = pick_locked(budget, NULL, now);
+    if (task) {
+        unpark_locked(budget, task);
+        start_locked(budget, task, backfills_locked(budget, task));
+        pthread_cond_broadcast(&budget->room);
+    }
+    pthread_mutex_unlock(&budget->mutex);
+    
+    return task;
+}
+
+void memory_budget_release(task_t *task) {
+    if (!task || !task->memory_budget) return;
+    
+    memory_budget_t *budget = task->memory_budget;
+    pthread_mutex_lock(&budget->mutex);
+    budget->reserved -= task->memory_bytes;
+    if (--budget->running == 0) {
+        budget->idle_since_ns = task_now_ns();
+    }
+    if (atomic_load_explicit(&budget->waiting, memory_order_relaxed) > 0) {
+        atomic_fetch_add_explicit(&budget->releases, 1, memory_order_relaxed);
+    }
+    pthread_cond_broadcast(&budget->room);
+    pthread_mutex_unlock(&budget->mutex);
+    
+    task->memory_budget = NULL;
+}
+
+size_t memory_budget_take_releases(memory_budget_t *budget) {
+    if (!budget || atomic_load_explicit(&budget->releases, memory_order_relaxed) == 0) return 0;
+    return atomic_exchange_explicit(&budget->releases, 0, memory_order_relaxed);
+}
+
+size_t memory_budget_drain(memory_budget_t *budget) {
+    if (!budget) return 0;
+    
+    // Unlinked under the lock, destroyed outside it: task_destroy() hooks
+    // may submit work that comes back through the budget
+    task_t *drained = NULL;
+    size_t count = 0;
+    pthread_mutex_lock(&budget->mutex);
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        while (budget->parked_head[level]) {
+            task_t *task = budget->parked_head[level];
+            budget->parked_head[level] = task->next;
+            task->next = drained;
+            drained = task;
+            count++;
+        }
+        budget->parked_tail[level] = NULL;
+    }
+    atomic_store_explicit(&budget->waiting, 0, memory_order_relaxed);
+    pthread_cond_broadcast(&budget->room);      // the park has room again
+    pthread_mutex_unlock(&budget->mutex);
+    
+    while (drained) {
+        task_t *task = drained;
+        drained = task->next;
+        task->next = NULL;
+        task->status = TASK_STATUS_CANCELLED;
+        task->error = ESHUTDOWN;
+        task_destroy(task);
+    }
+    return count;
+}
+
+size_t memory_budget_waiting(memory_budget_t *budget) {
+    return budget ? atomic_load_explicit(&budget->waiting, memory_order_relaxed) : 0;
+}
+
+void memory_budget_get_stats(memory_budget_t *budget, memory_budget_stats_t *stats) {
+    if (!stats) return;
+    
+    memset(stats, 0, sizeof(*stats));
+    if (!budget) return;
+    
+    pthread_mutex_lock(&budget->mutex);
+    *stats = budget->stats;
+    stats->limit_bytes = budget->limit;
+    stats->reserved_bytes = budget->reserved;
+    stats->running = budget->running;
+    stats->waiting = atomic_load_explicit(&budget->waiting, memory_order_relaxed);
+    pthread_mutex_unlock(&budget->mutex);
+}
+
+void memory_budget_print_stats(memory_budget_t *budget, FILE *out) {
+    if (!budget || !out) return;
+    
+    memory_budget_stats_t stats;
+    memory_budget_get_stats(budget, &stats);
+    fprintf(out, "Memory budget: %llu admitted, %llu parked, %llu backfilled, %llu overcommitted, "
+            "%llu stalls, peak %.1f MB of ",
+            (unsigned long long)stats.admitted, (unsigned long long)stats.parked,
+            (unsigned long long)stats.backfilled, (unsigned long long)stats.overcommitted,
+            (unsigned long long)stats.stalled, stats.peak_reserved_bytes / (double)MIB);
+    if (stats.limit_bytes == UINT64_MAX) {
+        fprintf(out, "unlimited\n");
+    } else {
+        fprintf(out, "%.1f MB\n", stats.limit_bytes / (double)MIB);
+    }
+}
+
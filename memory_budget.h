@@ -0,0 +1,95 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include "task_queue.h"
+#include "resource_monitor.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define MEMORY_BUDGET_DEFAULT_HEADROOM 0.8
+#define MEMORY_BUDGET_DEFAULT_MAX_WAIT_MS 2000
+#define MEMORY_BUDGET_DEFAULT_MAX_PARKED 64
+#define MEMORY_BUDGET_REFRESH_MS 100
+
+typedef struct {
+    size_t limit_mb;                // fixed budget, 0 = follow available memory
+    double headroom_share;          // share of available memory running tasks may claim
+    uint64_t max_wait_ms;           // a task set aside this long stops backfilling, 0 = never
+    size_t max_parked;              // tasks set aside before workers wait instead
+} memory_budget_config_t;
+
+typedef struct {
+    uint64_t admitted;              // tasks started against the budget
+    uint64_t parked;                // set aside for want of headroom
+    uint64_t backfilled;            // started ahead of a task set aside that comes first
+    uint64_t overcommitted;         // bigger than the whole budget, started alone
+    uint64_t stalled;               // times a worker waited with the park full
+    uint64_t limit_bytes;
+    uint64_t reserved_bytes;        // claimed by running tasks
+    uint64_t peak_reserved_bytes;
+    size_t running;
+    size_t waiting;                 // set aside now
+} memory_budget_stats_t;
+
+// Memory-aware dispatch. A task with a memory_bytes footprint starts only
+// while the footprints of running tasks, its own included, stay within the
+// limit: limit_mb, or headroom_share of what the system (MemAvailable) or
+// the cgroup (memory.max less usage) has free plus what running tasks
+// were measured to use, taken from each new resource monitor sample
+// (checked every MEMORY_BUDGET_REFRESH_MS). Until a task shows up in a
+// sample, its whole footprint comes out of the free memory. A task that
+// does not fit is set aside (parked) and the worker moves on to smaller or
+// less urgent work that does; each release hands the freed headroom to
+// parked tasks, most urgent first. Once a parked task has waited
+// max_wait_ms nothing else starts until it has, so a large task is not
+// starved by a stream of small ones. With nothing running any task
+// starts, however large.
+typedef struct memory_budget {
+    memory_budget_config_t config;
+    resource_monitor_t *monitor;    // not owned; NULL with a fixed limit
+    pthread_mutex_t mutex;          // guards everything below but waiting
+    pthread_cond_t room;            // workers wait here with the park full
+    uint64_t limit;
+    uint64_t next_refresh_ns;
+    uint64_t sample_ms;             // sample_time_ms of the sample the limit is from
+    uint64_t idle_since_ns;         // nothing has run since
+    uint64_t baseline_used;         // usage in the last sample with nothing running
+    uint64_t baseline_cgroup_used;
+    uint64_t reserved;
+    size_t running;
+    task_t *parked_head[TASK_PRIORITY_LEVELS];  // FIFO per priority, linked by next
+    task_t *parked_tail[TASK_PRIORITY_LEVELS];
+    _Atomic size_t waiting;         // parked tasks, read without the lock
+    _Atomic size_t releases;        // made while tasks were parked, not yet passed on
+    memory_budget_stats_t stats;
+} memory_budget_t;
+
+void memory_budget_config_init(memory_budget_config_t *config);
+// monitor may be NULL only with a fixed limit_mb
+memory_budget_t* memory_budget_create(const memory_budget_config_t *config,
+                                      resource_monitor_t *monitor);
+// Drains what is still parked (see memory_budget_drain())
+void memory_budget_destroy(memory_budget_t *budget);
+// For a dequeued task with a footprint: returns the task to run now, which
+// holds its reservation until destroyed. That is task itself, or a parked
+// one that may start instead while task takes its place; NULL when task was
+// parked. Waits while the park is full and nothing can start.
+task_t* memory_budget_admit(memory_budget_t *budget, task_t *task);
+// A parked task that may start now, reserved, or NULL
+task_t* memory_budget_take(memory_budget_t *budget);
+// Called by task_destroy() for a task holding a reservation
+void memory_budget_release(task_t *task);
+// Releases made with tasks parked since the last call; each may let one of
+// them start, so each is worth waking one idle worker for
+size_t memory_budget_take_releases(memory_budget_t *budget);
+// Destroys every parked task unrun, as cancelled (ESHUTDOWN); returns how
+// many there were
+size_t memory_budget_drain(memory_budget_t *budget);
+size_t memory_budget_waiting(memory_budget_t *budget);
+void memory_budget_get_stats(memory_budget_t *budget, memory_budget_stats_t *stats);
+void memory_budget_print_stats(memory_budget_t *budget, FILE *out);
+
+#endif // MEMORY_BUDGET_H
+
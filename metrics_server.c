@@ -0,0 +1,206 @@
+#define _GNU_SOURCE
+#include "metrics_server.h"
+#include "listen_socket.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define METRICS_REQUEST_MAX 4096
+#define METRICS_READ_TIMEOUT_MS 200
+#define METRICS_WRITE_TIMEOUT_MS 1000
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Gives up at the deadline, so a client that stops reading cannot wedge
+// the metrics thread (and destroy's join behind it). Each send blocks for
+// at most the time left; a trickling reader still runs out of it.
+static int send_all(int fd, const char *data, size_t size, uint64_t deadline_ns) {
+    while (size > 0) {
+        uint64_t now = now_ns();
+        if (now >= deadline_ns) return -1;
+        uint64_t left_us = (deadline_ns - now + 999) / 1000;
+        struct timeval timeout = { (time_t)(left_us / 1000000), (suseconds_t)(left_us % 1000000) };
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        
+        ssize_t sent = send(fd, data, size, SEND_FLAGS);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return 0;
+}
+
+// Reads until the end of an HTTP request head, EOF or a short timeout;
+// true if the client spoke HTTP
+static bool read_request(int fd) {
+    struct timeval timeout = { 0, METRICS_READ_TIMEOUT_MS * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    char request[METRICS_REQUEST_MAX];
+    size_t length = 0;
+    while (length < sizeof(request) - 1) {
+        ssize_t got = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        length += (size_t)got;
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) break;
+    }
+    request[length] = '\0';
+    return strncmp(request, "GET ", 4) == 0;
+}
+
+static void serve(metrics_server_t *server, int fd) {
+    bool http = read_request(fd);
+    
+    char *page = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&page, &size);
+    if (!out) return;
+    server->render(out, server->ctx);
+    fclose(out);
+    
+    uint64_t deadline_ns = now_ns() + METRICS_WRITE_TIMEOUT_MS * 1000000ULL;
+    if (http) {
+        char head[160];
+        int length = snprintf(head, sizeof(head),
+                              "HTTP/1.0 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4\r\n"
+                              "Content-Length: %zu\r\n"
+                              "Connection: close\r\n\r\n", size);
+        if (send_all(fd, head, (size_t)length, deadline_ns) != 0) {
+            free(page);
+            return;
+        }
+    }
+    send_all(fd, page, size, deadline_ns);
+    free(page);
+    atomic_fetch_add_explicit(&server->scrapes, 1, memory_order_relaxed);
+}
+
+static void* server_thread(void *arg) {
+    metrics_server_t *server = (metrics_server_t*)arg;
+    struct pollfd fds[3];
+    nfds_t count = 0;
+    
+    fds[count++] = (struct pollfd){ .fd = server->wake_fds[0], .events = POLLIN };
+    for (int i = 0; i < 2; i++) {
+        if (server->listen_fds[i] >= 0) {
+            fds[count++] = (struct pollfd){ .fd = server->listen_fds[i], .events = POLLIN };
+        }
+    }
+    
+    for (;;) {
+        if (poll(fds, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents) break;
+        
+        for (nfds_t i = 1; i < count; i++) {
+            if (!(fds[i].revents & POLLIN)) continue;
+            int client = accept(fds[i].fd, NULL, NULL);
+            if (client < 0) continue;
+            serve(server, client);
+            close(client);
+        }
+    }
+    
+    return NULL;
+}
+
+static void close_fds(metrics_server_t *server) {
+    for (int i = 0; i < 2; i++) {
+        if (server->listen_fds[i] >= 0) close(server->listen_fds[i]);
+        if (server->wake_fds[i] >= 0) close(server->wake_fds[i]);
+    }
+    if (server->socket_path[0]) unlink(server->socket_path);
+}
+
+metrics_server_t* metrics_server_create(const char *socket_path, uint16_t tcp_port,
+                                        metrics_render_t render, void *ctx) {
+    bool use_unix = socket_path && socket_path[0];
+    if (!render || (!use_unix && tcp_port == 0)) return NULL;
+    if (use_unix && strlen(socket_path) >= METRICS_SOCKET_PATH_MAX) return NULL;
+    
+    metrics_server_t *server = (metrics_server_t*)calloc(1, sizeof(metrics_server_t));
+    if (!server) return NULL;
+    
+    server->listen_fds[0] = server->listen_fds[1] = -1;
+    server->wake_fds[0] = server->wake_fds[1] = -1;
+    server->render = render;
+    server->ctx = ctx;
+    atomic_init(&server->scrapes, 0);
+    
+    if (pipe(server->wake_fds) != 0) {
+        server->wake_fds[0] = server->wake_fds[1] = -1;
+        close_fds(server);
+        free(server);
+        return NULL;
+    }
+    
+    if (use_unix) {
+        server->listen_fds[0] = listen_socket_unix(socket_path);
+        if (server->listen_fds[0] < 0) {
+            close_fds(server);
+            free(server);
+            return NULL;
+        }
+        strcpy(server->socket_path, socket_path);
+    }
+    if (tcp_port != 0) {
+        server->listen_fds[1] = listen_socket_tcp_loopback(tcp_port);
+        if (server->listen_fds[1] < 0) {
+            close_fds(server);
+            free(server);
+            return NULL;
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(server->wake_fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    
+    if (pthread_create(&server->thread, NULL, server_thread, server) != 0) {
+        close_fds(server);
+        free(server);
+        return NULL;
+    }
+    
+    return server;
+}
+
+void metrics_server_destroy(metrics_server_t *server) {
+    if (!server) return;
+    
+    char byte = 1;
+    ssize_t written;
+    do {
+        written = write(server->wake_fds[1], &byte, 1);
+    } while (written < 0 && errno == EINTR);
+    pthread_join(server->thread, NULL);
+    
+    close_fds(server);
+    free(server);
+}
+
@@ -0,0 +1,37 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define METRICS_SOCKET_PATH_MAX 108
+
+// Writes the whole metrics page to out; runs on the server thread
+typedef void (*metrics_render_t)(FILE *out, void *ctx);
+
+// Serves metrics in the Prometheus text format from its own thread, on a
+// UNIX domain socket and/or a loopback TCP port. Each connection gets one
+// page: HTTP clients (curl --unix-socket, Prometheus) get a response with
+// headers, anything else just the text. Connections are served one at a
+// time; nothing is rendered between scrapes.
+typedef struct {
+    int listen_fds[2];              // UNIX socket, TCP socket; -1 if unused
+    int wake_fds[2];                // pipe; destroy writes to stop the thread
+    char socket_path[METRICS_SOCKET_PATH_MAX];
+    pthread_t thread;
+    metrics_render_t render;
+    void *ctx;
+    _Atomic uint64_t scrapes;
+} metrics_server_t;
+
+// socket_path NULL or "" and tcp_port 0 skip that listener; at least one
+// is required. A stale socket file at socket_path is replaced.
+metrics_server_t* metrics_server_create(const char *socket_path, uint16_t tcp_port,
+                                        metrics_render_t render, void *ctx);
+// Stops the thread and removes the socket file
+void metrics_server_destroy(metrics_server_t *server);
+
+#endif // METRICS_SERVER_H
+
@@ -1,29 +1,249 @@
+#define _GNU_SOURCE
 #include "orchestrator.h"
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <errno.h>
 #include <signal.h>
+#include <fcntl.h>
 #include <sys/wait.h>
 
 static orchestrator_t *g_orchestrator = NULL;
 
+// Write end of the started orchestrator's signal pipe
+static volatile sig_atomic_t g_signal_fd = -1;
+
+// Only async-signal-safe work here: the signal thread does the rest
 static void signal_handler(int sig) {
-    if (g_orchestrator) {
-        printf("\nReceived signal %d, shutting down...\n", sig);
-        orchestrator_stop(g_orchestrator);
+    int saved_errno = errno;
+    unsigned char byte = (unsigned char)sig;
+    if (g_signal_fd >= 0 && write(g_signal_fd, &byte, 1) < 0) {
+        // Pipe full: a shutdown is already pending
+    }
+    errno = saved_errno;
+}
+
+static void* signal_thread(void *arg) {
+    orchestrator_t *orch = (orchestrator_t*)arg;
+    
+    for (;;) {
+        unsigned char sig;
+        ssize_t n = read(orch->signal_pipe[0], &sig, 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0 || sig == 0) break;         // 0: orchestrator_destroy()
+        
+        if (sig == SIGTERM && orch->journal) {
+            printf("\nReceived signal %d, checkpointing...\n", sig);
+            size_t saved = orchestrator_checkpoint(orch);
+            printf("Checkpointed %zu queued tasks for the next start\n", saved);
+        } else {
+            printf("\nReceived signal %d, shutting down...\n", sig);
+        }
+        orchestrator_stop(orch);
+    }
+    
+    return NULL;
+}
+
+static int start_signal_thread(orchestrator_t *orch) {
+    if (pipe(orch->signal_pipe) != 0) {
+        orch->signal_pipe[0] = orch->signal_pipe[1] = -1;
+        return -1;
+    }
+    // The handler must never block on a full pipe
+    fcntl(orch->signal_pipe[1], F_SETFL, O_NONBLOCK);
+    fcntl(orch->signal_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(orch->signal_pipe[1], F_SETFD, FD_CLOEXEC);
+    if (pthread_create(&orch->signal_thread, NULL, signal_thread, orch) != 0) {
+        close(orch->signal_pipe[0]);
+        close(orch->signal_pipe[1]);
+        orch->signal_pipe[0] = orch->signal_pipe[1] = -1;
+        return -1;
+    }
+    orch->signal_thread_started = true;
+    
+    g_signal_fd = orch->signal_pipe[1];
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    return 0;
+}
+
+static void stop_signal_thread(orchestrator_t *orch) {
+    if (!orch->signal_thread_started) return;
+    
+    if (g_signal_fd == orch->signal_pipe[1]) {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        g_signal_fd = -1;
+    }
+    unsigned char byte = 0;
+    while (write(orch->signal_pipe[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+    pthread_join(orch->signal_thread, NULL);
+    close(orch->signal_pipe[0]);
+    close(orch->signal_pipe[1]);
+    orch->signal_pipe[0] = orch->signal_pipe[1] = -1;
+    orch->signal_thread_started = false;
+}
+
+static void render_metrics(FILE *out, void *ctx) {
+    orchestrator_write_metrics((orchestrator_t*)ctx, out);
+}
+
+// Timer wheel thread: a running task overran its timeout. In-process
+// callbacks can only be told; a Python worker stuck on the task is killed
+// so the hung inference gives its worker back.
+static void on_task_timeout(timer_wheel_entry_t *entry, void *ctx) {
+    orchestrator_t *orch = (orchestrator_t*)ctx;
+    task_t *task = (task_t*)((char*)entry - offsetof(task_t, timer));
+    
+    task_cancel(task, ETIMEDOUT);
+    if (orch->python_workers) {
+        python_worker_pool_abort(orch->python_workers, task);
+    }
+}
+
+// Requeue callback of the result cache: a waiter takes over from a leader
+// that never ran. It was admitted when it attached, so it skips admission.
+static int requeue_waiter(task_t *task, void *ctx) {
+    orchestrator_t *orch = (orchestrator_t*)ctx;
+    
+    if (!orch->thread_pool) return ESHUTDOWN;
+    return thread_pool_release(orch->thread_pool, task, false) == 0 ? 0 : EAGAIN;
+}
+
+// NULL selects the workers' default model
+static const char* model_path_for(orchestrator_t *orch, uint32_t model_id) {
+    if (model_id == 0 || model_id >= atomic_load_explicit(&orch->num_models, memory_order_acquire)) {
+        return NULL;
+    }
+    return orch->models[model_id];
+}
+
+static void report_result(const task_t *task, const void *result, size_t result_size,
+                          size_t batch_size) {
+    tensor_view_t view;
+    if (tensor_frame_decode(result, result_size, &view) == 0) {
+        printf("Task %s completed: rank-%u output tensor, %llu elements",
+               task->task_id, view.desc.rank,
+               (unsigned long long)tensor_element_count(&view.desc));
+    } else {
+        printf("Task %s completed (%zu result bytes)", task->task_id, result_size);
+    }
+    
+    if (batch_size > 1) {
+        printf(" in a batch of %zu", batch_size);
+    }
+    printf("\n");
+}
+
+static void simulate_inference(const char *task_data, size_t data_size) {
+    if (tensor_is_frame(task_data, data_size)) {
+        tensor_view_t view;
+        if (tensor_frame_decode(task_data, data_size, &view) == 0) {
+            printf("Executing AI inference task: %s (rank-%u tensor)\n",
+                   view.task_id, view.desc.rank);
+            return;
+        }
+    }
+    // Payloads from the network need not be NUL-terminated
+    const char *end = memchr(task_data, '\0', data_size);
+    int length = end ? (int)(end - task_data) : (int)data_size;
+    printf("Executing AI inference task: %.*s\n", length, task_data);
+}
+
+// Stands in for a model output, so simulated pipelines have something to
+// pass down: the input, echoed for the dependent the task feeds
+static void simulate_output(task_t *task) {
+    if (!task->output_to) return;
+    
+    void *output = malloc(task->data_size ? task->data_size : 1);
+    if (!output) return;
+    if (task->data_size > 0) {
+        memcpy(output, task->data, task->data_size);
+    }
+    if (!task_set_output(task, output, task->data_size)) {
+        free(output);
     }
 }
 
 static int python_inference_execute(void *data) {
     // This will be called by worker threads
-    // In a real implementation, this would communicate with Python process
     char *task_data = (char*)data;
     if (!task_data) return -1;
     
-    // For now, simulate execution
-    printf("Executing AI inference task: %s\n", task_data);
+    task_t *task = thread_pool_current_task();
+    if (task && g_orchestrator && g_orchestrator->python_workers) {
+        void *result = NULL;
+        size_t result_size = 0;
+        if (python_worker_pool_execute(g_orchestrator->python_workers,
+                                       model_path_for(g_orchestrator, task->model_id),
+                                       task, &result, &result_size) != 0) {
+            return -1;
+        }
+        
+        report_result(task, result, result_size, 1);
+        result_cache_set_result(task, result, result_size);
+        // The dependent it feeds, else a future, takes the buffer as it is
+        if (!task_set_output(task, result, result_size) &&
+            task_future_set_result(task->future, result, result_size) != 0) {
+            free(result);
+        }
+        return 0;
+    }
+    
+    // No Python workers configured, simulate execution
+    simulate_inference(task_data, task ? task->data_size : 0);
     usleep(100000); // Simulate work (100ms)
+    if (task) {
+        simulate_output(task);
+    }
+    
+    return 0;
+}
+
+// Batch callback: one round trip for the whole batch, results scattered
+// back per task
+static int python_inference_execute_batch(task_t **tasks, size_t count) {
+    if (g_orchestrator && g_orchestrator->python_workers) {
+        void *results[TASK_BATCH_MAX_SIZE];
+        size_t result_sizes[TASK_BATCH_MAX_SIZE];
+        if (python_worker_pool_execute_batch(g_orchestrator->python_workers,
+                                             model_path_for(g_orchestrator, tasks[0]->model_id),
+                                             tasks, count, results, result_sizes) != 0) {
+            return -1;
+        }
+        
+        for (size_t i = 0; i < count; i++) {
+            if (tasks[i]->status == TASK_STATUS_COMPLETED) {
+                report_result(tasks[i], results[i], result_sizes[i], count);
+                result_cache_set_result(tasks[i], results[i], result_sizes[i]);
+                if (task_set_output(tasks[i], results[i], result_sizes[i]) ||
+                    task_future_set_result(tasks[i]->future, results[i], result_sizes[i]) == 0) {
+                    continue;
+                }
+            }
+            free(results[i]);
+        }
+        return 0;
+    }
+    
+    // No Python workers configured, simulate one execution for the batch
+    for (size_t i = 0; i < count; i++) {
+        simulate_inference((const char*)tasks[i]->data, tasks[i]->data_size);
+    }
+    printf("Simulated a batch of %zu tasks\n", count);
+    usleep(100000); // Simulate work (100ms)
+    for (size_t i = 0; i < count; i++) {
+        simulate_output(tasks[i]);
+    }
     
     return 0;
 }
@@ -33,28 +253,113 @@ static void python_inference_cleanup(void *data) {
     (void)data; // Suppress unused parameter warning
 }
 
+void orchestrator_config_init(orchestrator_config_t *config) {
+    if (!config) return;
+    
+    config->num_threads = DEFAULT_NUM_THREADS;
+    config->queue_size = DEFAULT_QUEUE_SIZE;
+    config->python_script_path = NULL;
+    config->queue_mode = TASK_QUEUE_MODE_LOCKED;
+    config->aging_ms = DEFAULT_AGING_MS;
+    config->pool_mode = THREAD_POOL_MODE_SHARED_QUEUE;
+    config->python_workers = 0;
+    config->model_path = NULL;
+    config->model_budget_mb = PY_DEFAULT_MODEL_BUDGET_MB;
+    task_batch_config_init(&config->batch);
+    config->batch.max_batch = 1;
+    admission_config_init(&config->admission);
+    config->metrics_socket = NULL;
+    config->metrics_port = 0;
+    cpu_placement_config_init(&config->placement);
+    pool_scaler_config_init(&config->scaler);
+    config->task_timeout_ms = 0;
+    config->result_cache_mb = 0;
+    config->journal_dir = NULL;
+    task_journal_config_init(&config->journal);
+    config->memory_aware = false;
+    memory_budget_config_init(&config->memory);
+    config->task_memory_mb = 0;
+}
+
 orchestrator_t* orchestrator_create(size_t num_threads, size_t queue_size,
                                     const char *python_script_path) {
+    orchestrator_config_t config;
+    orchestrator_config_init(&config);
+    config.num_threads = num_threads;
+    config.queue_size = queue_size;
+    config.python_script_path = python_script_path;
+    
+    return orchestrator_create_with_config(&config);
+}
+
+orchestrator_t* orchestrator_create_with_config(const orchestrator_config_t *config) {
+    if (!config) return NULL;
+    
+    size_t num_threads = config->num_threads;
+    size_t queue_size = config->queue_size;
+    const char *python_script_path = config->python_script_path;
+    
     orchestrator_t *orch = (orchestrator_t*)malloc(sizeof(orchestrator_t));
     if (!orch) return NULL;
     
-    orch->task_queue = task_queue_create(queue_size);
+    // The plan may resize the worker pools to fit the core budget
+    size_t python_workers = config->python_workers;
+    orch->cpu_plan = NULL;
+    const cpu_placement_config_t *placement = &config->placement;
+    if (placement->pin || placement->workload != CPU_WORKLOAD_DEFAULT ||
+        placement->core_budget > 0 || placement->reserved_cores > 0) {
+        cpu_topology_t *topo = cpu_topology_create();
+        orch->cpu_plan = cpu_plan_create(topo, placement, num_threads, python_workers);
+        cpu_topology_destroy(topo);
+        if (orch->cpu_plan) {
+            num_threads = orch->cpu_plan->workers;
+            python_workers = orch->cpu_plan->python_workers;
+        } else {
+            fprintf(stderr, "CPU topology unavailable, keeping the configured threads unpinned\n");
+        }
+    }
+    
+    orch->task_slab = task_slab_create();
+    if (!orch->task_slab) {
+        cpu_plan_destroy(orch->cpu_plan);
+        free(orch);
+        return NULL;
+    }
+    
+    orch->task_queue = task_queue_create_ex(queue_size, config->queue_mode);
     if (!orch->task_queue) {
+        task_slab_destroy(orch->task_slab);
+        cpu_plan_destroy(orch->cpu_plan);
         free(orch);
         return NULL;
     }
+    task_queue_set_aging(orch->task_queue, config->aging_ms * 1000ULL);
     
-    orch->thread_pool = thread_pool_create(num_threads, orch->task_queue);
+    // An elastic pool has a slot for every worker it may grow to
+    bool elastic = config->scaler.max_threads > 0;
+    size_t slots = elastic ? config->scaler.max_threads : num_threads;
+    orch->thread_pool = thread_pool_create_ex(slots, orch->task_queue, config->pool_mode);
     if (!orch->thread_pool) {
         task_queue_destroy(orch->task_queue);
+        task_slab_destroy(orch->task_slab);
+        cpu_plan_destroy(orch->cpu_plan);
         free(orch);
         return NULL;
     }
+    thread_pool_set_placement(orch->thread_pool, orch->cpu_plan);
+    if (elastic) {
+        thread_pool_set_elastic(orch->thread_pool, config->scaler.min_threads, num_threads);
+        num_threads = orch->thread_pool->initial_threads;
+    }
+    orch->scaler_config = config->scaler;
+    orch->scaler = NULL;
     
     orch->resource_monitor = resource_monitor_create(1000); // Check every second
     if (!orch->resource_monitor) {
         thread_pool_destroy(orch->thread_pool);
         task_queue_destroy(orch->task_queue);
+        task_slab_destroy(orch->task_slab);
+        cpu_plan_destroy(orch->cpu_plan);
         free(orch);
         return NULL;
     }
@@ -67,9 +372,151 @@ orchestrator_t* orchestrator_create(size_t num_threads, size_t queue_size,
         orch->python_script_path[MAX_PYTHON_SCRIPT_PATH - 1] = '\0';
     }
     
+    orch->python_workers = NULL;
+    if (python_workers > 0) {
+        orch->python_workers = python_worker_pool_create(python_workers, "python3",
+                                                         orch->python_script_path,
+                                                         config->model_path);
+        if (!orch->python_workers) {
+            resource_monitor_destroy(orch->resource_monitor);
+            thread_pool_destroy(orch->thread_pool);
+            task_queue_destroy(orch->task_queue);
+            task_slab_destroy(orch->task_slab);
+            cpu_plan_destroy(orch->cpu_plan);
+            free(orch);
+            return NULL;
+        }
+        python_worker_pool_set_model_budget(orch->python_workers, config->model_budget_mb);
+        python_worker_pool_set_placement(orch->python_workers, orch->cpu_plan);
+    }
+    
+    orch->batcher = NULL;
+    if (config->batch.max_batch > 1) {
+        orch->batcher = task_batcher_create(&config->batch);
+        if (!orch->batcher) {
+            python_worker_pool_destroy(orch->python_workers);
+            resource_monitor_destroy(orch->resource_monitor);
+            thread_pool_destroy(orch->thread_pool);
+            task_queue_destroy(orch->task_queue);
+            task_slab_destroy(orch->task_slab);
+            cpu_plan_destroy(orch->cpu_plan);
+            free(orch);
+            return NULL;
+        }
+        thread_pool_set_batcher(orch->thread_pool, orch->batcher);
+    }
+    
+    orch->admission = admission_controller_create(&config->admission, orch->task_queue,
+                                                  orch->resource_monitor);
+    if (!orch->admission) {
+        task_batcher_destroy(orch->batcher);
+        python_worker_pool_destroy(orch->python_workers);
+        resource_monitor_destroy(orch->resource_monitor);
+        thread_pool_destroy(orch->thread_pool);
+        task_queue_destroy(orch->task_queue);
+        task_slab_destroy(orch->task_slab);
+        cpu_plan_destroy(orch->cpu_plan);
+        free(orch);
+        return NULL;
+    }
+    
+    if (pthread_mutex_init(&orch->models_mutex, NULL) != 0) {
+        admission_controller_destroy(orch->admission);
+        task_batcher_destroy(orch->batcher);
+        python_worker_pool_destroy(orch->python_workers);
+        resource_monitor_destroy(orch->resource_monitor);
+        thread_pool_destroy(orch->thread_pool);
+        task_queue_destroy(orch->task_queue);
+        task_slab_destroy(orch->task_slab);
+        cpu_plan_destroy(orch->cpu_plan);
+        free(orch);
+        return NULL;
+    }
+    orch->models[0][0] = '\0';
+    atomic_init(&orch->num_models, 1);
+    
+    orch->task_index = task_index_create();
+    if (!orch->task_index) {
+        pthread_mutex_destroy(&orch->models_mutex);
+        admission_controller_destroy(orch->admission);
+        task_batcher_destroy(orch->batcher);
+        python_worker_pool_destroy(orch->python_workers);
+        resource_monitor_destroy(orch->resource_monitor);
+        thread_pool_destroy(orch->thread_pool);
+        task_queue_destroy(orch->task_queue);
+        task_slab_destroy(orch->task_slab);
+        cpu_plan_destroy(orch->cpu_plan);
+        free(orch);
+        return NULL;
+    }
+    
+    // Sleeps until a task with a timeout starts
+    orch->timers = timer_wheel_create(TIMER_WHEEL_DEFAULT_TICK_MS, on_task_timeout, orch);
+    if (!orch->timers) {
+        task_index_destroy(orch->task_index);
+        pthread_mutex_destroy(&orch->models_mutex);
+        admission_controller_destroy(orch->admission);
+        task_batcher_destroy(orch->batcher);
+        python_worker_pool_destroy(orch->python_workers);
+        resource_monitor_destroy(orch->resource_monitor);
+        thread_pool_destroy(orch->thread_pool);
+        task_queue_destroy(orch->task_queue);
+        task_slab_destroy(orch->task_slab);
+        cpu_plan_destroy(orch->cpu_plan);
+        free(orch);
+        return NULL;
+    }
+    thread_pool_set_timer_wheel(orch->thread_pool, orch->timers);
+    orch->task_timeout_ns = config->task_timeout_ms * 1000000ULL;
+    
+    // Optional, so running without it beats failing
+    orch->result_cache = NULL;
+    if (config->result_cache_mb > 0) {
+        orch->result_cache = result_cache_create(config->result_cache_mb * 1024 * 1024);
+        if (!orch->result_cache) {
+            fprintf(stderr, "Failed to create the result cache, continuing without it\n");
+        }
+        result_cache_set_requeue(orch->result_cache, requeue_waiter, orch);
+    }
+    
+    orch->metrics = NULL;
+    orch->metrics_socket[0] = '\0';
+    if (config->metrics_socket) {
+        snprintf(orch->metrics_socket, sizeof(orch->metrics_socket), "%s", config->metrics_socket);
+    }
+    orch->metrics_port = config->metrics_port;
+    
     orch->running = false;
     orch->num_threads = num_threads;
     orch->queue_size = queue_size;
+    orch->signal_pipe[0] = orch->signal_pipe[1] = -1;
+    orch->signal_thread_started = false;
+    orch->task_memory_bytes = (uint64_t)config->task_memory_mb * 1024 * 1024;
+    
+    // Last, so a failure can go through orchestrator_destroy()
+    orch->memory_budget = NULL;
+    orch->journal = NULL;
+    if (config->memory_aware) {
+        orch->memory_budget = memory_budget_create(&config->memory, orch->resource_monitor);
+        if (!orch->memory_budget) {
+            fprintf(stderr, "Failed to create the memory budget\n");
+            orchestrator_destroy(orch);
+            return NULL;
+        }
+        thread_pool_set_memory_budget(orch->thread_pool, orch->memory_budget);
+    }
+    if (config->journal_dir) {
+        orch->journal = task_journal_open(config->journal_dir, &config->journal);
+        if (!orch->journal) {
+            fprintf(stderr, "Failed to open the journal in %s\n", config->journal_dir);
+            orchestrator_destroy(orch);
+            return NULL;
+        }
+        task_journal_stats_t stats;
+        task_journal_get_stats(orch->journal, &stats);
+        printf("Journal: %zu unfinished tasks in %zu records, recovered in %.1f ms\n",
+               stats.recovered, stats.recovered_records, stats.recovery_ns / 1e6);
+    }
     
     return orch;
 }
@@ -77,37 +524,97 @@ orchestrator_t* orchestrator_create(size_t num_threads, size_t queue_size,
 int orchestrator_start(orchestrator_t *orch) {
     if (!orch || orch->running) return -1;
     
-    // Setup signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
     g_orchestrator = orch;
     
+    if (orch->python_workers && python_worker_pool_start(orch->python_workers) != 0) {
+        return -1;
+    }
+    
     if (thread_pool_start(orch->thread_pool) != 0) {
         return -1;
     }
+    if (orch->thread_pool->elastic && !orch->scaler) {
+        orch->scaler = pool_scaler_create(&orch->scaler_config, orch->thread_pool,
+                                          orch->resource_monitor);
+        if (!orch->scaler) {
+            fprintf(stderr, "Failed to start the pool scaler, keeping %zu workers\n",
+                    orch->num_threads);
+        } else {
+            orchestrator_pin_service_thread(orch, orch->scaler->thread);
+        }
+    }
+    orchestrator_pin_service_thread(orch, orch->resource_monitor->thread);
+    orchestrator_pin_service_thread(orch, orch->timers->thread);
+    if (orch->python_workers) {
+        orchestrator_pin_service_thread(orch, orch->python_workers->supervisor);
+    }
+    
+    // After the pool, whose start time the metrics read. Metrics are
+    // optional, so failing to bind only costs the endpoint.
+    if ((orch->metrics_socket[0] || orch->metrics_port) && !orch->metrics) {
+        orch->metrics = metrics_server_create(orch->metrics_socket, orch->metrics_port,
+                                              render_metrics, orch);
+        if (!orch->metrics) {
+            fprintf(stderr, "Failed to start the metrics server, continuing without it\n");
+        } else {
+            orchestrator_pin_service_thread(orch, orch->metrics->thread);
+        }
+    }
     
     orch->running = true;
-    printf("Orchestrator started with %zu threads\n", orch->num_threads);
+    if (!orch->signal_thread_started && start_signal_thread(orch) != 0) {
+        fprintf(stderr, "Failed to set up signal handling, continuing without it\n");
+    }
+    if (orch->scaler) {
+        printf("Orchestrator started with %zu threads (elastic, %zu-%zu)\n", orch->num_threads,
+               orch->scaler->config.min_threads, orch->scaler->config.max_threads);
+    } else {
+        printf("Orchestrator started with %zu threads\n", orch->num_threads);
+    }
     
     return 0;
 }
 
 void orchestrator_stop(orchestrator_t *orch) {
-    if (!orch || !orch->running) return;
+    // Once, whether from the signal thread or the owner
+    if (!orch || !atomic_exchange(&orch->running, false)) return;
     
-    orch->running = false;
+    pool_scaler_stop(orch->scaler);             // no resizing while workers drain
     thread_pool_shutdown(orch->thread_pool);
     printf("Orchestrator stopped\n");
 }
 
+int orchestrator_pin_service_thread(orchestrator_t *orch, pthread_t thread) {
+    if (!orch) return -1;
+    return cpu_plan_pin_service(orch->cpu_plan, thread);
+}
+
 void orchestrator_destroy(orchestrator_t *orch) {
     if (!orch) return;
     
+    stop_signal_thread(orch);               // may be stopping the orchestrator itself
     orchestrator_stop(orch);
     
+    metrics_server_destroy(orch->metrics);     // renders from everything below
+    pool_scaler_destroy(orch->scaler);
     resource_monitor_destroy(orch->resource_monitor);
     thread_pool_destroy(orch->thread_pool);
+    orch->thread_pool = NULL;               // dependents released from here on are dropped
+    timer_wheel_destroy(orch->timers);      // no task is running to time
+    python_worker_pool_destroy(orch->python_workers);  // no task can reach it now
+    task_batcher_destroy(orch->batcher);
+    admission_controller_destroy(orch->admission);
+    pthread_mutex_destroy(&orch->models_mutex);
+    if (orch->journal) {
+        orchestrator_checkpoint(orch);      // leftovers never ran, so they replay
+    }
+    memory_budget_destroy(orch->memory_budget);  // tasks set aside never ran either
     task_queue_destroy(orch->task_queue);
+    result_cache_destroy(orch->result_cache);  // leftover leaders settle their waiters first
+    task_journal_close(orch->journal);      // every journaled task is gone now
+    task_index_destroy(orch->task_index);   // leftover tasks leave it as they are destroyed
+    task_slab_destroy(orch->task_slab);    // after every task has been returned
+    cpu_plan_destroy(orch->cpu_plan);       // after the pools that point to it
     free(orch);
     
     if (g_orchestrator == orch) {
@@ -115,44 +622,960 @@ void orchestrator_destroy(orchestrator_t *orch) {
     }
 }
 
+// Slab task wired to the inference callbacks and findable by
+// orchestrator_cancel(); the caller sets up ownership
+static task_t* prepare_task(orchestrator_t *orch, const char *task_id,
+                            task_priority_t priority, void *data, size_t data_size) {
+    task_t *task = task_slab_alloc(orch->task_slab);
+    if (!task) return NULL;
+    
+    task_init(task, task_id, priority, data, data_size,
+              python_inference_execute,
+              python_inference_cleanup);
+    task->data_free = NULL;
+    task->timeout_ns = orch->task_timeout_ns;
+    task->memory_bytes = orch->task_memory_bytes;
+    task_index_insert(orch->task_index, task);
+    
+    // One model per orchestrator, so payload size stands in for input shape
+    if (orch->batcher) {
+        task->batch_callback = python_inference_execute_batch;
+        task->batch_key = data_size;
+    }
+    
+    return task;
+}
+
+// On failure the task is destroyed without touching its data, so the
+// caller still owns whatever it passed in.
+static int enqueue_task(orchestrator_t *orch, task_t *task, uint64_t timeout_us,
+                        size_t *queue_depth) {
+    // Write-ahead: journaled before anything can run it. Graph nodes are
+    // not journaled, a lone node would replay without its edges.
+    if (orch->journal && !task->dependents && task_journal_append(orch->journal, task) != 0) {
+        printf("Task '%s' rejected: journal write failed\n", task->task_id);
+        task->data_free = NULL;
+        task->done_callback = NULL;
+        task->future = NULL;
+        task_destroy(task);
+        return -1;
+    }
+    
+    // A cached answer has no output to hand to dependents
+    if (orch->result_cache && !task->dependents) {
+        // Answered or attached, the task may be gone once routed
+        char task_id[MAX_TASK_ID_LEN];
+        memcpy(task_id, task->task_id, sizeof(task_id));
+        task_priority_t priority = task->priority;
+        result_cache_route_t route = result_cache_route(orch->result_cache, task);
+        if (route != RESULT_CACHE_MISS) {
+            printf("Task '%s' submitted with priority %d, %s\n", task_id, priority,
+                   route == RESULT_CACHE_HIT ? "answered from the result cache" :
+                   "attached to an identical task in flight");
+            if (queue_depth) *queue_depth = task_queue_size(orch->task_queue);
+            return 0;
+        }
+    }
+    
+    int result;
+    if (thread_pool_current_task()) {
+        // Spawned by a running task, which was already admitted; this lands
+        // on the worker's local deque
+        result = thread_pool_submit(orch->thread_pool, task);
+        if (queue_depth) *queue_depth = task_queue_size(orch->task_queue);
+    } else {
+        admission_verdict_t verdict = admission_enqueue(orch->admission, task, timeout_us, queue_depth);
+        if (verdict != ADMISSION_ACCEPTED) {
+            printf("Task '%s' rejected: %s\n", task->task_id, admission_verdict_name(verdict));
+        }
+        result = (verdict == ADMISSION_ACCEPTED) ? 0 : -1;
+    }
+    
+    if (result != 0) {
+        task->data_free = NULL;
+        task->done_callback = NULL;
+        task->future = NULL;            // the submitter discards it
+        task_destroy(task);
+        return -1;
+    }
+    
+    printf("Task '%s' submitted with priority %d\n", task->task_id, task->priority);
+    return 0;
+}
+
+// Copying submit shared by the plain, blocking, deadline and try variants
+static int submit_copy(orchestrator_t *orch, const char *task_id, task_priority_t priority,
+                       uint32_t model_id, void *data, size_t data_size,
+                       uint64_t deadline_ns, uint64_t timeout_us, size_t *queue_depth,
+                       task_future_t *future) {
+    if (!orch || !task_id || (!data && data_size > 0)) return -1;
+    if (model_id >= atomic_load_explicit(&orch->num_models, memory_order_acquire)) return -1;
+    
+    task_t *task = prepare_task(orch, task_id, priority, NULL, data_size);
+    if (!task) return -1;
+    task->model_id = model_id;
+    task->deadline_ns = deadline_ns;
+    
+    // Small payloads are copied into the slab object itself
+    void *task_data = task_slab_inline_data(task);
+    bool inline_data = (data_size <= TASK_INLINE_DATA_SIZE);
+    if (!inline_data) {
+        task_data = malloc(data_size);
+        if (!task_data) {
+            task_destroy(task);
+            return -1;
+        }
+    }
+    memcpy(task_data, data, data_size);
+    
+    task->data = task_data;
+    task->data_free = inline_data ? NULL : free;
+    task->future = future;
+    if (enqueue_task(orch, task, timeout_us, queue_depth) != 0) {
+        if (!inline_data) {
+            free(task_data);
+        }
+        return -1;
+    }
+    
+    return 0;
+}
+
 int orchestrator_submit_task(orchestrator_t *orch, const char *task_id,
                             task_priority_t priority, void *data, size_t data_size) {
+    return submit_copy(orch, task_id, priority, 0, data, data_size, 0, 0, NULL, NULL);
+}
+
+int orchestrator_submit_task_future(orchestrator_t *orch, const char *task_id,
+                                    task_priority_t priority, void *data, size_t data_size,
+                                    completion_queue_t *queue, task_future_t **future) {
+    if (future) *future = NULL;
+    if (!queue && !future) {
+        return submit_copy(orch, task_id, priority, 0, data, data_size, 0, 0, NULL, NULL);
+    }
+    
+    task_future_t *handle = task_future_create(queue, future != NULL);
+    if (!handle) return -1;
+    if (submit_copy(orch, task_id, priority, 0, data, data_size, 0, 0, NULL, handle) != 0) {
+        task_future_discard(handle);
+        return -1;
+    }
+    
+    if (future) *future = handle;
+    return 0;
+}
+
+int orchestrator_submit_task_timeout(orchestrator_t *orch, const char *task_id,
+                                     task_priority_t priority, void *data, size_t data_size,
+                                     uint64_t timeout_ms) {
+    return submit_copy(orch, task_id, priority, 0, data, data_size, 0, timeout_ms * 1000ULL,
+                       NULL, NULL);
+}
+
+int orchestrator_submit_task_deadline(orchestrator_t *orch, const char *task_id,
+                                      task_priority_t priority, void *data, size_t data_size,
+                                      uint64_t deadline_ns) {
+    return submit_copy(orch, task_id, priority, 0, data, data_size, deadline_ns, 0, NULL, NULL);
+}
+
+int orchestrator_try_submit_task(orchestrator_t *orch, const char *task_id,
+                                 task_priority_t priority, void *data, size_t data_size,
+                                 size_t *queue_depth) {
+    return submit_copy(orch, task_id, priority, 0, data, data_size, 0, 0, queue_depth, NULL);
+}
+
+int orchestrator_submit_model_task(orchestrator_t *orch, const char *task_id,
+                                   task_priority_t priority, uint32_t model_id,
+                                   void *data, size_t data_size) {
+    return submit_copy(orch, task_id, priority, model_id, data, data_size, 0, 0, NULL, NULL);
+}
+
+// Slab task holding a copy of the submission's payload
+static task_t* prepare_submission(orchestrator_t *orch, const task_submission_t *submission,
+                                  payload_arena_t *arena) {
+    if (!submission->task_id || (!submission->data && submission->data_size > 0) ||
+        submission->model_id >= atomic_load_explicit(&orch->num_models, memory_order_acquire)) {
+        return NULL;
+    }
+    
+    task_t *task = prepare_task(orch, submission->task_id, submission->priority,
+                                NULL, submission->data_size);
+    if (!task) return NULL;
+    
+    void *task_data = task_slab_inline_data(task);
+    if (submission->data_size > TASK_INLINE_DATA_SIZE) {
+        // Payloads bigger than an arena block fall back to malloc
+        task_data = arena ? payload_arena_alloc(arena, submission->data_size) : NULL;
+        task->data_free = payload_arena_release;
+        if (!task_data) {
+            task_data = malloc(submission->data_size);
+            task->data_free = free;
+        }
+        if (!task_data) {
+            task->data_free = NULL;
+            task_destroy(task);
+            return NULL;
+        }
+    }
+    if (submission->data_size > 0) {
+        memcpy(task_data, submission->data, submission->data_size);
+    }
+    
+    task->data = task_data;
+    task->model_id = submission->model_id;
+    task->deadline_ns = submission->deadline_ns;
+    if (submission->timeout_ns) {
+        task->timeout_ns = submission->timeout_ns;
+    }
+    if (submission->memory_bytes) {
+        task->memory_bytes = submission->memory_bytes;
+    }
+    task->done_callback = submission->on_done;
+    task->done_ctx = submission->done_ctx;
+    return task;
+}
+
+size_t orchestrator_submit_batch(orchestrator_t *orch, const task_submission_t *submissions,
+                                 size_t count, payload_arena_t *arena, int *results) {
+    if (!orch || !submissions || !results) return 0;
+    
+    size_t accepted = 0;
+    for (size_t start = 0; start < count; start += ADMISSION_BATCH_MAX) {
+        size_t chunk = count - start < ADMISSION_BATCH_MAX ? count - start : ADMISSION_BATCH_MAX;
+        task_t *tasks[ADMISSION_BATCH_MAX];
+        size_t index[ADMISSION_BATCH_MAX];
+        size_t prepared = 0;
+        
+        for (size_t i = start; i < start + chunk; i++) {
+            results[i] = -1;
+            task_t *task = prepare_submission(orch, &submissions[i], arena);
+            if (task && orch->journal && task_journal_append(orch->journal, task) != 0) {
+                task->done_callback = NULL;
+                task_destroy(task);
+                task = NULL;
+            }
+            if (task && orch->result_cache &&
+                result_cache_route(orch->result_cache, task) != RESULT_CACHE_MISS) {
+                // Answered from the cache or riding along with a twin in flight
+                results[i] = ADMISSION_ACCEPTED;
+                accepted++;
+            } else if (task) {
+                index[prepared] = i;
+                tasks[prepared++] = task;
+            }
+        }
+        
+        admission_verdict_t verdicts[ADMISSION_BATCH_MAX];
+        if (thread_pool_current_task()) {
+            // Spawned by a running task, which was already admitted
+            for (size_t j = 0; j < prepared; j++) {
+                verdicts[j] = thread_pool_submit(orch->thread_pool, tasks[j]) == 0
+                            ? ADMISSION_ACCEPTED : ADMISSION_QUEUE_FULL;
+            }
+        } else {
+            admission_enqueue_batch(orch->admission, tasks, prepared, verdicts);
+        }
+        
+        for (size_t j = 0; j < prepared; j++) {
+            results[index[j]] = (int)verdicts[j];
+            if (verdicts[j] == ADMISSION_ACCEPTED) {
+                accepted++;
+            } else {
+                // Not the submitter's data, so the copy is released; on_done
+                // is only for accepted tasks
+                tasks[j]->done_callback = NULL;
+                task_destroy(tasks[j]);
+            }
+        }
+    }
+    
+    return accepted;
+}
+
+// Release callback of graph nodes: the last parent just finished, most
+// likely on a worker
+static void release_dependent(task_t *task, bool chain, void *ctx) {
+    orchestrator_t *orch = (orchestrator_t*)ctx;
+    
+    // An input handed down may have changed the payload size
+    if (task->batch_callback) {
+        task->batch_key = task->data_size;
+    }
+    if (!orch->thread_pool || thread_pool_release(orch->thread_pool, task, chain) != 0) {
+        // Shut down, or no room from outside a worker; it never runs
+        task->status = TASK_STATUS_CANCELLED;
+        task->error = ECANCELED;
+        task_destroy(task);
+    }
+}
+
+static bool valid_graph(const task_graph_node_t *nodes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const task_graph_node_t *node = &nodes[i];
+        if (node->num_parents > ORCHESTRATOR_MAX_PARENTS) return false;
+        
+        bool input_found = (node->input_from < 0);
+        for (size_t p = 0; p < node->num_parents; p++) {
+            // Parents come first, so there is no cycle to look for
+            if (node->parents[p] < 0 || (size_t)node->parents[p] >= i) return false;
+            if (node->parents[p] == node->input_from) input_found = true;
+        }
+        if (!input_found) return false;
+    }
+    return true;
+}
+
+// Nothing is queued yet, so the graph comes apart without releasing anything
+static void discard_graph(task_t **tasks, task_future_t **futures, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (tasks[i]) {
+            task_graph_unlink(tasks[i]);
+            tasks[i]->done_callback = NULL;
+            tasks[i]->future = NULL;
+            task_destroy(tasks[i]);
+        }
+        if (futures[i]) {
+            task_future_discard(futures[i]);
+        }
+    }
+}
+
+int orchestrator_submit_graph(orchestrator_t *orch, const task_graph_node_t *nodes,
+                              size_t count, completion_queue_t *queue) {
+    if (!orch || !nodes || count == 0 || !valid_graph(nodes, count)) return -1;
+    
+    task_t **tasks = (task_t**)calloc(count, sizeof(task_t*));
+    task_future_t **futures = (task_future_t**)calloc(count, sizeof(task_future_t*));
+    if (!tasks || !futures) {
+        free(tasks);
+        free(futures);
+        return -1;
+    }
+    
+    bool built = true;
+    for (size_t i = 0; i < count && built; i++) {
+        task_submission_t submission = nodes[i].task;
+        if (nodes[i].input_from >= 0) {
+            submission.data = NULL;
+            submission.data_size = 0;
+        }
+        tasks[i] = prepare_submission(orch, &submission, NULL);
+        if (queue && tasks[i]) {
+            futures[i] = task_future_create(queue, false);
+        }
+        built = tasks[i] && (!queue || futures[i]);
+        if (!built) break;
+        
+        tasks[i]->release_callback = release_dependent;
+        tasks[i]->release_ctx = orch;
+        for (size_t p = 0; p < nodes[i].num_parents && built; p++) {
+            int parent = nodes[i].parents[p];
+            built = task_graph_add_edge(tasks[parent], tasks[i], parent == nodes[i].input_from) == 0;
+        }
+    }
+    if (!built) {
+        discard_graph(tasks, futures, count);
+        free(tasks);
+        free(futures);
+        return -1;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        tasks[i]->future = futures[i];
+    }
+    
+    // Once the first root is in, any node may finish; only roots not yet
+    // submitted are touched from here
+    size_t roots = 0, admitted = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (nodes[i].num_parents > 0) continue;
+        
+        roots++;
+        void *copy = tasks[i]->data_free ? tasks[i]->data : NULL;
+        if (enqueue_task(orch, tasks[i], 0, NULL) == 0) {
+            admitted++;
+            continue;
+        }
+        // Rejected: its dependents are cancelled already, its copy is ours
+        free(copy);
+        if (futures[i]) {
+            task_future_discard(futures[i]);
+        }
+    }
+    
+    printf("Graph of %zu tasks submitted, %zu of %zu roots admitted\n", count, admitted, roots);
+    free(tasks);
+    free(futures);
+    return (int)admitted;
+}
+
+int orchestrator_submit_task_owned(orchestrator_t *orch, const char *task_id,
+                                   task_priority_t priority, void *data, size_t data_size,
+                                   void (*free_fn)(void *data)) {
+    if (!orch || !task_id || !data) return -1;
+    
+    task_t *task = prepare_task(orch, task_id, priority, data, data_size);
+    if (!task) return -1;
+    
+    task->data_free = free_fn;
+    return enqueue_task(orch, task, 0, NULL);
+}
+
+int orchestrator_submit_task_borrowed(orchestrator_t *orch, const char *task_id,
+                                      task_priority_t priority, void *data, size_t data_size,
+                                      task_done_callback_t on_done, void *ctx) {
+    if (!orch || !task_id || !data || !on_done) return -1;
+    
+    task_t *task = prepare_task(orch, task_id, priority, data, data_size);
+    if (!task) return -1;
+    
+    task->done_callback = on_done;
+    task->done_ctx = ctx;
+    return enqueue_task(orch, task, 0, NULL);
+}
+
+int orchestrator_submit_task_arena(orchestrator_t *orch, const char *task_id,
+                                   task_priority_t priority, void *data, size_t data_size) {
+    if (!orch || !task_id || !data) return -1;
+    
+    task_t *task = prepare_task(orch, task_id, priority, data, data_size);
+    if (!task) return -1;
+    
+    task->data_free = payload_arena_release;
+    return enqueue_task(orch, task, 0, NULL);
+}
+
+size_t orchestrator_replay_journal(orchestrator_t *orch) {
+    if (!orch || !orch->journal) return 0;
+    
+    size_t replayed = 0, dropped = 0;
+    task_journal_record_t record;
+    while (task_journal_next_recovered(orch->journal, &record)) {
+        // Ids beyond this run's models fall back to the default one
+        size_t num_models = atomic_load_explicit(&orch->num_models, memory_order_acquire);
+        task_t *task = prepare_task(orch, record.task_id, record.priority, NULL, record.data_size);
+        void *task_data = task ? task_slab_inline_data(task) : NULL;
+        if (task && record.data_size > TASK_INLINE_DATA_SIZE) {
+            task_data = malloc(record.data_size);
+            task->data_free = free;
+        }
+        if (!task || !task_data) {
+            // Left unfinished in the journal for the next start
+            if (task) {
+                task->data_free = NULL;
+                task_destroy(task);
+            }
+            dropped++;
+            continue;
+        }
+        memcpy(task_data, record.data, record.data_size);
+        task->data = task_data;
+        task->model_id = record.model_id < num_models ? record.model_id : 0;
+        task->deadline_ns = record.deadline_ns;
+        if (record.timeout_ns) {
+            task->timeout_ns = record.timeout_ns;
+        }
+        if (record.memory_bytes) {
+            task->memory_bytes = record.memory_bytes;
+        }
+        task_journal_adopt(orch->journal, task, &record);
+        
+        // Already admitted once, so only the queue bound applies
+        int result;
+        while ((result = thread_pool_submit(orch->thread_pool, task)) != 0 &&
+               orchestrator_is_running(orch) &&
+               task_queue_wait_for_room(orch->task_queue, orch->task_queue->max_size, 100000)) {
+        }
+        if (result != 0) {
+            task_journal_detach(task);
+            task_destroy(task);
+            dropped++;
+            continue;
+        }
+        replayed++;
+    }
+    
+    if (replayed || dropped) {
+        printf("Journal: replayed %zu unfinished tasks", replayed);
+        if (dropped) {
+            printf(", %zu left for the next start", dropped);
+        }
+        printf("\n");
+    }
+    return replayed;
+}
+
+size_t orchestrator_checkpoint(orchestrator_t *orch) {
+    if (!orch || !orch->journal) return 0;
+    
+    // ESHUTDOWN tells task_journal_complete() to leave them unfinished;
+    // their futures and callbacks see the same
+    size_t count = 0;
+    task_t *task;
+    while ((task = task_queue_try_dequeue(orch->task_queue)) != NULL) {
+        task->status = TASK_STATUS_CANCELLED;
+        task->error = ESHUTDOWN;
+        task_destroy(task);
+        count++;
+    }
+    // Set aside for memory, they never ran either
+    count += memory_budget_drain(orch->memory_budget);
+    task_journal_sync(orch->journal);
+    
+    return count;
+}
+
+int orchestrator_cancel(orchestrator_t *orch, const char *task_id) {
     if (!orch || !task_id) return -1;
     
-    // Check resource health before submitting
-    if (!resource_monitor_is_healthy(orch->resource_monitor, 90.0, 85.0)) {
-        printf("Warning: System resources high, task may be delayed\n");
+    size_t cancelled = task_index_cancel(orch->task_index, task_id, ECANCELED);
+    if (cancelled > 0) {
+        printf("Task '%s' cancelled\n", task_id);
     }
+    return (int)cancelled;
+}
+
+void orchestrator_print_batch_stats(orchestrator_t *orch) {
+    if (!orch || !orch->batcher) return;
     
-    // Allocate and copy task data
-    void *task_data = malloc(data_size);
-    if (!task_data) return -1;
-    memcpy(task_data, data, data_size);
+    printf("Batch size distribution:\n");
+    task_batcher_print_stats(orch->batcher, stdout);
+}
+
+void orchestrator_print_admission_stats(orchestrator_t *orch) {
+    if (!orch) return;
+    
+    printf("Admission:\n");
+    admission_print_stats(orch->admission, stdout);
+    
+    // Admitted, then never finished: not admission decisions
+    printf("Dropped after admission:\n");
+    printf("  past deadline: %llu\n",
+           (unsigned long long)thread_pool_expired_count(orch->thread_pool));
     
-    task_t *task = task_create(task_id, priority, task_data, data_size,
-                              python_inference_execute,
-                              python_inference_cleanup);
+    uint64_t cancelled = 0, timed_out = 0;
+    thread_pool_worker_stats_t stats;
+    for (size_t i = 0; i < orch->thread_pool->num_threads; i++) {
+        if (thread_pool_get_worker_stats(orch->thread_pool, i, &stats) == 0) {
+            cancelled += stats.cancelled;
+            timed_out += stats.timed_out;
+        }
+    }
+    printf("  cancelled: %llu, timed out: %llu\n",
+           (unsigned long long)cancelled, (unsigned long long)timed_out);
+}
+
+int orchestrator_get_latency(orchestrator_t *orch, latency_snapshot_t *snapshot) {
+    if (!orch || !snapshot) return -1;
+    
+    thread_pool_get_latency(orch->thread_pool, snapshot);
+    return 0;
+}
+
+void orchestrator_print_latency_stats(orchestrator_t *orch) {
+    if (!orch) return;
+    
+    latency_snapshot_t snapshot;
+    thread_pool_get_latency(orch->thread_pool, &snapshot);
+    printf("Latency:\n");
+    task_latency_print(&snapshot, stdout);
+}
+
+int orchestrator_register_model(orchestrator_t *orch, const char *model_path) {
+    if (!orch || !model_path || !model_path[0] ||
+        strlen(model_path) >= MAX_PYTHON_SCRIPT_PATH) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&orch->models_mutex);
+    
+    size_t count = atomic_load_explicit(&orch->num_models, memory_order_relaxed);
+    for (size_t i = 1; i < count; i++) {
+        if (strcmp(orch->models[i], model_path) == 0) {
+            pthread_mutex_unlock(&orch->models_mutex);
+            return (int)i;
+        }
+    }
+    if (count == ORCHESTRATOR_MAX_MODELS) {
+        pthread_mutex_unlock(&orch->models_mutex);
+        return -1;
+    }
+    
+    // Publish the entry before the count so lock-free readers see it whole
+    strcpy(orch->models[count], model_path);
+    atomic_store_explicit(&orch->num_models, count + 1, memory_order_release);
+    
+    pthread_mutex_unlock(&orch->models_mutex);
+    return (int)count;
+}
+
+int orchestrator_submit_tensor(orchestrator_t *orch, const char *task_id,
+                               task_priority_t priority, uint32_t model_id,
+                               const tensor_desc_t *desc, const void *tensor_data) {
+    if (!orch || !task_id || !desc) return -1;
+    if (model_id >= atomic_load_explicit(&orch->num_models, memory_order_acquire)) return -1;
+    
+    size_t frame_size = tensor_frame_size(desc);
+    void *frame = malloc(frame_size);
+    if (!frame) return -1;
+    
+    if (tensor_frame_encode(frame, frame_size, task_id, 0, desc, tensor_data, NULL) != 0) {
+        free(frame);
+        return -1;
+    }
+    
+    task_t *task = prepare_task(orch, task_id, priority, frame, frame_size);
     if (!task) {
-        free(task_data);
+        free(frame);
         return -1;
     }
+    task->model_id = model_id;
     
-    int result = task_queue_enqueue(orch->task_queue, task);
-    if (result != 0) {
-        task_destroy(task);
+    // Tensors batch by dtype and trailing dimensions, not payload size
+    if (task->batch_callback) {
+        task->batch_key = tensor_batch_key(desc);
+    }
+    
+    task->data_free = free;
+    if (enqueue_task(orch, task, 0, NULL) != 0) {
+        free(frame);
         return -1;
     }
     
-    printf("Task '%s' submitted with priority %d\n", task_id, priority);
     return 0;
 }
 
+void orchestrator_print_worker_stats(orchestrator_t *orch) {
+    if (!orch) return;
+    
+    pool_scaler_print_stats(orch->scaler, stdout);
+    
+    uint64_t chained = 0;
+    thread_pool_worker_stats_t worker;
+    for (size_t i = 0; i < orch->thread_pool->num_threads; i++) {
+        if (thread_pool_get_worker_stats(orch->thread_pool, i, &worker) == 0) {
+            chained += worker.chained;
+        }
+    }
+    if (chained > 0) {
+        printf("Dependent tasks run next on their parent's worker: %llu\n",
+               (unsigned long long)chained);
+    }
+    if (!orch->python_workers) return;
+    
+    python_worker_stats_t stats;
+    python_worker_pool_get_stats(orch->python_workers, &stats);
+    printf("Python workers: %llu completed, %llu failed, %llu restarts, %llu killed on timeout, "
+           "%llu model affinity hits\n",
+           (unsigned long long)stats.completed, (unsigned long long)stats.failed,
+           (unsigned long long)stats.restarts, (unsigned long long)stats.killed,
+           (unsigned long long)stats.affinity_hits);
+}
+
+void orchestrator_print_cache_stats(orchestrator_t *orch) {
+    if (!orch) return;
+    result_cache_print_stats(orch->result_cache, stdout);
+}
+
+void orchestrator_print_journal_stats(orchestrator_t *orch) {
+    if (!orch) return;
+    task_journal_print_stats(orch->journal, stdout);
+}
+
+void orchestrator_print_memory_stats(orchestrator_t *orch) {
+    if (!orch) return;
+    memory_budget_print_stats(orch->memory_budget, stdout);
+}
+
+static const char *metric_levels[TASK_PRIORITY_LEVELS] = { "low", "normal", "high", "critical" };
+static const char *metric_stages[LATENCY_METRICS] = { "queue_wait", "execution", "end_to_end" };
+
+// Histogram bounds in seconds. Each is filled with the log-linear buckets
+// lying wholly below it, so a count may trail by one bucket (6.25%).
+static const double latency_bounds[] = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+    0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+static const struct {
+    const char *name;
+    const char *help;
+    size_t field;               // uint64_t in thread_pool_worker_stats_t
+    bool seconds;               // field is in nanoseconds
+} worker_metrics[] = {
+    { "orchestrator_tasks_completed_total", "Tasks that ran successfully, by worker.",
+      offsetof(thread_pool_worker_stats_t, completed), false },
+    { "orchestrator_tasks_failed_total", "Tasks that ran and failed, by worker.",
+      offsetof(thread_pool_worker_stats_t, failed), false },
+    { "orchestrator_tasks_expired_total", "Tasks dropped past their deadline, by worker.",
+      offsetof(thread_pool_worker_stats_t, expired), false },
+    { "orchestrator_tasks_cancelled_total", "Tasks cancelled while queued or running, by worker.",
+      offsetof(thread_pool_worker_stats_t, cancelled), false },
+    { "orchestrator_tasks_timed_out_total", "Tasks stopped for overrunning their timeout, by worker.",
+      offsetof(thread_pool_worker_stats_t, timed_out), false },
+    { "orchestrator_tasks_chained_total", "Dependent tasks run next on the worker that ran their parent.",
+      offsetof(thread_pool_worker_stats_t, chained), false },
+    { "orchestrator_worker_busy_seconds_total", "Time spent running tasks, by worker.",
+      offsetof(thread_pool_worker_stats_t, busy_ns), true },
+    { "orchestrator_worker_idle_seconds_total", "Time since start not spent running tasks, by worker.",
+      offsetof(thread_pool_worker_stats_t, idle_ns), true }
+};
+
+static void write_header(FILE *out, const char *name, const char *type, const char *help) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void write_latency(orchestrator_t *orch, FILE *out) {
+    uint64_t counts[LATENCY_BUCKETS];
+    const char *name = "orchestrator_task_latency_seconds";
+    write_header(out, name, "histogram",
+                 "Task queue wait, execution and end-to-end latency by priority.");
+    
+    thread_pool_t *pool = orch->thread_pool;
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        for (int metric = 0; metric < LATENCY_METRICS; metric++) {
+            uint64_t sum;
+            task_latency_merge(pool->latency, pool->num_threads, level,
+                               (latency_metric_t)metric, counts, &sum, NULL);
+            
+            uint64_t cumulative = 0;
+            size_t bucket = 0;
+            for (size_t b = 0; b < sizeof(latency_bounds) / sizeof(latency_bounds[0]); b++) {
+                uint64_t bound_ns = (uint64_t)(latency_bounds[b] * 1e9);
+                while (bucket < LATENCY_BUCKETS && task_latency_bucket_limit(bucket) <= bound_ns) {
+                    cumulative += counts[bucket++];
+                }
+                fprintf(out, "%s_bucket{priority=\"%s\",stage=\"%s\",le=\"%g\"} %llu\n",
+                        name, metric_levels[level], metric_stages[metric], latency_bounds[b],
+                        (unsigned long long)cumulative);
+            }
+            while (bucket < LATENCY_BUCKETS) {
+                cumulative += counts[bucket++];
+            }
+            fprintf(out, "%s_bucket{priority=\"%s\",stage=\"%s\",le=\"+Inf\"} %llu\n",
+                    name, metric_levels[level], metric_stages[metric], (unsigned long long)cumulative);
+            fprintf(out, "%s_sum{priority=\"%s\",stage=\"%s\"} %.9f\n",
+                    name, metric_levels[level], metric_stages[metric], sum / 1e9);
+            fprintf(out, "%s_count{priority=\"%s\",stage=\"%s\"} %llu\n",
+                    name, metric_levels[level], metric_stages[metric], (unsigned long long)cumulative);
+        }
+    }
+}
+
+void orchestrator_write_metrics(orchestrator_t *orch, FILE *out) {
+    if (!orch || !out) return;
+    
+    size_t depth[TASK_PRIORITY_LEVELS];
+    task_queue_level_sizes(orch->task_queue, depth);
+    write_header(out, "orchestrator_queue_depth", "gauge", "Tasks waiting in the queue by priority.");
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        fprintf(out, "orchestrator_queue_depth{priority=\"%s\"} %zu\n", metric_levels[level], depth[level]);
+    }
+    write_header(out, "orchestrator_queue_capacity", "gauge", "Task queue capacity.");
+    fprintf(out, "orchestrator_queue_capacity %zu\n", orch->task_queue->max_size);
+    
+    admission_stats_t admission;
+    admission_get_stats(orch->admission, &admission);
+    write_header(out, "orchestrator_tasks_submitted_total", "counter",
+                 "Tasks admitted to the queue from outside the workers.");
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        fprintf(out, "orchestrator_tasks_submitted_total{priority=\"%s\"} %llu\n",
+                metric_levels[level], (unsigned long long)admission.accepted[level]);
+    }
+    write_header(out, "orchestrator_tasks_rejected_total", "counter", "Tasks refused by admission control.");
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        const uint64_t reasons[] = {
+            admission.queue_full[level], admission.rate_limited[level], admission.shed[level]
+        };
+        static const char *reason_names[] = { "queue_full", "rate_limited", "shed" };
+        for (size_t r = 0; r < sizeof(reasons) / sizeof(reasons[0]); r++) {
+            fprintf(out, "orchestrator_tasks_rejected_total{priority=\"%s\",reason=\"%s\"} %llu\n",
+                    metric_levels[level], reason_names[r], (unsigned long long)reasons[r]);
+        }
+    }
+    
+    write_header(out, "orchestrator_workers_active", "gauge", "Worker threads currently running.");
+    fprintf(out, "orchestrator_workers_active %zu\n", thread_pool_active_threads(orch->thread_pool));
+    if (orch->scaler) {
+        pool_scaler_stats_t scaler;
+        pool_scaler_get_stats(orch->scaler, &scaler);
+        write_header(out, "orchestrator_workers_limit", "gauge",
+                     "Most workers the elastic pool may run, after the cgroup CPU quota.");
+        fprintf(out, "orchestrator_workers_limit %zu\n", scaler.limit);
+        write_header(out, "orchestrator_worker_utilization", "gauge",
+                     "Smoothed busy share of the active workers.");
+        fprintf(out, "orchestrator_worker_utilization %.3f\n", scaler.utilization);
+        write_header(out, "orchestrator_workers_added_total", "counter", "Workers added by the pool scaler.");
+        fprintf(out, "orchestrator_workers_added_total %llu\n", (unsigned long long)scaler.grown);
+        write_header(out, "orchestrator_workers_retired_total", "counter", "Workers retired by the pool scaler.");
+        fprintf(out, "orchestrator_workers_retired_total %llu\n", (unsigned long long)scaler.shrunk);
+    }
+    
+    // Workers keep their own counters; each slot gets its own series
+    size_t workers = orch->thread_pool->num_threads;
+    thread_pool_worker_stats_t *stats = (thread_pool_worker_stats_t*)calloc(workers, sizeof(*stats));
+    if (stats) {
+        for (size_t i = 0; i < workers; i++) {
+            thread_pool_get_worker_stats(orch->thread_pool, i, &stats[i]);
+        }
+        
+        for (size_t m = 0; m < sizeof(worker_metrics) / sizeof(worker_metrics[0]); m++) {
+            write_header(out, worker_metrics[m].name, "counter", worker_metrics[m].help);
+            for (size_t i = 0; i < workers; i++) {
+                uint64_t value = *(const uint64_t*)((const char*)&stats[i] + worker_metrics[m].field);
+                if (worker_metrics[m].seconds) {
+                    fprintf(out, "%s{worker=\"%zu\"} %.6f\n", worker_metrics[m].name, i, value / 1e9);
+                } else {
+                    fprintf(out, "%s{worker=\"%zu\"} %llu\n", worker_metrics[m].name, i,
+                            (unsigned long long)value);
+                }
+            }
+        }
+        free(stats);
+    }
+    
+    if (orch->result_cache) {
+        result_cache_stats_t cache;
+        result_cache_get_stats(orch->result_cache, &cache);
+        write_header(out, "orchestrator_result_cache_lookups_total", "counter",
+                     "Submissions looked up in the result cache, by outcome.");
+        fprintf(out, "orchestrator_result_cache_lookups_total{outcome=\"hit\"} %llu\n",
+                (unsigned long long)cache.hits);
+        fprintf(out, "orchestrator_result_cache_lookups_total{outcome=\"coalesced\"} %llu\n",
+                (unsigned long long)cache.coalesced);
+        fprintf(out, "orchestrator_result_cache_lookups_total{outcome=\"miss\"} %llu\n",
+                (unsigned long long)cache.misses);
+        write_header(out, "orchestrator_result_cache_evictions_total", "counter",
+                     "Results dropped to stay within the cache budget.");
+        fprintf(out, "orchestrator_result_cache_evictions_total %llu\n",
+                (unsigned long long)cache.evictions);
+        write_header(out, "orchestrator_result_cache_entries", "gauge", "Results held in the cache.");
+        fprintf(out, "orchestrator_result_cache_entries %zu\n", cache.entries);
+        write_header(out, "orchestrator_result_cache_bytes", "gauge",
+                     "Bytes held by cached results and their keys.");
+        fprintf(out, "orchestrator_result_cache_bytes %zu\n", cache.bytes);
+        write_header(out, "orchestrator_result_cache_budget_bytes", "gauge", "Result cache byte budget.");
+        fprintf(out, "orchestrator_result_cache_budget_bytes %zu\n", cache.budget);
+    }
+    
+    if (orch->journal) {
+        task_journal_stats_t journal;
+        task_journal_get_stats(orch->journal, &journal);
+        write_header(out, "orchestrator_journal_records_total", "counter",
+                     "Records appended to the journal since start, by type.");
+        fprintf(out, "orchestrator_journal_records_total{type=\"submit\"} %llu\n",
+                (unsigned long long)journal.submitted);
+        fprintf(out, "orchestrator_journal_records_total{type=\"done\"} %llu\n",
+                (unsigned long long)journal.finished);
+        write_header(out, "orchestrator_journal_syncs_total", "counter",
+                     "Group commits that made the journal durable.");
+        fprintf(out, "orchestrator_journal_syncs_total %llu\n", (unsigned long long)journal.syncs);
+        write_header(out, "orchestrator_journal_bytes_total", "counter", "Bytes appended to the journal.");
+        fprintf(out, "orchestrator_journal_bytes_total %llu\n", (unsigned long long)journal.bytes);
+        write_header(out, "orchestrator_journal_segments", "gauge", "Journal segment files on disk.");
+        fprintf(out, "orchestrator_journal_segments %zu\n", journal.segments);
+        write_header(out, "orchestrator_journal_unfinished", "gauge",
+                     "Journaled tasks not yet finished, replayed ones included.");
+        fprintf(out, "orchestrator_journal_unfinished %zu\n", journal.live);
+    }
+    
+    if (orch->memory_budget) {
+        memory_budget_stats_t memory;
+        memory_budget_get_stats(orch->memory_budget, &memory);
+        write_header(out, "orchestrator_memory_budget_starts_total", "counter",
+                     "Tasks started against the memory budget, by how.");
+        fprintf(out, "orchestrator_memory_budget_starts_total{how=\"fit\"} %llu\n",
+                (unsigned long long)memory.admitted);
+        fprintf(out, "orchestrator_memory_budget_starts_total{how=\"overcommitted\"} %llu\n",
+                (unsigned long long)memory.overcommitted);
+        write_header(out, "orchestrator_memory_budget_backfilled_total", "counter",
+                     "Tasks started ahead of an equally or more urgent one set aside.");
+        fprintf(out, "orchestrator_memory_budget_backfilled_total %llu\n", (unsigned long long)memory.backfilled);
+        write_header(out, "orchestrator_memory_budget_parked_total", "counter",
+                     "Tasks set aside for want of memory headroom.");
+        fprintf(out, "orchestrator_memory_budget_parked_total %llu\n", (unsigned long long)memory.parked);
+        write_header(out, "orchestrator_memory_budget_stalls_total", "counter",
+                     "Times a worker waited with the maximum of tasks set aside.");
+        fprintf(out, "orchestrator_memory_budget_stalls_total %llu\n", (unsigned long long)memory.stalled);
+        write_header(out, "orchestrator_memory_budget_limit_bytes", "gauge",
+                     "Memory running tasks may claim together.");
+        fprintf(out, "orchestrator_memory_budget_limit_bytes %llu\n",
+                (unsigned long long)(memory.limit_bytes == UINT64_MAX ? 0 : memory.limit_bytes));
+        write_header(out, "orchestrator_memory_budget_reserved_bytes", "gauge",
+                     "Memory claimed by running tasks.");
+        fprintf(out, "orchestrator_memory_budget_reserved_bytes %llu\n",
+                (unsigned long long)memory.reserved_bytes);
+        write_header(out, "orchestrator_memory_budget_waiting", "gauge", "Tasks set aside now.");
+        fprintf(out, "orchestrator_memory_budget_waiting %zu\n", memory.waiting);
+    }
+    
+    write_header(out, "orchestrator_task_timers_armed", "gauge", "Running tasks with a timeout pending.");
+    fprintf(out, "orchestrator_task_timers_armed %zu\n", timer_wheel_armed(orch->timers));
+    if (orch->python_workers) {
+        python_worker_stats_t python;
+        python_worker_pool_get_stats(orch->python_workers, &python);
+        write_header(out, "orchestrator_python_worker_restarts_total", "counter",
+                     "Python worker processes restarted after exiting.");
+        fprintf(out, "orchestrator_python_worker_restarts_total %llu\n",
+                (unsigned long long)python.restarts);
+        write_header(out, "orchestrator_python_workers_killed_total", "counter",
+                     "Python worker processes killed under a task that ran out of time.");
+        fprintf(out, "orchestrator_python_workers_killed_total %llu\n",
+                (unsigned long long)python.killed);
+    }
+    
+    system_resources_t resources;
+    if (resource_monitor_get_resources(orch->resource_monitor, &resources) == 0) {
+        write_header(out, "orchestrator_cpu_usage_percent", "gauge", "System CPU utilisation.");
+        fprintf(out, "orchestrator_cpu_usage_percent %.2f\n", resources.cpu_usage);
+        write_header(out, "orchestrator_memory_used_bytes", "gauge", "System memory in use.");
+        fprintf(out, "orchestrator_memory_used_bytes %llu\n", (unsigned long long)resources.memory_used);
+        write_header(out, "orchestrator_memory_available_bytes", "gauge", "MemAvailable, including reclaimable cache.");
+        fprintf(out, "orchestrator_memory_available_bytes %llu\n", (unsigned long long)resources.memory_available);
+        write_header(out, "orchestrator_memory_total_bytes", "gauge", "Total system memory.");
+        fprintf(out, "orchestrator_memory_total_bytes %llu\n", (unsigned long long)resources.memory_total);
+        if (resources.cpu_quota > 0.0) {
+            write_header(out, "orchestrator_cgroup_cpu_quota_cores", "gauge", "cgroup CPU limit in cores.");
+            fprintf(out, "orchestrator_cgroup_cpu_quota_cores %.2f\n", resources.cpu_quota);
+        }
+        if (resources.cgroup_memory_limit > 0) {
+            write_header(out, "orchestrator_cgroup_memory_limit_bytes", "gauge", "cgroup memory limit.");
+            fprintf(out, "orchestrator_cgroup_memory_limit_bytes %llu\n",
+                    (unsigned long long)resources.cgroup_memory_limit);
+            write_header(out, "orchestrator_cgroup_memory_used_bytes", "gauge",
+                         "Memory charged to the cgroup, page cache included.");
+            fprintf(out, "orchestrator_cgroup_memory_used_bytes %llu\n",
+                    (unsigned long long)resources.cgroup_memory_used);
+        }
+        
+        // Pressure stall information is missing on older kernels and macOS
+        if (resources.cpu_pressure >= 0.0 || resources.memory_pressure >= 0.0) {
+            write_header(out, "orchestrator_pressure_percent", "gauge", "PSI avg10 stall percentage.");
+        }
+        if (resources.cpu_pressure >= 0.0) {
+            fprintf(out, "orchestrator_pressure_percent{resource=\"cpu\",kind=\"some\"} %.2f\n",
+                    resources.cpu_pressure);
+        }
+        if (resources.memory_pressure >= 0.0) {
+            fprintf(out, "orchestrator_pressure_percent{resource=\"memory\",kind=\"some\"} %.2f\n",
+                    resources.memory_pressure);
+        }
+        if (resources.memory_pressure_full >= 0.0) {
+            fprintf(out, "orchestrator_pressure_percent{resource=\"memory\",kind=\"full\"} %.2f\n",
+                    resources.memory_pressure_full);
+        }
+    }
+    
+    write_latency(orch, out);
+}
+
 bool orchestrator_is_running(orchestrator_t *orch) {
     return orch && orch->running;
 }
 
 size_t orchestrator_get_queue_size(orchestrator_t *orch) {
     if (!orch) return 0;
-    return task_queue_size(orch->task_queue);
+    return task_queue_size(orch->task_queue) + thread_pool_local_size(orch->thread_pool) +
+           memory_budget_waiting(orch->memory_budget);
 }
 
@@ -4,30 +4,235 @@
 #include "task_queue.h"
 #include "thread_pool.h"
 #include "resource_monitor.h"
+#include "task_slab.h"
+#include "payload_arena.h"
+#include "python_worker_pool.h"
+#include "tensor_codec.h"
+#include "admission.h"
+#include "metrics_server.h"
+#include "pool_scaler.h"
+#include "task_future.h"
+#include "task_index.h"
+#include "timer_wheel.h"
+#include "result_cache.h"
+#include "task_graph.h"
+#include "task_journal.h"
+#include "memory_budget.h"
 #include <stdbool.h>
 
 #define MAX_PYTHON_SCRIPT_PATH 256
 #define DEFAULT_NUM_THREADS 4
 #define DEFAULT_QUEUE_SIZE 100
+#define ORCHESTRATOR_MAX_MODELS 32
+#define DEFAULT_AGING_MS 1000
+#define ORCHESTRATOR_MAX_PARENTS 8
 
 typedef struct {
+    size_t num_threads;
+    size_t queue_size;
+    const char *python_script_path;     // NULL selects the default script
+    task_queue_mode_t queue_mode;
+    uint64_t aging_ms;                  // deadline queue: wait that lifts a task one
+                                        // priority, 0 = never
+    thread_pool_mode_t pool_mode;
+    size_t python_workers;              // 0 keeps inference in-process (simulated)
+    const char *model_path;             // passed to each Python worker, may be NULL
+    size_t model_budget_mb;             // resident model memory per Python worker
+    task_batch_config_t batch;          // max_batch 1 (the default) disables batching
+    admission_config_t admission;       // per-priority rate limits and shedding watermarks
+    const char *metrics_socket;         // UNIX socket serving Prometheus metrics, NULL = none
+    uint16_t metrics_port;              // loopback TCP port for the same, 0 = none
+    cpu_placement_config_t placement;   // core budget, pinning and workload profile
+    pool_scaler_config_t scaler;        // max_threads > 0 lets the pool grow and shrink,
+                                        // starting from num_threads
+    uint64_t task_timeout_ms;           // execution budget of every task, 0 = unlimited
+    size_t result_cache_mb;             // completed results kept for repeated inputs, 0 = off
+    const char *journal_dir;            // write-ahead journal of submissions, NULL = none
+    task_journal_config_t journal;      // segment size and group commit of the journal
+    bool memory_aware;                  // start tasks only as memory allows, see memory_budget.h
+    memory_budget_config_t memory;      // fixed limit or share of available memory
+    size_t task_memory_mb;              // footprint of tasks that declare none, 0 = untracked
+} orchestrator_config_t;
+
+// One task of orchestrator_submit_batch()
+typedef struct {
+    const char *task_id;
+    task_priority_t priority;
+    uint32_t model_id;
+    const void *data;                   // copied; only needs to live for the call
+    size_t data_size;
+    uint64_t deadline_ns;               // absolute task_now_ns() time, 0 = none
+    uint64_t timeout_ns;                // execution budget once running, 0 = task_timeout_ms
+    uint64_t memory_bytes;              // peak memory while running, 0 = task_memory_mb
+    task_done_callback_t on_done;       // optional, sees the task's final status
+    void *done_ctx;
+} task_submission_t;
+
+// One task of orchestrator_submit_graph()
+typedef struct {
+    task_submission_t task;             // data is ignored when input_from is set
+    int parents[ORCHESTRATOR_MAX_PARENTS];  // indexes of earlier nodes it waits for
+    size_t num_parents;
+    int input_from;                     // parent whose output becomes its data, -1 = none
+} task_graph_node_t;
+
+typedef struct {
+    task_slab_t *task_slab;
     task_queue_t *task_queue;
     thread_pool_t *thread_pool;
     resource_monitor_t *resource_monitor;
+    python_worker_pool_t *python_workers;   // NULL when inference is simulated
+    task_batcher_t *batcher;                // NULL when batching is off
+    admission_controller_t *admission;
+    cpu_plan_t *cpu_plan;                   // NULL unless placement is configured
+    pool_scaler_config_t scaler_config;
+    pool_scaler_t *scaler;                  // NULL unless elastic, runs while started
+    metrics_server_t *metrics;              // NULL unless configured, runs while started
+    task_index_t *task_index;               // every live task, for orchestrator_cancel()
+    timer_wheel_t *timers;                  // execution timeouts of running tasks
+    result_cache_t *result_cache;           // NULL when off
+    task_journal_t *journal;                // NULL unless durable
+    memory_budget_t *memory_budget;         // NULL unless memory-aware
+    int signal_pipe[2];                     // SIGINT/SIGTERM land here while started
+    pthread_t signal_thread;
+    bool signal_thread_started;
+    uint64_t task_timeout_ns;
+    uint64_t task_memory_bytes;
+    char metrics_socket[METRICS_SOCKET_PATH_MAX];
+    uint16_t metrics_port;
     char python_script_path[MAX_PYTHON_SCRIPT_PATH];
-    bool running;
+    pthread_mutex_t models_mutex;       // serializes orchestrator_register_model()
+    char models[ORCHESTRATOR_MAX_MODELS][MAX_PYTHON_SCRIPT_PATH];  // [0]: default model
+    _Atomic size_t num_models;          // entries below this are immutable
+    _Atomic bool running;
     size_t num_threads;
     size_t queue_size;
 } orchestrator_t;
 
+void orchestrator_config_init(orchestrator_config_t *config);
 orchestrator_t* orchestrator_create(size_t num_threads, size_t queue_size, 
                                     const char *python_script_path);
+orchestrator_t* orchestrator_create_with_config(const orchestrator_config_t *config);
 void orchestrator_destroy(orchestrator_t *orch);
+// Also takes over SIGINT and SIGTERM: both stop the orchestrator, letting
+// the workers drain the queue, except that SIGTERM with a journal first
+// checkpoints (see orchestrator_checkpoint()).
 int orchestrator_start(orchestrator_t *orch);
 void orchestrator_stop(orchestrator_t *orch);
+// With a journal, resubmits what an earlier run left unfinished, oldest
+// first and bypassing admission; call once after orchestrator_start().
+// Returns the number of tasks resubmitted.
+size_t orchestrator_replay_journal(orchestrator_t *orch);
+// Takes every task still queued, or set aside by the memory budget, off
+// unrun and makes the journal durable, so the next start replays them
+// instead of this run draining them. Tasks already running finish.
+// Returns the number taken off.
+size_t orchestrator_checkpoint(orchestrator_t *orch);
+// Pins an ingest or monitoring thread to the reserved service cores; a
+// no-op unless the placement pins threads
+int orchestrator_pin_service_thread(orchestrator_t *orch, pthread_t thread);
+// With a result cache, every submit variant first looks the model id and
+// payload up: a cached result completes the task at once, and an identical
+// task already in flight takes it along instead of it being queued again.
 int orchestrator_submit_task(orchestrator_t *orch, const char *task_id,
                              task_priority_t priority, void *data, size_t data_size);
+// orchestrator_submit_task() that reports the outcome: status, error,
+// timing and the result buffer. *future (may be NULL) receives a handle to
+// wait on, poll or hang a callback on; queue (may be NULL) receives
+// another once the task finishes. Each is released with
+// task_future_release(). On failure neither is handed out.
+int orchestrator_submit_task_future(orchestrator_t *orch, const char *task_id,
+                                    task_priority_t priority, void *data, size_t data_size,
+                                    completion_queue_t *queue, task_future_t **future);
+// Waits up to timeout_ms for queue room or a rate-limit token. Tasks shed
+// under resource pressure fail at once.
+int orchestrator_submit_task_timeout(orchestrator_t *orch, const char *task_id,
+                                     task_priority_t priority, void *data, size_t data_size,
+                                     uint64_t timeout_ms);
+// deadline_ns is an absolute task_now_ns() time. The deadline queue mode
+// runs tasks earliest-deadline-first within a priority; in every mode a
+// task still queued after its deadline is dropped instead of run.
+int orchestrator_submit_task_deadline(orchestrator_t *orch, const char *task_id,
+                                      task_priority_t priority, void *data, size_t data_size,
+                                      uint64_t deadline_ns);
+// Never blocks. *queue_depth (may be NULL) receives the queue depth seen
+// at admission, whether or not the task got in.
+int orchestrator_try_submit_task(orchestrator_t *orch, const char *task_id,
+                                 task_priority_t priority, void *data, size_t data_size,
+                                 size_t *queue_depth);
+
+// Zero-copy variants. On failure (-1) nothing is freed or called and the
+// buffer still belongs to the caller.
+
+// Takes ownership of data; free_fn(data) runs once the task is done.
+int orchestrator_submit_task_owned(orchestrator_t *orch, const char *task_id,
+                                   task_priority_t priority, void *data, size_t data_size,
+                                   void (*free_fn)(void *data));
+// Borrows data until on_done(task, ctx) reports the task finished with it.
+int orchestrator_submit_task_borrowed(orchestrator_t *orch, const char *task_id,
+                                      task_priority_t priority, void *data, size_t data_size,
+                                      task_done_callback_t on_done, void *ctx);
+// data must come from payload_arena_alloc(); its block reference is
+// released when the task is destroyed.
+int orchestrator_submit_task_arena(orchestrator_t *orch, const char *task_id,
+                                   task_priority_t priority, void *data, size_t data_size);
+// Submits count tasks with one admission pass and one queue operation per
+// ADMISSION_BATCH_MAX of them; never blocks. Payloads that do not fit
+// inline are copied into arena when given (single producer, see
+// payload_arena.h), malloc'd otherwise. results[i] is the task's
+// admission_verdict_t (ADMISSION_ACCEPTED is 0), or -1 for an invalid
+// submission or no memory; on_done only runs for accepted tasks. Returns
+// the number accepted.
+size_t orchestrator_submit_batch(orchestrator_t *orch, const task_submission_t *submissions,
+                                 size_t count, payload_arena_t *arena, int *results);
+// Submits a DAG of count tasks, listed parents first: preprocess, infer,
+// postprocess and the like, without a round trip between stages. Nodes
+// without parents go through admission as usual; the rest wait outside
+// the queue and go straight to a worker once their last parent finishes,
+// bypassing admission and the result cache. A node with input_from runs
+// on that parent's output buffer itself, not a copy. A sole dependent of
+// a node that is its only parent runs next on the same worker, its input
+// still in cache. A parent that does not complete cancels (ECANCELED)
+// everything downstream of it. queue (may be NULL) receives every node's
+// future as it finishes, except those of roots that were not admitted.
+// Returns how many roots were admitted, or -1 when nothing was submitted:
+// a bad parent index or input_from, or no memory.
+int orchestrator_submit_graph(orchestrator_t *orch, const task_graph_node_t *nodes,
+                              size_t count, completion_queue_t *queue);
+// Returns the id tasks use to target model_path (registering it on first
+// use), or -1 when the table is full. Id 0 is the default model.
+int orchestrator_register_model(orchestrator_t *orch, const char *model_path);
+// orchestrator_submit_task() for a registered model
+int orchestrator_submit_model_task(orchestrator_t *orch, const char *task_id,
+                                   task_priority_t priority, uint32_t model_id,
+                                   void *data, size_t data_size);
+
+// Encodes the tensor as a binary frame (see tensor_codec.h) and submits it
+// for model_id; results come back as full output tensors in the same format
+int orchestrator_submit_tensor(orchestrator_t *orch, const char *task_id,
+                               task_priority_t priority, uint32_t model_id,
+                               const tensor_desc_t *desc, const void *tensor_data);
+// Cancels every live task with task_id. A queued one is dropped when a
+// worker reaches it, without running; a running one is flagged and sees
+// it through task_cancelled(task) (from thread_pool_current_task()).
+// Either way it finishes as TASK_STATUS_CANCELLED with ECANCELED, unless
+// it completes first. Returns how many tasks were reached, 0 if none is
+// live.
+int orchestrator_cancel(orchestrator_t *orch, const char *task_id);
 bool orchestrator_is_running(orchestrator_t *orch);
+void orchestrator_print_batch_stats(orchestrator_t *orch);
+void orchestrator_print_admission_stats(orchestrator_t *orch);
+// Queue wait, execution and end-to-end percentiles per priority, plus
+// throughput since start
+int orchestrator_get_latency(orchestrator_t *orch, latency_snapshot_t *snapshot);
+void orchestrator_print_latency_stats(orchestrator_t *orch);
+void orchestrator_print_worker_stats(orchestrator_t *orch);
+void orchestrator_print_cache_stats(orchestrator_t *orch);
+void orchestrator_print_journal_stats(orchestrator_t *orch);
+void orchestrator_print_memory_stats(orchestrator_t *orch);
+// Writes every metric in the Prometheus text exposition format; this is
+// the page the metrics socket serves
+void orchestrator_write_metrics(orchestrator_t *orch, FILE *out);
 size_t orchestrator_get_queue_size(orchestrator_t *orch);
 
 #endif // ORCHESTRATOR_H
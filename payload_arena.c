@@ -0,0 +1,150 @@
+#include "payload_arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define ALLOC_ALIGN 16
+#define ALLOC_HEADER_SIZE ALLOC_ALIGN   // holds the owning block pointer
+
+struct payload_arena_block {
+    payload_arena_t *arena;
+    payload_arena_block_t *next;    // free list link
+    _Atomic size_t refs;            // live allocations, +1 while current
+    size_t offset;
+    unsigned char data[];
+};
+
+static size_t align_up(size_t value) {
+    return (value + ALLOC_ALIGN - 1) & ~(size_t)(ALLOC_ALIGN - 1);
+}
+
+// Called with the last reference gone: recycle the block, or free it if
+// the arena is being torn down.
+static void block_retire(payload_arena_block_t *block) {
+    payload_arena_t *arena = block->arena;
+    bool free_arena = false;
+    
+    pthread_mutex_lock(&arena->mutex);
+    if (arena->closing) {
+        free(block);
+        arena->blocks_alive--;
+        free_arena = (arena->blocks_alive == 0);
+    } else {
+        block->offset = 0;
+        block->next = arena->free_blocks;
+        arena->free_blocks = block;
+    }
+    pthread_mutex_unlock(&arena->mutex);
+    
+    if (free_arena) {
+        pthread_mutex_destroy(&arena->mutex);
+        free(arena);
+    }
+}
+
+static void block_put(payload_arena_block_t *block) {
+    if (atomic_fetch_sub_explicit(&block->refs, 1, memory_order_acq_rel) == 1) {
+        block_retire(block);
+    }
+}
+
+static payload_arena_block_t* block_get(payload_arena_t *arena) {
+    pthread_mutex_lock(&arena->mutex);
+    payload_arena_block_t *block = arena->free_blocks;
+    if (block) {
+        arena->free_blocks = block->next;
+    }
+    pthread_mutex_unlock(&arena->mutex);
+    
+    if (!block) {
+        block = (payload_arena_block_t*)malloc(sizeof(payload_arena_block_t) + arena->block_size);
+        if (!block) return NULL;
+        block->arena = arena;
+        block->offset = 0;
+        
+        pthread_mutex_lock(&arena->mutex);
+        arena->blocks_alive++;
+        pthread_mutex_unlock(&arena->mutex);
+    }
+    
+    block->next = NULL;
+    atomic_store_explicit(&block->refs, 1, memory_order_relaxed);   // the "current" reference
+    return block;
+}
+
+payload_arena_t* payload_arena_create(size_t block_size) {
+    payload_arena_t *arena = (payload_arena_t*)calloc(1, sizeof(payload_arena_t));
+    if (!arena) return NULL;
+    
+    arena->block_size = align_up(block_size ? block_size : PAYLOAD_ARENA_DEFAULT_BLOCK_SIZE);
+    
+    if (pthread_mutex_init(&arena->mutex, NULL) != 0) {
+        free(arena);
+        return NULL;
+    }
+    
+    return arena;
+}
+
+void payload_arena_destroy(payload_arena_t *arena) {
+    if (!arena) return;
+    
+    // Blocks still referenced by queued or running tasks are freed by
+    // their last release; the arena itself goes with the last block.
+    pthread_mutex_lock(&arena->mutex);
+    arena->closing = true;
+    payload_arena_block_t *block = arena->free_blocks;
+    arena->free_blocks = NULL;
+    while (block) {
+        payload_arena_block_t *next = block->next;
+        free(block);
+        arena->blocks_alive--;
+        block = next;
+    }
+    bool free_arena = (arena->blocks_alive == 0);
+    pthread_mutex_unlock(&arena->mutex);
+    
+    if (arena->current) {
+        payload_arena_block_t *current = arena->current;
+        arena->current = NULL;
+        block_put(current);     // may free the arena
+        return;
+    }
+    
+    if (free_arena) {
+        pthread_mutex_destroy(&arena->mutex);
+        free(arena);
+    }
+}
+
+void* payload_arena_alloc(payload_arena_t *arena, size_t size) {
+    if (!arena || size == 0) return NULL;
+    
+    size_t needed = ALLOC_HEADER_SIZE + align_up(size);
+    if (needed > arena->block_size) return NULL;
+    
+    payload_arena_block_t *block = arena->current;
+    if (!block || block->offset + needed > arena->block_size) {
+        payload_arena_block_t *fresh = block_get(arena);
+        if (!fresh) return NULL;
+        arena->current = fresh;
+        if (block) {
+            block_put(block);   // drop the "current" reference
+        }
+        block = fresh;
+    }
+    
+    unsigned char *header = block->data + block->offset;
+    block->offset += needed;
+    atomic_fetch_add_explicit(&block->refs, 1, memory_order_relaxed);
+    
+    *(payload_arena_block_t**)header = block;
+    return header + ALLOC_HEADER_SIZE;
+}
+
+void payload_arena_release(void *ptr) {
+    if (!ptr) return;
+    
+    payload_arena_block_t *block = *(payload_arena_block_t**)((unsigned char*)ptr - ALLOC_HEADER_SIZE);
+    block_put(block);
+}
+
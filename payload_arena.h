@@ -0,0 +1,34 @@
+#ifndef PAYLOAD_ARENA_H
+#define PAYLOAD_ARENA_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PAYLOAD_ARENA_DEFAULT_BLOCK_SIZE (1024 * 1024)
+
+typedef struct payload_arena_block payload_arena_block_t;
+
+// Per-producer bump allocator for task payloads. Allocation is a pointer
+// bump within the current block and is NOT thread-safe: one producer per
+// arena. Every allocation holds a reference on its block; the reference
+// is dropped with payload_arena_release() (the arena submit path does
+// this when the task is destroyed). A block whose allocations have all
+// been released is reset in one step and reused.
+typedef struct {
+    size_t block_size;
+    payload_arena_block_t *current;
+    pthread_mutex_t mutex;          // guards free_blocks, closing, blocks_alive
+    payload_arena_block_t *free_blocks;
+    size_t blocks_alive;
+    bool closing;
+} payload_arena_t;
+
+payload_arena_t* payload_arena_create(size_t block_size);
+void payload_arena_destroy(payload_arena_t *arena);
+void* payload_arena_alloc(payload_arena_t *arena, size_t size);
+void payload_arena_release(void *ptr);
+
+#endif // PAYLOAD_ARENA_H
+
@@ -0,0 +1,254 @@
+#include "pool_scaler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#define UTILIZATION_SMOOTHING 0.5   // weight of the newest sample
+
+void pool_scaler_config_init(pool_scaler_config_t *config) {
+    if (!config) return;
+    
+    config->min_threads = 1;
+    config->max_threads = 0;
+    config->interval_ms = 250;
+    config->backlog_per_worker = 2.0;
+    config->grow_utilization = 0.75;
+    config->shrink_utilization = 0.25;
+    config->drain_ticks = 8;
+    config->grow_ticks = 2;
+    config->shrink_ticks = 20;
+    config->cooldown_ticks = 4;
+    config->cpu_pressure_limit = 40.0;
+    config->memory_limit_share = 0.9;
+}
+
+static uint64_t total_busy_ns(thread_pool_t *pool) {
+    uint64_t total = 0;
+    thread_pool_worker_stats_t stats;
+    for (size_t i = 0; i < pool->num_threads; i++) {
+        if (thread_pool_get_worker_stats(pool, i, &stats) == 0) {
+            total += stats.busy_ns;
+        }
+    }
+    return total;
+}
+
+// Most workers the pool may run now: max_threads, or fewer when the
+// cgroup grants fewer whole cores
+static size_t current_limit(const pool_scaler_t *scaler, const system_resources_t *resources) {
+    size_t limit = scaler->config.max_threads;
+    if (resources && resources->cpu_quota > 0.0) {
+        size_t cores = (size_t)ceil(resources->cpu_quota);
+        if (cores < limit) limit = cores;
+    }
+    return limit > scaler->config.min_threads ? limit : scaler->config.min_threads;
+}
+
+static void grow(pool_scaler_t *scaler, size_t active, size_t depth, size_t limit) {
+    // Enough workers to bring the backlog down to its threshold, but at
+    // most half again as many per step
+    size_t wanted = (size_t)ceil((double)depth / scaler->config.backlog_per_worker);
+    size_t step = wanted > active ? wanted - active : 1;
+    size_t max_step = active / 2 > 0 ? active / 2 : 1;
+    if (step > max_step) step = max_step;
+    if (step > limit - active) step = limit - active;
+    
+    size_t added = 0;
+    while (added < step && thread_pool_add_worker(scaler->pool) == 0) {
+        added++;
+    }
+    atomic_fetch_add_explicit(&scaler->grown, added, memory_order_relaxed);
+}
+
+static void shrink(pool_scaler_t *scaler) {
+    if (thread_pool_retire_worker(scaler->pool) == 0) {
+        atomic_fetch_add_explicit(&scaler->shrunk, 1, memory_order_relaxed);
+    }
+}
+
+static void tick(pool_scaler_t *scaler) {
+    const pool_scaler_config_t *config = &scaler->config;
+    thread_pool_t *pool = scaler->pool;
+    
+    uint64_t now = task_now_ns();
+    uint64_t busy = total_busy_ns(pool);
+    size_t active = thread_pool_active_threads(pool);
+    size_t depth = task_queue_size(pool->task_queue) + thread_pool_local_size(pool);
+    
+    // Busy time includes tasks still running, so a worker stuck in one
+    // long task reads as busy on every tick, not only when it ends
+    if (now > scaler->last_tick_ns && busy >= scaler->last_busy_ns && active > 0) {
+        double sample = (double)(busy - scaler->last_busy_ns) /
+                        ((double)(now - scaler->last_tick_ns) * (double)active);
+        scaler->utilization += UTILIZATION_SMOOTHING * (sample - scaler->utilization);
+    }
+    
+    system_resources_t resources;
+    bool have_resources = scaler->monitor &&
+                          resource_monitor_get_resources(scaler->monitor, &resources) == 0;
+    size_t limit = current_limit(scaler, have_resources ? &resources : NULL);
+    bool pressured = have_resources && resources.cpu_pressure >= config->cpu_pressure_limit;
+    bool memory_tight = have_resources && resources.cgroup_memory_limit > 0 &&
+                        (double)resources.cgroup_memory_used >=
+                        config->memory_limit_share * (double)resources.cgroup_memory_limit;
+    
+    // Backed up: deep, not clearing soon at the current drain rate, and
+    // the workers are busy rather than stalled elsewhere
+    size_t drained = scaler->last_depth > depth ? scaler->last_depth - depth : 0;
+    bool backed_up = (double)depth > config->backlog_per_worker * (double)active &&
+                     (uint64_t)drained * config->drain_ticks < depth &&
+                     scaler->utilization >= config->grow_utilization;
+    bool idle = depth == 0 && scaler->utilization < config->shrink_utilization;
+    scaler->backed_up_ticks = backed_up ? scaler->backed_up_ticks + 1 : 0;
+    scaler->idle_ticks = idle ? scaler->idle_ticks + 1 : 0;
+    scaler->pressured_ticks = pressured ? scaler->pressured_ticks + 1 : 0;
+    
+    bool changed = false;
+    if (scaler->cooldown > 0) {
+        scaler->cooldown--;
+    } else if (active > limit) {
+        // The quota shrank under us
+        shrink(scaler);
+        changed = true;
+    } else if (scaler->backed_up_ticks >= config->grow_ticks && active < limit &&
+               !pressured && !memory_tight) {
+        grow(scaler, active, depth, limit);
+        changed = true;
+    } else if (active > config->min_threads && (scaler->idle_ticks >= config->shrink_ticks ||
+                                                scaler->pressured_ticks >= config->shrink_ticks)) {
+        shrink(scaler);
+        changed = true;
+    }
+    if (changed) {
+        scaler->cooldown = config->cooldown_ticks;
+        scaler->backed_up_ticks = 0;
+        scaler->idle_ticks = 0;
+        scaler->pressured_ticks = 0;
+    }
+    
+    scaler->last_tick_ns = now;
+    scaler->last_busy_ns = busy;
+    scaler->last_depth = depth;
+    
+    double shown = scaler->utilization < 1.0 ? scaler->utilization : 1.0;
+    atomic_store_explicit(&scaler->limit, limit, memory_order_relaxed);
+    atomic_store_explicit(&scaler->utilization_ppm, (uint64_t)(shown * 1e6), memory_order_relaxed);
+}
+
+static void* scaler_thread(void *arg) {
+    pool_scaler_t *scaler = (pool_scaler_t*)arg;
+    
+    pthread_mutex_lock(&scaler->mutex);
+    while (scaler->running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)scaler->config.interval_ms * 1000000ULL;
+        deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+        deadline.tv_nsec = (long)(ns % 1000000000ULL);
+        
+        int rc = 0;
+        while (scaler->running && rc != ETIMEDOUT) {
+            rc = pthread_cond_timedwait(&scaler->cond, &scaler->mutex, &deadline);
+        }
+        if (!scaler->running) break;
+        
+        pthread_mutex_unlock(&scaler->mutex);
+        tick(scaler);
+        pthread_mutex_lock(&scaler->mutex);
+    }
+    pthread_mutex_unlock(&scaler->mutex);
+    
+    return NULL;
+}
+
+pool_scaler_t* pool_scaler_create(const pool_scaler_config_t *config, thread_pool_t *pool,
+                                  resource_monitor_t *monitor) {
+    if (!config || !pool || !pool->elastic) return NULL;
+    
+    pool_scaler_t *scaler = (pool_scaler_t*)calloc(1, sizeof(pool_scaler_t));
+    if (!scaler) return NULL;
+    
+    scaler->config = *config;
+    scaler->config.min_threads = pool->min_threads;
+    if (scaler->config.max_threads == 0 || scaler->config.max_threads > pool->num_threads) {
+        scaler->config.max_threads = pool->num_threads;
+    }
+    if (scaler->config.interval_ms == 0) scaler->config.interval_ms = 250;
+    if (scaler->config.backlog_per_worker <= 0.0) scaler->config.backlog_per_worker = 1.0;
+    scaler->pool = pool;
+    scaler->monitor = monitor;
+    scaler->running = true;
+    scaler->last_tick_ns = task_now_ns();
+    scaler->last_busy_ns = total_busy_ns(pool);
+    atomic_init(&scaler->limit, current_limit(scaler, NULL));
+    atomic_init(&scaler->utilization_ppm, 0);
+    atomic_init(&scaler->grown, 0);
+    atomic_init(&scaler->shrunk, 0);
+    
+    if (pthread_mutex_init(&scaler->mutex, NULL) != 0) {
+        free(scaler);
+        return NULL;
+    }
+    if (pthread_cond_init(&scaler->cond, NULL) != 0) {
+        pthread_mutex_destroy(&scaler->mutex);
+        free(scaler);
+        return NULL;
+    }
+    if (pthread_create(&scaler->thread, NULL, scaler_thread, scaler) != 0) {
+        pthread_cond_destroy(&scaler->cond);
+        pthread_mutex_destroy(&scaler->mutex);
+        free(scaler);
+        return NULL;
+    }
+    
+    return scaler;
+}
+
+void pool_scaler_stop(pool_scaler_t *scaler) {
+    if (!scaler) return;
+    
+    pthread_mutex_lock(&scaler->mutex);
+    scaler->running = false;
+    pthread_cond_signal(&scaler->cond);
+    bool join = !scaler->joined;
+    scaler->joined = true;
+    pthread_mutex_unlock(&scaler->mutex);
+    
+    if (join) pthread_join(scaler->thread, NULL);
+}
+
+void pool_scaler_destroy(pool_scaler_t *scaler) {
+    if (!scaler) return;
+    
+    pool_scaler_stop(scaler);
+    pthread_cond_destroy(&scaler->cond);
+    pthread_mutex_destroy(&scaler->mutex);
+    free(scaler);
+}
+
+void pool_scaler_get_stats(pool_scaler_t *scaler, pool_scaler_stats_t *stats) {
+    if (!scaler || !stats) return;
+    
+    stats->active = thread_pool_active_threads(scaler->pool);
+    stats->min_threads = scaler->config.min_threads;
+    stats->max_threads = scaler->config.max_threads;
+    stats->limit = atomic_load_explicit(&scaler->limit, memory_order_relaxed);
+    stats->utilization = atomic_load_explicit(&scaler->utilization_ppm, memory_order_relaxed) / 1e6;
+    stats->grown = atomic_load_explicit(&scaler->grown, memory_order_relaxed);
+    stats->shrunk = atomic_load_explicit(&scaler->shrunk, memory_order_relaxed);
+}
+
+void pool_scaler_print_stats(pool_scaler_t *scaler, FILE *out) {
+    if (!scaler || !out) return;
+    
+    pool_scaler_stats_t stats;
+    pool_scaler_get_stats(scaler, &stats);
+    fprintf(out, "Elastic pool: %zu of %zu-%zu workers active (limit %zu), %.0f%% busy, "
+            "%llu added, %llu retired\n",
+            stats.active, stats.min_threads, stats.max_threads, stats.limit,
+            stats.utilization * 100.0,
+            (unsigned long long)stats.grown, (unsigned long long)stats.shrunk);
+}
+
@@ -0,0 +1,82 @@
+#ifndef POOL_SCALER_H
+#define POOL_SCALER_H
+
+#include "thread_pool.h"
+#include "resource_monitor.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    size_t min_threads;
+    size_t max_threads;             // 0 keeps the pool fixed at num_threads
+    uint32_t interval_ms;           // controller tick
+    double backlog_per_worker;      // queued tasks per active worker that call for growth
+    double grow_utilization;        // busy share of active workers needed to grow
+    double shrink_utilization;      // below this, with nothing queued, workers are idle
+    uint32_t drain_ticks;           // a backlog that drains within this many ticks is left alone
+    uint32_t grow_ticks;            // consecutive backed-up ticks before growing
+    uint32_t shrink_ticks;          // consecutive idle or pressured ticks before shrinking
+    uint32_t cooldown_ticks;        // ticks after any change before the next
+    double cpu_pressure_limit;      // PSI cpu "some" avg10 % that stops growth and sheds workers
+    double memory_limit_share;      // no growth past this share of the cgroup memory limit
+} pool_scaler_config_t;
+
+typedef struct {
+    size_t active;
+    size_t min_threads;
+    size_t max_threads;
+    size_t limit;                   // max_threads after the cgroup CPU quota
+    double utilization;             // smoothed busy share of active workers
+    uint64_t grown;                 // workers added
+    uint64_t shrunk;                // workers retired
+} pool_scaler_stats_t;
+
+// Controller thread that resizes an elastic pool (see
+// thread_pool_set_elastic()) every interval_ms. It grows while workers
+// are busy and the queue stays deeper than backlog_per_worker per worker
+// without draining fast enough to clear within drain_ticks, and retires
+// one worker at a time once they sit idle or the CPU is contended. The
+// gap between the grow and shrink thresholds, the tick counts and the
+// cooldown keep it from flapping.
+// The cgroup CPU quota caps the pool and the cgroup memory limit blocks
+// growth, so a container is sized by its own limits, not the host's.
+typedef struct {
+    pool_scaler_config_t config;
+    thread_pool_t *pool;
+    resource_monitor_t *monitor;    // NULL: queue depth and utilization only
+    pthread_t thread;
+    pthread_mutex_t mutex;          // controller sleeps on cond; stop wakes it
+    pthread_cond_t cond;
+    bool running;                   // under mutex
+    bool joined;
+    // Controller thread only
+    uint64_t last_tick_ns;
+    uint64_t last_busy_ns;
+    size_t last_depth;
+    uint32_t backed_up_ticks;
+    uint32_t idle_ticks;
+    uint32_t pressured_ticks;
+    uint32_t cooldown;
+    double utilization;
+    // Published for stats
+    _Atomic size_t limit;
+    _Atomic uint64_t utilization_ppm;
+    _Atomic uint64_t grown;
+    _Atomic uint64_t shrunk;
+} pool_scaler_t;
+
+void pool_scaler_config_init(pool_scaler_config_t *config);
+// Starts the controller. pool must be elastic and already started;
+// config->max_threads is clamped to its slots.
+pool_scaler_t* pool_scaler_create(const pool_scaler_config_t *config, thread_pool_t *pool,
+                                  resource_monitor_t *monitor);
+// Joins the controller; the pool keeps its current size
+void pool_scaler_stop(pool_scaler_t *scaler);
+void pool_scaler_destroy(pool_scaler_t *scaler);
+void pool_scaler_get_stats(pool_scaler_t *scaler, pool_scaler_stats_t *stats);
+void pool_scaler_print_stats(pool_scaler_t *scaler, FILE *out);
+
+#endif // POOL_SCALER_H
+
@@ -0,0 +1,797 @@
+#define _GNU_SOURCE
+#include "python_worker_pool.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define SUPERVISOR_TICK_MS 100
+#define CHILD_SUB_FD 3
+#define CHILD_COMP_FD 4
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static python_ring_header_t* ring_header(python_worker_t *worker) {
+    return (python_ring_header_t*)worker->shm;
+}
+
+static unsigned char* sub_slot(python_worker_t *worker, uint64_t pos) {
+    return (unsigned char*)worker->shm + PY_RING_DATA_OFFSET +
+           (pos & (PY_RING_SLOTS - 1)) * PY_RING_SLOT_SIZE;
+}
+
+static unsigned char* comp_slot(python_worker_t *worker, uint64_t pos) {
+    return (unsigned char*)worker->shm + PY_RING_DATA_OFFSET +
+           (PY_RING_SLOTS + (pos & (PY_RING_SLOTS - 1))) * PY_RING_SLOT_SIZE;
+}
+
+static void ring_doorbell(int efd) {
+    uint64_t one = 1;
+    ssize_t written = write(efd, &one, sizeof(one));
+    (void)written;  // EAGAIN only on counter overflow, the reader is awake then
+}
+
+static void drain_doorbell(int efd) {
+    uint64_t count;
+    while (read(efd, &count, sizeof(count)) == sizeof(count)) {
+    }
+}
+
+static void ring_reset(python_worker_t *worker) {
+    python_ring_header_t *header = ring_header(worker);
+    header->magic = PY_RING_MAGIC;
+    header->version = PY_RING_VERSION;
+    header->slot_count = PY_RING_SLOTS;
+    header->slot_size = PY_RING_SLOT_SIZE;
+    atomic_store(&header->sub_head, 0);
+    atomic_store(&header->sub_tail, 0);
+    atomic_store(&header->comp_head, 0);
+    atomic_store(&header->comp_tail, 0);
+}
+
+static int worker_setup(python_worker_pool_t *pool, python_worker_t *worker, size_t index) {
+    worker->index = index;
+    worker->pid = -1;
+    worker->alive = false;
+    worker->backoff_ms = PY_RESTART_BACKOFF_MIN_MS;
+    worker->shm_size = PY_RING_DATA_OFFSET + 2 * PY_RING_SLOTS * (size_t)PY_RING_SLOT_SIZE;
+    snprintf(worker->shm_name, sizeof(worker->shm_name), "/ai_orchestrator_%d_%zu",
+             (int)getpid(), index);
+    
+    int fd = shm_open(worker->shm_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return -1;
+    
+    if (ftruncate(fd, (off_t)worker->shm_size) != 0) {
+        close(fd);
+        shm_unlink(worker->shm_name);
+        return -1;
+    }
+    
+    worker->shm = mmap(NULL, worker->shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (worker->shm == MAP_FAILED) {
+        worker->shm = NULL;
+        shm_unlink(worker->shm_name);
+        return -1;
+    }
+    ring_reset(worker);
+    
+    worker->sub_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    worker->comp_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (worker->sub_efd < 0 || worker->comp_efd < 0) {
+        if (worker->sub_efd >= 0) close(worker->sub_efd);
+        if (worker->comp_efd >= 0) close(worker->comp_efd);
+        munmap(worker->shm, worker->shm_size);
+        shm_unlink(worker->shm_name);
+        return -1;
+    }
+    
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = index };
+    if (epoll_ctl(pool->epoll_fd, EPOLL_CTL_ADD, worker->comp_efd, &ev) != 0) {
+        close(worker->sub_efd);
+        close(worker->comp_efd);
+        munmap(worker->shm, worker->shm_size);
+        shm_unlink(worker->shm_name);
+        return -1;
+    }
+    
+    pthread_mutex_init(&worker->mutex, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+    
+    return 0;
+}
+
+static void worker_teardown(python_worker_t *worker) {
+    close(worker->sub_efd);
+    close(worker->comp_efd);
+    munmap(worker->shm, worker->shm_size);
+    shm_unlink(worker->shm_name);
+    pthread_mutex_destroy(&worker->mutex);
+    pthread_cond_destroy(&worker->cond);
+}
+
+// Move fd to target in the child, making sure it survives exec
+static void child_install_fd(int fd, int target) {
+    if (fd == target) {
+        fcntl(fd, F_SETFD, 0);
+    } else {
+        dup2(fd, target);
+    }
+}
+
+static int worker_spawn(python_worker_pool_t *pool, python_worker_t *worker) {
+    char sub_fd[16], comp_fd[16], budget[24], intra_op[24];
+    snprintf(sub_fd, sizeof(sub_fd), "%d", CHILD_SUB_FD);
+    snprintf(comp_fd, sizeof(comp_fd), "%d", CHILD_COMP_FD);
+    snprintf(budget, sizeof(budget), "%zu", pool->model_budget_mb);
+    snprintf(intra_op, sizeof(intra_op), "%zu", pool->intra_op_threads);
+    
+    int cpus[CPU_TOPOLOGY_MAX_CPUS];
+    size_t num_cpus = 0;
+    if (pool->placement && pool->placement->pin) {
+        num_cpus = cpu_plan_python_cpus(pool->placement, worker->index, cpus);
+    }
+    
+    // Build argv before fork; only async-signal-safe calls in the child
+    char *argv[16];
+    int argc = 0;
+    argv[argc++] = pool->python;
+    argv[argc++] = pool->script;
+    argv[argc++] = "--worker";
+    argv[argc++] = "--shm";
+    argv[argc++] = worker->shm_name;
+    argv[argc++] = "--sub-fd";
+    argv[argc++] = sub_fd;
+    argv[argc++] = "--comp-fd";
+    argv[argc++] = comp_fd;
+    argv[argc++] = "--model-budget-mb";
+    argv[argc++] = budget;
+    argv[argc++] = "--intra-op-threads";
+    argv[argc++] = intra_op;
+    if (pool->model_path[0]) {
+        argv[argc++] = "--model";
+        argv[argc++] = pool->model_path;
+    }
+    argv[argc] = NULL;
+    
+    ring_reset(worker);
+    drain_doorbell(worker->sub_efd);
+    drain_doorbell(worker->comp_efd);
+    
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    
+    if (pid == 0) {
+        // Both fds may need to move; park the completion fd out of the
+        // way first so installing the submission fd cannot clobber it.
+        int comp = worker->comp_efd;
+        if (comp == CHILD_SUB_FD) {
+            comp = dup(comp);
+        }
+        child_install_fd(worker->sub_efd, CHILD_SUB_FD);
+        child_install_fd(comp, CHILD_COMP_FD);
+        cpu_pin_process(cpus, num_cpus);    // ONNX Runtime's threads inherit it
+        execvp(pool->python, argv);
+        _exit(127);
+    }
+    
+    worker->pid = pid;
+    worker->alive = true;
+    memset(worker->recent_models, 0, sizeof(worker->recent_models));   // nothing loaded yet
+    return 0;
+}
+
+// Fails every request still waiting on a dead worker
+static void fail_pending_locked(python_worker_pool_t *pool, python_worker_t *worker) {
+    for (size_t i = 0; i < PY_RING_SLOTS; i++) {
+        python_request_t *request = worker->pending[i];
+        if (request) {
+            request->status = -1;
+            request->done = true;
+            worker->pending[i] = NULL;
+            atomic_fetch_add(&pool->failed, 1);
+        }
+    }
+    worker->in_flight = 0;
+    pthread_cond_broadcast(&worker->cond);
+}
+
+static void drain_completions(python_worker_pool_t *pool, python_worker_t *worker) {
+    python_ring_header_t *header = ring_header(worker);
+    
+    pthread_mutex_lock(&worker->mutex);
+    
+    uint64_t head = atomic_load_explicit(&header->comp_head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&header->comp_tail, memory_order_acquire);
+    
+    for (; head != tail; head++) {
+        const unsigned char *slot = comp_slot(worker, head);
+        python_slot_header_t slot_header;
+        memcpy(&slot_header, slot, sizeof(slot_header));
+        
+        python_request_t *request = NULL;
+        size_t index = 0;
+        for (; index < PY_RING_SLOTS; index++) {
+            if (worker->pending[index] &&
+                worker->pending[index]->request_id == slot_header.request_id) {
+                request = worker->pending[index];
+                break;
+            }
+        }
+        if (!request) continue;     // request already failed and forgotten
+        
+        // A length past the slot is a corrupt completion, not a short result
+        size_t length = slot_header.length;
+        bool fits = length <= PY_SLOT_PAYLOAD_SIZE;
+        request->result = fits ? malloc(length + 1) : NULL;
+        if (request->result) {
+            memcpy(request->result, slot + sizeof(slot_header), length);
+            ((char*)request->result)[length] = '\0';
+            request->result_size = length;
+        }
+        request->status = (slot_header.status == 0 && request->result) ? 0 : -1;
+        request->done = true;
+        
+        worker->pending[index] = NULL;
+        worker->in_flight--;
+        worker->backoff_ms = PY_RESTART_BACKOFF_MIN_MS;   // it is healthy again
+        atomic_fetch_add(request->status == 0 ? &pool->completed : &pool->failed, 1);
+    }
+    
+    atomic_store_explicit(&header->comp_head, head, memory_order_release);
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+}
+
+static void supervise(python_worker_pool_t *pool) {
+    uint64_t now = now_ns();
+    
+    for (size_t i = 0; i < pool->num_workers; i++) {
+        python_worker_t *worker = &pool->workers[i];
+        
+        if (worker->alive) {
+            int status;
+            if (waitpid(worker->pid, &status, WNOHANG) != worker->pid) continue;
+            
+            fprintf(stderr, "Python worker %zu (pid %d) exited with status %d, restarting in %u ms\n",
+                    i, (int)worker->pid, WIFEXITED(status) ? WEXITSTATUS(status) : -1,
+                    worker->backoff_ms);
+            
+            pthread_mutex_lock(&worker->mutex);
+            worker->alive = false;
+            worker->pid = -1;
+            fail_pending_locked(pool, worker);
+            pthread_mutex_unlock(&worker->mutex);
+            
+            worker->restart_at_ns = now + (uint64_t)worker->backoff_ms * 1000000ULL;
+            worker->backoff_ms *= 2;
+            if (worker->backoff_ms > PY_RESTART_BACKOFF_MAX_MS) {
+                worker->backoff_ms = PY_RESTART_BACKOFF_MAX_MS;
+            }
+        } else if (now >= worker->restart_at_ns) {
+            pthread_mutex_lock(&worker->mutex);
+            if (worker_spawn(pool, worker) == 0) {
+                atomic_fetch_add(&pool->restarts, 1);
+            }
+            pthread_cond_broadcast(&worker->cond);
+            pthread_mutex_unlock(&worker->mutex);
+        }
+    }
+}
+
+static void* supervisor_thread(void *arg) {
+    python_worker_pool_t *pool = (python_worker_pool_t*)arg;
+    struct epoll_event events[16];
+    
+    while (!atomic_load(&pool->stopping)) {
+        int n = epoll_wait(pool->epoll_fd, events, 16, SUPERVISOR_TICK_MS);
+        
+        for (int i = 0; i < n; i++) {
+            python_worker_t *worker = &pool->workers[events[i].data.u64];
+            drain_doorbell(worker->comp_efd);
+            drain_completions(pool, worker);
+        }
+        
+        supervise(pool);
+    }
+    
+    return NULL;
+}
+
+python_worker_pool_t* python_worker_pool_create(size_t num_workers, const char *python,
+                                                const char *script, const char *model_path) {
+    if (num_workers == 0 || !python || !script) return NULL;
+    
+    python_worker_pool_t *pool = (python_worker_pool_t*)calloc(1, sizeof(python_worker_pool_t));
+    if (!pool) return NULL;
+    
+    pool->workers = (python_worker_t*)calloc(num_workers, sizeof(python_worker_t));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+    
+    strncpy(pool->python, python, MAX_PYTHON_PATH_LEN - 1);
+    strncpy(pool->script, script, MAX_PYTHON_PATH_LEN - 1);
+    if (model_path) {
+        strncpy(pool->model_path, model_path, MAX_PYTHON_PATH_LEN - 1);
+    }
+    pool->model_budget_mb = PY_DEFAULT_MODEL_BUDGET_MB;
+    pool->intra_op_threads = 1;
+    atomic_init(&pool->stopping, false);
+    atomic_init(&pool->next_worker, 0);
+    atomic_init(&pool->affinity_hits, 0);
+    atomic_init(&pool->killed, 0);
+    
+    pool->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (pool->epoll_fd < 0) {
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < num_workers; i++) {
+        if (worker_setup(pool, &pool->workers[i], i) != 0) {
+            for (size_t j = 0; j < i; j++) {
+                worker_teardown(&pool->workers[j]);
+            }
+            close(pool->epoll_fd);
+            free(pool->workers);
+            free(pool);
+            return NULL;
+        }
+        pool->num_workers++;
+    }
+    
+    return pool;
+}
+
+void python_worker_pool_set_model_budget(python_worker_pool_t *pool, size_t budget_mb) {
+    if (!pool || pool->started) return;
+    pool->model_budget_mb = budget_mb;
+}
+
+void python_worker_pool_set_placement(python_worker_pool_t *pool, const cpu_plan_t *plan) {
+    if (!pool || pool->started) return;
+    pool->placement = plan;
+    pool->intra_op_threads = (plan && plan->intra_op_threads > 0) ? plan->intra_op_threads : 1;
+}
+
+int python_worker_pool_start(python_worker_pool_t *pool) {
+    if (!pool || pool->started) return -1;
+    
+    for (size_t i = 0; i < pool->num_workers; i++) {
+        python_worker_t *worker = &pool->workers[i];
+        pthread_mutex_lock(&worker->mutex);
+        if (worker_spawn(pool, worker) != 0) {
+            // The supervisor keeps retrying with backoff
+            worker->restart_at_ns = now_ns() + (uint64_t)worker->backoff_ms * 1000000ULL;
+        }
+        pthread_mutex_unlock(&worker->mutex);
+    }
+    
+    if (pthread_create(&pool->supervisor, NULL, supervisor_thread, pool) != 0) {
+        return -1;
+    }
+    pool->started = true;
+    
+    return 0;
+}
+
+void python_worker_pool_destroy(python_worker_pool_t *pool) {
+    if (!pool) return;
+    
+    atomic_store(&pool->stopping, true);
+    if (pool->started) {
+        pthread_join(pool->supervisor, NULL);
+    }
+    
+    for (size_t i = 0; i < pool->num_workers; i++) {
+        python_worker_t *worker = &pool->workers[i];
+        
+        pthread_mutex_lock(&worker->mutex);
+        if (worker->alive) {
+            kill(worker->pid, SIGTERM);
+            waitpid(worker->pid, NULL, 0);
+            worker->alive = false;
+        }
+        fail_pending_locked(pool, worker);
+        pthread_mutex_unlock(&worker->mutex);
+        
+        worker_teardown(worker);
+    }
+    
+    close(pool->epoll_fd);
+    free(pool->workers);
+    free(pool);
+}
+
+// FNV-1a of the model path; the empty path (default model) hashes too
+static uint64_t model_key(const char *model) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char*)(model ? model : ""); *p; p++) {
+        hash ^= *p;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static bool has_model_locked(const python_worker_t *worker, uint64_t key) {
+    for (size_t i = 0; i < PY_AFFINITY_SLOTS; i++) {
+        if (worker->recent_models[i] == key) return true;
+    }
+    return false;
+}
+
+// Moves key to the front of the worker's most-recently-used list
+static void touch_model_locked(python_worker_t *worker, uint64_t key) {
+    size_t i = 0;
+    while (i < PY_AFFINITY_SLOTS - 1 && worker->recent_models[i] != key) {
+        i++;
+    }
+    memmove(&worker->recent_models[1], &worker->recent_models[0], i * sizeof(uint64_t));
+    worker->recent_models[0] = key;
+}
+
+// Picks a live worker with a free submission slot, preferring one that
+// recently served the model, otherwise round-robin. Returns with that
+// worker's mutex held, or NULL if none is alive.
+static python_worker_t* acquire_worker(python_worker_pool_t *pool, uint64_t model) {
+    size_t start = atomic_fetch_add(&pool->next_worker, 1);
+    
+    // Model affinity: skips a reload on the worker side
+    for (size_t i = 0; i < pool->num_workers; i++) {
+        python_worker_t *worker = &pool->workers[(start + i) % pool->num_workers];
+        pthread_mutex_lock(&worker->mutex);
+        if (worker->alive && worker->in_flight < PY_RING_SLOTS && has_model_locked(worker, model)) {
+            atomic_fetch_add(&pool->affinity_hits, 1);
+            return worker;
+        }
+        pthread_mutex_unlock(&worker->mutex);
+    }
+    
+    for (size_t i = 0; i < pool->num_workers; i++) {
+        python_worker_t *worker = &pool->workers[(start + i) % pool->num_workers];
+        pthread_mutex_lock(&worker->mutex);
+        if (worker->alive && worker->in_flight < PY_RING_SLOTS) {
+            return worker;
+        }
+        pthread_mutex_unlock(&worker->mutex);
+    }
+    
+    // Everyone is busy: queue up behind the round-robin choice
+    python_worker_t *worker = &pool->workers[start % pool->num_workers];
+    pthread_mutex_lock(&worker->mutex);
+    while (worker->alive && worker->in_flight >= PY_RING_SLOTS &&
+           !atomic_load(&pool->stopping)) {
+        pthread_cond_wait(&worker->cond, &worker->mutex);
+    }
+    if (worker->alive && worker->in_flight < PY_RING_SLOTS) {
+        return worker;
+    }
+    pthread_mutex_unlock(&worker->mutex);
+    
+    return NULL;
+}
+
+typedef struct {
+    task_t *task;                   // tagged with the worker while it is in flight
+    const char *task_id;
+    const void *data;
+    size_t data_size;
+} python_record_t;
+
+// Bytes a submission occupies: the model prefix, then the records
+// (batched records carry a length prefix)
+static size_t records_size(const char *model, const python_record_t *records, size_t count,
+                           bool batched) {
+    size_t total = sizeof(uint16_t) + strlen(model);
+    for (size_t i = 0; i < count; i++) {
+        total += MAX_TASK_ID_LEN + records[i].data_size + (batched ? sizeof(uint32_t) : 0);
+    }
+    return total;
+}
+
+// Slot payload: 16-bit model path length and the path (empty for the
+// worker's default model), then per record the NUL-padded task id,
+// (batched only) a 32-bit length, and the task data
+static void write_records(unsigned char *out, const char *model, const python_record_t *records,
+                          size_t count, bool batched) {
+    uint16_t model_length = (uint16_t)strlen(model);
+    memcpy(out, &model_length, sizeof(model_length));
+    memcpy(out + sizeof(model_length), model, model_length);
+    out += sizeof(model_length) + model_length;
+    
+    for (size_t i = 0; i < count; i++) {
+        memset(out, 0, MAX_TASK_ID_LEN);
+        strncpy((char*)out, records[i].task_id, MAX_TASK_ID_LEN - 1);
+        out += MAX_TASK_ID_LEN;
+        
+        if (batched) {
+            uint32_t length = (uint32_t)records[i].data_size;
+            memcpy(out, &length, sizeof(length));
+            out += sizeof(length);
+        }
+        if (records[i].data_size > 0) {
+            memcpy(out, records[i].data, records[i].data_size);
+            out += records[i].data_size;
+        }
+    }
+}
+
+// Sends one request and waits for its completion. A batch travels as a
+// single request whose submission status field holds the record count.
+static int execute_records(python_worker_pool_t *pool, const char *model,
+                           const python_record_t *records, size_t count, bool batched,
+                           void **result, size_t *result_size) {
+    if (!model) model = "";
+    if (strlen(model) >= MAX_PYTHON_PATH_LEN) return -1;
+    
+    size_t payload_size = records_size(model, records, count, batched);
+    if (payload_size > PY_SLOT_PAYLOAD_SIZE) {
+        fprintf(stderr, "Task '%s' payload of %zu bytes exceeds the IPC slot size\n",
+                records[0].task_id, payload_size);
+        return -1;
+    }
+    
+    uint64_t key = model_key(model);
+    python_worker_t *worker;
+    python_ring_header_t *header;
+    uint64_t tail;
+    for (;;) {
+        worker = acquire_worker(pool, key);
+        if (!worker) {
+            atomic_fetch_add(&pool->failed, 1);
+            return -1;
+        }
+        
+        // Slots free up as Python consumes them; in_flight bounds the wait
+        pid_t pid = worker->pid;
+        header = ring_header(worker);
+        tail = atomic_load_explicit(&header->sub_tail, memory_order_relaxed);
+        while (worker->alive && worker->pid == pid &&
+               tail - atomic_load_explicit(&header->sub_head, memory_order_acquire) >= PY_RING_SLOTS) {
+            pthread_mutex_unlock(&worker->mutex);
+            sched_yield();
+            pthread_mutex_lock(&worker->mutex);
+            tail = atomic_load_explicit(&header->sub_tail, memory_order_relaxed);
+        }
+        if (worker->alive && worker->pid == pid) break;
+        
+        // It died (and maybe restarted on a fresh ring) while the lock was
+        // dropped; pick again rather than write into a dead ring
+        pthread_mutex_unlock(&worker->mutex);
+    }
+    
+    python_request_t request = { .request_id = ++worker->next_request_id };
+    
+    unsigned char *slot = sub_slot(worker, tail);
+    python_slot_header_t slot_header = {
+        .request_id = request.request_id,
+        .status = batched ? (uint32_t)count : 0,
+        .length = (uint32_t)payload_size
+    };
+    memcpy(slot, &slot_header, sizeof(slot_header));
+    write_records(slot + sizeof(slot_header), model, records, count, batched);
+    touch_model_locked(worker, key);
+    
+    for (size_t i = 0; i < PY_RING_SLOTS; i++) {
+        if (!worker->pending[i]) {
+            worker->pending[i] = &request;
+            break;
+        }
+    }
+    worker->in_flight++;
+    for (size_t i = 0; i < count; i++) {
+        atomic_store_explicit(&records[i].task->backend_worker, (int)worker->index,
+                              memory_order_relaxed);
+    }
+    
+    atomic_store_explicit(&header->sub_tail, tail + 1, memory_order_release);
+    ring_doorbell(worker->sub_efd);
+    
+    while (!request.done) {
+        pthread_cond_wait(&worker->cond, &worker->mutex);
+    }
+    // Under the lock, so python_worker_pool_abort() never kills the worker
+    // once the request is over
+    for (size_t i = 0; i < count; i++) {
+        atomic_store_explicit(&records[i].task->backend_worker, -1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&worker->mutex);
+    
+    if (request.status != 0) {
+        free(request.result);
+        return -1;
+    }
+    
+    if (result && result_size) {
+        *result = request.result;
+        *result_size = request.result_size;
+    } else {
+        free(request.result);
+    }
+    return 0;
+}
+
+int python_worker_pool_execute(python_worker_pool_t *pool, const char *model, task_t *task,
+                               void **result, size_t *result_size) {
+    if (!pool || !task) return -1;
+    
+    python_record_t record = { task, task->task_id, task->data, task->data_size };
+    return execute_records(pool, model, &record, 1, false, result, result_size);
+}
+
+int python_worker_pool_execute_batch(python_worker_pool_t *pool, const char *model,
+                                     task_t **tasks, size_t count,
+                                     void **results, size_t *result_sizes) {
+    if (!pool || !tasks || count == 0 || count > PY_MAX_BATCH || !results || !result_sizes) {
+        return -1;
+    }
+    
+    python_record_t records[PY_MAX_BATCH];
+    for (size_t i = 0; i < count; i++) {
+        records[i] = (python_record_t){ tasks[i], tasks[i]->task_id, tasks[i]->data,
+                                        tasks[i]->data_size };
+        results[i] = NULL;
+        result_sizes[i] = 0;
+    }
+    
+    void *reply = NULL;
+    size_t reply_size = 0;
+    if (execute_records(pool, model, records, count, true, &reply, &reply_size) != 0) {
+        return -1;
+    }
+    
+    // Completion holds one (status, length, bytes) record per task, in order
+    const unsigned char *in = (const unsigned char*)reply;
+    const unsigned char *end = in + reply_size;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t status, length;
+        if ((size_t)(end - in) < 2 * sizeof(uint32_t)) break;
+        memcpy(&status, in, sizeof(status));
+        memcpy(&length, in + sizeof(status), sizeof(length));
+        in += 2 * sizeof(uint32_t);
+        if ((size_t)(end - in) < length) break;
+        
+        results[i] = malloc((size_t)length + 1);
+        if (results[i]) {
+            memcpy(results[i], in, length);
+            ((char*)results[i])[length] = '\0';
+            result_sizes[i] = length;
+        }
+        tasks[i]->status = (status == 0 && results[i]) ? TASK_STATUS_COMPLETED : TASK_STATUS_FAILED;
+        in += length;
+    }
+    
+    // Tasks the reply did not cover failed
+    for (size_t i = 0; i < count; i++) {
+        if (tasks[i]->status == TASK_STATUS_RUNNING) {
+            tasks[i]->status = TASK_STATUS_FAILED;
+        }
+    }
+    
+    free(reply);
+    return 0;
+}
+
+void python_worker_pool_get_stats(python_worker_pool_t *pool, python_worker_stats_t *stats) {
+    if (!pool || !stats) return;
+    
+    stats->completed = atomic_load(&pool->completed);
+    stats->failed = atomic_load(&pool->failed);
+    stats->restarts = atomic_load(&pool->restarts);
+    stats->affinity_hits = atomic_load(&pool->affinity_hits);
+    stats->killed = atomic_load(&pool->killed);
+}
+
+int python_worker_pool_abort(python_worker_pool_t *pool, task_t *task) {
+    if (!pool || !task) return -1;
+    
+    int index = atomic_load_explicit(&task->backend_worker, memory_order_relaxed);
+    if (index < 0 || (size_t)index >= pool->num_workers) return -1;
+    
+    // The tag only changes under this lock, so a match means the request
+    // is still pending on this process
+    python_worker_t *worker = &pool->workers[index];
+    pthread_mutex_lock(&worker->mutex);
+    bool serving = atomic_load_explicit(&task->backend_worker, memory_order_relaxed) == index &&
+                   worker->alive && worker->pid > 0;
+    if (serving) {
+        kill(worker->pid, SIGKILL);
+    }
+    pthread_mutex_unlock(&worker->mutex);
+    
+    if (!serving) return -1;
+    fprintf(stderr, "Python worker %d killed: task '%s' ran out of time\n", index, task->task_id);
+    atomic_fetch_add(&pool->killed, 1);
+    return 0;
+}
+
+#else
+
+python_worker_pool_t* python_worker_pool_create(size_t num_workers, const char *python,
+                                                const char *script, const char *model_path) {
+    // Shared-memory rings use eventfd/epoll doorbells, which are Linux-only
+    (void)num_workers;
+    (void)python;
+    (void)script;
+    (void)model_path;
+    return NULL;
+}
+
+void python_worker_pool_set_model_budget(python_worker_pool_t *pool, size_t budget_mb) {
+    (void)pool;
+    (void)budget_mb;
+}
+
+void python_worker_pool_set_placement(python_worker_pool_t *pool, const cpu_plan_t *plan) {
+    (void)pool;
+    (void)plan;
+}
+
+int python_worker_pool_start(python_worker_pool_t *pool) {
+    (void)pool;
+    return -1;
+}
+
+void python_worker_pool_destroy(python_worker_pool_t *pool) {
+    (void)pool;
+}
+
+int python_worker_pool_execute_batch(python_worker_pool_t *pool, const char *model,
+                                     task_t **tasks, size_t count,
+                                     void **results, size_t *result_sizes) {
+    (void)pool;
+    (void)model;
+    (void)tasks;
+    (void)count;
+    (void)results;
+    (void)result_sizes;
+    return -1;
+}
+
+int python_worker_pool_execute(python_worker_pool_t *pool, const char *model, task_t *task,
+                               void **result, size_t *result_size) {
+    (void)pool;
+    (void)model;
+    (void)task;
+    (void)result;
+    (void)result_size;
+    return -1;
+}
+
+void python_worker_pool_get_stats(python_worker_pool_t *pool, python_worker_stats_t *stats) {
+    (void)pool;
+    if (stats) {
+        stats->completed = 0;
+        stats->failed = 0;
+        stats->restarts = 0;
+        stats->affinity_hits = 0;
+        stats->killed = 0;
+    }
+}
+
+int python_worker_pool_abort(python_worker_pool_t *pool, task_t *task) {
+    (void)pool;
+    (void)task;
+    return -1;
+}
+
+#endif
+
@@ -0,0 +1,146 @@
+#ifndef PYTHON_WORKER_POOL_H
+#define PYTHON_WORKER_POOL_H
+
+#include "task_queue.h"
+#include "cpu_topology.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define MAX_PYTHON_PATH_LEN 256
+#define PY_RING_MAGIC 0x524f4941u      // "AIOR"
+#define PY_RING_VERSION 2
+#define PY_RING_SLOTS 16               // per direction, power of two
+#define PY_RING_SLOT_SIZE (64 * 1024)
+#define PY_RING_DATA_OFFSET 4096
+#define PY_MAX_BATCH 32                // records per batched request
+#define PY_AFFINITY_SLOTS 4            // models remembered per worker for affinity
+#define PY_DEFAULT_MODEL_BUDGET_MB 1024
+#define PY_RESTART_BACKOFF_MIN_MS 100
+#define PY_RESTART_BACKOFF_MAX_MS 5000
+
+// Layout of the start of each worker's shared-memory segment. Must match
+// ShmRing in communication.py. The four cursors are byte offsets 64,
+// 128, 192 and 256; slots follow at PY_RING_DATA_OFFSET, submission
+// slots first, then completion slots.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    char pad0[CACHE_LINE_SIZE - 4 * sizeof(uint32_t)];
+    _Atomic uint64_t sub_head;      // advanced by Python
+    char pad1[CACHE_LINE_SIZE - sizeof(uint64_t)];
+    _Atomic uint64_t sub_tail;      // advanced by C
+    char pad2[CACHE_LINE_SIZE - sizeof(uint64_t)];
+    _Atomic uint64_t comp_head;     // advanced by C
+    char pad3[CACHE_LINE_SIZE - sizeof(uint64_t)];
+    _Atomic uint64_t comp_tail;     // advanced by Python
+    char pad4[CACHE_LINE_SIZE - sizeof(uint64_t)];
+} python_ring_header_t;
+
+// A submission payload starts with a uint16 model path length and the
+// path (empty: the worker's default model). It normally carries one task
+// next: a 64-byte NUL-padded task id and its data. A nonzero submission
+// status is a batch record count; each record is then id, uint32 length,
+// data, and the completion holds one (uint32 status, uint32 length,
+// bytes) record per task.
+typedef struct {
+    uint64_t request_id;
+    uint32_t status;                // completions: 0 = ok; submissions: batch count
+    uint32_t length;                // payload bytes following the header
+} python_slot_header_t;
+
+// Caps requests and results alike: an oversized result fails its request,
+// a batched one fails the batch
+#define PY_SLOT_PAYLOAD_SIZE (PY_RING_SLOT_SIZE - sizeof(python_slot_header_t))
+
+typedef struct {
+    uint64_t request_id;
+    int status;
+    bool done;
+    void *result;                   // malloc'd copy of the completion payload
+    size_t result_size;
+} python_request_t;
+
+typedef struct {
+    size_t index;
+    pid_t pid;
+    bool alive;
+    char shm_name[64];
+    void *shm;
+    size_t shm_size;
+    int sub_efd;                    // doorbell C -> Python
+    int comp_efd;                   // doorbell Python -> C
+    pthread_mutex_t mutex;          // guards the submission ring and pending
+    pthread_cond_t cond;            // slot freed, request done or worker died
+    python_request_t *pending[PY_RING_SLOTS];
+    uint64_t recent_models[PY_AFFINITY_SLOTS];  // model path hashes, most recent first
+    size_t in_flight;
+    uint64_t next_request_id;
+    uint32_t backoff_ms;
+    uint64_t restart_at_ns;
+} python_worker_t;
+
+typedef struct {
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t restarts;
+    uint64_t affinity_hits;         // requests routed to a worker with the model warm
+    uint64_t killed;                // workers killed by python_worker_pool_abort()
+} python_worker_stats_t;
+
+// Supervises long-lived inference_engine.py processes, each fed through
+// its own shared-memory ring with eventfd doorbells. Crashed workers are
+// restarted with exponential backoff; their in-flight requests fail.
+// Each worker keeps several models warm; requests prefer a worker that
+// recently served their model.
+typedef struct {
+    python_worker_t *workers;
+    size_t num_workers;
+    char python[MAX_PYTHON_PATH_LEN];
+    char script[MAX_PYTHON_PATH_LEN];
+    char model_path[MAX_PYTHON_PATH_LEN];
+    size_t model_budget_mb;         // resident model memory per worker, 0 = unlimited
+    const cpu_plan_t *placement;    // optional, not owned; pins workers to their cores
+    size_t intra_op_threads;        // per ONNX Runtime session
+    int epoll_fd;
+    pthread_t supervisor;
+    bool started;
+    _Atomic bool stopping;
+    _Atomic size_t next_worker;
+    _Atomic uint64_t completed;
+    _Atomic uint64_t failed;
+    _Atomic uint64_t restarts;
+    _Atomic uint64_t affinity_hits;
+    _Atomic uint64_t killed;
+} python_worker_pool_t;
+
+python_worker_pool_t* python_worker_pool_create(size_t num_workers, const char *python,
+                                                const char *script, const char *model_path);
+void python_worker_pool_set_model_budget(python_worker_pool_t *pool, size_t budget_mb);
+// Takes intra-op threads and per-worker CPUs from plan; call before
+// python_worker_pool_start()
+void python_worker_pool_set_placement(python_worker_pool_t *pool, const cpu_plan_t *plan);
+int python_worker_pool_start(python_worker_pool_t *pool);
+void python_worker_pool_destroy(python_worker_pool_t *pool);
+// model is a model path, or NULL/"" for the worker's default model. While
+// the request is in flight task->backend_worker names the worker serving it.
+int python_worker_pool_execute(python_worker_pool_t *pool, const char *model, task_t *task,
+                               void **result, size_t *result_size);
+// Runs tasks as one batched request. Sets each task's status and hands
+// back a malloc'd result per task (NULL on failure); -1 if the batch never ran.
+int python_worker_pool_execute_batch(python_worker_pool_t *pool, const char *model,
+                                     task_t **tasks, size_t count,
+                                     void **results, size_t *result_sizes);
+// Kills the process serving task, if a request of it is in flight, so a
+// hung inference cannot hold its worker: every request on that process
+// fails and the supervisor starts a replacement. Safe from any thread;
+// -1 if the task is not with a Python worker.
+int python_worker_pool_abort(python_worker_pool_t *pool, task_t *task);
+void python_worker_pool_get_stats(python_worker_pool_t *pool, python_worker_stats_t *stats);
+
+#endif // PYTHON_WORKER_POOL_H
+
@@ -1,8 +1,11 @@
+#define _GNU_SOURCE
 #include "resource_monitor.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
+#include <errno.h>
 
 #ifdef __linux__
 #include <sys/sysinfo.h>
@@ -11,58 +14,241 @@
 #include <mach/mach.h>
 #endif
 
-resource_monitor_t* resource_monitor_create(uint32_t check_interval_ms) {
-    resource_monitor_t *monitor = (resource_monitor_t*)malloc(sizeof(resource_monitor_t));
-    if (!monitor) return NULL;
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+#ifdef __linux__
+// Aggregate "cpu" line of /proc/stat. Guest time is already part of user.
+static int read_cpu_times(cpu_times_t *times) {
+    FILE *file = fopen("/proc/stat", "r");
+    if (!file) return -1;
     
-    monitor->monitoring = false;
-    monitor->check_interval_ms = check_interval_ms;
+    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
+    int fields = fscanf(file, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                        &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+    fclose(file);
+    if (fields < 4) return -1;
+    if (fields < 8) {
+        iowait = irq = softirq = steal = 0;
+    }
     
-    return monitor;
+    uint64_t idle_all = idle + iowait;
+    times->total = user + nice + system + idle_all + irq + softirq + steal;
+    times->busy = times->total - idle_all;
+    return 0;
 }
 
-void resource_monitor_destroy(resource_monitor_t *monitor) {
-    if (monitor) {
-        free(monitor);
+// MemTotal/MemAvailable; falls back to sysinfo() on kernels without MemAvailable
+static void read_memory(system_resources_t *resources) {
+    unsigned long long total_kb = 0, available_kb = 0;
+    bool have_available = false;
+    
+    FILE *file = fopen("/proc/meminfo", "r");
+    if (file) {
+        char line[128];
+        while (fgets(line, sizeof(line), file)) {
+            if (sscanf(line, "MemTotal: %llu kB", &total_kb) == 1) continue;
+            if (sscanf(line, "MemAvailable: %llu kB", &available_kb) == 1) {
+                have_available = true;
+                break;
+            }
+        }
+        fclose(file);
+    }
+    
+    if (have_available && total_kb > 0) {
+        resources->memory_total = (uint64_t)total_kb * 1024;
+        resources->memory_available = (uint64_t)available_kb * 1024;
+    } else {
+        struct sysinfo info;
+        if (sysinfo(&info) == 0) {
+            resources->memory_total = (uint64_t)info.totalram * info.mem_unit;
+            resources->memory_available = (uint64_t)(info.freeram + info.bufferram) * info.mem_unit;
+        } else {
+            resources->memory_total = 0;
+            resources->memory_available = 0;
+        }
     }
+    resources->memory_used = resources->memory_total - resources->memory_available;
 }
 
-int resource_monitor_get_resources(resource_monitor_t *monitor, system_resources_t *resources) {
-    if (!monitor || !resources) return -1;
+// avg10 of the "some" or "full" line of a PSI file, -1 if unsupported
+static double read_pressure(const char *path, const char *kind) {
+    FILE *file = fopen(path, "r");
+    if (!file) return -1.0;
     
-    // CPU usage (simplified - in production, calculate over time)
-#ifdef __linux__
-    FILE *file = fopen("/proc/loadavg", "r");
-    if (file) {
-        double load[3];
-        if (fscanf(file, "%lf %lf %lf", &load[0], &load[1], &load[2]) == 3) {
-            resources->cpu_usage = load[0] * 100.0; // Simplified
+    double avg10 = -1.0;
+    char line[256];
+    char name[8];
+    double value;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%7s avg10=%lf", name, &value) == 2 && strcmp(name, kind) == 0) {
+            avg10 = value;
+            break;
+        }
+    }
+    fclose(file);
+    return avg10;
+}
+
+#define CGROUP_MOUNT "/sys/fs/cgroup"
+#define CGROUP_V1_UNLIMITED (1ULL << 62)    // v1 reports "no limit" as a huge page-aligned value
+
+static bool file_exists(const char *path) {
+    return access(path, R_OK) == 0;
+}
+
+// This process's cgroup from /proc/self/cgroup: the v2 "0::" entry when
+// controller is NULL, otherwise the v1 hierarchy carrying controller
+static bool read_cgroup_path(const char *controller, char *path, size_t size) {
+    FILE *file = fopen("/proc/self/cgroup", "r");
+    if (!file) return false;
+    
+    bool found = false;
+    char line[512];
+    while (!found && fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\n")] = '\0';
+        char *controllers = strchr(line, ':');
+        if (!controllers) continue;
+        char *cgroup = strchr(++controllers, ':');
+        if (!cgroup) continue;
+        *cgroup++ = '\0';
+        
+        if (!controller) {
+            found = controllers[0] == '\0';
         } else {
-            resources->cpu_usage = 0.0;
+            char *save;
+            for (char *name = strtok_r(controllers, ",", &save); name && !found;
+                 name = strtok_r(NULL, ",", &save)) {
+                found = strcmp(name, controller) == 0;
+            }
         }
-        fclose(file);
+        if (found) snprintf(path, size, "%s", cgroup);
+    }
+    fclose(file);
+    return found;
+}
+
+// Directory under mount that holds file for this process: its own cgroup
+// when visible there, the mount itself inside a cgroup namespace
+static void find_cgroup_dir(const char *mount, const char *controller, const char *file,
+                            char *dir, size_t size) {
+    char cgroup[RESOURCE_CGROUP_PATH_MAX / 2];
+    char path[RESOURCE_CGROUP_PATH_MAX * 2];
+    
+    if (read_cgroup_path(controller, cgroup, sizeof(cgroup)) && strcmp(cgroup, "/") != 0) {
+        snprintf(path, sizeof(path), "%s%s/%s", mount, cgroup, file);
+        if (file_exists(path)) {
+            snprintf(dir, size, "%s%s", mount, cgroup);
+            return;
+        }
+    }
+    snprintf(path, sizeof(path), "%s/%s", mount, file);
+    if (file_exists(path)) {
+        snprintf(dir, size, "%s", mount);
     } else {
-        resources->cpu_usage = 0.0;
+        dir[0] = '\0';
+    }
+}
+
+static void find_cgroup_limits(resource_monitor_t *monitor) {
+    // The root of a pure v2 hierarchy carries no cpu.max or memory.max,
+    // so a process there is reported as unlimited
+    monitor->cgroup_v2 = file_exists(CGROUP_MOUNT "/cgroup.controllers");
+    if (monitor->cgroup_v2) {
+        find_cgroup_dir(CGROUP_MOUNT, NULL, "cpu.max",
+                        monitor->cgroup_cpu, sizeof(monitor->cgroup_cpu));
+        find_cgroup_dir(CGROUP_MOUNT, NULL, "memory.max",
+                        monitor->cgroup_memory, sizeof(monitor->cgroup_memory));
+    } else {
+        find_cgroup_dir(CGROUP_MOUNT "/cpu", "cpu", "cpu.cfs_quota_us",
+                        monitor->cgroup_cpu, sizeof(monitor->cgroup_cpu));
+        find_cgroup_dir(CGROUP_MOUNT "/memory", "memory", "memory.limit_in_bytes",
+                        monitor->cgroup_memory, sizeof(monitor->cgroup_memory));
+    }
+}
+
+// First whitespace-separated values of dir/name; "max" reads as 0.
+// Returns how many were read.
+static int read_cgroup_values(const char *dir, const char *name, long long *values, int count) {
+    char path[RESOURCE_CGROUP_PATH_MAX * 2];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+    
+    int read = 0;
+    char token[32];
+    while (read < count && fscanf(file, "%31s", token) == 1) {
+        values[read++] = strcmp(token, "max") == 0 ? 0 : strtoll(token, NULL, 10);
+    }
+    fclose(file);
+    return read;
+}
+
+static void read_cgroup(const resource_monitor_t *monitor, system_resources_t *resources) {
+    long long values[2];
+    
+    // v2 cpu.max is "<quota> <period>"; v1 splits them and uses -1 for none
+    if (monitor->cgroup_cpu[0]) {
+        long long quota = 0, period = 0;
+        if (monitor->cgroup_v2) {
+            if (read_cgroup_values(monitor->cgroup_cpu, "cpu.max", values, 2) == 2) {
+                quota = values[0];
+                period = values[1];
+            }
+        } else if (read_cgroup_values(monitor->cgroup_cpu, "cpu.cfs_quota_us", &quota, 1) == 1) {
+            read_cgroup_values(monitor->cgroup_cpu, "cpu.cfs_period_us", &period, 1);
+        }
+        if (quota > 0 && period > 0) {
+            resources->cpu_quota = (double)quota / (double)period;
+        }
     }
-#else
-    // For macOS and other systems, use a simplified approach
-    // In production, use sysctl or other platform-specific APIs
-    resources->cpu_usage = 0.0; // Placeholder
-#endif
     
-    // Memory usage
+    if (monitor->cgroup_memory[0]) {
+        const char *limit_file = monitor->cgroup_v2 ? "memory.max" : "memory.limit_in_bytes";
+        const char *used_file = monitor->cgroup_v2 ? "memory.current" : "memory.usage_in_bytes";
+        if (read_cgroup_values(monitor->cgroup_memory, limit_file, values, 1) == 1 &&
+            values[0] > 0 && (unsigned long long)values[0] < CGROUP_V1_UNLIMITED) {
+            resources->cgroup_memory_limit = (uint64_t)values[0];
+        }
+        if (read_cgroup_values(monitor->cgroup_memory, used_file, values, 1) == 1 && values[0] > 0) {
+            resources->cgroup_memory_used = (uint64_t)values[0];
+        }
+    }
+}
+#endif
+
+static void sample_resources(resource_monitor_t *monitor, system_resources_t *resources) {
+    resources->cpu_usage = 0.0;
+    resources->cpu_pressure = -1.0;
+    resources->memory_pressure = -1.0;
+    resources->memory_pressure_full = -1.0;
+    resources->cpu_quota = 0.0;
+    resources->cgroup_memory_limit = 0;
+    resources->cgroup_memory_used = 0;
+    resources->sample_time_ms = monotonic_ms();
+
 #ifdef __linux__
-    struct sysinfo info;
-    if (sysinfo(&info) == 0) {
-        resources->memory_total = info.totalram * info.mem_unit;
-        resources->memory_available = info.freeram * info.mem_unit;
-        resources->memory_used = resources->memory_total - resources->memory_available;
-    } else {
-        resources->memory_total = 0;
-        resources->memory_available = 0;
-        resources->memory_used = 0;
+    // Busy share of CPU time since the previous sample (since boot on the first)
+    cpu_times_t now;
+    if (read_cpu_times(&now) == 0) {
+        uint64_t total = now.total - monitor->prev_cpu.total;
+        uint64_t busy = now.busy - monitor->prev_cpu.busy;
+        resources->cpu_usage = total ? (double)busy / (double)total * 100.0 : 0.0;
+        monitor->prev_cpu = now;
     }
+    
+    read_memory(resources);
+    resources->cpu_pressure = read_pressure("/proc/pressure/cpu", "some");
+    resources->memory_pressure = read_pressure("/proc/pressure/memory", "some");
+    resources->memory_pressure_full = read_pressure("/proc/pressure/memory", "full");
+    read_cgroup(monitor, resources);
 #elif __APPLE__
+    // CPU% is not sampled here; memory comes from the Mach VM statistics
+    (void)monitor;
     int mib[2];
     uint64_t total_mem;
     size_t len = sizeof(total_mem);
@@ -91,27 +277,167 @@ int resource_monitor_get_resources(resource_monitor_t *monitor, system_resources
         resources->memory_used = 0;
     }
 #else
+    (void)monitor;
     resources->memory_total = 0;
     resources->memory_available = 0;
     resources->memory_used = 0;
 #endif
+}
+
+static uint64_t pack_health(const system_resources_t *resources) {
+    float cpu = (float)resources->cpu_usage;
+    float memory = resources->memory_total
+                   ? (float)((double)resources->memory_used / resources->memory_total * 100.0)
+                   : 0.0f;
+    
+    uint32_t cpu_bits, memory_bits;
+    memcpy(&cpu_bits, &cpu, sizeof(cpu_bits));
+    memcpy(&memory_bits, &memory, sizeof(memory_bits));
+    return (uint64_t)cpu_bits | ((uint64_t)memory_bits << 32);
+}
+
+// Single writer (the sampler thread, or create() before it starts)
+static void publish(resource_monitor_t *monitor, const system_resources_t *resources) {
+    uint64_t words[RESOURCE_SNAPSHOT_WORDS];
+    memcpy(words, resources, sizeof(words));
+    
+    uint32_t seq = atomic_load_explicit(&monitor->sequence, memory_order_relaxed);
+    atomic_store_explicit(&monitor->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < RESOURCE_SNAPSHOT_WORDS; i++) {
+        atomic_store_explicit(&monitor->snapshot[i], words[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&monitor->sequence, seq + 2, memory_order_release);
+    
+    atomic_store_explicit(&monitor->health, pack_health(resources), memory_order_release);
+}
+
+static void* sampler_thread(void *arg) {
+    resource_monitor_t *monitor = (resource_monitor_t*)arg;
+    
+    pthread_mutex_lock(&monitor->mutex);
+    while (atomic_load(&monitor->monitoring)) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)monitor->check_interval_ms * 1000000ULL;
+        deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+        deadline.tv_nsec = (long)(ns % 1000000000ULL);
+        
+        int rc = 0;
+        while (atomic_load(&monitor->monitoring) && rc != ETIMEDOUT) {
+            rc = pthread_cond_timedwait(&monitor->cond, &monitor->mutex, &deadline);
+        }
+        if (!atomic_load(&monitor->monitoring)) break;
+        
+        pthread_mutex_unlock(&monitor->mutex);
+        system_resources_t resources;
+        sample_resources(monitor, &resources);
+        publish(monitor, &resources);
+        pthread_mutex_lock(&monitor->mutex);
+    }
+    pthread_mutex_unlock(&monitor->mutex);
+    
+    return NULL;
+}
+
+resource_monitor_t* resource_monitor_create(uint32_t check_interval_ms) {
+    resource_monitor_t *monitor = (resource_monitor_t*)calloc(1, sizeof(resource_monitor_t));
+    if (!monitor) return NULL;
+    
+    monitor->check_interval_ms = check_interval_ms ? check_interval_ms : 1000;
+    atomic_init(&monitor->monitoring, true);
+    atomic_init(&monitor->sequence, 0);
+    atomic_init(&monitor->health, 0);
+    for (size_t i = 0; i < RESOURCE_SNAPSHOT_WORDS; i++) {
+        atomic_init(&monitor->snapshot[i], 0);
+    }
     
+    if (pthread_mutex_init(&monitor->mutex, NULL) != 0) {
+        free(monitor);
+        return NULL;
+    }
+    if (pthread_cond_init(&monitor->cond, NULL) != 0) {
+        pthread_mutex_destroy(&monitor->mutex);
+        free(monitor);
+        return NULL;
+    }
+
+#ifdef __linux__
+    find_cgroup_limits(monitor);
+#endif
+    
+    // Readers always find a complete snapshot, even before the first tick
+    system_resources_t resources;
+    sample_resources(monitor, &resources);
+    publish(monitor, &resources);
+    
+    if (pthread_create(&monitor->thread, NULL, sampler_thread, monitor) != 0) {
+        pthread_cond_destroy(&monitor->cond);
+        pthread_mutex_destroy(&monitor->mutex);
+        free(monitor);
+        return NULL;
+    }
+    
+    return monitor;
+}
+
+void resource_monitor_destroy(resource_monitor_t *monitor) {
+    if (!monitor) return;
+    
+    pthread_mutex_lock(&monitor->mutex);
+    atomic_store(&monitor->monitoring, false);
+    pthread_cond_signal(&monitor->cond);
+    pthread_mutex_unlock(&monitor->mutex);
+    pthread_join(monitor->thread, NULL);
+    
+    pthread_cond_destroy(&monitor->cond);
+    pthread_mutex_destroy(&monitor->mutex);
+    free(monitor);
+}
+
+// Copies the latest snapshot; never blocks
+int resource_monitor_get_resources(resource_monitor_t *monitor, system_resources_t *resources) {
+    if (!monitor || !resources) return -1;
+    
+    uint64_t words[RESOURCE_SNAPSHOT_WORDS];
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(&monitor->sequence, memory_order_acquire);
+        if (before & 1) continue;   // writer in progress
+        
+        for (size_t i = 0; i < RESOURCE_SNAPSHOT_WORDS; i++) {
+            words[i] = atomic_load_explicit(&monitor->snapshot[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&monitor->sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    
+    memcpy(resources, words, sizeof(words));
     return 0;
 }
 
+void resource_monitor_get_usage(resource_monitor_t *monitor, double *cpu_percent, double *memory_percent) {
+    float cpu = 0.0f, memory = 0.0f;
+    if (monitor) {
+        uint64_t health = atomic_load_explicit(&monitor->health, memory_order_acquire);
+        uint32_t cpu_bits = (uint32_t)health;
+        uint32_t memory_bits = (uint32_t)(health >> 32);
+        memcpy(&cpu, &cpu_bits, sizeof(cpu));
+        memcpy(&memory, &memory_bits, sizeof(memory));
+    }
+    
+    if (cpu_percent) *cpu_percent = cpu;
+    if (memory_percent) *memory_percent = memory;
+}
+
 bool resource_monitor_is_healthy(resource_monitor_t *monitor, 
                                   double max_cpu_percent, 
                                   double max_memory_percent) {
     if (!monitor) return false;
     
-    system_resources_t resources;
-    if (resource_monitor_get_resources(monitor, &resources) != 0) {
-        return false;
-    }
-    
-    double cpu_percent = resources.cpu_usage;
-    double memory_percent = (double)resources.memory_used / resources.memory_total * 100.0;
-    
+    // One atomic load on the submit path
+    double cpu_percent, memory_percent;
+    resource_monitor_get_usage(monitor, &cpu_percent, &memory_percent);
     return (cpu_percent < max_cpu_percent && memory_percent < max_memory_percent);
 }
 
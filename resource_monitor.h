@@ -1,24 +1,62 @@
 #ifndef RESOURCE_MONITOR_H
 #define RESOURCE_MONITOR_H
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+// Every field is 8 bytes wide so snapshots can be copied word by word
 typedef struct {
-    double cpu_usage;
+    double cpu_usage;               // percent of all CPUs busy since the previous sample
     uint64_t memory_used;
     uint64_t memory_total;
-    uint64_t memory_available;
+    uint64_t memory_available;      // MemAvailable, counts reclaimable cache
+    double cpu_pressure;            // PSI "some" avg10 in percent, -1 if unsupported
+    double memory_pressure;         // PSI "some" avg10 in percent, -1 if unsupported
+    double memory_pressure_full;    // PSI "full" avg10 in percent, -1 if unsupported
+    double cpu_quota;               // cgroup CPU limit in cores, 0 if none
+    uint64_t cgroup_memory_limit;   // cgroup memory limit in bytes, 0 if none
+    uint64_t cgroup_memory_used;    // charged to the cgroup, page cache included
+    uint64_t sample_time_ms;        // CLOCK_MONOTONIC time of the sample
 } system_resources_t;
 
+#define RESOURCE_SNAPSHOT_WORDS (sizeof(system_resources_t) / sizeof(uint64_t))
+
+// CPU time counters from /proc/stat, kept between samples
+typedef struct {
+    uint64_t busy;
+    uint64_t total;
+} cpu_times_t;
+
+#define RESOURCE_CGROUP_PATH_MAX 256
+
+// A sampling thread refreshes the snapshot every check_interval_ms.
+// Readers never block or touch /proc: the snapshot sits behind a
+// sequence lock, and the two numbers resource_monitor_is_healthy() needs
+// are also packed into one word so that check is a single atomic load.
 typedef struct {
-    bool monitoring;
+    _Atomic bool monitoring;
     uint32_t check_interval_ms;
+    pthread_t thread;
+    pthread_mutex_t mutex;          // sampler sleeps on cond; destroy wakes it
+    pthread_cond_t cond;
+    cpu_times_t prev_cpu;           // sampler thread only
+    // cgroup directories holding the CPU and memory limits, "" if none;
+    // found once at create, the limits themselves are read every sample
+    bool cgroup_v2;
+    char cgroup_cpu[RESOURCE_CGROUP_PATH_MAX];
+    char cgroup_memory[RESOURCE_CGROUP_PATH_MAX];
+    _Atomic uint32_t sequence;      // odd while the snapshot is being written
+    _Atomic uint64_t snapshot[RESOURCE_SNAPSHOT_WORDS];
+    _Atomic uint64_t health;        // float CPU% (low half), float memory% (high half)
 } resource_monitor_t;
 
 resource_monitor_t* resource_monitor_create(uint32_t check_interval_ms);
 void resource_monitor_destroy(resource_monitor_t *monitor);
 int resource_monitor_get_resources(resource_monitor_t *monitor, system_resources_t *resources);
+// Latest CPU% and memory% from a single atomic load
+void resource_monitor_get_usage(resource_monitor_t *monitor, double *cpu_percent, double *memory_percent);
 bool resource_monitor_is_healthy(resource_monitor_t *monitor, double max_cpu_percent, double max_memory_percent);
 
 #endif // RESOURCE_MONITOR_H
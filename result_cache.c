@@ -0,0 +1,450 @@
+#include "result_cache.h"
+#include "task_future.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define SHARD_MASK (RESULT_CACHE_SHARDS - 1)
+#define BUCKET_MASK (RESULT_CACHE_BUCKETS - 1)
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Native byte order: hashes only have to agree within one process
+static uint64_t read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static uint64_t xxh_merge(uint64_t acc, uint64_t value) {
+    acc ^= xxh_round(0, value);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+// XXH64 with the model id as seed: four independent lanes over 32-byte
+// stripes, so long payloads hash at several bytes per cycle
+uint64_t result_cache_hash(uint32_t model_id, const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char*)data;
+    const unsigned char *end = p + size;
+    uint64_t seed = model_id;
+    uint64_t h;
+    
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        do {
+            v1 = xxh_round(v1, read64(p));
+            v2 = xxh_round(v2, read64(p + 8));
+            v3 = xxh_round(v3, read64(p + 16));
+            v4 = xxh_round(v4, read64(p + 24));
+            p += 32;
+        } while (p + 32 <= end);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += size;
+    
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxh_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (uint64_t)*p * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+    }
+    
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+result_cache_t* result_cache_create(size_t budget_bytes) {
+    if (budget_bytes == 0) return NULL;
+    
+    result_cache_t *cache = (result_cache_t*)calloc(1, sizeof(result_cache_t));
+    if (!cache) return NULL;
+    
+    cache->budget = budget_bytes;
+    for (size_t i = 0; i < RESULT_CACHE_SHARDS; i++) {
+        if (pthread_mutex_init(&cache->shards[i].mutex, NULL) != 0) {
+            while (i-- > 0) {
+                pthread_mutex_destroy(&cache->shards[i].mutex);
+            }
+            free(cache);
+            return NULL;
+        }
+        cache->shards[i].budget = budget_bytes / RESULT_CACHE_SHARDS;
+        cache->shards[i].cache = cache;
+    }
+    return cache;
+}
+
+void result_cache_set_requeue(result_cache_t *cache, result_cache_requeue_t requeue, void *ctx) {
+    if (!cache) return;
+    cache->requeue = requeue;
+    cache->requeue_ctx = ctx;
+}
+
+static void free_entry(result_cache_entry_t *entry) {
+    free(entry->result);
+    free(entry);
+}
+
+void result_cache_destroy(result_cache_t *cache) {
+    if (!cache) return;
+    
+    for (size_t i = 0; i < RESULT_CACHE_SHARDS; i++) {
+        result_cache_shard_t *shard = &cache->shards[i];
+        for (size_t b = 0; b < RESULT_CACHE_BUCKETS; b++) {
+            result_cache_entry_t *entry = shard->buckets[b];
+            while (entry) {
+                result_cache_entry_t *next = entry->hash_next;
+                free_entry(entry);
+                entry = next;
+            }
+        }
+        pthread_mutex_destroy(&shard->mutex);
+    }
+    free(cache);
+}
+
+static size_t bucket_of(uint64_t hash) {
+    return (size_t)(hash >> 4) & BUCKET_MASK;
+}
+
+static result_cache_entry_t* find_locked(result_cache_shard_t *shard, uint64_t hash,
+                                         const task_t *task) {
+    for (result_cache_entry_t *entry = shard->buckets[bucket_of(hash)]; entry;
+         entry = entry->hash_next) {
+        if (entry->hash == hash && entry->model_id == task->model_id &&
+            entry->key_size == task->data_size &&
+            (task->data_size == 0 || memcmp(entry->key, task->data, task->data_size) == 0)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void unlink_hash_locked(result_cache_shard_t *shard, result_cache_entry_t *entry) {
+    result_cache_entry_t **link = &shard->buckets[bucket_of(entry->hash)];
+    while (*link != entry) {
+        link = &(*link)->hash_next;
+    }
+    *link = entry->hash_next;
+}
+
+static void lru_unlink_locked(result_cache_shard_t *shard, result_cache_entry_t *entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        shard->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        shard->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void lru_push_locked(result_cache_shard_t *shard, result_cache_entry_t *entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = shard->lru_head;
+    if (shard->lru_head) {
+        shard->lru_head->lru_prev = entry;
+    } else {
+        shard->lru_tail = entry;
+    }
+    shard->lru_head = entry;
+}
+
+// Least recently used first, down to the budget
+static void evict_locked(result_cache_shard_t *shard) {
+    while (shard->bytes > shard->budget && shard->lru_tail) {
+        result_cache_entry_t *victim = shard->lru_tail;
+        lru_unlink_locked(shard, victim);
+        unlink_hash_locked(shard, victim);
+        shard->bytes -= victim->charge;
+        shard->entries--;
+        shard->evictions++;
+        free_entry(victim);
+    }
+}
+
+// malloc'd copy with a terminating NUL, like the Python workers' replies
+static void* copy_result(const void *result, size_t result_size) {
+    void *copy = malloc(result_size + 1);
+    if (copy) {
+        memcpy(copy, result, result_size);
+        ((char*)copy)[result_size] = '\0';
+    }
+    return copy;
+}
+
+result_cache_route_t result_cache_route(result_cache_t *cache, task_t *task) {
+    if (!cache || !task || (!task->data && task->data_size > 0)) return RESULT_CACHE_MISS;
+    
+    uint64_t hash = result_cache_hash(task->model_id, task->data, task->data_size);
+    result_cache_shard_t *shard = &cache->shards[hash & SHARD_MASK];
+    
+    pthread_mutex_lock(&shard->mutex);
+    result_cache_entry_t *entry = find_locked(shard, hash, task);
+    
+    if (entry && entry->ready) {
+        void *result = entry->result ? copy_result(entry->result, entry->result_size) : NULL;
+        size_t result_size = entry->result_size;
+        if (entry->result && !result) {
+            pthread_mutex_unlock(&shard->mutex);
+            return RESULT_CACHE_MISS;       // run it rather than drop the result
+        }
+        shard->hits++;
+        lru_unlink_locked(shard, entry);
+        lru_push_locked(shard, entry);
+        pthread_mutex_unlock(&shard->mutex);
+        
+        task->status = TASK_STATUS_COMPLETED;
+        task->enqueue_ns = task->dequeue_ns = task->start_ns = task->end_ns = task_now_ns();
+        if (task_future_set_result(task->future, result, result_size) != 0) {
+            free(result);
+        }
+        task_destroy(task);
+        return RESULT_CACHE_HIT;
+    }
+    
+    if (entry) {
+        shard->coalesced++;
+        task->next = entry->waiters;
+        entry->waiters = task;
+        pthread_mutex_unlock(&shard->mutex);
+        return RESULT_CACHE_ATTACHED;
+    }
+    
+    // First of its kind: it runs, and the entry waits for its result
+    shard->misses++;
+    entry = (result_cache_entry_t*)malloc(sizeof(result_cache_entry_t) + task->data_size);
+    if (entry) {
+        entry->hash = hash;
+        entry->model_id = task->model_id;
+        entry->ready = false;
+        entry->key_size = task->data_size;
+        entry->result = NULL;
+        entry->result_size = 0;
+        entry->charge = 0;
+        entry->waiters = NULL;
+        entry->shard = shard;
+        entry->lru_prev = entry->lru_next = NULL;
+        if (task->data_size > 0) {
+            memcpy(entry->key, task->data, task->data_size);
+        }
+        entry->hash_next = shard->buckets[bucket_of(hash)];
+        shard->buckets[bucket_of(hash)] = entry;
+        task->cache_entry = entry;
+    }
+    pthread_mutex_unlock(&shard->mutex);
+    
+    return RESULT_CACHE_MISS;
+}
+
+void result_cache_set_result(task_t *task, const void *result, size_t result_size) {
+    if (!task || !task->cache_entry || !result) return;
+    
+    // Only the leader's thread touches a pending entry's result
+    result_cache_entry_t *entry = task->cache_entry;
+    free(entry->result);
+    entry->result = copy_result(result, result_size);
+    entry->result_size = entry->result ? result_size : 0;
+}
+
+static void finish_waiter(task_t *waiter, task_status_t status, int error,
+                          uint64_t start_ns, uint64_t end_ns) {
+    int reason = task_cancelled(waiter);
+    if (reason) {
+        waiter->status = TASK_STATUS_CANCELLED;
+        waiter->error = reason;
+    } else {
+        waiter->status = status;
+        waiter->error = error;
+    }
+    waiter->start_ns = start_ns;
+    waiter->end_ns = end_ns;
+    task_destroy(waiter);
+}
+
+// Hands the entry to a waiter in place of a leader that never ran to an
+// outcome. Waiters cancelled meanwhile finish; one that cannot be queued
+// finishes without running and the next one is tried.
+static void promote_waiter(result_cache_entry_t *entry) {
+    result_cache_shard_t *shard = entry->shard;
+    result_cache_t *cache = shard->cache;
+    
+    for (;;) {
+        pthread_mutex_lock(&shard->mutex);
+        task_t *leader = NULL;
+        task_t *cancelled = NULL;
+        while (entry->waiters && !leader) {
+            task_t *waiter = entry->waiters;
+            entry->waiters = waiter->next;
+            waiter->next = NULL;
+            if (task_cancelled(waiter)) {
+                waiter->next = cancelled;
+                cancelled = waiter;
+            } else {
+                leader = waiter;
+            }
+        }
+        if (leader) {
+            leader->cache_entry = entry;
+        } else {
+            unlink_hash_locked(shard, entry);
+            free_entry(entry);
+        }
+        pthread_mutex_unlock(&shard->mutex);
+        
+        uint64_t now = task_now_ns();
+        while (cancelled) {
+            task_t *waiter = cancelled;
+            cancelled = waiter->next;
+            waiter->next = NULL;
+            finish_waiter(waiter, TASK_STATUS_CANCELLED, ECANCELED, 0, now);
+        }
+        if (!leader) return;
+        
+        int error = cache->requeue(leader, cache->requeue_ctx);
+        if (error == 0) return;
+        
+        // Detached first, so it does not promote again from task_destroy()
+        leader->cache_entry = NULL;
+        leader->status = (error == ESHUTDOWN) ? TASK_STATUS_CANCELLED : TASK_STATUS_FAILED;
+        leader->error = error;
+        leader->end_ns = task_now_ns();
+        task_destroy(leader);
+    }
+}
+
+void result_cache_complete(task_t *task) {
+    if (!task || !task->cache_entry) return;
+    
+    result_cache_entry_t *entry = task->cache_entry;
+    result_cache_shard_t *shard = entry->shard;
+    task->cache_entry = NULL;
+    bool completed = (task->status == TASK_STATUS_COMPLETED);
+    bool ran = completed || task->status == TASK_STATUS_FAILED ||
+               (task->status == TASK_STATUS_CANCELLED && task->error == ESHUTDOWN);
+    
+    // The leader's own fate: cancelled by id, its deadline, its timeout or
+    // admission. Identical tasks submitted by others still want a run.
+    if (!ran && shard->cache->requeue) {
+        promote_waiter(entry);
+        return;
+    }
+    
+    pthread_mutex_lock(&shard->mutex);
+    task_t *waiters = entry->waiters;
+    entry->waiters = NULL;
+    
+    // Each waiter's future gets a copy of its own
+    if (completed && entry->result) {
+        for (task_t *waiter = waiters; waiter; waiter = waiter->next) {
+            if (!waiter->future) continue;
+            void *result = copy_result(entry->result, entry->result_size);
+            if (task_future_set_result(waiter->future, result, entry->result_size) != 0) {
+                free(result);
+            }
+        }
+    }
+    
+    if (completed) {
+        entry->ready = true;
+        entry->charge = sizeof(result_cache_entry_t) + entry->key_size + entry->result_size;
+        lru_push_locked(shard, entry);
+        shard->bytes += entry->charge;
+        shard->entries++;
+        evict_locked(shard);
+    } else {
+        // Failures are not cached; the next submission runs again
+        unlink_hash_locked(shard, entry);
+        free_entry(entry);
+    }
+    pthread_mutex_unlock(&shard->mutex);
+    
+    // Outside the lock: done callbacks may submit again
+    bool final = task->status != TASK_STATUS_PENDING && task->status != TASK_STATUS_RUNNING;
+    uint64_t now = task_now_ns();
+    while (waiters) {
+        task_t *waiter = waiters;
+        waiters = waiter->next;
+        waiter->next = NULL;
+        finish_waiter(waiter, final ? task->status : TASK_STATUS_FAILED, task->error,
+                      task->start_ns, task->end_ns ? task->end_ns : now);
+    }
+}
+
+void result_cache_get_stats(result_cache_t *cache, result_cache_stats_t *stats) {
+    if (!stats) return;
+    
+    memset(stats, 0, sizeof(*stats));
+    if (!cache) return;
+    
+    stats->budget = cache->budget;
+    for (size_t i = 0; i < RESULT_CACHE_SHARDS; i++) {
+        result_cache_shard_t *shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->mutex);
+        stats->hits += shard->hits;
+        stats->misses += shard->misses;
+        stats->coalesced += shard->coalesced;
+        stats->evictions += shard->evictions;
+        stats->bytes += shard->bytes;
+        stats->entries += shard->entries;
+        pthread_mutex_unlock(&shard->mutex);
+    }
+}
+
+void result_cache_print_stats(result_cache_t *cache, FILE *out) {
+    if (!cache || !out) return;
+    
+    result_cache_stats_t stats;
+    result_cache_get_stats(cache, &stats);
+    uint64_t lookups = stats.hits + stats.misses + stats.coalesced;
+    double scale = lookups ? 100.0 / (double)lookups : 0.0;
+    fprintf(out, "Result cache: %llu lookups, %.1f%% hits, %.1f%% coalesced, %.1f%% misses; "
+            "%zu entries, %zu of %zu bytes, %llu evictions\n",
+            (unsigned long long)lookups, stats.hits * scale, stats.coalesced * scale,
+            stats.misses * scale, stats.entries, stats.bytes, stats.budget,
+            (unsigned long long)stats.evictions);
+}
+
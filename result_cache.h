@@ -0,0 +1,113 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "task_queue.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define RESULT_CACHE_SHARDS 16          // power of two; one lock each
+#define RESULT_CACHE_BUCKETS 1024       // per shard, power of two
+
+typedef struct result_cache result_cache_t;
+typedef struct result_cache_entry result_cache_entry_t;
+typedef struct result_cache_shard result_cache_shard_t;
+
+// Queues a waiter promoted to leader (see result_cache_complete()); 0 on
+// success, else an errno-style reason it could not be queued
+typedef int (*result_cache_requeue_t)(task_t *task, void *ctx);
+
+// One input seen before: model id and payload bytes, and either the
+// result of running it or the tasks waiting for the run in flight
+struct result_cache_entry {
+    uint64_t hash;
+    uint32_t model_id;
+    bool ready;                         // result valid; false while the leader runs
+    size_t key_size;
+    void *result;                       // malloc'd, NULL for a task that produced none
+    size_t result_size;
+    size_t charge;                      // bytes counted against the shard's budget
+    task_t *waiters;                    // identical tasks parked on the leader, via next
+    result_cache_shard_t *shard;
+    result_cache_entry_t *hash_next;
+    result_cache_entry_t *lru_prev;     // ready entries only, most recent first
+    result_cache_entry_t *lru_next;
+    unsigned char key[];                // the payload, compared on every match
+};
+
+struct result_cache_shard {
+    pthread_mutex_t mutex;              // guards the shard and its entries
+    result_cache_t *cache;
+    result_cache_entry_t *buckets[RESULT_CACHE_BUCKETS];
+    result_cache_entry_t *lru_head;
+    result_cache_entry_t *lru_tail;
+    size_t bytes;
+    size_t entries;                     // ready ones
+    size_t budget;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t coalesced;                 // attached to a run already in flight
+    uint64_t evictions;
+    char pad[CACHE_LINE_SIZE];
+};
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t coalesced;
+    uint64_t evictions;
+    size_t bytes;
+    size_t entries;
+    size_t budget;
+} result_cache_stats_t;
+
+typedef enum {
+    RESULT_CACHE_MISS = 0,              // the caller runs the task as usual
+    RESULT_CACHE_HIT,                   // finished from the cache; the task is gone
+    RESULT_CACHE_ATTACHED               // parked on an identical task in flight
+} result_cache_route_t;
+
+// Completed results keyed by an XXH64 of model id and payload, so repeated
+// inputs skip inference. The key space is split over RESULT_CACHE_SHARDS
+// shards, each behind its own lock with its own share of the byte budget
+// and its own LRU list. While a task runs, identical submissions wait on
+// it instead of running again, and share the outcome of its run.
+struct result_cache {
+    result_cache_shard_t shards[RESULT_CACHE_SHARDS];
+    size_t budget;
+    result_cache_requeue_t requeue;     // NULL: waiters share any outcome
+    void *requeue_ctx;
+};
+
+// XXH64 of the payload, seeded with model_id. Agrees with the reference
+// implementation; with seed 0:
+//   ""                                          ef46db3751d8e999
+//   "abc"                                       44bc2cf5ad770999
+//   "Nobody inspects the spammish repetition"   fbcea83c8a378bf1
+// (the last covers the 32-byte stripe loop)
+uint64_t result_cache_hash(uint32_t model_id, const void *data, size_t size);
+
+result_cache_t* result_cache_create(size_t budget_bytes);
+// No task may still be in flight through the cache
+void result_cache_destroy(result_cache_t *cache);
+// Where waiters go when their leader ends without running to an outcome
+void result_cache_set_requeue(result_cache_t *cache, result_cache_requeue_t requeue, void *ctx);
+// Called before a task is queued. On a hit the task is completed with a
+// copy of the cached result and destroyed; attached, it finishes when the
+// identical task ahead of it does. Either way the caller must not touch it
+// again. A miss makes the task the leader for its input.
+result_cache_route_t result_cache_route(result_cache_t *cache, task_t *task);
+// Copies the result of a running leader for the cache; a no-op for other tasks
+void result_cache_set_result(task_t *task, const void *result, size_t result_size);
+// Called by task_destroy() for a leader: caches a completed result and
+// finishes the tasks attached to it with the same outcome. That is only
+// an outcome of running it, completed or failed, or a shutdown (ESHUTDOWN).
+// A leader cancelled, expired, timed out or never queued decides nothing
+// for the others: the first waiter not cancelled itself becomes leader
+// and is requeued, and the rest wait on it.
+void result_cache_complete(task_t *task);
+void result_cache_get_stats(result_cache_t *cache, result_cache_stats_t *stats);
+void result_cache_print_stats(result_cache_t *cache, FILE *out);
+
+#endif // RESULT_CACHE_H
+
@@ -0,0 +1,134 @@
+#define _GNU_SOURCE
+#include "task_batcher.h"
+#include <stdlib.h>
+#include <time.h>
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static bool compatible(const task_t *a, const task_t *b) {
+    return a->batch_callback == b->batch_callback && a->batch_key == b->batch_key &&
+           a->model_id == b->model_id;
+}
+
+void task_batch_config_init(task_batch_config_t *config) {
+    if (!config) return;
+    
+    config->max_batch = TASK_BATCH_DEFAULT_SIZE;
+    config->max_wait_us = TASK_BATCH_DEFAULT_WAIT_US;
+    config->bypass_priority = TASK_PRIORITY_CRITICAL;
+}
+
+task_batcher_t* task_batcher_create(const task_batch_config_t *config) {
+    if (!config || config->max_batch == 0) return NULL;
+    
+    task_batcher_t *batcher = (task_batcher_t*)calloc(1, sizeof(task_batcher_t));
+    if (!batcher) return NULL;
+    
+    batcher->config = *config;
+    if (batcher->config.max_batch > TASK_BATCH_MAX_SIZE) {
+        batcher->config.max_batch = TASK_BATCH_MAX_SIZE;
+    }
+    
+    return batcher;
+}
+
+void task_batcher_destroy(task_batcher_t *batcher) {
+    free(batcher);
+}
+
+bool task_batcher_accepts(const task_batcher_t *batcher, const task_t *task) {
+    return batcher && batcher->config.max_batch > 1 && task->batch_callback &&
+           task->priority < batcher->config.bypass_priority;
+}
+
+size_t task_batcher_collect(task_batcher_t *batcher, task_queue_t *queue, task_t *first,
+                            task_t **batch, task_t **deferred) {
+    size_t count = 0;
+    batch[count++] = first;
+    
+    // Companions already parked on the deferred list go first
+    task_t **link = deferred;
+    while (*link && count < batcher->config.max_batch) {
+        task_t *task = *link;
+        if (compatible(first, task)) {
+            *link = task->next;
+            task->next = NULL;
+            batch[count++] = task;
+        } else {
+            link = &task->next;
+        }
+    }
+    
+    // Skipped tasks are held back at most one batch's worth
+    size_t parked = 0;
+    for (task_t *task = *deferred; task; task = task->next) {
+        parked++;
+    }
+    
+    uint64_t deadline = now_us() + batcher->config.max_wait_us;
+    while (count < batcher->config.max_batch && parked < batcher->config.max_batch) {
+        uint64_t now = now_us();
+        if (now >= deadline) break;
+        
+        task_t *task = task_queue_dequeue_timeout(queue, deadline - now);
+        if (!task) break;
+        task->dequeue_ns = task_now_ns();
+        
+        if (compatible(first, task) && task_batcher_accepts(batcher, task)) {
+            batch[count++] = task;
+            continue;
+        }
+        
+        // Append at the tail so skipped tasks keep their queue order
+        link = deferred;
+        while (*link) {
+            link = &(*link)->next;
+        }
+        task->next = NULL;
+        *link = task;
+        parked++;
+        
+        // Urgent work should not sit behind a batch still filling up
+        if (task->priority >= batcher->config.bypass_priority) break;
+    }
+    
+    return count;
+}
+
+void task_batcher_record(task_batcher_t *batcher, size_t batch_size) {
+    if (!batcher || batch_size == 0 || batch_size > TASK_BATCH_MAX_SIZE) return;
+    
+    atomic_fetch_add_explicit(&batcher->batches, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&batcher->tasks, batch_size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&batcher->size_counts[batch_size], 1, memory_order_relaxed);
+}
+
+void task_batcher_get_stats(task_batcher_t *batcher, task_batch_stats_t *stats) {
+    if (!batcher || !stats) return;
+    
+    stats->batches = atomic_load(&batcher->batches);
+    stats->tasks = atomic_load(&batcher->tasks);
+    for (size_t i = 0; i <= TASK_BATCH_MAX_SIZE; i++) {
+        stats->size_counts[i] = atomic_load(&batcher->size_counts[i]);
+    }
+}
+
+void task_batcher_print_stats(task_batcher_t *batcher, FILE *out) {
+    if (!batcher || !out) return;
+    
+    task_batch_stats_t stats;
+    task_batcher_get_stats(batcher, &stats);
+    
+    fprintf(out, "Batches: %llu, tasks: %llu, mean size: %.2f\n",
+            (unsigned long long)stats.batches, (unsigned long long)stats.tasks,
+            stats.batches ? (double)stats.tasks / (double)stats.batches : 0.0);
+    for (size_t i = 1; i <= TASK_BATCH_MAX_SIZE; i++) {
+        if (stats.size_counts[i] == 0) continue;
+        fprintf(out, "  size %2zu: %llu\n", i, (unsigned long long)stats.size_counts[i]);
+    }
+}
+
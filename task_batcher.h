@@ -0,0 +1,51 @@
+#ifndef TASK_BATCHER_H
+#define TASK_BATCHER_H
+
+#include "task_queue.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TASK_BATCH_MAX_SIZE 32
+#define TASK_BATCH_DEFAULT_SIZE 8
+#define TASK_BATCH_DEFAULT_WAIT_US 2000
+
+typedef struct {
+    size_t max_batch;                   // 1 disables batching
+    uint64_t max_wait_us;               // longest a partial batch waits for company
+    task_priority_t bypass_priority;    // tasks at or above this run unbatched
+} task_batch_config_t;
+
+typedef struct {
+    uint64_t batches;
+    uint64_t tasks;
+    uint64_t size_counts[TASK_BATCH_MAX_SIZE + 1];  // [n] = batches of n tasks
+} task_batch_stats_t;
+
+// Micro-batching stage between the task queue and the executor. After a
+// worker dequeues a task with a batch_callback, the batcher keeps pulling
+// from the queue until it holds max_batch tasks with the same callback,
+// batch_key and model, or max_wait_us has passed, then runs them in one call.
+// Incompatible tasks pulled meanwhile are parked on the worker's deferred
+// list and run next.
+typedef struct {
+    task_batch_config_t config;
+    _Atomic uint64_t batches;
+    _Atomic uint64_t tasks;
+    _Atomic uint64_t size_counts[TASK_BATCH_MAX_SIZE + 1];
+} task_batcher_t;
+
+void task_batch_config_init(task_batch_config_t *config);
+task_batcher_t* task_batcher_create(const task_batch_config_t *config);
+void task_batcher_destroy(task_batcher_t *batcher);
+bool task_batcher_accepts(const task_batcher_t *batcher, const task_t *task);
+// Gathers companions for first into batch (first included). Returns the
+// batch size; *deferred collects skipped tasks in FIFO order.
+size_t task_batcher_collect(task_batcher_t *batcher, task_queue_t *queue, task_t *first,
+                            task_t **batch, task_t **deferred);
+void task_batcher_record(task_batcher_t *batcher, size_t batch_size);
+void task_batcher_get_stats(task_batcher_t *batcher, task_batch_stats_t *stats);
+void task_batcher_print_stats(task_batcher_t *batcher, FILE *out);
+
+#endif // TASK_BATCHER_H
+
@@ -0,0 +1,305 @@
+#define _GNU_SOURCE
+#include "task_future.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+enum {
+    FUTURE_PENDING = 0,
+    FUTURE_CALLBACK,            // pending, callback registered
+    FUTURE_DONE
+};
+
+task_future_t* task_future_create(completion_queue_t *queue, bool caller_ref) {
+    task_future_t *future = (task_future_t*)calloc(1, sizeof(task_future_t));
+    if (!future) return NULL;
+    
+    if (event_count_init(&future->done) != 0) {
+        free(future);
+        return NULL;
+    }
+    atomic_init(&future->refs, 1 + (caller_ref ? 1 : 0) + (queue ? 1 : 0));
+    atomic_init(&future->state, FUTURE_PENDING);
+    future->queue = queue;
+    return future;
+}
+
+static void free_future(task_future_t *future) {
+    free(future->result);
+    event_count_destroy(&future->done);
+    free(future);
+}
+
+void task_future_discard(task_future_t *future) {
+    if (!future) return;
+    free_future(future);
+}
+
+void task_future_release(task_future_t *future) {
+    if (!future) return;
+    
+    if (atomic_fetch_sub_explicit(&future->refs, 1, memory_order_acq_rel) == 1) {
+        free_future(future);
+    }
+}
+
+static void signal_queue(completion_queue_t *queue) {
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t written = write(queue->write_fd, &one, sizeof(one));
+#else
+    char byte = 0;
+    ssize_t written = write(queue->write_fd, &byte, 1);
+#endif
+    (void)written;              // a full counter or pipe is readable anyway
+}
+
+static void completion_queue_push(completion_queue_t *queue, task_future_t *future) {
+    task_future_t *head = atomic_load_explicit(&queue->pushed, memory_order_relaxed);
+    do {
+        future->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&queue->pushed, &head, future,
+                                                    memory_order_release, memory_order_relaxed));
+    
+    // Only the push that ends an empty spell needs to wake the consumer
+    if (!head) signal_queue(queue);
+}
+
+void task_future_complete(task_future_t *future, const task_t *task) {
+    if (!future || !task) return;
+    
+    task_outcome_t *outcome = &future->outcome;
+    snprintf(future->task_id, sizeof(future->task_id), "%s", task->task_id);
+    outcome->status = task->status;
+    switch (task->status) {
+        case TASK_STATUS_COMPLETED:
+            outcome->error = 0;
+            break;
+        case TASK_STATUS_FAILED:
+            outcome->error = task->error ? task->error : EIO;
+            break;
+        case TASK_STATUS_EXPIRED:
+            outcome->error = ETIMEDOUT;
+            break;
+        case TASK_STATUS_CANCELLED:
+            // ETIMEDOUT ran out of time, ESHUTDOWN was set aside for the
+            // next start
+            outcome->error = task->error ? task->error : ECANCELED;
+            break;
+        default:
+            // Destroyed before it ran
+            outcome->status = TASK_STATUS_FAILED;
+            outcome->error = ECANCELED;
+            break;
+    }
+    outcome->result = future->result;
+    outcome->submit_ns = task->timestamp;
+    outcome->enqueue_ns = task->enqueue_ns;
+    outcome->start_ns = task->start_ns;
+    outcome->end_ns = task->end_ns;
+    
+    int previous = atomic_exchange_explicit(&future->state, FUTURE_DONE, memory_order_acq_rel);
+    if (previous == FUTURE_CALLBACK) {
+        future->callback(future, future->callback_ctx);
+    }
+    event_count_notify_all(&future->done);
+    if (future->queue) {
+        completion_queue_push(future->queue, future);
+    }
+    task_future_release(future);
+}
+
+int task_future_set_result(task_future_t *future, void *result, size_t result_size) {
+    if (!future) return -1;
+    
+    free(future->result);
+    future->result = result;
+    future->outcome.result_size = result ? result_size : 0;
+    return 0;
+}
+
+bool task_future_is_done(task_future_t *future) {
+    return future && atomic_load_explicit(&future->state, memory_order_acquire) == FUTURE_DONE;
+}
+
+void task_future_wait(task_future_t *future) {
+    if (!future) return;
+    
+    while (!task_future_is_done(future)) {
+        uint32_t key = event_count_prepare(&future->done);
+        if (task_future_is_done(future)) {
+            event_count_cancel(&future->done);
+            break;
+        }
+        event_count_wait(&future->done, key);
+    }
+}
+
+bool task_future_wait_timeout(task_future_t *future, uint64_t timeout_us) {
+    if (!future) return false;
+    
+    uint64_t deadline = task_now_ns() + timeout_us * 1000ULL;
+    while (!task_future_is_done(future)) {
+        uint64_t now = task_now_ns();
+        if (now >= deadline) return false;
+        
+        uint32_t key = event_count_prepare(&future->done);
+        if (task_future_is_done(future)) {
+            event_count_cancel(&future->done);
+            break;
+        }
+        event_count_wait_timeout(&future->done, key, deadline - now);
+    }
+    return true;
+}
+
+int task_future_on_complete(task_future_t *future, task_future_callback_t callback, void *ctx) {
+    if (!future || !callback) return -1;
+    if (atomic_load_explicit(&future->state, memory_order_acquire) == FUTURE_CALLBACK) return -1;
+    
+    future->callback = callback;
+    future->callback_ctx = ctx;
+    int expected = FUTURE_PENDING;
+    if (!atomic_compare_exchange_strong_explicit(&future->state, &expected, FUTURE_CALLBACK,
+                                                 memory_order_acq_rel, memory_order_acquire)) {
+        if (expected != FUTURE_DONE) return -1;
+        callback(future, ctx);
+    }
+    return 0;
+}
+
+int task_future_get(task_future_t *future, task_outcome_t *outcome) {
+    if (!outcome || !task_future_is_done(future)) return -1;
+    
+    *outcome = future->outcome;
+    return 0;
+}
+
+void* task_future_take_result(task_future_t *future, size_t *result_size) {
+    if (!task_future_is_done(future)) return NULL;
+    
+    void *result = future->result;
+    if (result_size) *result_size = future->outcome.result_size;
+    future->result = NULL;
+    future->outcome.result = NULL;
+    future->outcome.result_size = 0;
+    return result;
+}
+
+const char* task_future_task_id(task_future_t *future) {
+    return task_future_is_done(future) ? future->task_id : NULL;
+}
+
+completion_queue_t* completion_queue_create(void) {
+    completion_queue_t *queue = (completion_queue_t*)calloc(1, sizeof(completion_queue_t));
+    if (!queue) return NULL;
+    
+    atomic_init(&queue->pushed, NULL);
+#ifdef __linux__
+    queue->read_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    queue->write_fd = queue->read_fd;
+    if (queue->read_fd < 0) {
+        free(queue);
+        return NULL;
+    }
+#else
+    int fds[2];
+    if (pipe(fds) != 0) {
+        free(queue);
+        return NULL;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    queue->read_fd = fds[0];
+    queue->write_fd = fds[1];
+#endif
+    return queue;
+}
+
+void completion_queue_destroy(completion_queue_t *queue) {
+    if (!queue) return;
+    
+    task_future_t *future;
+    while ((future = completion_queue_pop(queue)) != NULL) {
+        task_future_release(future);
+    }
+    close(queue->read_fd);
+    if (queue->write_fd != queue->read_fd) {
+        close(queue->write_fd);
+    }
+    free(queue);
+}
+
+int completion_queue_fd(completion_queue_t *queue) {
+    return queue ? queue->read_fd : -1;
+}
+
+// Moves everything pushed so far onto the ready list, oldest first
+static void refill(completion_queue_t *queue) {
+    // Reset the fd before taking the list: a push landing after the
+    // exchange finds the list empty and makes the fd readable again
+#ifdef __linux__
+    uint64_t count;
+    ssize_t got = read(queue->read_fd, &count, sizeof(count));
+    (void)got;
+#else
+    char buffer[64];
+    while (read(queue->read_fd, buffer, sizeof(buffer)) > 0) {
+    }
+#endif
+    
+    task_future_t *pushed = atomic_exchange_explicit(&queue->pushed, NULL, memory_order_acquire);
+    task_future_t *ready = NULL;
+    while (pushed) {
+        task_future_t *next = pushed->next;
+        pushed->next = ready;
+        ready = pushed;
+        pushed = next;
+    }
+    queue->ready = ready;
+}
+
+task_future_t* completion_queue_pop(completion_queue_t *queue) {
+    if (!queue) return NULL;
+    
+    if (!queue->ready) refill(queue);
+    task_future_t *future = queue->ready;
+    if (future) {
+        queue->ready = future->next;
+        future->next = NULL;
+    }
+    return future;
+}
+
+size_t completion_queue_drain(completion_queue_t *queue, task_future_t **futures, size_t max) {
+    size_t count = 0;
+    while (count < max && (futures[count] = completion_queue_pop(queue)) != NULL) {
+        count++;
+    }
+    return count;
+}
+
+bool completion_queue_wait(completion_queue_t *queue, uint64_t timeout_us) {
+    if (!queue) return false;
+    if (queue->ready || atomic_load_explicit(&queue->pushed, memory_order_acquire)) return true;
+    
+    struct pollfd pfd = { .fd = queue->read_fd, .events = POLLIN };
+    uint64_t timeout_ms = (timeout_us + 999) / 1000;
+    if (timeout_ms > INT32_MAX) timeout_ms = INT32_MAX;
+    int ready;
+    do {
+        ready = poll(&pfd, 1, timeout_us ? (int)timeout_ms : -1);
+    } while (ready < 0 && errno == EINTR);
+    return ready > 0;
+}
+
@@ -0,0 +1,103 @@
+#ifndef TASK_FUTURE_H
+#define TASK_FUTURE_H
+
+#include "task_queue.h"
+#include "event_count.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct task_future task_future_t;
+typedef struct completion_queue completion_queue_t;
+
+// Runs once, on the thread that finishes the task, or at once on the
+// registering thread if the task is already done. It must not block.
+typedef void (*task_future_callback_t)(task_future_t *future, void *ctx);
+
+typedef struct {
+    task_status_t status;       // COMPLETED, FAILED, EXPIRED or CANCELLED
+    int error;                  // 0; task->error, else EIO when failed, ETIMEDOUT when
+                                // expired; for CANCELLED task->error (ECANCELED,
+                                // ETIMEDOUT or ESHUTDOWN); FAILED with ECANCELED
+                                // when destroyed before it ran
+    const void *result;         // owned by the future, NULL if the task produced none
+    size_t result_size;
+    uint64_t submit_ns;         // task_now_ns() times, 0 where never reached
+    uint64_t enqueue_ns;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} task_outcome_t;
+
+// Outcome of one task, filled in by task_destroy(). Reference counted:
+// the task holds one until it finishes, and every handle given out (to
+// the submitter, to a completion queue) holds one of its own.
+struct task_future {
+    _Atomic uint32_t refs;
+    _Atomic int state;                  // FUTURE_* in task_future.c
+    event_count_t done;                 // waiters park here
+    task_future_callback_t callback;
+    void *callback_ctx;
+    completion_queue_t *queue;          // receives the future on completion, may be NULL
+    task_future_t *next;                // completion queue link
+    char task_id[MAX_TASK_ID_LEN];
+    task_outcome_t outcome;
+    void *result;                       // malloc'd, freed with the future unless taken
+};
+
+// Futures of finished tasks, multi-producer single-consumer. Workers push
+// with one CAS; the consumer takes everything pushed so far in one
+// exchange. The fd turns readable when the queue goes from empty to
+// non-empty (an eventfd on Linux, a pipe elsewhere), so it can sit in an
+// epoll or poll set next to sockets.
+struct completion_queue {
+    _Atomic(task_future_t*) pushed;     // newest first
+    task_future_t *ready;               // consumer only, oldest first
+    int read_fd;
+    int write_fd;                       // same as read_fd for an eventfd
+};
+
+// A future with a reference for the task, one more if caller_ref, and one
+// for queue if given
+task_future_t* task_future_create(completion_queue_t *queue, bool caller_ref);
+// Frees a future whose task was never queued; nothing is signalled
+void task_future_discard(task_future_t *future);
+void task_future_release(task_future_t *future);
+
+// Called from task_destroy() with the task's final state
+void task_future_complete(task_future_t *future, const task_t *task);
+// Hands a malloc'd result to the future without copying it; called by
+// the task's callback while it runs. Returns -1 (result still the
+// caller's) when future is NULL.
+int task_future_set_result(task_future_t *future, void *result, size_t result_size);
+
+bool task_future_is_done(task_future_t *future);
+void task_future_wait(task_future_t *future);
+// false if the task is still not done after timeout_us
+bool task_future_wait_timeout(task_future_t *future, uint64_t timeout_us);
+// -1 if a callback is already registered
+int task_future_on_complete(task_future_t *future, task_future_callback_t callback, void *ctx);
+// -1 while the task is pending. outcome->result stays valid until the
+// future is released or the result taken.
+int task_future_get(task_future_t *future, task_outcome_t *outcome);
+// Moves the result out; the caller frees it with free(). NULL while
+// pending or when there is none.
+void* task_future_take_result(task_future_t *future, size_t *result_size);
+const char* task_future_task_id(task_future_t *future);
+
+completion_queue_t* completion_queue_create(void);
+// Releases futures never popped. Every future pointing at queue must have
+// completed first.
+void completion_queue_destroy(completion_queue_t *queue);
+int completion_queue_fd(completion_queue_t *queue);
+// Next completed future, oldest first, or NULL; never blocks. The caller
+// owns the returned reference. Single consumer. Once the fd turns
+// readable, pop until NULL before waiting on it again.
+task_future_t* completion_queue_pop(completion_queue_t *queue);
+// Up to max futures at once; returns how many
+size_t completion_queue_drain(completion_queue_t *queue, task_future_t **futures, size_t max);
+// Waits until a future is ready or timeout_us passes (0 waits forever);
+// false on timeout
+bool completion_queue_wait(completion_queue_t *queue, uint64_t timeout_us);
+
+#endif // TASK_FUTURE_H
+
@@ -0,0 +1,78 @@
+#include "task_graph.h"
+#include <errno.h>
+#include <stdlib.h>
+
+int task_graph_add_edge(task_t *parent, task_t *child, bool takes_output) {
+    if (!parent || !child || parent == child || !child->release_callback) return -1;
+    if (takes_output && parent->output_to) return -1;
+    
+    task_t **dependents = (task_t**)realloc(parent->dependents,
+                                            (parent->num_dependents + 1) * sizeof(task_t*));
+    if (!dependents) return -1;
+    
+    dependents[parent->num_dependents++] = child;
+    parent->dependents = dependents;
+    if (takes_output) {
+        parent->output_to = child;
+    }
+    child->num_parents++;
+    atomic_fetch_add_explicit(&child->pending_parents, 1, memory_order_relaxed);
+    return 0;
+}
+
+bool task_set_output(task_t *task, void *output, size_t output_size) {
+    if (!task || !task->output_to) return false;
+    
+    free(task->output);
+    task->output = output;
+    task->output_size = output_size;
+    return true;
+}
+
+void task_graph_release(task_t *task) {
+    task_t **dependents = task->dependents;
+    uint32_t count = task->num_dependents;
+    bool completed = (task->status == TASK_STATUS_COMPLETED);
+    
+    // The pointer moves; the dependent is not running yet, and the release
+    // below publishes its new data to whoever runs it
+    task_t *input = task->output_to;
+    if (input && completed && task->output) {
+        if (input->data_free && input->data) {
+            input->data_free(input->data);
+        }
+        input->data = task->output;
+        input->data_size = task->output_size;
+        input->data_free = free;
+    } else {
+        free(task->output);
+    }
+    task->output = NULL;
+    task->output_to = NULL;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        task_t *child = dependents[i];
+        if (!completed) {
+            task_cancel(child, ECANCELED);
+        }
+        if (atomic_fetch_sub_explicit(&child->pending_parents, 1, memory_order_acq_rel) == 1) {
+            // A chain: nothing else waits on this parent or feeds the child
+            bool chain = (count == 1 && child->num_parents == 1);
+            child->release_callback(child, chain, child->release_ctx);
+        }
+    }
+    
+    free(dependents);
+    task->dependents = NULL;
+    task->num_dependents = 0;
+}
+
+void task_graph_unlink(task_t *task) {
+    if (!task) return;
+    
+    free(task->dependents);
+    task->dependents = NULL;
+    task->num_dependents = 0;
+    task->output_to = NULL;
+}
+
@@ -0,0 +1,30 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include "task_queue.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Dependencies between tasks. A dependent is held outside every queue
+// until the last of its parents is destroyed, which hands it to its
+// release_callback exactly once: whichever parent takes pending_parents to
+// zero does it. A parent that did not complete cancels its dependents
+// (ECANCELED) before letting them go, so they finish without running and
+// take their own dependents with them.
+
+// Makes child wait for parent. Neither may have been queued yet, and child
+// needs a release_callback. With takes_output, the buffer the parent
+// passes to task_set_output() becomes child's data; each parent feeds one
+// dependent. Returns -1 when out of memory or the parent already feeds one.
+int task_graph_add_edge(task_t *parent, task_t *child, bool takes_output);
+// For a running task: moves output (malloc'd) to the dependent it feeds,
+// which frees it. false if it feeds none, and the caller keeps the buffer.
+bool task_set_output(task_t *task, void *output, size_t output_size);
+// Called by task_destroy() for a task with dependents
+void task_graph_release(task_t *task);
+// Drops task's edges without releasing anything, for tasks destroyed
+// before any of their graph was queued
+void task_graph_unlink(task_t *task);
+
+#endif // TASK_GRAPH_H
+
@@ -0,0 +1,92 @@
+#include "task_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a of the id
+static size_t bucket_of(const char *task_id) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char*)task_id; *p; p++) {
+        hash ^= *p;
+        hash *= 0x100000001b3ULL;
+    }
+    return (size_t)(hash & (TASK_INDEX_BUCKETS - 1));
+}
+
+static pthread_mutex_t* stripe_of(task_index_t *index, size_t bucket) {
+    return &index->stripes[bucket & (TASK_INDEX_STRIPES - 1)];
+}
+
+task_index_t* task_index_create(void) {
+    task_index_t *index = (task_index_t*)calloc(1, sizeof(task_index_t));
+    if (!index) return NULL;
+    
+    for (size_t i = 0; i < TASK_INDEX_STRIPES; i++) {
+        if (pthread_mutex_init(&index->stripes[i], NULL) != 0) {
+            while (i-- > 0) {
+                pthread_mutex_destroy(&index->stripes[i]);
+            }
+            free(index);
+            return NULL;
+        }
+    }
+    return index;
+}
+
+void task_index_destroy(task_index_t *index) {
+    if (!index) return;
+    
+    for (size_t i = 0; i < TASK_INDEX_STRIPES; i++) {
+        pthread_mutex_destroy(&index->stripes[i]);
+    }
+    free(index);
+}
+
+void task_index_insert(task_index_t *index, task_t *task) {
+    if (!index || !task) return;
+    
+    size_t bucket = bucket_of(task->task_id);
+    pthread_mutex_t *stripe = stripe_of(index, bucket);
+    pthread_mutex_lock(stripe);
+    task->index = index;
+    task->index_next = index->buckets[bucket];
+    index->buckets[bucket] = task;
+    pthread_mutex_unlock(stripe);
+}
+
+void task_index_remove(task_t *task) {
+    if (!task || !task->index) return;
+    
+    task_index_t *index = task->index;
+    size_t bucket = bucket_of(task->task_id);
+    pthread_mutex_t *stripe = stripe_of(index, bucket);
+    pthread_mutex_lock(stripe);
+    task_t **link = &index->buckets[bucket];
+    while (*link && *link != task) {
+        link = &(*link)->index_next;
+    }
+    if (*link) {
+        *link = task->index_next;
+    }
+    pthread_mutex_unlock(stripe);
+    
+    task->index = NULL;
+    task->index_next = NULL;
+}
+
+size_t task_index_cancel(task_index_t *index, const char *task_id, int reason) {
+    if (!index || !task_id) return 0;
+    
+    size_t cancelled = 0;
+    size_t bucket = bucket_of(task_id);
+    pthread_mutex_t *stripe = stripe_of(index, bucket);
+    pthread_mutex_lock(stripe);
+    for (task_t *task = index->buckets[bucket]; task; task = task->index_next) {
+        if (strcmp(task->task_id, task_id) == 0 && task_cancel(task, reason)) {
+            cancelled++;
+        }
+    }
+    pthread_mutex_unlock(stripe);
+    
+    return cancelled;
+}
+
@@ -0,0 +1,31 @@
+#ifndef TASK_INDEX_H
+#define TASK_INDEX_H
+
+#include "task_queue.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#define TASK_INDEX_BUCKETS 4096         // power of two
+#define TASK_INDEX_STRIPES 64           // locks, each guarding every 64th bucket
+
+// Live tasks by id, so a task can be found for cancellation without
+// searching the queue. Chained through task->index_next; ids need not be
+// unique. A task leaves the index in task_destroy(), under the same lock
+// a lookup holds, so a task found here stays valid until the lock drops.
+typedef struct task_index {
+    task_t *buckets[TASK_INDEX_BUCKETS];
+    pthread_mutex_t stripes[TASK_INDEX_STRIPES];
+} task_index_t;
+
+task_index_t* task_index_create(void);
+// Every indexed task must have been destroyed first
+void task_index_destroy(task_index_t *index);
+void task_index_insert(task_index_t *index, task_t *task);
+// Called by task_destroy() for indexed tasks
+void task_index_remove(task_t *task);
+// Cancels (see task_cancel()) every live task with task_id; returns how
+// many were not cancelled already
+size_t task_index_cancel(task_index_t *index, const char *task_id, int reason);
+
+#endif // TASK_INDEX_H
+
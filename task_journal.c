@@ -0,0 +1,706 @@
+#define _GNU_SOURCE
+#include "task_journal.h"
+#include "result_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define JOURNAL_MAGIC 0x4e524a54u       // "TJRN"
+#define JOURNAL_VERSION 2
+#define JOURNAL_MIN_SEGMENT (1024 * 1024)
+
+enum {
+    RECORD_SUBMIT = 1,
+    RECORD_DONE = 2
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t seq;
+    char pad[48];
+} segment_header_t;
+
+// Segments are preallocated with zeros, so a size of 0 ends the records
+typedef struct {
+    uint32_t size;                      // whole record, a multiple of 8
+    uint32_t type;
+    uint64_t checksum;                  // XXH64 from id to the end, seeded by size and type
+    uint64_t id;
+} record_header_t;
+
+// Follows the header of a RECORD_SUBMIT, the payload follows it
+typedef struct {
+    uint64_t timeout_ns;
+    int64_t deadline_unix_ns;           // CLOCK_REALTIME, so it survives a reboot; 0 = none
+    uint64_t memory_bytes;
+    uint32_t priority;
+    uint32_t model_id;
+    uint32_t data_size;
+    char task_id[MAX_TASK_ID_LEN];
+} submit_body_t;
+
+static int64_t realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint64_t record_checksum(const record_header_t *record) {
+    return result_cache_hash(record->size ^ (record->type << 24), &record->id,
+                             record->size - offsetof(record_header_t, id));
+}
+
+static void segment_path(const task_journal_t *journal, uint64_t seq, char *path, size_t size) {
+    snprintf(path, size, "%s/journal-%016" PRIx64 ".wal", journal->dir, seq);
+}
+
+// So a new or deleted segment file survives a crash as well as its contents
+static void sync_dir(const task_journal_t *journal) {
+    int fd = open(journal->dir, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+static void segment_unmap(task_journal_segment_t *segment) {
+    munmap(segment->base, segment->size);
+    close(segment->fd);
+    free(segment);
+}
+
+static task_journal_segment_t* segment_create(task_journal_t *journal) {
+    char path[TASK_JOURNAL_PATH_MAX + 32];
+    uint64_t seq = journal->next_seq;
+    segment_path(journal, seq, path, sizeof(path));
+    
+    task_journal_segment_t *segment = (task_journal_segment_t*)calloc(1, sizeof(*segment));
+    if (!segment) return NULL;
+    
+    segment->fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (segment->fd < 0) {
+        free(segment);
+        return NULL;
+    }
+    // Allocated up front: a store into a hole of a full disk is a SIGBUS
+    segment->size = journal->config.segment_bytes;
+    if (posix_fallocate(segment->fd, 0, (off_t)segment->size) != 0) {
+        close(segment->fd);
+        unlink(path);
+        free(segment);
+        return NULL;
+    }
+    segment->base = (unsigned char*)mmap(NULL, segment->size, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED, segment->fd, 0);
+    if (segment->base == MAP_FAILED) {
+        close(segment->fd);
+        unlink(path);
+        free(segment);
+        return NULL;
+    }
+    
+    segment_header_t *header = (segment_header_t*)segment->base;
+    header->magic = JOURNAL_MAGIC;
+    header->version = JOURNAL_VERSION;
+    header->seq = seq;
+    segment->seq = seq;
+    segment->write_off = sizeof(segment_header_t);
+    segment->synced_off = 0;
+    journal->next_seq++;
+    sync_dir(journal);
+    
+    return segment;
+}
+
+static void segment_link(task_journal_t *journal, task_journal_segment_t *segment) {
+    task_journal_segment_t **link = &journal->segments;
+    while (*link) {
+        link = &(*link)->next;
+    }
+    *link = segment;
+    journal->stats.segments++;
+}
+
+// Oldest first, and only while nothing older is left: a segment holds the
+// completions of tasks in older segments, which would otherwise replay.
+// The unlinks are synced too, or a crash could bring a retired segment
+// back and replay tasks that finished.
+static void retire_segments_locked(task_journal_t *journal, bool closing) {
+    size_t retired = 0;
+    while (journal->segments) {
+        task_journal_segment_t *segment = journal->segments;
+        if (segment->live > 0 || segment->synced_off < segment->write_off) break;
+        if (segment == journal->active && !closing) break;
+        
+        char path[TASK_JOURNAL_PATH_MAX + 32];
+        segment_path(journal, segment->seq, path, sizeof(path));
+        unlink(path);
+        journal->segments = segment->next;
+        if (journal->active == segment) {
+            journal->active = NULL;
+        }
+        journal->stats.segments--;
+        segment_unmap(segment);
+        retired++;
+    }
+    if (retired > 0) {
+        sync_dir(journal);
+    }
+}
+
+static size_t record_size(size_t payload) {
+    return (sizeof(record_header_t) + payload + 7) & ~(size_t)7;
+}
+
+// Copies one record into the active segment, starting a new segment when
+// it does not fit; returns the segment written to
+static task_journal_segment_t* append_locked(task_journal_t *journal, uint32_t type, uint64_t id,
+                                             const submit_body_t *body,
+                                             const void *data, size_t data_size) {
+    size_t payload = body ? sizeof(*body) + data_size : 0;
+    size_t size = record_size(payload);
+    if (size > journal->config.segment_bytes - sizeof(segment_header_t)) return NULL;
+    
+    task_journal_segment_t *segment = journal->active;
+    if (!segment || segment->write_off + size > segment->size) {
+        segment = segment_create(journal);
+        if (!segment) return NULL;
+        segment_link(journal, segment);
+        journal->active = segment;
+    }
+    
+    record_header_t *record = (record_header_t*)(segment->base + segment->write_off);
+    record->id = id;
+    if (body) {
+        memcpy(record + 1, body, sizeof(*body));
+        if (data_size > 0) {
+            memcpy((unsigned char*)(record + 1) + sizeof(*body), data, data_size);
+        }
+    }
+    record->type = type;
+    record->size = (uint32_t)size;
+    record->checksum = record_checksum(record);
+    segment->write_off += size;
+    
+    journal->stats.bytes += size;
+    // The first record starts the interval, a full group cuts it short
+    journal->unsynced++;
+    if (journal->unsynced == 1 ||
+        (journal->config.sync_records && journal->unsynced == journal->config.sync_records)) {
+        pthread_cond_signal(&journal->wake);
+    }
+    return segment;
+}
+
+// One group commit: msync every range written since the last one. Only
+// the active segment and those filled since the last round are dirty,
+// and they end the list.
+static void sync_round_locked(task_journal_t *journal) {
+    task_journal_segment_t *first = NULL, *last = NULL;
+    for (task_journal_segment_t *s = journal->segments; s; s = s->next) {
+        s->sync_end = s->write_off;
+        if (!first && s->synced_off < s->write_off) {
+            first = s;
+        }
+        last = s;
+    }
+    journal->unsynced = 0;
+    journal->sync_requested = false;
+    journal->syncing = true;
+    
+    // Appenders only link after last, and only this thread unlinks, so the
+    // segments from first to last stay put unlocked
+    pthread_mutex_unlock(&journal->mutex);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    for (task_journal_segment_t *s = first; s; s = (s == last) ? NULL : s->next) {
+        size_t start = s->synced_off & ~(page - 1);
+        msync(s->base + start, s->sync_end - start, MS_SYNC);
+    }
+    pthread_mutex_lock(&journal->mutex);
+    
+    for (task_journal_segment_t *s = first; s; s = (s == last) ? NULL : s->next) {
+        s->synced_off = s->sync_end;
+    }
+    // Before the round counts, so a task_journal_sync() waiting on it
+    // also covers the segments it retires
+    retire_segments_locked(journal, false);
+    journal->syncing = false;
+    journal->stats.syncs++;
+    journal->sync_generation++;
+    pthread_cond_broadcast(&journal->synced);
+}
+
+static void* sync_thread(void *arg) {
+    task_journal_t *journal = (task_journal_t*)arg;
+    
+    pthread_mutex_lock(&journal->mutex);
+    for (;;) {
+        while (!journal->stopping && !journal->sync_requested && journal->unsynced == 0) {
+            pthread_cond_wait(&journal->wake, &journal->mutex);
+        }
+        
+        // Give the group until the interval ends or it is full
+        if (!journal->stopping && !journal->sync_requested &&
+            (!journal->config.sync_records || journal->unsynced < journal->config.sync_records)) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            uint64_t ns = (uint64_t)deadline.tv_nsec + journal->config.sync_interval_ms * 1000000ULL;
+            deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+            deadline.tv_nsec = (long)(ns % 1000000000ULL);
+            pthread_cond_timedwait(&journal->wake, &journal->mutex, &deadline);
+        }
+        
+        sync_round_locked(journal);
+        if (journal->stopping && journal->unsynced == 0) break;
+    }
+    pthread_mutex_unlock(&journal->mutex);
+    
+    return NULL;
+}
+
+void task_journal_config_init(task_journal_config_t *config) {
+    if (!config) return;
+    
+    config->segment_bytes = (size_t)TASK_JOURNAL_DEFAULT_SEGMENT_MB * 1024 * 1024;
+    config->sync_interval_ms = TASK_JOURNAL_DEFAULT_SYNC_MS;
+    config->sync_records = TASK_JOURNAL_DEFAULT_SYNC_RECORDS;
+}
+
+/* ---- recovery ---- */
+
+static int compare_seq(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Segment numbers of the files in dir, sorted; NULL with *count 0 if none
+static uint64_t* list_segments(const char *dir, size_t *count) {
+    *count = 0;
+    DIR *d = opendir(dir);
+    if (!d) return NULL;
+    
+    uint64_t *seqs = NULL;
+    size_t capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        uint64_t seq;
+        int end = 0;
+        if (sscanf(entry->d_name, "journal-%16" SCNx64 ".wal%n", &seq, &end) != 1 ||
+            entry->d_name[end] != '\0' || end == 0) {
+            continue;
+        }
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            uint64_t *grown = (uint64_t*)realloc(seqs, capacity * sizeof(uint64_t));
+            if (!grown) break;
+            seqs = grown;
+        }
+        seqs[(*count)++] = seq;
+    }
+    closedir(d);
+    
+    qsort(seqs, *count, sizeof(uint64_t), compare_seq);
+    return seqs;
+}
+
+// Maps an existing segment read-only and finds the end of its valid
+// records: the first empty, torn or corrupt one
+static task_journal_segment_t* segment_load(task_journal_t *journal, uint64_t seq) {
+    char path[TASK_JOURNAL_PATH_MAX + 32];
+    segment_path(journal, seq, path, sizeof(path));
+    
+    task_journal_segment_t *segment = (task_journal_segment_t*)calloc(1, sizeof(*segment));
+    if (!segment) return NULL;
+    
+    struct stat st;
+    segment->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (segment->fd < 0 || fstat(segment->fd, &st) != 0 ||
+        (size_t)st.st_size < sizeof(segment_header_t)) {
+        if (segment->fd >= 0) close(segment->fd);
+        free(segment);
+        return NULL;
+    }
+    segment->size = (size_t)st.st_size;
+    segment->base = (unsigned char*)mmap(NULL, segment->size, PROT_READ, MAP_SHARED, segment->fd, 0);
+    if (segment->base == MAP_FAILED) {
+        close(segment->fd);
+        free(segment);
+        return NULL;
+    }
+    
+    // A bad header (a crash while creating it) leaves the segment empty
+    const segment_header_t *header = (const segment_header_t*)segment->base;
+    size_t end = sizeof(segment_header_t);
+    bool valid = (header->magic == JOURNAL_MAGIC && header->version == JOURNAL_VERSION);
+    while (valid && end + sizeof(record_header_t) <= segment->size) {
+        const record_header_t *record = (const record_header_t*)(segment->base + end);
+        if (record->size < sizeof(record_header_t) || record->size % 8 != 0 ||
+            record->size > segment->size - end || record_checksum(record) != record->checksum) {
+            break;
+        }
+        if (record->type == RECORD_SUBMIT) {
+            if (record->size < record_size(sizeof(submit_body_t))) break;
+            if (!segment->first_id) {
+                segment->first_id = record->id;
+            }
+            segment->last_id = record->id;
+        }
+        end += record->size;
+    }
+    
+    segment->seq = seq;
+    segment->write_off = end;
+    segment->synced_off = end;
+    return segment;
+}
+
+#define FOR_EACH_RECORD(segment, record) \
+    for (const record_header_t *record = (const record_header_t*)((segment)->base + sizeof(segment_header_t)); \
+         (const unsigned char*)record < (segment)->base + (segment)->write_off; \
+         record = (const record_header_t*)((const unsigned char*)record + record->size))
+
+// Segments with submissions, ordered by id; the index of the one holding
+// id, or count if its segment is gone
+static size_t find_owner(task_journal_segment_t **owners, size_t count, uint64_t id) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (owners[mid]->last_id < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < count && owners[lo]->first_id <= id) ? lo : count;
+}
+
+static bool add_recovered(task_journal_t *journal, size_t *capacity, task_journal_segment_t *segment,
+                          const record_header_t *record, int64_t now_real, uint64_t now) {
+    if (journal->num_recovered == *capacity) {
+        size_t grown = *capacity ? *capacity * 2 : 1024;
+        task_journal_record_t *records = (task_journal_record_t*)realloc(
+            journal->recovered, grown * sizeof(task_journal_record_t));
+        if (!records) return false;
+        journal->recovered = records;
+        *capacity = grown;
+    }
+    
+    const submit_body_t *body = (const submit_body_t*)(record + 1);
+    task_journal_record_t *out = &journal->recovered[journal->num_recovered++];
+    out->id = record->id;
+    out->task_id = body->task_id;
+    out->priority = (task_priority_t)(body->priority < TASK_PRIORITY_LEVELS ? body->priority
+                                                                             : TASK_PRIORITY_NORMAL);
+    out->model_id = body->model_id;
+    out->timeout_ns = body->timeout_ns;
+    out->memory_bytes = body->memory_bytes;
+    out->deadline_ns = 0;
+    if (body->deadline_unix_ns) {
+        // Already past, it expires when dequeued instead of running
+        int64_t left = body->deadline_unix_ns - now_real;
+        out->deadline_ns = left > 0 ? now + (uint64_t)left : 1;
+    }
+    out->data = body + 1;
+    out->data_size = body->data_size;
+    out->segment = segment;
+    segment->live++;
+    return true;
+}
+
+// Two passes over the mapped records: each completion sets the bit of its
+// submission, in the slice of a shared bitmap owned by the segment that
+// holds it; then every submission whose bit is clear is live. Linear in
+// the journal, with one bit of state per submission.
+static int recover(task_journal_t *journal) {
+    uint64_t start = task_now_ns();
+    size_t num_seqs;
+    uint64_t *seqs = list_segments(journal->dir, &num_seqs);
+    
+    task_journal_segment_t **owners = (task_journal_segment_t**)malloc(
+        (num_seqs ? num_seqs : 1) * sizeof(task_journal_segment_t*));
+    size_t *first_bit = (size_t*)malloc((num_seqs ? num_seqs : 1) * sizeof(size_t));
+    if (!owners || !first_bit) {
+        free(owners);
+        free(first_bit);
+        free(seqs);
+        return -1;
+    }
+    
+    size_t num_owners = 0, bits = 0;
+    for (size_t i = 0; i < num_seqs; i++) {
+        task_journal_segment_t *segment = segment_load(journal, seqs[i]);
+        if (!segment) continue;
+        
+        segment_link(journal, segment);
+        FOR_EACH_RECORD(segment, record) {
+            journal->stats.recovered_records++;
+            if (record->id >= journal->next_id) {
+                journal->next_id = record->id + 1;
+            }
+        }
+        if (segment->first_id) {
+            first_bit[num_owners] = bits;
+            owners[num_owners++] = segment;
+            bits += (size_t)(segment->last_id - segment->first_id + 1);
+        }
+    }
+    // Past every file, loadable or not, so a new segment never collides
+    if (num_seqs > 0) {
+        journal->next_seq = seqs[num_seqs - 1] + 1;
+    }
+    free(seqs);
+    
+    unsigned char *done = (unsigned char*)calloc(bits / 8 + 1, 1);
+    if (!done) {
+        free(owners);
+        free(first_bit);
+        return -1;
+    }
+    for (task_journal_segment_t *s = journal->segments; s; s = s->next) {
+        FOR_EACH_RECORD(s, record) {
+            if (record->type != RECORD_DONE) continue;
+            
+            size_t owner = find_owner(owners, num_owners, record->id);
+            if (owner == num_owners) continue;
+            size_t bit = first_bit[owner] + (size_t)(record->id - owners[owner]->first_id);
+            done[bit / 8] |= (unsigned char)(1u << (bit % 8));
+        }
+    }
+    
+    int result = 0;
+    size_t capacity = 0;
+    int64_t now_real = realtime_ns();
+    uint64_t now = task_now_ns();
+    for (size_t i = 0; i < num_owners && result == 0; i++) {
+        FOR_EACH_RECORD(owners[i], record) {
+            if (record->type != RECORD_SUBMIT) continue;
+            
+            size_t bit = first_bit[i] + (size_t)(record->id - owners[i]->first_id);
+            if (!(done[bit / 8] & (1u << (bit % 8))) &&
+                !add_recovered(journal, &capacity, owners[i], record, now_real, now)) {
+                result = -1;
+                break;
+            }
+        }
+    }
+    free(done);
+    free(owners);
+    free(first_bit);
+    
+    journal->stats.live = journal->num_recovered;
+    journal->stats.recovered = journal->num_recovered;
+    journal->stats.recovery_ns = task_now_ns() - start;
+    return result;
+}
+
+/* ---- public API ---- */
+
+task_journal_t* task_journal_open(const char *dir, const task_journal_config_t *config) {
+    if (!dir || strlen(dir) >= TASK_JOURNAL_PATH_MAX) return NULL;
+    
+    task_journal_t *journal = (task_journal_t*)calloc(1, sizeof(task_journal_t));
+    if (!journal) return NULL;
+    
+    snprintf(journal->dir, sizeof(journal->dir), "%s", dir);
+    if (config) {
+        journal->config = *config;
+    } else {
+        task_journal_config_init(&journal->config);
+    }
+    if (journal->config.segment_bytes < JOURNAL_MIN_SEGMENT) {
+        journal->config.segment_bytes = JOURNAL_MIN_SEGMENT;
+    }
+    if (journal->config.sync_interval_ms == 0) {
+        journal->config.sync_interval_ms = 1;
+    }
+    journal->next_seq = 1;
+    journal->next_id = 1;
+    
+    if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || recover(journal) != 0) {
+        task_journal_close(journal);
+        return NULL;
+    }
+    // Nothing recovered keeps a finished segment around
+    retire_segments_locked(journal, false);
+    
+    if (pthread_mutex_init(&journal->mutex, NULL) != 0) {
+        task_journal_close(journal);
+        return NULL;
+    }
+    pthread_cond_init(&journal->wake, NULL);
+    pthread_cond_init(&journal->synced, NULL);
+    if (pthread_create(&journal->thread, NULL, sync_thread, journal) != 0) {
+        pthread_cond_destroy(&journal->wake);
+        pthread_cond_destroy(&journal->synced);
+        pthread_mutex_destroy(&journal->mutex);
+        task_journal_close(journal);
+        return NULL;
+    }
+    journal->running = true;
+    
+    return journal;
+}
+
+void task_journal_close(task_journal_t *journal) {
+    if (!journal) return;
+    
+    if (journal->running) {
+        pthread_mutex_lock(&journal->mutex);
+        journal->stopping = true;
+        pthread_cond_signal(&journal->wake);
+        pthread_mutex_unlock(&journal->mutex);
+        pthread_join(journal->thread, NULL);
+        
+        pthread_cond_destroy(&journal->wake);
+        pthread_cond_destroy(&journal->synced);
+        pthread_mutex_destroy(&journal->mutex);
+    }
+    
+    // Everything is synced by now; an empty journal leaves no files
+    retire_segments_locked(journal, true);
+    while (journal->segments) {
+        task_journal_segment_t *segment = journal->segments;
+        journal->segments = segment->next;
+        segment_unmap(segment);
+    }
+    free(journal->recovered);
+    free(journal);
+}
+
+int task_journal_append(task_journal_t *journal, task_t *task) {
+    if (!journal || !task) return -1;
+    
+    submit_body_t body;
+    memset(&body, 0, sizeof(body));
+    body.timeout_ns = task->timeout_ns;
+    if (task->deadline_ns) {
+        body.deadline_unix_ns = realtime_ns() + (int64_t)(task->deadline_ns - task_now_ns());
+    }
+    body.memory_bytes = task->memory_bytes;
+    body.priority = (uint32_t)task->priority;
+    body.model_id = task->model_id;
+    body.data_size = (uint32_t)task->data_size;
+    memcpy(body.task_id, task->task_id, sizeof(body.task_id));
+    
+    pthread_mutex_lock(&journal->mutex);
+    uint64_t id = journal->next_id;
+    task_journal_segment_t *segment = append_locked(journal, RECORD_SUBMIT, id, &body,
+                                                    task->data, task->data_size);
+    if (segment) {
+        journal->next_id++;
+        if (!segment->first_id) {
+            segment->first_id = id;
+        }
+        segment->last_id = id;
+        segment->live++;
+        journal->stats.submitted++;
+        journal->stats.live++;
+    }
+    pthread_mutex_unlock(&journal->mutex);
+    if (!segment) return -1;
+    
+    task->journal = journal;
+    task->journal_id = id;
+    task->journal_segment = segment;
+    return 0;
+}
+
+void task_journal_complete(task_t *task) {
+    if (!task || !task->journal) return;
+    
+    // Shut down unrun by a checkpoint, or waiting on a task that was: it
+    // stays unfinished and replays on the next open
+    if (task->status == TASK_STATUS_CANCELLED && task->error == ESHUTDOWN) {
+        task_journal_detach(task);
+        return;
+    }
+    
+    task_journal_t *journal = task->journal;
+    pthread_mutex_lock(&journal->mutex);
+    // Without room for the record the task replays on the next open,
+    // which beats losing it
+    if (append_locked(journal, RECORD_DONE, task->journal_id, NULL, NULL, 0)) {
+        task->journal_segment->live--;
+        journal->stats.finished++;
+        journal->stats.live--;
+    }
+    pthread_mutex_unlock(&journal->mutex);
+    
+    task->journal = NULL;
+    task->journal_segment = NULL;
+}
+
+void task_journal_detach(task_t *task) {
+    if (!task) return;
+    
+    task->journal = NULL;
+    task->journal_segment = NULL;
+}
+
+bool task_journal_next_recovered(task_journal_t *journal, task_journal_record_t *record) {
+    if (!journal || !record) return false;
+    
+    pthread_mutex_lock(&journal->mutex);
+    bool found = journal->replay_next < journal->num_recovered;
+    if (found) {
+        *record = journal->recovered[journal->replay_next++];
+    }
+    pthread_mutex_unlock(&journal->mutex);
+    
+    return found;
+}
+
+void task_journal_adopt(task_journal_t *journal, task_t *task, const task_journal_record_t *record) {
+    if (!journal || !task || !record) return;
+    
+    task->journal = journal;
+    task->journal_id = record->id;
+    task->journal_segment = record->segment;
+}
+
+int task_journal_sync(task_journal_t *journal) {
+    if (!journal) return -1;
+    
+    pthread_mutex_lock(&journal->mutex);
+    // A round already running may have missed the latest records
+    uint64_t target = journal->sync_generation + (journal->syncing ? 2 : 1);
+    journal->sync_requested = true;
+    pthread_cond_signal(&journal->wake);
+    while (journal->sync_generation < target) {
+        pthread_cond_wait(&journal->synced, &journal->mutex);
+    }
+    pthread_mutex_unlock(&journal->mutex);
+    
+    return 0;
+}
+
+void task_journal_get_stats(task_journal_t *journal, task_journal_stats_t *stats) {
+    if (!stats) return;
+    
+    memset(stats, 0, sizeof(*stats));
+    if (!journal) return;
+    
+    pthread_mutex_lock(&journal->mutex);
+    *stats = journal->stats;
+    pthread_mutex_unlock(&journal->mutex);
+}
+
+void task_journal_print_stats(task_journal_t *journal, FILE *out) {
+    if (!journal || !out) return;
+    
+    task_journal_stats_t stats;
+    task_journal_get_stats(journal, &stats);
+    fprintf(out, "Journal: %llu submitted, %llu finished, %zu unfinished, %llu syncs, "
+            "%llu bytes, %zu segments\n",
+            (unsigned long long)stats.submitted, (unsigned long long)stats.finished, stats.live,
+            (unsigned long long)stats.syncs, (unsigned long long)stats.bytes, stats.segments);
+}
+
@@ -0,0 +1,120 @@
+#ifndef TASK_JOURNAL_H
+#define TASK_JOURNAL_H
+
+#include "task_queue.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TASK_JOURNAL_DEFAULT_SEGMENT_MB 64
+#define TASK_JOURNAL_DEFAULT_SYNC_MS 10
+#define TASK_JOURNAL_DEFAULT_SYNC_RECORDS 256
+#define TASK_JOURNAL_PATH_MAX 256
+
+typedef struct {
+    size_t segment_bytes;               // size of each preallocated segment file
+    uint32_t sync_interval_ms;          // longest a record waits to be synced
+    uint32_t sync_records;              // records that trigger a sync sooner, 0 = never
+} task_journal_config_t;
+
+typedef struct task_journal_segment task_journal_segment_t;
+
+// One segment file, mapped whole. Submission ids in a segment are
+// consecutive, so one bit per submission tracks which have finished.
+struct task_journal_segment {
+    uint64_t seq;                       // file name order
+    int fd;
+    unsigned char *base;
+    size_t size;
+    size_t write_off;                   // end of the records; under the journal mutex
+    size_t synced_off;                  // durable up to here
+    size_t sync_end;                    // write_off when the current sync round began
+    uint64_t first_id;                  // submissions in it, 0 while there are none
+    uint64_t last_id;
+    size_t live;                        // submissions not yet finished
+    task_journal_segment_t *next;       // oldest first
+};
+
+// A submission found unfinished on open, pointing into its mapped segment
+typedef struct {
+    uint64_t id;
+    const char *task_id;
+    task_priority_t priority;
+    uint32_t model_id;
+    uint64_t timeout_ns;
+    uint64_t deadline_ns;               // converted to task_now_ns() time, 0 = none
+    uint64_t memory_bytes;
+    const void *data;
+    size_t data_size;
+    task_journal_segment_t *segment;
+} task_journal_record_t;
+
+typedef struct {
+    uint64_t submitted;                 // records appended since open
+    uint64_t finished;
+    uint64_t syncs;
+    uint64_t bytes;
+    size_t segments;
+    size_t live;                        // journaled tasks not yet finished
+    size_t recovered;                   // unfinished submissions found on open
+    size_t recovered_records;           // records scanned on open
+    uint64_t recovery_ns;
+} task_journal_stats_t;
+
+// Write-ahead journal of task submissions and completions. Records are
+// copied into mmap'd segment files, so a crashed process loses nothing
+// that was appended; a background thread msyncs in groups, every
+// sync_interval_ms or sync_records records, which bounds what a power
+// loss can take. A full segment is followed by a new one, and a segment
+// whose submissions have all finished is deleted.
+typedef struct task_journal {
+    char dir[TASK_JOURNAL_PATH_MAX];
+    task_journal_config_t config;
+    pthread_mutex_t mutex;              // guards everything below but the stats
+    pthread_cond_t wake;                // the sync thread waits here
+    pthread_cond_t synced;              // task_journal_sync() callers wait here
+    task_journal_segment_t *segments;
+    task_journal_segment_t *active;     // appended to; NULL until the first append
+    uint64_t next_seq;
+    uint64_t next_id;
+    uint32_t unsynced;                  // records since the last sync
+    uint64_t sync_generation;           // completed sync rounds
+    bool syncing;                       // a round is between capture and completion
+    bool sync_requested;
+    bool stopping;
+    pthread_t thread;
+    bool running;                       // the sync thread was started
+    task_journal_record_t *recovered;
+    size_t num_recovered;
+    size_t replay_next;
+    task_journal_stats_t stats;         // under mutex
+} task_journal_t;
+
+void task_journal_config_init(task_journal_config_t *config);
+// Opens (creating it if need be) the journal in dir and scans what an
+// earlier run left there; its unfinished submissions are handed out by
+// task_journal_next_recovered(). Starts the sync thread.
+task_journal_t* task_journal_open(const char *dir, const task_journal_config_t *config);
+// Syncs and unmaps. Every journaled task must have been destroyed or
+// detached; submissions still unfinished stay for the next open.
+void task_journal_close(task_journal_t *journal);
+// Records the task as submitted and ties it to the journal, before it is
+// queued. -1 if the record could not be written.
+int task_journal_append(task_journal_t *journal, task_t *task);
+// Called by task_destroy() for a journaled task: records it as finished,
+// unless it was cancelled with ESHUTDOWN, which leaves it to be replayed
+void task_journal_complete(task_t *task);
+// Unties a task that will not finish here, so the next open replays it
+void task_journal_detach(task_t *task);
+// Hands out the next unfinished submission from open, oldest first; false
+// once there are none. The record stays valid until the journal closes.
+bool task_journal_next_recovered(task_journal_t *journal, task_journal_record_t *record);
+// Ties a task rebuilt from record to it, in place of task_journal_append()
+void task_journal_adopt(task_journal_t *journal, task_t *task, const task_journal_record_t *record);
+// Returns once everything appended so far is durable
+int task_journal_sync(task_journal_t *journal);
+void task_journal_get_stats(task_journal_t *journal, task_journal_stats_t *stats);
+void task_journal_print_stats(task_journal_t *journal, FILE *out);
+
+#endif // TASK_JOURNAL_H
+
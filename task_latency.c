@@ -0,0 +1,174 @@
+#include "task_latency.h"
+#include <string.h>
+
+static const char *level_names[TASK_PRIORITY_LEVELS] = { "LOW", "NORMAL", "HIGH", "CRITICAL" };
+static const char *metric_names[LATENCY_METRICS] = { "queue wait", "execution", "end-to-end" };
+
+static size_t bucket_index(uint64_t value) {
+    if (value < LATENCY_SUB_BUCKETS) return (size_t)value;
+    
+    int exponent = 63 - __builtin_clzll(value);
+    size_t sub = (size_t)(value >> (exponent - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return (size_t)(exponent - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Midpoint of the values that land in bucket index
+static uint64_t bucket_value(size_t index) {
+    if (index < LATENCY_SUB_BUCKETS) return index;
+    
+    int shift = (int)(index / LATENCY_SUB_BUCKETS) - 1;
+    uint64_t sub = index % LATENCY_SUB_BUCKETS;
+    uint64_t lower = (LATENCY_SUB_BUCKETS + sub) << shift;
+    return lower + ((1ULL << shift) >> 1);
+}
+
+uint64_t task_latency_bucket_limit(size_t index) {
+    if (index < LATENCY_SUB_BUCKETS) return index;
+    
+    int shift = (int)(index / LATENCY_SUB_BUCKETS) - 1;
+    uint64_t sub = index % LATENCY_SUB_BUCKETS;
+    return ((LATENCY_SUB_BUCKETS + sub) << shift) + ((1ULL << shift) - 1);
+}
+
+static void record(latency_histogram_t *histogram, uint64_t value) {
+    // Single writer: no read-modify-write needed
+    _Atomic uint64_t *count = &histogram->counts[bucket_index(value)];
+    atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_store_explicit(&histogram->sum,
+                          atomic_load_explicit(&histogram->sum, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+    if (value > atomic_load_explicit(&histogram->max, memory_order_relaxed)) {
+        atomic_store_explicit(&histogram->max, value, memory_order_relaxed);
+    }
+}
+
+static uint64_t span(uint64_t from, uint64_t to) {
+    return (from && to > from) ? to - from : 0;
+}
+
+void task_latency_record(task_latency_t *latency, const task_t *task) {
+    if (!latency || !task) return;
+    
+    int level = (int)task->priority;
+    if (level < 0 || level >= TASK_PRIORITY_LEVELS) return;
+    
+    latency_histogram_t *row = latency->histograms[level];
+    record(&row[LATENCY_QUEUE_WAIT], span(task->enqueue_ns, task->dequeue_ns));
+    record(&row[LATENCY_EXECUTION], span(task->start_ns, task->end_ns));
+    record(&row[LATENCY_END_TO_END], span(task->timestamp, task->end_ns));
+    atomic_store_explicit(&latency->completed,
+                          atomic_load_explicit(&latency->completed, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+static uint64_t percentile(const uint64_t *counts, uint64_t total, double fraction) {
+    uint64_t rank = (uint64_t)(fraction * (double)total);
+    if (rank >= total) rank = total - 1;
+    
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen > rank) return bucket_value(i);
+    }
+    return 0;
+}
+
+static void summarize(const uint64_t *counts, uint64_t max, latency_summary_t *summary) {
+    memset(summary, 0, sizeof(*summary));
+    
+    uint64_t total = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        total += counts[i];
+    }
+    if (total == 0) return;
+    
+    // A bucket midpoint can overshoot the largest value actually seen
+    uint64_t *quantiles[] = { &summary->p50, &summary->p90, &summary->p99, &summary->p999 };
+    static const double fractions[] = { 0.50, 0.90, 0.99, 0.999 };
+    for (size_t i = 0; i < sizeof(fractions) / sizeof(fractions[0]); i++) {
+        uint64_t value = percentile(counts, total, fractions[i]);
+        *quantiles[i] = (max && value > max) ? max : value;
+    }
+    summary->count = total;
+    summary->max = max;
+}
+
+void task_latency_merge(const task_latency_t *recorders, size_t count, int level,
+                        latency_metric_t metric, uint64_t counts[LATENCY_BUCKETS],
+                        uint64_t *sum, uint64_t *max) {
+    memset(counts, 0, LATENCY_BUCKETS * sizeof(uint64_t));
+    if (sum) *sum = 0;
+    if (max) *max = 0;
+    if (!recorders || level < 0 || level >= TASK_PRIORITY_LEVELS) return;
+    
+    for (size_t r = 0; r < count; r++) {
+        const latency_histogram_t *histogram = &recorders[r].histograms[level][metric];
+        for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+            counts[i] += atomic_load_explicit(&histogram->counts[i], memory_order_relaxed);
+        }
+        if (sum) *sum += atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+        uint64_t worker_max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+        if (max && worker_max > *max) *max = worker_max;
+    }
+}
+
+void task_latency_snapshot(const task_latency_t *recorders, size_t count,
+                           uint64_t elapsed_ns, latency_snapshot_t *snapshot) {
+    if (!snapshot) return;
+    memset(snapshot, 0, sizeof(*snapshot));
+    if (!recorders) return;
+    
+    uint64_t merged[LATENCY_BUCKETS];
+    uint64_t overall[LATENCY_METRICS][LATENCY_BUCKETS];
+    uint64_t overall_max[LATENCY_METRICS] = { 0 };
+    memset(overall, 0, sizeof(overall));
+    
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        for (int metric = 0; metric < LATENCY_METRICS; metric++) {
+            uint64_t max;
+            task_latency_merge(recorders, count, level, (latency_metric_t)metric, merged, NULL, &max);
+            
+            summarize(merged, max, &snapshot->by_priority[level][metric]);
+            for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+                overall[metric][i] += merged[i];
+            }
+            if (max > overall_max[metric]) overall_max[metric] = max;
+        }
+    }
+    
+    for (int metric = 0; metric < LATENCY_METRICS; metric++) {
+        summarize(overall[metric], overall_max[metric], &snapshot->overall[metric]);
+    }
+    
+    for (size_t r = 0; r < count; r++) {
+        snapshot->completed += atomic_load_explicit(&recorders[r].completed, memory_order_relaxed);
+    }
+    snapshot->throughput = elapsed_ns ? (double)snapshot->completed * 1e9 / (double)elapsed_ns : 0.0;
+}
+
+static void print_summary(FILE *out, const char *label, const char *metric,
+                          const latency_summary_t *summary) {
+    fprintf(out, "  %-8s %-10s n=%-8llu p50 %9.3f  p90 %9.3f  p99 %9.3f  p999 %9.3f  max %9.3f ms\n",
+            label, metric, (unsigned long long)summary->count,
+            summary->p50 / 1e6, summary->p90 / 1e6, summary->p99 / 1e6,
+            summary->p999 / 1e6, summary->max / 1e6);
+}
+
+void task_latency_print(const latency_snapshot_t *snapshot, FILE *out) {
+    if (!snapshot || !out) return;
+    
+    fprintf(out, "Completed: %llu tasks, %.1f tasks/s\n",
+            (unsigned long long)snapshot->completed, snapshot->throughput);
+    for (int level = TASK_PRIORITY_LEVELS - 1; level >= 0; level--) {
+        if (snapshot->by_priority[level][LATENCY_END_TO_END].count == 0) continue;
+        for (int metric = 0; metric < LATENCY_METRICS; metric++) {
+            print_summary(out, level_names[level], metric_names[metric],
+                          &snapshot->by_priority[level][metric]);
+        }
+    }
+    for (int metric = 0; metric < LATENCY_METRICS; metric++) {
+        print_summary(out, "all", metric_names[metric], &snapshot->overall[metric]);
+    }
+}
+
@@ -0,0 +1,70 @@
+#ifndef TASK_LATENCY_H
+#define TASK_LATENCY_H
+
+#include "task_queue.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Log-linear buckets in the style of HdrHistogram: values below 16 ns get
+// their own bucket, above that each power of two is split into 16 equal
+// sub-buckets, so a recorded value is off by at most 1/16 (6.25%).
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+typedef enum {
+    LATENCY_QUEUE_WAIT = 0,     // enqueue to dequeue
+    LATENCY_EXECUTION = 1,      // execute start to end
+    LATENCY_END_TO_END = 2,     // submit to execute end
+    LATENCY_METRICS = 3
+} latency_metric_t;
+
+typedef struct {
+    _Atomic uint64_t counts[LATENCY_BUCKETS];
+    _Atomic uint64_t max;
+    _Atomic uint64_t sum;       // of all recorded values
+} latency_histogram_t;
+
+// One per worker. Only the owning worker records, so updates are plain
+// relaxed load/store pairs; readers merge all workers' copies on demand.
+typedef struct {
+    latency_histogram_t histograms[TASK_PRIORITY_LEVELS][LATENCY_METRICS];
+    _Atomic uint64_t completed;
+} task_latency_t;
+
+// Values in nanoseconds
+typedef struct {
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+} latency_summary_t;
+
+typedef struct {
+    latency_summary_t by_priority[TASK_PRIORITY_LEVELS][LATENCY_METRICS];
+    latency_summary_t overall[LATENCY_METRICS];
+    uint64_t completed;
+    double throughput;          // tasks per second since start
+} latency_snapshot_t;
+
+// Records a finished task; its enqueue, dequeue, start and end times must
+// be set
+void task_latency_record(task_latency_t *latency, const task_t *task);
+// Merges an array of count recorders into *snapshot; throughput is taken
+// over elapsed_ns
+void task_latency_snapshot(const task_latency_t *recorders, size_t count,
+                           uint64_t elapsed_ns, latency_snapshot_t *snapshot);
+void task_latency_print(const latency_snapshot_t *snapshot, FILE *out);
+// Raw bucket counts of one priority and metric summed over count
+// recorders, for exporters; *sum and *max may be NULL
+void task_latency_merge(const task_latency_t *recorders, size_t count, int level,
+                        latency_metric_t metric, uint64_t counts[LATENCY_BUCKETS],
+                        uint64_t *sum, uint64_t *max);
+// Largest value that lands in bucket index
+uint64_t task_latency_bucket_limit(size_t index);
+
+#endif // TASK_LATENCY_H
+
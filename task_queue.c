@@ -1,24 +1,105 @@
 #include "task_queue.h"
+#include "task_slab.h"
+#include "task_future.h"
+#include "task_index.h"
+#include "result_cache.h"
+#include "task_graph.h"
+#include "task_journal.h"
+#include "memory_budget.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <limits.h>
+
+static size_t ring_capacity_for(size_t max_size) {
+    size_t capacity = 1;
+    while (capacity < max_size) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+static void free_levels(task_queue_t *queue) {
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        free(queue->levels[level].slots);
+        free(queue->lf_levels[level].cells);
+        free(queue->heaps[level].items);
+    }
+}
 
 task_queue_t* task_queue_create(size_t max_size) {
-    task_queue_t *queue = (task_queue_t*)malloc(sizeof(task_queue_t));
+    return task_queue_create_ex(max_size, TASK_QUEUE_MODE_LOCKED);
+}
+
+task_queue_t* task_queue_create_ex(size_t max_size, task_queue_mode_t mode) {
+    task_queue_t *queue = (task_queue_t*)calloc(1, sizeof(task_queue_t));
     if (!queue) return NULL;
     
-    queue->head = NULL;
-    queue->size = 0;
+    queue->mode = mode;
+    queue->nonempty_mask = 0;
     queue->max_size = max_size;
+    atomic_init(&queue->size, 0);
+    atomic_init(&queue->shutdown, false);
+    
+    // Every level may have to hold the whole queue on its own. The slot
+    // arrays are never zeroed, so pages are only touched once used.
+    size_t capacity = ring_capacity_for(max_size);
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        if (mode == TASK_QUEUE_MODE_LOCK_FREE) {
+            task_mpmc_ring_t *ring = &queue->lf_levels[level];
+            ring->cells = (task_cell_t*)malloc(sizeof(task_cell_t) * capacity);
+            if (!ring->cells) {
+                free_levels(queue);
+                free(queue);
+                return NULL;
+            }
+            for (size_t i = 0; i < capacity; i++) {
+                atomic_init(&ring->cells[i].sequence, i);
+            }
+            ring->mask = capacity - 1;
+            atomic_init(&ring->enqueue_pos, 0);
+            atomic_init(&ring->dequeue_pos, 0);
+        } else if (mode == TASK_QUEUE_MODE_DEADLINE) {
+            task_heap_t *heap = &queue->heaps[level];
+            heap->items = (task_t**)malloc(sizeof(task_t*) * capacity);
+            if (!heap->items) {
+                free_levels(queue);
+                free(queue);
+                return NULL;
+            }
+            heap->count = 0;
+        } else {
+            task_ring_t *ring = &queue->levels[level];
+            ring->slots = (task_t**)malloc(sizeof(task_t*) * capacity);
+            if (!ring->slots) {
+                free_levels(queue);
+                free(queue);
+                return NULL;
+            }
+            ring->capacity = capacity;
+            ring->head = 0;
+            ring->count = 0;
+        }
+    }
     
     if (pthread_mutex_init(&queue->mutex, NULL) != 0) {
+        free_levels(queue);
         free(queue);
         return NULL;
     }
     
-    if (pthread_cond_init(&queue->cond, NULL) != 0) {
+    if (event_count_init(&queue->not_empty) != 0) {
         pthread_mutex_destroy(&queue->mutex);
+        free_levels(queue);
+        free(queue);
+        return NULL;
+    }
+    
+    if (event_count_init(&queue->not_full) != 0) {
+        event_count_destroy(&queue->not_empty);
+        pthread_mutex_destroy(&queue->mutex);
+        free_levels(queue);
         free(queue);
         return NULL;
     }
@@ -26,107 +107,453 @@ task_queue_t* task_queue_create(size_t max_size) {
     return queue;
 }
 
+void task_queue_set_aging(task_queue_t *queue, uint64_t aging_us) {
+    if (!queue) return;
+    queue->aging_ns = aging_us * 1000ULL;
+}
+
 void task_queue_destroy(task_queue_t *queue) {
     if (!queue) return;
     
-    pthread_mutex_lock(&queue->mutex);
-    
-    task_node_t *current = queue->head;
-    while (current) {
-        task_node_t *next = current->next;
-        if (current->task) {
-            task_destroy(current->task);
-        }
-        free(current);
-        current = next;
+    task_t *task;
+    while ((task = task_queue_try_dequeue(queue)) != NULL) {
+        task_destroy(task);
     }
     
-    pthread_mutex_unlock(&queue->mutex);
     pthread_mutex_destroy(&queue->mutex);
-    pthread_cond_destroy(&queue->cond);
+    event_count_destroy(&queue->not_empty);
+    event_count_destroy(&queue->not_full);
+    free_levels(queue);
     free(queue);
 }
 
-static task_node_t* create_node(task_t *task) {
-    task_node_t *node = (task_node_t*)malloc(sizeof(task_node_t));
-    if (!node) return NULL;
-    node->task = task;
-    node->next = NULL;
-    return node;
+static void ring_push(task_ring_t *ring, task_t *task) {
+    ring->slots[(ring->head + ring->count) & (ring->capacity - 1)] = task;
+    ring->count++;
 }
 
-static void insert_sorted(task_queue_t *queue, task_node_t *new_node) {
-    if (!queue->head || new_node->task->priority > queue->head->task->priority) {
-        new_node->next = queue->head;
-        queue->head = new_node;
-        return;
+static task_t* ring_pop(task_ring_t *ring) {
+    task_t *task = ring->slots[ring->head];
+    ring->head = (ring->head + 1) & (ring->capacity - 1);
+    ring->count--;
+    return task;
+}
+
+static uint64_t deadline_key(const task_t *task) {
+    return task->deadline_ns ? task->deadline_ns : UINT64_MAX;
+}
+
+static bool runs_before(const task_t *a, const task_t *b) {
+    uint64_t da = deadline_key(a), db = deadline_key(b);
+    return da != db ? da < db : a->timestamp < b->timestamp;
+}
+
+static void heap_sift_down(task_heap_t *heap, size_t i) {
+    for (;;) {
+        size_t first = i;
+        size_t left = 2 * i + 1, right = left + 1;
+        if (left < heap->count && runs_before(heap->items[left], heap->items[first])) first = left;
+        if (right < heap->count && runs_before(heap->items[right], heap->items[first])) first = right;
+        if (first == i) return;
+        
+        task_t *tmp = heap->items[i];
+        heap->items[i] = heap->items[first];
+        heap->items[first] = tmp;
+        i = first;
+    }
+}
+
+static void heap_push(task_heap_t *heap, task_t *task) {
+    size_t i = heap->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!runs_before(task, heap->items[parent])) break;
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i] = task;
+}
+
+static task_t* heap_pop(task_heap_t *heap) {
+    task_t *task = heap->items[0];
+    heap->items[0] = heap->items[--heap->count];
+    heap_sift_down(heap, 0);
+    return task;
+}
+
+// Band a task has earned by waiting, never below its own priority
+static int aged_band(const task_queue_t *queue, const task_t *task, uint64_t now) {
+    uint64_t waited = now > task->timestamp ? now - task->timestamp : 0;
+    uint64_t band = (uint64_t)task->priority + waited / queue->aging_ns;
+    return band >= TASK_PRIORITY_CRITICAL ? TASK_PRIORITY_CRITICAL : (int)band;
+}
+
+// Moves tasks that waited long enough into higher bands. Runs under the
+// queue lock, at most four times per aging period, so a task is promoted
+// no later than a quarter period after it qualifies.
+static void age_tasks(task_queue_t *queue) {
+    if (queue->aging_ns == 0) return;
+    
+    uint64_t now = task_now_ns();
+    if (now < queue->next_aging_ns) return;
+    queue->next_aging_ns = now + queue->aging_ns / 4;
+    
+    // Top down, so a promoted task lands in a band already swept
+    for (int level = TASK_PRIORITY_LEVELS - 2; level >= 0; level--) {
+        task_heap_t *heap = &queue->heaps[level];
+        size_t kept = 0;
+        for (size_t i = 0; i < heap->count; i++) {
+            task_t *task = heap->items[i];
+            int band = aged_band(queue, task, now);
+            if (band > level) {
+                heap_push(&queue->heaps[band], task);
+                queue->nonempty_mask |= 1u << band;
+            } else {
+                heap->items[kept++] = task;
+            }
+        }
+        
+        if (kept != heap->count) {
+            heap->count = kept;
+            for (size_t i = kept / 2; i-- > 0;) {
+                heap_sift_down(heap, i);
+            }
+            if (kept == 0) {
+                queue->nonempty_mask &= ~(1u << level);
+            }
+        }
+    }
+}
+
+// Highest non-empty priority level, or -1 when the queue is empty.
+static int highest_level(const task_queue_t *queue) {
+    for (int level = TASK_PRIORITY_LEVELS - 1; level >= 0; level--) {
+        if (queue->nonempty_mask & (1u << level)) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+static void mpmc_push(task_mpmc_ring_t *ring, task_t *task) {
+    size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    task_cell_t *cell;
+    
+    for (;;) {
+        cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else {
+            // diff < 0: a consumer claimed this cell but has not released it
+            // yet. The size reservation in the caller guarantees it will.
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
     }
     
-    task_node_t *current = queue->head;
-    while (current->next && 
-           current->next->task->priority >= new_node->task->priority) {
-        current = current->next;
+    cell->task = task;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+}
+
+static task_t* mpmc_pop(task_mpmc_ring_t *ring) {
+    size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    task_cell_t *cell;
+    
+    for (;;) {
+        cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return NULL; // Level empty
+        } else {
+            pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+        }
     }
     
-    new_node->next = current->next;
-    current->next = new_node;
+    task_t *task = cell->task;
+    atomic_store_explicit(&cell->sequence, pos + ring->mask + 1, memory_order_release);
+    return task;
+}
+
+static task_t* mpmc_peek(task_mpmc_ring_t *ring) {
+    size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_acquire);
+    task_cell_t *cell = &ring->cells[pos & ring->mask];
+    size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    return (seq == pos + 1) ? cell->task : NULL;
 }
 
 int task_queue_enqueue(task_queue_t *queue, task_t *task) {
     if (!queue || !task) return -1;
+    if ((int)task->priority < 0 || task->priority >= TASK_PRIORITY_LEVELS) return -1;
     
-    pthread_mutex_lock(&queue->mutex);
+    // Stamped before the push: once published a consumer may own the task
+    task->enqueue_ns = task_now_ns();
     
-    if (queue->size >= queue->max_size) {
+    if (queue->mode == TASK_QUEUE_MODE_LOCK_FREE) {
+        // Reserve capacity first; the level ring can then never overflow
+        if (atomic_fetch_add(&queue->size, 1) >= queue->max_size) {
+            atomic_fetch_sub(&queue->size, 1);
+            return -1; // Queue full
+        }
+        mpmc_push(&queue->lf_levels[task->priority], task);
+    } else {
+        pthread_mutex_lock(&queue->mutex);
+        
+        if (atomic_load_explicit(&queue->size, memory_order_relaxed) >= queue->max_size) {
+            pthread_mutex_unlock(&queue->mutex);
+            return -1; // Queue full
+        }
+        
+        if (queue->mode == TASK_QUEUE_MODE_DEADLINE) {
+            heap_push(&queue->heaps[task->priority], task);
+        } else {
+            ring_push(&queue->levels[task->priority], task);
+        }
+        queue->nonempty_mask |= 1u << task->priority;
+        atomic_fetch_add_explicit(&queue->size, 1, memory_order_relaxed);
+        
         pthread_mutex_unlock(&queue->mutex);
-        return -1; // Queue full
     }
     
-    task_node_t *node = create_node(task);
-    if (!node) {
+    event_count_notify_one(&queue->not_empty);
+    return 0;
+}
+
+size_t task_queue_enqueue_batch(task_queue_t *queue, task_t **tasks, size_t count) {
+    if (!queue || !tasks) return 0;
+    
+    // Invalid priorities end the batch early, like a full queue
+    size_t valid = 0;
+    uint64_t now = task_now_ns();
+    while (valid < count && tasks[valid] && (int)tasks[valid]->priority >= 0 &&
+           tasks[valid]->priority < TASK_PRIORITY_LEVELS) {
+        tasks[valid++]->enqueue_ns = now;
+    }
+    if (valid == 0) return 0;
+    
+    size_t enqueued;
+    if (queue->mode == TASK_QUEUE_MODE_LOCK_FREE) {
+        size_t before = atomic_fetch_add(&queue->size, valid);
+        size_t room = before < queue->max_size ? queue->max_size - before : 0;
+        enqueued = valid < room ? valid : room;
+        if (enqueued < valid) {
+            atomic_fetch_sub(&queue->size, valid - enqueued);
+        }
+        for (size_t i = 0; i < enqueued; i++) {
+            mpmc_push(&queue->lf_levels[tasks[i]->priority], tasks[i]);
+        }
+    } else {
+        pthread_mutex_lock(&queue->mutex);
+        
+        size_t size = atomic_load_explicit(&queue->size, memory_order_relaxed);
+        size_t room = size < queue->max_size ? queue->max_size - size : 0;
+        enqueued = valid < room ? valid : room;
+        for (size_t i = 0; i < enqueued; i++) {
+            if (queue->mode == TASK_QUEUE_MODE_DEADLINE) {
+                heap_push(&queue->heaps[tasks[i]->priority], tasks[i]);
+            } else {
+                ring_push(&queue->levels[tasks[i]->priority], tasks[i]);
+            }
+            queue->nonempty_mask |= 1u << tasks[i]->priority;
+        }
+        atomic_fetch_add_explicit(&queue->size, enqueued, memory_order_relaxed);
+        
         pthread_mutex_unlock(&queue->mutex);
-        return -1;
     }
     
-    insert_sorted(queue, node);
-    queue->size++;
-    
-    pthread_cond_signal(&queue->cond);
-    pthread_mutex_unlock(&queue->mutex);
-    
-    return 0;
+    event_count_notify_many(&queue->not_empty, enqueued > INT_MAX ? INT_MAX : (int)enqueued);
+    return enqueued;
 }
 
-task_t* task_queue_dequeue(task_queue_t *queue) {
+task_t* task_queue_try_dequeue(task_queue_t *queue) {
+    return task_queue_try_dequeue_min(queue, TASK_PRIORITY_LOW);
+}
+
+task_t* task_queue_try_dequeue_min(task_queue_t *queue, task_priority_t min_priority) {
     if (!queue) return NULL;
+    if ((int)min_priority < 0) min_priority = TASK_PRIORITY_LOW;
+    
+    if (queue->mode == TASK_QUEUE_MODE_LOCK_FREE) {
+        if (atomic_load_explicit(&queue->size, memory_order_acquire) == 0) {
+            return NULL;
+        }
+        for (int level = TASK_PRIORITY_LEVELS - 1; level >= (int)min_priority; level--) {
+            task_t *task = mpmc_pop(&queue->lf_levels[level]);
+            if (task) {
+                atomic_fetch_sub(&queue->size, 1);
+                event_count_notify_all(&queue->not_full);
+                return task;
+            }
+        }
+        return NULL;
+    }
+    
+    if (atomic_load_explicit(&queue->size, memory_order_relaxed) == 0) {
+        return NULL;
+    }
     
     pthread_mutex_lock(&queue->mutex);
     
-    while (queue->size == 0) {
-        pthread_cond_wait(&queue->cond, &queue->mutex);
+    if (queue->mode == TASK_QUEUE_MODE_DEADLINE) {
+        age_tasks(queue);
     }
     
-    if (!queue->head) {
+    int level = highest_level(queue);
+    if (level < (int)min_priority) {
         pthread_mutex_unlock(&queue->mutex);
         return NULL;
     }
     
-    task_node_t *node = queue->head;
-    queue->head = node->next;
-    queue->size--;
-    
-    task_t *task = node->task;
-    free(node);
+    task_t *task;
+    size_t remaining;
+    if (queue->mode == TASK_QUEUE_MODE_DEADLINE) {
+        task = heap_pop(&queue->heaps[level]);
+        remaining = queue->heaps[level].count;
+    } else {
+        task = ring_pop(&queue->levels[level]);
+        remaining = queue->levels[level].count;
+    }
+    if (remaining == 0) {
+        queue->nonempty_mask &= ~(1u << level);
+    }
+    atomic_fetch_sub_explicit(&queue->size, 1, memory_order_relaxed);
     
     pthread_mutex_unlock(&queue->mutex);
+    
+    // Producers may wait for different limits, so wake them all
+    event_count_notify_all(&queue->not_full);
     return task;
 }
 
+task_t* task_queue_dequeue(task_queue_t *queue) {
+    if (!queue) return NULL;
+    
+    for (;;) {
+        task_t *task = task_queue_try_dequeue(queue);
+        if (task) return task;
+        if (atomic_load(&queue->shutdown)) return NULL;
+        
+        uint32_t key = event_count_prepare(&queue->not_empty);
+        
+        task = task_queue_try_dequeue(queue);
+        if (task) {
+            event_count_cancel(&queue->not_empty);
+            return task;
+        }
+        if (atomic_load(&queue->shutdown)) {
+            event_count_cancel(&queue->not_empty);
+            return NULL;
+        }
+        
+        event_count_wait(&queue->not_empty, key);
+    }
+}
+
+// Blocking dequeue that gives up after timeout_us; NULL on timeout or
+// once shut down and drained
+task_t* task_queue_dequeue_timeout(task_queue_t *queue, uint64_t timeout_us) {
+    if (!queue) return NULL;
+    
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t deadline = (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000 + timeout_us;
+    
+    for (;;) {
+        task_t *task = task_queue_try_dequeue(queue);
+        if (task) return task;
+        if (atomic_load(&queue->shutdown)) return NULL;
+        
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        uint64_t now = (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+        if (now >= deadline) return NULL;
+        
+        uint32_t key = event_count_prepare(&queue->not_empty);
+        
+        task = task_queue_try_dequeue(queue);
+        if (task) {
+            event_count_cancel(&queue->not_empty);
+            return task;
+        }
+        if (atomic_load(&queue->shutdown)) {
+            event_count_cancel(&queue->not_empty);
+            return NULL;
+        }
+        
+        event_count_wait_timeout(&queue->not_empty, key, (deadline - now) * 1000ULL);
+    }
+}
+
+bool task_queue_wait_for_room(task_queue_t *queue, size_t limit, uint64_t timeout_us) {
+    if (!queue) return false;
+    
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t deadline = (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000 + timeout_us;
+    
+    for (;;) {
+        if (atomic_load(&queue->size) < limit) return true;
+        if (atomic_load(&queue->shutdown)) return false;
+        
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        uint64_t now = (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+        if (now >= deadline) return false;
+        
+        uint32_t key = event_count_prepare(&queue->not_full);
+        
+        if (atomic_load(&queue->size) < limit) {
+            event_count_cancel(&queue->not_full);
+            return true;
+        }
+        if (atomic_load(&queue->shutdown)) {
+            event_count_cancel(&queue->not_full);
+            return false;
+        }
+        
+        event_count_wait_timeout(&queue->not_full, key, (deadline - now) * 1000ULL);
+    }
+}
+
+void task_queue_shutdown(task_queue_t *queue) {
+    if (!queue) return;
+    
+    atomic_store(&queue->shutdown, true);
+    event_count_notify_all(&queue->not_empty);
+    event_count_notify_all(&queue->not_full);
+}
+
 task_t* task_queue_peek(task_queue_t *queue) {
     if (!queue) return NULL;
     
+    if (queue->mode == TASK_QUEUE_MODE_LOCK_FREE) {
+        for (int level = TASK_PRIORITY_LEVELS - 1; level >= 0; level--) {
+            task_t *task = mpmc_peek(&queue->lf_levels[level]);
+            if (task) return task;
+        }
+        return NULL;
+    }
+    
     pthread_mutex_lock(&queue->mutex);
-    task_t *task = queue->head ? queue->head->task : NULL;
+    int level = highest_level(queue);
+    task_t *task = NULL;
+    if (level >= 0 && queue->mode == TASK_QUEUE_MODE_DEADLINE) {
+        task = queue->heaps[level].items[0];
+    } else if (level >= 0) {
+        const task_ring_t *ring = &queue->levels[level];
+        task = ring->slots[ring->head];
+    }
     pthread_mutex_unlock(&queue->mutex);
     
     return task;
@@ -134,32 +561,50 @@ task_t* task_queue_peek(task_queue_t *queue) {
 
 bool task_queue_is_empty(task_queue_t *queue) {
     if (!queue) return true;
-    
-    pthread_mutex_lock(&queue->mutex);
-    bool empty = (queue->size == 0);
-    pthread_mutex_unlock(&queue->mutex);
-    
-    return empty;
+    return atomic_load_explicit(&queue->size, memory_order_relaxed) == 0;
 }
 
 bool task_queue_is_full(task_queue_t *queue) {
     if (!queue) return false;
-    
-    pthread_mutex_lock(&queue->mutex);
-    bool full = (queue->size >= queue->max_size);
-    pthread_mutex_unlock(&queue->mutex);
-    
-    return full;
+    return atomic_load_explicit(&queue->size, memory_order_relaxed) >= queue->max_size;
 }
 
 size_t task_queue_size(task_queue_t *queue) {
     if (!queue) return 0;
+    return atomic_load_explicit(&queue->size, memory_order_relaxed);
+}
+
+void task_queue_level_sizes(task_queue_t *queue, size_t sizes[TASK_PRIORITY_LEVELS]) {
+    if (!sizes) return;
+    
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        sizes[level] = 0;
+    }
+    if (!queue) return;
+    
+    if (queue->mode == TASK_QUEUE_MODE_LOCK_FREE) {
+        // Cursors move independently; a racing pop can briefly overtake
+        for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+            const task_mpmc_ring_t *ring = &queue->lf_levels[level];
+            size_t dequeued = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+            size_t enqueued = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+            sizes[level] = enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+        return;
+    }
     
     pthread_mutex_lock(&queue->mutex);
-    size_t size = queue->size;
+    for (int level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        sizes[level] = (queue->mode == TASK_QUEUE_MODE_DEADLINE)
+                     ? queue->heaps[level].count : queue->levels[level].count;
+    }
     pthread_mutex_unlock(&queue->mutex);
-    
-    return size;
+}
+
+uint64_t task_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 }
 
 task_t* task_create(const char *task_id, task_priority_t priority,
@@ -171,30 +616,125 @@ task_t* task_create(const char *task_id, task_priority_t priority,
     task_t *task = (task_t*)malloc(sizeof(task_t));
     if (!task) return NULL;
     
+    task->slab = NULL;
+    task_init(task, task_id, priority, data, data_size,
+              execute_callback, cleanup_callback);
+    
+    return task;
+}
+
+void task_init(task_t *task, const char *task_id, task_priority_t priority,
+               void *data, size_t data_size,
+               int (*execute_callback)(void *),
+               void (*cleanup_callback)(void *)) {
     strncpy(task->task_id, task_id, MAX_TASK_ID_LEN - 1);
     task->task_id[MAX_TASK_ID_LEN - 1] = '\0';
     task->priority = priority;
     task->status = TASK_STATUS_PENDING;
+    task->error = 0;
     task->data = data;
     task->data_size = data_size;
     task->execute_callback = execute_callback;
     task->cleanup_callback = cleanup_callback;
-    task->timestamp = (uint64_t)time(NULL);
-    
-    return task;
+    task->data_free = free;
+    task->done_callback = NULL;
+    task->done_ctx = NULL;
+    task->batch_callback = NULL;
+    task->batch_key = 0;
+    task->model_id = 0;
+    task->future = NULL;
+    task->timeout_ns = 0;
+    atomic_init(&task->cancel, 0);
+    atomic_init(&task->backend_worker, -1);
+    task->timer.armed = false;
+    task->index = NULL;
+    task->index_next = NULL;
+    task->cache_entry = NULL;
+    task->dependents = NULL;
+    task->num_dependents = 0;
+    task->num_parents = 0;
+    atomic_init(&task->pending_parents, 0);
+    task->output_to = NULL;
+    task->output = NULL;
+    task->output_size = 0;
+    task->release_callback = NULL;
+    task->release_ctx = NULL;
+    task->journal = NULL;
+    task->journal_segment = NULL;
+    task->journal_id = 0;
+    task->memory_bytes = 0;
+    task->memory_budget = NULL;
+    task->next = NULL;
+    task->timestamp = task_now_ns();
+    task->deadline_ns = 0;
+    task->enqueue_ns = 0;
+    task->dequeue_ns = 0;
+    task->start_ns = 0;
+    task->end_ns = 0;
 }
 
 void task_destroy(task_t *task) {
     if (!task) return;
     
+    // First, so cancellation can no longer reach it
+    if (task->index) {
+        task_index_remove(task);
+    }
+    
+    // Finished for good, whatever the outcome, unless checkpointed (see
+    // task_journal_complete()); a replay would run it again
+    if (task->journal) {
+        task_journal_complete(task);
+    }
+    
     if (task->cleanup_callback && task->data) {
         task->cleanup_callback(task->data);
     }
     
-    if (task->data) {
-        free(task->data);
+    if (task->data_free && task->data) {
+        task->data_free(task->data);
+    }
+    
+    // Its memory is given back; parked tasks may start
+    if (task->memory_budget) {
+        memory_budget_release(task);
+    }
+    
+    // Tasks that waited on this one finish with it
+    if (task->cache_entry) {
+        result_cache_complete(task);
+    }
+    
+    // Dependents waiting on it go on, or are cancelled if it did not complete
+    if (task->dependents) {
+        task_graph_release(task);
     }
     
-    free(task);
+    if (task->done_callback) {
+        task->done_callback(task, task->done_ctx);
+    }
+    
+    if (task->future) {
+        task_future_complete(task->future, task);
+        task->future = NULL;
+    }
+    
+    if (task->slab) {
+        task_slab_free(task->slab, task);
+    } else {
+        free(task);
+    }
+}
+
+bool task_cancel(task_t *task, int reason) {
+    if (!task) return false;
+    
+    int expected = 0;
+    return atomic_compare_exchange_strong_explicit(&task->cancel, &expected, reason,
+                                                   memory_order_relaxed, memory_order_relaxed);
+}
+
+int task_cancelled(const task_t *task) {
+    return task ? atomic_load_explicit(&task->cancel, memory_order_relaxed) : 0;
 }
 
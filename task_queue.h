@@ -1,12 +1,17 @@
 #ifndef TASK_QUEUE_H
 #define TASK_QUEUE_H
 
+#include "event_count.h"
+#include "timer_wheel.h"
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #define MAX_TASK_ID_LEN 64
 #define MAX_TASK_DATA_SIZE 4096
+#define CACHE_LINE_SIZE 64
 
 typedef enum {
     TASK_PRIORITY_LOW = 0,
@@ -19,49 +24,187 @@ typedef enum {
     TASK_STATUS_PENDING,
     TASK_STATUS_RUNNING,
     TASK_STATUS_COMPLETED,
-    TASK_STATUS_FAILED
+    TASK_STATUS_FAILED,
+    TASK_STATUS_EXPIRED,    // deadline passed before dispatch, never ran
+    TASK_STATUS_CANCELLED   // cancelled or out of time; error is ECANCELED or ETIMEDOUT
 } task_status_t;
 
-typedef struct {
+struct task_slab;
+struct task_future;
+struct task_index;
+struct result_cache_entry;
+struct task_journal;
+struct task_journal_segment;
+struct memory_budget;
+
+typedef struct task task_t;
+
+// Called from task_destroy() once the task is finished with its data
+typedef void (*task_done_callback_t)(const task_t *task, void *ctx);
+
+// Hands over a dependent whose parents have all finished (see
+// task_graph.h); chain is true when it was its parent's only dependent and
+// had no other parent
+typedef void (*task_release_callback_t)(task_t *task, bool chain, void *ctx);
+
+// Runs several compatible tasks as one unit; sets each task's status and
+// returns 0 if the batch as a whole ran
+typedef int (*task_batch_callback_t)(task_t **tasks, size_t count);
+
+struct task {
     char task_id[MAX_TASK_ID_LEN];
     task_priority_t priority;
     task_status_t status;
+    int error;                          // errno-style reason a callback may give for failing
     void *data;
     size_t data_size;
-    uint64_t timestamp;
+    uint64_t timestamp;                 // task_now_ns() at creation (submit)
+    uint64_t deadline_ns;               // task_now_ns() time to finish by, 0 = none
+    uint64_t enqueue_ns;                // lifecycle times, task_now_ns(); 0 until reached
+    uint64_t dequeue_ns;
+    uint64_t start_ns;
+    uint64_t end_ns;
     int (*execute_callback)(void *data);
     void (*cleanup_callback)(void *data);
-} task_t;
+    void (*data_free)(void *data);      // releases data; NULL if not owned
+    task_done_callback_t done_callback; // optional, runs after data_free
+    void *done_ctx;
+    task_batch_callback_t batch_callback;   // NULL: never batched
+    uint64_t batch_key;                 // tasks batch only with equal keys
+    uint32_t model_id;                  // owner's model table index, 0 = default model
+    struct task_slab *slab;             // owning slab, NULL for malloc'd tasks
+    struct task_future *future;         // completed by task_destroy(), NULL if none
+    uint64_t timeout_ns;                // execution budget once running, 0 = none
+    _Atomic int cancel;                 // 0 until cancelled, then ECANCELED or ETIMEDOUT
+    _Atomic int backend_worker;         // out-of-process worker running it, -1 if none
+    timer_wheel_entry_t timer;          // armed while running with a timeout
+    struct task_index *index;           // set while findable by id, see task_index.h
+    struct task *index_next;
+    struct result_cache_entry *cache_entry;  // set while identical tasks may wait on it
+    struct task **dependents;           // released once this task is destroyed, see task_graph.h
+    uint32_t num_dependents;
+    uint32_t num_parents;
+    _Atomic uint32_t pending_parents;   // parents not yet finished; released at zero
+    struct task *output_to;             // dependent whose data is this task's output
+    void *output;                       // malloc'd, moved to output_to
+    size_t output_size;
+    task_release_callback_t release_callback;  // queues this task once its parents finish
+    void *release_ctx;
+    struct task_journal *journal;       // set while recorded as unfinished, see task_journal.h
+    struct task_journal_segment *journal_segment;
+    uint64_t journal_id;
+    uint64_t memory_bytes;              // estimated peak memory while running, 0 = not tracked
+    struct memory_budget *memory_budget;  // set while holding a reservation, see memory_budget.h
+    struct task *next;                  // intrusive link for free lists
+};
+
+#define TASK_PRIORITY_LEVELS 4
+
+// Fixed-capacity FIFO ring holding the tasks of a single priority level.
+// Capacity is a power of two so wrap-around is a mask, not a modulo.
+typedef struct {
+    task_t **slots;
+    size_t capacity;
+    size_t head;
+    size_t count;
+} task_ring_t;
 
-typedef struct task_node {
+// Binary min-heap of one priority band, earliest deadline on top. Tasks
+// without a deadline sort after those with one, oldest first.
+typedef struct {
+    task_t **items;
+    size_t count;
+} task_heap_t;
+
+typedef enum {
+    TASK_QUEUE_MODE_LOCKED = 0,     // mutex-protected rings
+    TASK_QUEUE_MODE_LOCK_FREE = 1,  // bounded MPMC rings, no queue lock
+    TASK_QUEUE_MODE_DEADLINE = 2    // mutex-protected EDF heaps with priority aging
+} task_queue_mode_t;
+
+typedef struct {
+    _Atomic size_t sequence;
     task_t *task;
-    struct task_node *next;
-} task_node_t;
+} task_cell_t;
+
+// Bounded multi-producer/multi-consumer ring for one priority level.
+// Each cell carries a sequence number telling producers and consumers
+// whether it is free for the current lap; the two cursors sit on
+// separate cache lines so producers and consumers do not share one.
+typedef struct {
+    task_cell_t *cells;
+    size_t mask;
+    char pad0[CACHE_LINE_SIZE];
+    _Atomic size_t enqueue_pos;
+    char pad1[CACHE_LINE_SIZE - sizeof(size_t)];
+    _Atomic size_t dequeue_pos;
+    char pad2[CACHE_LINE_SIZE - sizeof(size_t)];
+} task_mpmc_ring_t;
 
 typedef struct {
-    task_node_t *head;
+    task_queue_mode_t mode;
+    task_ring_t levels[TASK_PRIORITY_LEVELS];          // locked mode
+    task_mpmc_ring_t lf_levels[TASK_PRIORITY_LEVELS];  // lock-free mode
+    task_heap_t heaps[TASK_PRIORITY_LEVELS];           // deadline mode
+    uint64_t aging_ns;         // deadline mode: wait that lifts a task one band, 0 = never
+    uint64_t next_aging_ns;    // deadline mode: time of the next aging sweep
+    uint32_t nonempty_mask;    // bit N set when levels[N] (or heaps[N]) holds tasks
     pthread_mutex_t mutex;
-    pthread_cond_t cond;
-    size_t size;
+    event_count_t not_empty;   // idle consumers park here
+    event_count_t not_full;    // producers waiting for room park here
+    _Atomic size_t size;
+    _Atomic bool shutdown;
     size_t max_size;
 } task_queue_t;
 
 // Queue operations
 task_queue_t* task_queue_create(size_t max_size);
+task_queue_t* task_queue_create_ex(size_t max_size, task_queue_mode_t mode);
 void task_queue_destroy(task_queue_t *queue);
+// Deadline mode: a task waiting aging_us moves up one priority band, up to
+// CRITICAL. Call before the queue is shared.
+void task_queue_set_aging(task_queue_t *queue, uint64_t aging_us);
 int task_queue_enqueue(task_queue_t *queue, task_t *task);
+// Enqueues tasks in order under a single lock acquisition (one capacity
+// reservation in lock-free mode) and wakes one consumer per task. Stops at
+// the first task that does not fit; returns how many were enqueued.
+size_t task_queue_enqueue_batch(task_queue_t *queue, task_t **tasks, size_t count);
 task_t* task_queue_dequeue(task_queue_t *queue);
+task_t* task_queue_dequeue_timeout(task_queue_t *queue, uint64_t timeout_us);
+task_t* task_queue_try_dequeue(task_queue_t *queue);
+task_t* task_queue_try_dequeue_min(task_queue_t *queue, task_priority_t min_priority);
+// Blocks until fewer than limit tasks are queued; false on timeout or
+// shutdown. Room may be taken by another producer before the caller
+// enqueues, so callers re-check.
+bool task_queue_wait_for_room(task_queue_t *queue, size_t limit, uint64_t timeout_us);
+void task_queue_shutdown(task_queue_t *queue);
 task_t* task_queue_peek(task_queue_t *queue);
 bool task_queue_is_empty(task_queue_t *queue);
 bool task_queue_is_full(task_queue_t *queue);
 size_t task_queue_size(task_queue_t *queue);
+// Tasks queued at each priority, for monitoring. Locked and deadline modes
+// take the queue lock; lock-free mode reads the ring cursors.
+void task_queue_level_sizes(task_queue_t *queue, size_t sizes[TASK_PRIORITY_LEVELS]);
+
+// CLOCK_MONOTONIC in nanoseconds, the clock of timestamp and deadline_ns
+uint64_t task_now_ns(void);
 
 // Task operations
 task_t* task_create(const char *task_id, task_priority_t priority, 
                     void *data, size_t data_size,
                     int (*execute_callback)(void *),
                     void (*cleanup_callback)(void *));
+void task_init(task_t *task, const char *task_id, task_priority_t priority,
+               void *data, size_t data_size,
+               int (*execute_callback)(void *),
+               void (*cleanup_callback)(void *));
 void task_destroy(task_t *task);
+// Asks the task to stop, reason being ECANCELED or ETIMEDOUT. A queued
+// task is dropped when dequeued; a running one sees it through
+// task_cancelled(). false if it was cancelled already.
+bool task_cancel(task_t *task, int reason);
+// 0, or the reason the task was cancelled; long-running callbacks poll it
+int task_cancelled(const task_t *task);
 
 #endif // TASK_QUEUE_H
 
@@ -0,0 +1,595 @@
+#define _GNU_SOURCE
+#include "task_server.h"
+#include "listen_socket.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define IN_CAPACITY (2 * (TASK_SERVER_MAX_FRAME + 4))
+#define OUT_CAPACITY ((TASK_SERVER_MAX_INFLIGHT + 1) * (TASK_SERVER_RESPONSE_HEADER + MAX_TASK_ID_LEN))
+#define EPOLL_EVENTS 64
+
+typedef struct {
+    uint8_t status;
+    uint8_t id_length;
+    char id[MAX_TASK_ID_LEN];
+} task_completion_t;
+
+struct task_conn {
+    task_server_t *server;
+    int fd;                         // -1 once closed; freed when nothing is in flight
+    uint32_t events;                // registered with epoll
+    uint8_t in[IN_CAPACITY];
+    size_t in_length;
+    size_t in_parsed;               // bytes already turned into batch entries
+    uint8_t out[OUT_CAPACITY];
+    size_t out_length;
+    size_t out_sent;
+    size_t inflight;                // requests whose response is not in out yet; loop thread only
+    bool eof;                       // client sent its last request
+    bool broken;                    // protocol error: close once out is sent
+    bool on_done_list;              // guarded by server->done_mutex
+    task_completion_t done[TASK_SERVER_MAX_INFLIGHT];  // ring, guarded by done_mutex
+    size_t done_head;
+    size_t done_count;
+    task_conn_t *next_done;
+    task_conn_t *prev;
+    task_conn_t *next;
+};
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void write_le32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static void bump(_Atomic uint64_t *counter, uint64_t delta) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + delta,
+                          memory_order_relaxed);
+}
+
+static void wake(task_server_t *server) {
+    uint64_t one = 1;
+    ssize_t written;
+    do {
+        written = write(server->event_fd, &one, sizeof(one));
+    } while (written < 0 && errno == EINTR);
+}
+
+// Queues a response for conn; true if the server had nothing pending, so
+// the loop needs a wakeup
+static bool push_completion(task_conn_t *conn, task_server_status_t status, const char *id) {
+    task_server_t *server = conn->server;
+    size_t id_length = strnlen(id, MAX_TASK_ID_LEN - 1);
+    
+    pthread_mutex_lock(&server->done_mutex);
+    // Never full: every entry is an in-flight request, and those are capped
+    task_completion_t *completion = &conn->done[(conn->done_head + conn->done_count) %
+                                                TASK_SERVER_MAX_INFLIGHT];
+    conn->done_count++;
+    completion->status = (uint8_t)status;
+    completion->id_length = (uint8_t)id_length;
+    memcpy(completion->id, id, id_length);
+    
+    bool was_idle = (server->done_list == NULL);
+    if (!conn->on_done_list) {
+        conn->on_done_list = true;
+        conn->next_done = server->done_list;
+        server->done_list = conn;
+    } else {
+        was_idle = false;
+    }
+    pthread_mutex_unlock(&server->done_mutex);
+    
+    return was_idle;
+}
+
+// Worker thread: the task is finished with its data
+static void on_task_done(const task_t *task, void *ctx) {
+    task_conn_t *conn = (task_conn_t*)ctx;
+    task_server_status_t status = task->status == TASK_STATUS_COMPLETED ? TASK_SERVER_COMPLETED :
+                                  task->status == TASK_STATUS_EXPIRED ? TASK_SERVER_EXPIRED :
+                                  TASK_SERVER_FAILED;
+    
+    // The loop may free conn as soon as the completion is in its ring
+    task_server_t *server = conn->server;
+    if (push_completion(conn, status, task->task_id)) {
+        wake(server);
+    }
+}
+
+static void set_events(task_conn_t *conn, uint32_t events) {
+    if (conn->fd < 0 || conn->events == events) return;
+    
+    struct epoll_event event = { .events = events, .data.ptr = conn };
+    epoll_ctl(conn->server->epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+    conn->events = events;
+}
+
+// Reads while fewer than TASK_SERVER_MAX_INFLIGHT requests are open and
+// writes while output is pending
+static void update_events(task_conn_t *conn) {
+    uint32_t events = 0;
+    if (!conn->eof && !conn->broken && conn->inflight < TASK_SERVER_MAX_INFLIGHT) events |= EPOLLIN;
+    if (conn->out_sent < conn->out_length) events |= EPOLLOUT;
+    set_events(conn, events);
+}
+
+static void free_conn(task_conn_t *conn) {
+    task_server_t *server = conn->server;
+    if (conn->prev) {
+        conn->prev->next = conn->next;
+    } else {
+        server->connections = conn->next;
+    }
+    if (conn->next) conn->next->prev = conn->prev;
+    free(conn);
+}
+
+// Frees conn at once if no task holds it, otherwise when the last
+// completion comes back. Returns true if conn is gone.
+static bool close_conn(task_conn_t *conn) {
+    if (conn->fd >= 0) {
+        epoll_ctl(conn->server->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    
+    bool idle;
+    pthread_mutex_lock(&conn->server->done_mutex);
+    idle = conn->inflight == 0 && !conn->on_done_list;
+    pthread_mutex_unlock(&conn->server->done_mutex);
+    
+    if (idle) free_conn(conn);
+    return idle;
+}
+
+// Returns true if conn was closed and freed
+static bool flush_output(task_conn_t *conn) {
+    while (conn->fd >= 0 && conn->out_sent < conn->out_length) {
+        ssize_t sent = send(conn->fd, conn->out + conn->out_sent, conn->out_length - conn->out_sent,
+                            MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return close_conn(conn);
+        }
+        conn->out_sent += (size_t)sent;
+    }
+    
+    if (conn->out_sent == conn->out_length) {
+        conn->out_sent = conn->out_length = 0;
+        // A half-closed client still gets every response before we hang up
+        if (conn->broken || (conn->eof && conn->inflight == 0)) return close_conn(conn);
+    } else if (conn->out_sent > 0 && conn->out_length - conn->out_sent < OUT_CAPACITY / 2) {
+        memmove(conn->out, conn->out + conn->out_sent, conn->out_length - conn->out_sent);
+        conn->out_length -= conn->out_sent;
+        conn->out_sent = 0;
+    }
+    if (conn->fd < 0) return close_conn(conn);
+    
+    update_events(conn);
+    return false;
+}
+
+static void append_response(task_conn_t *conn, uint8_t status, const char *id, size_t id_length) {
+    uint8_t *frame = conn->out + conn->out_length;
+    write_le32(frame, (uint32_t)(TASK_SERVER_RESPONSE_HEADER - 4 + id_length));
+    frame[4] = status;
+    frame[5] = (uint8_t)id_length;
+    frame[6] = 0;
+    frame[7] = 0;
+    memcpy(frame + TASK_SERVER_RESPONSE_HEADER, id, id_length);
+    conn->out_length += TASK_SERVER_RESPONSE_HEADER + id_length;
+}
+
+// Moves conn's completions into its output buffer as far as there is room
+static size_t collect_completions(task_conn_t *conn) {
+    task_server_t *server = conn->server;
+    size_t moved = 0;
+    
+    pthread_mutex_lock(&server->done_mutex);
+    while (conn->done_count > 0 &&
+           conn->out_length + TASK_SERVER_RESPONSE_HEADER + MAX_TASK_ID_LEN <= OUT_CAPACITY) {
+        const task_completion_t *completion = &conn->done[conn->done_head];
+        if (conn->fd >= 0) {
+            append_response(conn, completion->status, completion->id, completion->id_length);
+        }
+        conn->done_head = (conn->done_head + 1) % TASK_SERVER_MAX_INFLIGHT;
+        conn->done_count--;
+        moved++;
+    }
+    conn->inflight -= moved;
+    pthread_mutex_unlock(&server->done_mutex);
+    
+    return moved;
+}
+
+static void parse_frames(task_conn_t *conn);
+
+// Returns true if conn was freed
+static bool deliver(task_conn_t *conn) {
+    collect_completions(conn);
+    // Frames left unparsed at the in-flight cap get no new EPOLLIN
+    parse_frames(conn);
+    return flush_output(conn);
+}
+
+static void drain_completions(task_server_t *server) {
+    pthread_mutex_lock(&server->done_mutex);
+    task_conn_t *conn = server->done_list;
+    server->done_list = NULL;
+    pthread_mutex_unlock(&server->done_mutex);
+    
+    // Detached connections keep on_done_list set, so workers leave their
+    // next_done links alone until each one is taken off below
+    while (conn) {
+        pthread_mutex_lock(&server->done_mutex);
+        task_conn_t *next = conn->next_done;
+        conn->on_done_list = false;
+        pthread_mutex_unlock(&server->done_mutex);
+        
+        deliver(conn);
+        conn = next;
+    }
+}
+
+static bool completions_pending(task_server_t *server) {
+    pthread_mutex_lock(&server->done_mutex);
+    bool pending = server->done_list != NULL;
+    pthread_mutex_unlock(&server->done_mutex);
+    return pending;
+}
+
+// Hands everything parsed so far to the orchestrator in one call, then
+// compacts the read buffers the batch pointed into
+static void submit_batch(task_server_t *server) {
+    size_t count = server->batch_count;
+    if (count == 0) return;
+    
+    int results[TASK_SERVER_BATCH];
+    orchestrator_submit_batch(server->orch, server->batch, count, server->arena, results);
+    bump(&server->batches, 1);
+    
+    for (size_t i = 0; i < count; i++) {
+        task_conn_t *conn = server->batch_conns[i];
+        if (results[i] != 0) {
+            bump(&server->rejected, 1);
+            push_completion(conn, TASK_SERVER_REJECTED, server->batch_ids[i]);
+        }
+        if (conn->in_parsed > 0) {
+            memmove(conn->in, conn->in + conn->in_parsed, conn->in_length - conn->in_parsed);
+            conn->in_length -= conn->in_parsed;
+            conn->in_parsed = 0;
+        }
+    }
+    server->batch_count = 0;
+}
+
+static void reject_malformed(task_conn_t *conn) {
+    bump(&conn->server->malformed, 1);
+    conn->broken = true;
+    if (conn->out_length + TASK_SERVER_RESPONSE_HEADER <= OUT_CAPACITY) {
+        append_response(conn, TASK_SERVER_MALFORMED, "", 0);
+    }
+}
+
+static void parse_frames(task_conn_t *conn) {
+    task_server_t *server = conn->server;
+    
+    while (conn->fd >= 0 && !conn->broken && conn->inflight < TASK_SERVER_MAX_INFLIGHT) {
+        if (server->batch_count == TASK_SERVER_BATCH) {
+            submit_batch(server);
+        }
+        
+        size_t available = conn->in_length - conn->in_parsed;
+        if (available < 4) break;
+        
+        const uint8_t *frame = conn->in + conn->in_parsed;
+        uint32_t length = read_le32(frame);
+        if (length < TASK_SERVER_REQUEST_HEADER - 4 || length > TASK_SERVER_MAX_FRAME) {
+            reject_malformed(conn);
+            break;
+        }
+        if (available < 4 + (size_t)length) break;
+        
+        uint8_t priority = frame[4];
+        uint8_t id_length = frame[5];
+        if (priority >= TASK_PRIORITY_LEVELS || id_length == 0 || id_length >= MAX_TASK_ID_LEN ||
+            TASK_SERVER_REQUEST_HEADER - 4 + (size_t)id_length > length) {
+            reject_malformed(conn);
+            break;
+        }
+        uint32_t deadline_ms = read_le32(frame + 12);
+        
+        size_t index = server->batch_count++;
+        char *id = server->batch_ids[index];
+        memcpy(id, frame + TASK_SERVER_REQUEST_HEADER, id_length);
+        id[id_length] = '\0';
+        
+        size_t header = TASK_SERVER_REQUEST_HEADER + id_length;
+        task_submission_t *submission = &server->batch[index];
+        submission->task_id = id;
+        submission->priority = (task_priority_t)priority;
+        submission->model_id = read_le32(frame + 8);
+        submission->data = frame + header;
+        submission->data_size = 4 + (size_t)length - header;
+        submission->deadline_ns = deadline_ms ? task_now_ns() + (uint64_t)deadline_ms * 1000000ULL : 0;
+        submission->timeout_ns = 0;
+        submission->on_done = on_task_done;
+        submission->done_ctx = conn;
+        server->batch_conns[index] = conn;
+        
+        conn->inflight++;
+        conn->in_parsed += 4 + (size_t)length;
+        bump(&server->requests, 1);
+    }
+    
+    update_events(conn);
+}
+
+// Returns true if conn was freed
+static bool read_conn(task_conn_t *conn) {
+    if (conn->in_length == IN_CAPACITY) return false;  // paused at the in-flight cap
+    
+    ssize_t got;
+    do {
+        got = recv(conn->fd, conn->in + conn->in_length, IN_CAPACITY - conn->in_length, 0);
+    } while (got < 0 && errno == EINTR);
+    
+    if (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        return close_conn(conn);
+    }
+    if (got == 0) {
+        conn->eof = true;
+        return flush_output(conn);
+    }
+    if (got > 0) {
+        conn->in_length += (size_t)got;
+        parse_frames(conn);
+    }
+    return false;
+}
+
+static void accept_connections(task_server_t *server, int listen_fd) {
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        
+        // Fails harmlessly on UNIX sockets
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        
+        task_conn_t *conn = (task_conn_t*)malloc(sizeof(task_conn_t));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->server = server;
+        conn->fd = fd;
+        conn->events = EPOLLIN;
+        conn->in_length = conn->in_parsed = 0;
+        conn->out_length = conn->out_sent = 0;
+        conn->inflight = 0;
+        conn->eof = false;
+        conn->broken = false;
+        conn->on_done_list = false;
+        conn->done_head = conn->done_count = 0;
+        conn->next_done = NULL;
+        
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = conn };
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+        
+        conn->prev = NULL;
+        conn->next = server->connections;
+        if (conn->next) conn->next->prev = conn;
+        server->connections = conn;
+        bump(&server->accepted_connections, 1);
+    }
+}
+
+static void* server_thread(void *arg) {
+    task_server_t *server = (task_server_t*)arg;
+    struct epoll_event events[EPOLL_EVENTS];
+    
+    while (!atomic_load(&server->stopping)) {
+        int count = epoll_wait(server->epoll_fd, events, EPOLL_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            void *source = events[i].data.ptr;
+            if (source == &server->event_fd) {
+                // Nonblocking: completions are picked up below either way
+                uint64_t value;
+                ssize_t drained = read(server->event_fd, &value, sizeof(value));
+                (void)drained;
+            } else if (source == &server->listen_fds[0] || source == &server->listen_fds[1]) {
+                accept_connections(server, *(int*)source);
+            } else {
+                task_conn_t *conn = (task_conn_t*)source;
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    // Nobody left to answer; tasks already queued still run
+                    close_conn(conn);
+                    continue;
+                }
+                if ((events[i].events & EPOLLOUT) && flush_output(conn)) continue;
+                if (conn->fd >= 0 && (events[i].events & EPOLLIN)) {
+                    read_conn(conn);
+                }
+            }
+        }
+        
+        // One admission pass for everything that arrived in this round.
+        // Delivering completions parses frames held at the in-flight cap and
+        // rejections complete at once, and neither brings another wakeup.
+        do {
+            submit_batch(server);
+            drain_completions(server);
+        } while (server->batch_count > 0 || completions_pending(server));
+    }
+    
+    return NULL;
+}
+
+static int watch(task_server_t *server, int fd, void *tag) {
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = tag };
+    return epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+static void close_listeners(task_server_t *server) {
+    for (int i = 0; i < 2; i++) {
+        if (server->listen_fds[i] >= 0) {
+            close(server->listen_fds[i]);
+            server->listen_fds[i] = -1;
+        }
+    }
+    if (server->socket_path[0]) {
+        unlink(server->socket_path);
+        server->socket_path[0] = '\0';
+    }
+}
+
+task_server_t* task_server_create(orchestrator_t *orch, const char *socket_path,
+                                  uint16_t tcp_port) {
+    bool use_unix = socket_path && socket_path[0];
+    if (!orch || (!use_unix && tcp_port == 0)) return NULL;
+    if (use_unix && strlen(socket_path) >= TASK_SERVER_SOCKET_PATH_MAX) return NULL;
+    
+    task_server_t *server = (task_server_t*)calloc(1, sizeof(task_server_t));
+    if (!server) return NULL;
+    
+    server->orch = orch;
+    server->listen_fds[0] = server->listen_fds[1] = -1;
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    server->arena = payload_arena_create(PAYLOAD_ARENA_DEFAULT_BLOCK_SIZE);
+    atomic_init(&server->stopping, false);
+    
+    bool ok = server->epoll_fd >= 0 && server->event_fd >= 0 && server->arena &&
+              pthread_mutex_init(&server->done_mutex, NULL) == 0;
+    if (ok && use_unix) {
+        server->listen_fds[0] = listen_socket_unix(socket_path);
+        ok = server->listen_fds[0] >= 0;
+        if (ok) strcpy(server->socket_path, socket_path);
+    }
+    if (ok && tcp_port != 0) {
+        server->listen_fds[1] = listen_socket_tcp_loopback(tcp_port);
+        ok = server->listen_fds[1] >= 0;
+    }
+    
+    for (int i = 0; ok && i < 2; i++) {
+        if (server->listen_fds[i] >= 0) {
+            fcntl(server->listen_fds[i], F_SETFL, O_NONBLOCK);
+            ok = watch(server, server->listen_fds[i], &server->listen_fds[i]) == 0;
+        }
+    }
+    ok = ok && watch(server, server->event_fd, &server->event_fd) == 0;
+    ok = ok && pthread_create(&server->thread, NULL, server_thread, server) == 0;
+    
+    if (!ok) {
+        close_listeners(server);
+        if (server->epoll_fd >= 0) close(server->epoll_fd);
+        if (server->event_fd >= 0) close(server->event_fd);
+        payload_arena_destroy(server->arena);
+        free(server);
+        return NULL;
+    }
+    
+    server->running = true;
+    return server;
+}
+
+void task_server_stop(task_server_t *server) {
+    if (!server || !server->running) return;
+    
+    atomic_store(&server->stopping, true);
+    wake(server);
+    pthread_join(server->thread, NULL);
+    server->running = false;
+    
+    close_listeners(server);
+    for (task_conn_t *conn = server->connections; conn; conn = conn->next) {
+        if (conn->fd >= 0) {
+            close(conn->fd);
+            conn->fd = -1;
+        }
+    }
+}
+
+void task_server_destroy(task_server_t *server) {
+    if (!server) return;
+    
+    task_server_stop(server);
+    
+    task_conn_t *conn = server->connections;
+    while (conn) {
+        task_conn_t *next = conn->next;
+        free(conn);
+        conn = next;
+    }
+    
+    close(server->epoll_fd);
+    close(server->event_fd);
+    pthread_mutex_destroy(&server->done_mutex);
+    payload_arena_destroy(server->arena);
+    free(server);
+}
+
+#else
+
+task_server_t* task_server_create(orchestrator_t *orch, const char *socket_path,
+                                  uint16_t tcp_port) {
+    // The event loop is built on epoll and eventfd, which are Linux-only
+    (void)orch;
+    (void)socket_path;
+    (void)tcp_port;
+    return NULL;
+}
+
+void task_server_stop(task_server_t *server) {
+    (void)server;
+}
+
+void task_server_destroy(task_server_t *server) {
+    (void)server;
+}
+
+#endif
+
+void task_server_print_stats(task_server_t *server, FILE *out) {
+    if (!server || !out) return;
+    
+    fprintf(out, "Task server: %llu connections, %llu requests in %llu batches, "
+            "%llu rejected, %llu malformed frames\n",
+            (unsigned long long)atomic_load_explicit(&server->accepted_connections, memory_order_relaxed),
+            (unsigned long long)atomic_load_explicit(&server->requests, memory_order_relaxed),
+            (unsigned long long)atomic_load_explicit(&server->batches, memory_order_relaxed),
+            (unsigned long long)atomic_load_explicit(&server->rejected, memory_order_relaxed),
+            (unsigned long long)atomic_load_explicit(&server->malformed, memory_order_relaxed));
+}
+
@@ -0,0 +1,90 @@
+#ifndef TASK_SERVER_H
+#define TASK_SERVER_H
+
+#include "orchestrator.h"
+#include "payload_arena.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Wire format, integers little-endian. A request frame is
+//   u32 length        bytes after this field, at most TASK_SERVER_MAX_FRAME
+//   u8  priority      0-3
+//   u8  id_length     1-63
+//   u16 reserved      0
+//   u32 model_id      from orchestrator_register_model(), 0 = default model
+//   u32 deadline_ms   budget from receipt, 0 = none
+//   id_length bytes of task id, then the payload
+// Every request gets one response frame on the same connection, in
+// completion order rather than request order:
+//   u32 length        4 + id_length
+//   u8  status        task_server_status_t
+//   u8  id_length
+//   u16 reserved
+//   id_length bytes of task id
+#define TASK_SERVER_REQUEST_HEADER 16       // including the length field
+#define TASK_SERVER_RESPONSE_HEADER 8
+#define TASK_SERVER_MAX_FRAME (64 * 1024)
+#define TASK_SERVER_MAX_INFLIGHT 256        // per connection; reading pauses at this
+#define TASK_SERVER_BATCH ADMISSION_BATCH_MAX
+#define TASK_SERVER_SOCKET_PATH_MAX 108
+
+typedef enum {
+    TASK_SERVER_COMPLETED = 0,
+    TASK_SERVER_FAILED = 1,
+    TASK_SERVER_EXPIRED = 2,        // deadline passed while queued, never ran
+    TASK_SERVER_REJECTED = 3,       // not admitted, nothing ran
+    TASK_SERVER_MALFORMED = 4       // bad frame; the connection closes after this
+} task_server_status_t;
+
+typedef struct task_conn task_conn_t;
+
+// Network front-end for task submission. One event-loop thread owns a
+// UNIX socket and/or a loopback TCP port (epoll, level-triggered) and
+// never runs tasks. Frames are parsed in place in each connection's read
+// buffer, everything that arrived in one wakeup is submitted with
+// orchestrator_submit_batch(), and payloads too big for the slab object
+// go to a payload arena, so a request costs no malloc. Workers hand
+// completions back through per-connection rings and an eventfd.
+typedef struct {
+    orchestrator_t *orch;
+    int epoll_fd;
+    int listen_fds[2];              // UNIX socket, TCP socket; -1 if unused
+    int event_fd;                   // completions pending, or stop
+    char socket_path[TASK_SERVER_SOCKET_PATH_MAX];
+    pthread_t thread;
+    bool running;
+    _Atomic bool stopping;
+    payload_arena_t *arena;         // the loop thread is its only producer
+    pthread_mutex_t done_mutex;     // guards every connection's completion ring and done_list
+    task_conn_t *done_list;         // connections with completions to send
+    task_conn_t *connections;       // loop thread only
+    // Requests parsed since the last submission; loop thread only
+    task_submission_t batch[TASK_SERVER_BATCH];
+    task_conn_t *batch_conns[TASK_SERVER_BATCH];
+    char batch_ids[TASK_SERVER_BATCH][MAX_TASK_ID_LEN];
+    size_t batch_count;
+    // Written by the loop thread only
+    _Atomic uint64_t accepted_connections;
+    _Atomic uint64_t requests;
+    _Atomic uint64_t rejected;
+    _Atomic uint64_t malformed;
+    _Atomic uint64_t batches;
+} task_server_t;
+
+// Starts serving orch. socket_path NULL or "" and tcp_port 0 skip that
+// listener; at least one is required. Linux only (NULL elsewhere).
+task_server_t* task_server_create(orchestrator_t *orch, const char *socket_path,
+                                  uint16_t tcp_port);
+// Stops accepting and reading and closes every connection. Completions of
+// tasks still queued are dropped, but their connections stay allocated.
+void task_server_stop(task_server_t *server);
+// Frees the server. Every task it submitted must be finished, e.g. call
+// this after orchestrator_destroy().
+void task_server_destroy(task_server_t *server);
+void task_server_print_stats(task_server_t *server, FILE *out);
+
+#endif // TASK_SERVER_H
+
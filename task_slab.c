@@ -0,0 +1,260 @@
+#include "task_slab.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INLINE_DATA_OFFSET (((sizeof(task_t)) + 15) & ~(size_t)15)
+#define SLAB_OBJECT_SIZE \
+    ((INLINE_DATA_OFFSET + TASK_INLINE_DATA_SIZE + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1))
+#define CHUNK_HEADER_SIZE CACHE_LINE_SIZE
+
+struct task_slab_cache {
+    task_slab_t *slab;
+    task_t *head;
+    size_t count;
+    _Atomic uint64_t allocs;    // written by the owning thread only
+    _Atomic uint64_t frees;
+    task_slab_cache_t *prev;
+    task_slab_cache_t *next;
+};
+
+static void bump(_Atomic uint64_t *counter) {
+    // Single writer, so a plain load/store pair is enough
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+static void depot_push_locked(task_slab_t *slab, task_t *task) {
+    task->next = slab->depot;
+    slab->depot = task;
+    slab->depot_count++;
+}
+
+static task_t* depot_pop_locked(task_slab_t *slab) {
+    task_t *task = slab->depot;
+    if (task) {
+        slab->depot = task->next;
+        slab->depot_count--;
+    }
+    return task;
+}
+
+static int carve_chunk_locked(task_slab_t *slab) {
+    char *chunk = (char*)malloc(CHUNK_HEADER_SIZE + SLAB_OBJECT_SIZE * TASK_SLAB_CHUNK_TASKS);
+    if (!chunk) return -1;
+    
+    *(void**)chunk = slab->chunks;
+    slab->chunks = chunk;
+    
+    for (size_t i = TASK_SLAB_CHUNK_TASKS; i > 0; i--) {
+        task_t *task = (task_t*)(chunk + CHUNK_HEADER_SIZE + (i - 1) * SLAB_OBJECT_SIZE);
+        depot_push_locked(slab, task);
+    }
+    slab->capacity += TASK_SLAB_CHUNK_TASKS;
+    
+    return 0;
+}
+
+static size_t in_use_locked(task_slab_t *slab) {
+    uint64_t allocs = slab->retired_allocs;
+    uint64_t frees = slab->retired_frees;
+    
+    for (task_slab_cache_t *cache = slab->caches; cache; cache = cache->next) {
+        allocs += atomic_load_explicit(&cache->allocs, memory_order_relaxed);
+        frees += atomic_load_explicit(&cache->frees, memory_order_relaxed);
+    }
+    
+    return (size_t)(allocs - frees);
+}
+
+static void flush_locked(task_slab_t *slab, task_slab_cache_t *cache, size_t count) {
+    while (count-- > 0 && cache->head) {
+        task_t *task = cache->head;
+        cache->head = task->next;
+        cache->count--;
+        depot_push_locked(slab, task);
+    }
+}
+
+// pthread key destructor: hands a dying thread's cache back to the depot
+static void cache_release(void *arg) {
+    task_slab_cache_t *cache = (task_slab_cache_t*)arg;
+    task_slab_t *slab = cache->slab;
+    
+    pthread_mutex_lock(&slab->mutex);
+    flush_locked(slab, cache, cache->count);
+    slab->retired_allocs += atomic_load_explicit(&cache->allocs, memory_order_relaxed);
+    slab->retired_frees += atomic_load_explicit(&cache->frees, memory_order_relaxed);
+    if (cache->prev) {
+        cache->prev->next = cache->next;
+    } else {
+        slab->caches = cache->next;
+    }
+    if (cache->next) {
+        cache->next->prev = cache->prev;
+    }
+    pthread_mutex_unlock(&slab->mutex);
+    
+    free(cache);
+}
+
+static task_slab_cache_t* get_cache(task_slab_t *slab) {
+    task_slab_cache_t *cache = (task_slab_cache_t*)pthread_getspecific(slab->cache_key);
+    if (cache) return cache;
+    
+    cache = (task_slab_cache_t*)calloc(1, sizeof(task_slab_cache_t));
+    if (!cache) return NULL;
+    
+    cache->slab = slab;
+    atomic_init(&cache->allocs, 0);
+    atomic_init(&cache->frees, 0);
+    
+    if (pthread_setspecific(slab->cache_key, cache) != 0) {
+        free(cache);
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&slab->mutex);
+    cache->next = slab->caches;
+    if (slab->caches) {
+        slab->caches->prev = cache;
+    }
+    slab->caches = cache;
+    pthread_mutex_unlock(&slab->mutex);
+    
+    return cache;
+}
+
+task_slab_t* task_slab_create(void) {
+    task_slab_t *slab = (task_slab_t*)calloc(1, sizeof(task_slab_t));
+    if (!slab) return NULL;
+    
+    if (pthread_mutex_init(&slab->mutex, NULL) != 0) {
+        free(slab);
+        return NULL;
+    }
+    
+    if (pthread_key_create(&slab->cache_key, cache_release) != 0) {
+        pthread_mutex_destroy(&slab->mutex);
+        free(slab);
+        return NULL;
+    }
+    
+    return slab;
+}
+
+void task_slab_destroy(task_slab_t *slab) {
+    if (!slab) return;
+    
+    // Threads still alive no longer run the destructor after this
+    pthread_key_delete(slab->cache_key);
+    
+    task_slab_cache_t *cache = slab->caches;
+    while (cache) {
+        task_slab_cache_t *next = cache->next;
+        free(cache);
+        cache = next;
+    }
+    
+    void *chunk = slab->chunks;
+    while (chunk) {
+        void *next = *(void**)chunk;
+        free(chunk);
+        chunk = next;
+    }
+    
+    pthread_mutex_destroy(&slab->mutex);
+    free(slab);
+}
+
+task_t* task_slab_alloc(task_slab_t *slab) {
+    if (!slab) return NULL;
+    
+    task_t *task = NULL;
+    task_slab_cache_t *cache = get_cache(slab);
+    
+    if (!cache) {
+        // No thread cache available; go straight to the depot
+        pthread_mutex_lock(&slab->mutex);
+        if (slab->depot_count == 0 && carve_chunk_locked(slab) == 0) {
+            slab->misses++;
+        }
+        task = depot_pop_locked(slab);
+        if (task) {
+            slab->retired_allocs++;
+        }
+        pthread_mutex_unlock(&slab->mutex);
+    } else {
+        if (cache->count == 0) {
+            pthread_mutex_lock(&slab->mutex);
+            if (slab->depot_count == 0 && carve_chunk_locked(slab) == 0) {
+                slab->misses++;
+            }
+            for (size_t i = 0; i < TASK_SLAB_BATCH && slab->depot_count > 0; i++) {
+                task_t *refill = depot_pop_locked(slab);
+                refill->next = cache->head;
+                cache->head = refill;
+                cache->count++;
+            }
+            size_t in_use = in_use_locked(slab);
+            if (in_use > slab->high_water) {
+                slab->high_water = in_use;
+            }
+            pthread_mutex_unlock(&slab->mutex);
+        }
+        
+        task = cache->head;
+        if (task) {
+            cache->head = task->next;
+            cache->count--;
+            bump(&cache->allocs);
+        }
+    }
+    
+    if (task) {
+        task->next = NULL;
+        task->slab = slab;
+    }
+    return task;
+}
+
+void task_slab_free(task_slab_t *slab, task_t *task) {
+    if (!slab || !task) return;
+    
+    task_slab_cache_t *cache = get_cache(slab);
+    
+    if (!cache) {
+        pthread_mutex_lock(&slab->mutex);
+        depot_push_locked(slab, task);
+        slab->retired_frees++;
+        pthread_mutex_unlock(&slab->mutex);
+        return;
+    }
+    
+    task->next = cache->head;
+    cache->head = task;
+    cache->count++;
+    bump(&cache->frees);
+    
+    if (cache->count > TASK_SLAB_CACHE_SIZE) {
+        pthread_mutex_lock(&slab->mutex);
+        flush_locked(slab, cache, TASK_SLAB_BATCH);
+        pthread_mutex_unlock(&slab->mutex);
+    }
+}
+
+void* task_slab_inline_data(task_t *task) {
+    if (!task || !task->slab) return NULL;
+    return (char*)task + INLINE_DATA_OFFSET;
+}
+
+void task_slab_get_stats(task_slab_t *slab, task_slab_stats_t *stats) {
+    if (!slab || !stats) return;
+    
+    pthread_mutex_lock(&slab->mutex);
+    stats->in_use = in_use_locked(slab);
+    stats->high_water = (stats->in_use > slab->high_water) ? stats->in_use : slab->high_water;
+    stats->capacity = slab->capacity;
+    stats->misses = slab->misses;
+    pthread_mutex_unlock(&slab->mutex);
+}
+
@@ -0,0 +1,49 @@
+#ifndef TASK_SLAB_H
+#define TASK_SLAB_H
+
+#include "task_queue.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define TASK_INLINE_DATA_SIZE 256   // payloads up to this size live inside the slab object
+#define TASK_SLAB_CHUNK_TASKS 256   // objects carved per chunk allocation
+#define TASK_SLAB_CACHE_SIZE 64     // objects a thread cache holds before flushing
+#define TASK_SLAB_BATCH 32          // objects moved between a cache and the depot at once
+
+typedef struct task_slab_cache task_slab_cache_t;
+
+typedef struct {
+    size_t in_use;          // tasks currently handed out
+    size_t high_water;      // peak in_use, sampled whenever a cache refills
+    size_t capacity;        // tasks carved from chunks so far
+    uint64_t misses;        // refills that found the depot empty and carved a chunk
+} task_slab_stats_t;
+
+// Free-list allocator for task_t. Each thread keeps a small cache of free
+// objects; only refills and flushes of TASK_SLAB_BATCH objects touch the
+// shared depot and its mutex. Objects carry TASK_INLINE_DATA_SIZE bytes of
+// payload storage right after the task_t.
+typedef struct task_slab {
+    pthread_mutex_t mutex;          // guards everything below
+    task_t *depot;
+    size_t depot_count;
+    void *chunks;
+    size_t capacity;
+    size_t high_water;
+    uint64_t misses;
+    task_slab_cache_t *caches;      // live per-thread caches
+    uint64_t retired_allocs;        // counts folded in from exited threads
+    uint64_t retired_frees;
+    pthread_key_t cache_key;
+} task_slab_t;
+
+task_slab_t* task_slab_create(void);
+void task_slab_destroy(task_slab_t *slab);
+task_t* task_slab_alloc(task_slab_t *slab);
+void task_slab_free(task_slab_t *slab, task_t *task);
+void* task_slab_inline_data(task_t *task);
+void task_slab_get_stats(task_slab_t *slab, task_slab_stats_t *stats);
+
+#endif // TASK_SLAB_H
+
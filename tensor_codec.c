@@ -0,0 +1,173 @@
+#include "tensor_codec.h"
+#include <string.h>
+
+#define OFFSET_MAGIC 0
+#define OFFSET_VERSION 4
+#define OFFSET_DTYPE 6
+#define OFFSET_RANK 7
+#define OFFSET_TASK_ID 8
+#define OFFSET_STATUS 72
+#define OFFSET_RESERVED 76
+#define OFFSET_SHAPE 80
+#define OFFSET_BYTE_LENGTH 144
+
+// Explicit byte order so frames read the same on any host
+static void put_u16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void put_u64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint16_t get_u16(const unsigned char *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+size_t tensor_dtype_size(tensor_dtype_t dtype) {
+    switch (dtype) {
+        case TENSOR_DTYPE_INT8:
+        case TENSOR_DTYPE_UINT8:
+            return 1;
+        case TENSOR_DTYPE_FLOAT16:
+            return 2;
+        case TENSOR_DTYPE_FLOAT32:
+        case TENSOR_DTYPE_INT32:
+            return 4;
+        case TENSOR_DTYPE_FLOAT64:
+        case TENSOR_DTYPE_INT64:
+            return 8;
+    }
+    return 0;
+}
+
+uint64_t tensor_element_count(const tensor_desc_t *desc) {
+    if (!desc) return 0;
+    
+    uint64_t count = 1;
+    for (uint32_t i = 0; i < desc->rank && i < TENSOR_MAX_RANK; i++) {
+        count *= desc->shape[i];
+    }
+    return count;
+}
+
+size_t tensor_frame_size(const tensor_desc_t *desc) {
+    if (!desc) return 0;
+    return TENSOR_FRAME_HEADER_SIZE + (size_t)tensor_element_count(desc) * tensor_dtype_size(desc->dtype);
+}
+
+bool tensor_is_frame(const void *buf, size_t size) {
+    return buf && size >= TENSOR_FRAME_HEADER_SIZE &&
+           get_u32((const unsigned char*)buf + OFFSET_MAGIC) == TENSOR_FRAME_MAGIC;
+}
+
+int tensor_frame_encode(void *buf, size_t buf_size, const char *task_id, uint32_t status,
+                        const tensor_desc_t *desc, const void *data, size_t *written) {
+    if (!buf || !task_id || !desc || desc->rank > TENSOR_MAX_RANK) return -1;
+    
+    size_t element_size = tensor_dtype_size(desc->dtype);
+    if (element_size == 0) return -1;
+    
+    size_t byte_length = (size_t)tensor_element_count(desc) * element_size;
+    if (byte_length > 0 && !data) return -1;
+    if (buf_size < TENSOR_FRAME_HEADER_SIZE + byte_length) return -1;
+    
+    unsigned char *out = (unsigned char*)buf;
+    memset(out, 0, TENSOR_FRAME_HEADER_SIZE);
+    put_u32(out + OFFSET_MAGIC, TENSOR_FRAME_MAGIC);
+    put_u16(out + OFFSET_VERSION, TENSOR_FRAME_VERSION);
+    out[OFFSET_DTYPE] = (unsigned char)desc->dtype;
+    out[OFFSET_RANK] = (unsigned char)desc->rank;
+    strncpy((char*)out + OFFSET_TASK_ID, task_id, MAX_TASK_ID_LEN - 1);
+    put_u32(out + OFFSET_STATUS, status);
+    for (uint32_t i = 0; i < desc->rank; i++) {
+        put_u64(out + OFFSET_SHAPE + 8 * i, desc->shape[i]);
+    }
+    put_u64(out + OFFSET_BYTE_LENGTH, byte_length);
+    
+    // Tensor data is raw little-endian, the native order of every target
+    if (byte_length > 0) {
+        memcpy(out + TENSOR_FRAME_HEADER_SIZE, data, byte_length);
+    }
+    
+    if (written) {
+        *written = TENSOR_FRAME_HEADER_SIZE + byte_length;
+    }
+    return 0;
+}
+
+int tensor_frame_decode(const void *buf, size_t size, tensor_view_t *view) {
+    if (!tensor_is_frame(buf, size) || !view) return -1;
+    
+    const unsigned char *in = (const unsigned char*)buf;
+    if (get_u16(in + OFFSET_VERSION) != TENSOR_FRAME_VERSION) return -1;
+    
+    view->desc.dtype = (tensor_dtype_t)in[OFFSET_DTYPE];
+    view->desc.rank = in[OFFSET_RANK];
+    size_t element_size = tensor_dtype_size(view->desc.dtype);
+    if (element_size == 0 || view->desc.rank > TENSOR_MAX_RANK) return -1;
+    
+    memcpy(view->task_id, in + OFFSET_TASK_ID, MAX_TASK_ID_LEN);
+    view->task_id[MAX_TASK_ID_LEN - 1] = '\0';
+    view->status = get_u32(in + OFFSET_STATUS);
+    for (uint32_t i = 0; i < TENSOR_MAX_RANK; i++) {
+        view->desc.shape[i] = (i < view->desc.rank) ? get_u64(in + OFFSET_SHAPE + 8 * i) : 0;
+    }
+    
+    uint64_t byte_length = get_u64(in + OFFSET_BYTE_LENGTH);
+    if (byte_length != tensor_element_count(&view->desc) * element_size ||
+        byte_length > size - TENSOR_FRAME_HEADER_SIZE) {
+        return -1;
+    }
+    
+    view->byte_length = (size_t)byte_length;
+    view->data = in + TENSOR_FRAME_HEADER_SIZE;
+    return 0;
+}
+
+uint64_t tensor_batch_key(const tensor_desc_t *desc) {
+    if (!desc) return 0;
+    
+    // FNV-1a over dtype, rank and every dimension after the batch axis
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint64_t words[2 + TENSOR_MAX_RANK];
+    size_t n = 0;
+    words[n++] = (uint64_t)desc->dtype;
+    words[n++] = desc->rank;
+    for (uint32_t i = 1; i < desc->rank && i < TENSOR_MAX_RANK; i++) {
+        words[n++] = desc->shape[i];
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (int b = 0; b < 8; b++) {
+            hash ^= (words[i] >> (8 * b)) & 0xff;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
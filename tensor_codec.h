@@ -0,0 +1,68 @@
+#ifndef TENSOR_CODEC_H
+#define TENSOR_CODEC_H
+
+#include "task_queue.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TENSOR_FRAME_MAGIC 0x524e5354u      // "TSNR"
+#define TENSOR_FRAME_VERSION 1
+#define TENSOR_MAX_RANK 8
+#define TENSOR_FRAME_HEADER_SIZE 152
+
+typedef enum {
+    TENSOR_DTYPE_FLOAT32 = 1,
+    TENSOR_DTYPE_FLOAT16 = 2,
+    TENSOR_DTYPE_FLOAT64 = 3,
+    TENSOR_DTYPE_INT8 = 4,
+    TENSOR_DTYPE_UINT8 = 5,
+    TENSOR_DTYPE_INT32 = 6,
+    TENSOR_DTYPE_INT64 = 7
+} tensor_dtype_t;
+
+typedef struct {
+    tensor_dtype_t dtype;
+    uint32_t rank;
+    uint64_t shape[TENSOR_MAX_RANK];
+} tensor_desc_t;
+
+// Decoded frame. data points into the buffer that was decoded; nothing
+// is copied.
+typedef struct {
+    char task_id[MAX_TASK_ID_LEN];
+    uint32_t status;                // results: 0 = ok
+    tensor_desc_t desc;
+    const void *data;
+    size_t byte_length;
+} tensor_view_t;
+
+// Framed binary tensor, shared with tensor_codec.py. All integers are
+// little-endian; the header is TENSOR_FRAME_HEADER_SIZE bytes:
+//
+//   offset  size  field
+//        0     4  magic
+//        4     2  version
+//        6     1  dtype
+//        7     1  rank
+//        8    64  task_id, NUL-padded
+//       72     4  status
+//       76     4  reserved (0)
+//       80    64  shape[TENSOR_MAX_RANK], unused dims 0
+//      144     8  byte_length
+//
+// followed by byte_length bytes of row-major tensor data.
+
+size_t tensor_dtype_size(tensor_dtype_t dtype);
+uint64_t tensor_element_count(const tensor_desc_t *desc);
+size_t tensor_frame_size(const tensor_desc_t *desc);
+bool tensor_is_frame(const void *buf, size_t size);
+int tensor_frame_encode(void *buf, size_t buf_size, const char *task_id, uint32_t status,
+                        const tensor_desc_t *desc, const void *data, size_t *written);
+int tensor_frame_decode(const void *buf, size_t size, tensor_view_t *view);
+// Key equal for tensors that stack along the first axis (same dtype and
+// trailing dimensions)
+uint64_t tensor_batch_key(const tensor_desc_t *desc);
+
+#endif // TENSOR_CODEC_H
+
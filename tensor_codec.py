@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""
+Binary tensor frames shared with tensor_codec.h
+A fixed little-endian header followed by raw row-major tensor bytes
+"""
+
+import struct
+import numpy as np
+from typing import Optional, Tuple
+
+
+FRAME_MAGIC = 0x524e5354
+FRAME_VERSION = 1
+MAX_RANK = 8
+TASK_ID_LEN = 64
+
+# magic, version, dtype, rank, task_id, status, reserved, shape[8], byte_length
+FRAME_HEADER = struct.Struct('<IHBB64sII8QQ')
+
+DTYPES = {
+    1: np.dtype('<f4'),
+    2: np.dtype('<f2'),
+    3: np.dtype('<f8'),
+    4: np.dtype('i1'),
+    5: np.dtype('u1'),
+    6: np.dtype('<i4'),
+    7: np.dtype('<i8'),
+}
+DTYPE_CODES = {dtype: code for code, dtype in DTYPES.items()}
+
+
+def is_frame(buf) -> bool:
+    """Check whether a buffer starts with a tensor frame header"""
+    return len(buf) >= FRAME_HEADER.size and struct.unpack_from('<I', buf, 0)[0] == FRAME_MAGIC
+
+
+def decode_frame(buf) -> Tuple[str, int, np.ndarray]:
+    """
+    Decode a tensor frame without copying
+    
+    Args:
+        buf: bytes, bytearray or memoryview holding the frame
+    
+    Returns:
+        (task_id, status, array). The array is a read-only view over buf,
+        valid only as long as buf is.
+    """
+    (magic, version, dtype_code, rank, task_id, status, _reserved,
+     *rest) = FRAME_HEADER.unpack_from(buf, 0)
+    shape, byte_length = rest[:MAX_RANK], rest[MAX_RANK]
+    
+    if magic != FRAME_MAGIC or version != FRAME_VERSION:
+        raise ValueError("Not a tensor frame")
+    if dtype_code not in DTYPES or rank > MAX_RANK:
+        raise ValueError(f"Unsupported tensor dtype {dtype_code} or rank {rank}")
+    
+    dtype = DTYPES[dtype_code]
+    shape = tuple(shape[:rank])
+    count = int(np.prod(shape, dtype=np.int64)) if rank else 1
+    if byte_length != count * dtype.itemsize or FRAME_HEADER.size + byte_length > len(buf):
+        raise ValueError("Tensor frame length does not match its shape")
+    
+    array = np.frombuffer(buf, dtype=dtype, count=count, offset=FRAME_HEADER.size)
+    task_id = task_id.split(b'\0', 1)[0].decode('utf-8', 'replace')
+    return task_id, status, array.reshape(shape)
+
+
+def encode_frame(task_id: str, array: Optional[np.ndarray], status: int = 0) -> bytes:
+    """
+    Encode a tensor frame
+    
+    Args:
+        task_id: Task the tensor belongs to
+        array: Tensor to send (None sends an empty float32 tensor, e.g.
+               alongside a failure status)
+        status: 0 on success
+    
+    Returns:
+        Frame bytes
+    """
+    if array is None:
+        array = np.zeros((0,), dtype=np.float32)
+    
+    array = np.ascontiguousarray(array)
+    dtype = array.dtype.newbyteorder('<') if array.dtype.byteorder == '>' else array.dtype
+    if dtype not in DTYPE_CODES:
+        raise ValueError(f"Unsupported tensor dtype {array.dtype}")
+    if array.ndim > MAX_RANK:
+        raise ValueError(f"Tensor rank {array.ndim} exceeds {MAX_RANK}")
+    
+    data = array.astype(dtype, copy=False).tobytes()
+    shape = list(array.shape) + [0] * (MAX_RANK - array.ndim)
+    header = FRAME_HEADER.pack(FRAME_MAGIC, FRAME_VERSION, DTYPE_CODES[dtype], array.ndim,
+                               task_id.encode('utf-8')[:TASK_ID_LEN - 1], status, 0,
+                               *shape, len(data))
+    return header + data
+
@@ -57,14 +57,88 @@ def test_communication():
     print("Communication test completed!")
 
 
+def test_tensor_codec():
+    """Test binary tensor frame encoding"""
+    print("\nTesting Tensor Codec...")
+    
+    import numpy as np
+    from tensor_codec import FRAME_HEADER, decode_frame, encode_frame
+    
+    array = np.arange(24, dtype=np.float32).reshape(2, 3, 4)
+    frame = encode_frame('codec_test', array, status=0)
+    assert len(frame) == FRAME_HEADER.size + array.nbytes
+    
+    task_id, status, decoded = decode_frame(memoryview(frame))
+    assert (task_id, status) == ('codec_test', 0)
+    assert decoded.shape == (2, 3, 4) and decoded.dtype == np.float32
+    assert np.array_equal(decoded, array)
+    print(f"Round trip of {decoded.shape} tensor succeeded")
+    
+    print("Tensor codec test completed!")
+
+
+def test_shm_ring():
+    """Test the worker side of the shared memory ring"""
+    print("\nTesting Shared Memory Ring...")
+    
+    import os
+    import communication as cm
+    
+    # Play the orchestrator's side of one round trip
+    slots, slot_size = 4, 4096
+    name = f"/aiorch_test_{os.getpid()}"
+    segment = cm.open_named_segment(name, cm.RING_DATA_OFFSET + 2 * slots * slot_size, create=True)
+    sub_fd = os.eventfd(0, os.EFD_NONBLOCK)
+    comp_fd = os.eventfd(0, os.EFD_NONBLOCK)
+    try:
+        cm.RING_HEADER.pack_into(segment.buf, 0, cm.RING_MAGIC, cm.RING_VERSION, slots, slot_size)
+        model = b'models/a.onnx'
+        payload = (cm.MODEL_LENGTH.pack(len(model)) + model +
+                   b'ring_task'.ljust(cm.TASK_ID_LEN, b'\0') + b'hello')
+        cm.SLOT_HEADER.pack_into(segment.buf, cm.RING_DATA_OFFSET, 7, 0, len(payload))
+        start = cm.RING_DATA_OFFSET + cm.SLOT_HEADER.size
+        segment.buf[start:start + len(payload)] = payload
+        cm.RING_CURSOR.pack_into(segment.buf, cm.SUB_TAIL_OFFSET, 1)
+        os.eventfd_write(sub_fd, 1)
+        
+        ring = cm.ShmRing(name, sub_fd, comp_fd)
+        request_id, model_path, records, batched = ring.next_submission(timeout_ms=1000)
+        assert (request_id, model_path, batched) == (7, 'models/a.onnx', False)
+        assert [(task_id, bytes(data)) for task_id, data in records] == [('ring_task', b'hello')]
+        del records
+        ring.release_submission()
+        ring.post_completion(request_id, 0, b'done')
+        ring.close()
+        # Attaching in the creating process dropped the creator's tracker entry
+        cm.resource_tracker.register(segment._name, 'shared_memory')
+        
+        assert os.eventfd_read(comp_fd) == 1
+        assert cm.RING_CURSOR.unpack_from(segment.buf, cm.SUB_HEAD_OFFSET)[0] == 1
+        assert cm.RING_CURSOR.unpack_from(segment.buf, cm.COMP_TAIL_OFFSET)[0] == 1
+        offset = cm.RING_DATA_OFFSET + slots * slot_size
+        assert cm.SLOT_HEADER.unpack_from(segment.buf, offset) == (7, 0, 4)
+        print("Round trip through the ring succeeded")
+    finally:
+        os.close(sub_fd)
+        os.close(comp_fd)
+        segment.close()
+        segment.unlink()
+    
+    print("Shared memory ring test completed!")
+
+
 if __name__ == '__main__':
     print("=== AI Task Orchestrator Test Suite ===\n")
     
     if len(sys.argv) > 1 and sys.argv[1] == '--comm':
         test_communication()
+    elif len(sys.argv) > 1 and sys.argv[1] == '--shm':
+        test_shm_ring()
     else:
         test_inference_engine()
         test_communication()
+        test_tensor_codec()
+        test_shm_ring()
     
     print("\nAll tests completed!")
 
@@ -0,0 +1,95 @@
+// Outcomes a task_future reports for tasks that did not complete
+#include "thread_pool.h"
+#include "task_future.h"
+#include "timer_wheel.h"
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_TIMEOUT_MS 20
+
+static int failures = 0;
+
+static void expect_outcome(const char *name, task_future_t *future,
+                           task_status_t status, int error) {
+    task_outcome_t outcome;
+    if (task_future_get(future, &outcome) != 0) {
+        printf("FAIL %s: future not done\n", name);
+        failures++;
+        return;
+    }
+    if (outcome.status != status || outcome.error != error) {
+        printf("FAIL %s: status %d error %s, expected status %d error %s\n", name,
+               (int)outcome.status, strerror(outcome.error), (int)status, strerror(error));
+        failures++;
+        return;
+    }
+    printf("ok   %s\n", name);
+}
+
+// As the orchestrator does: an overrun cancels the running task
+static void on_timeout(timer_wheel_entry_t *entry, void *ctx) {
+    (void)ctx;
+    task_cancel((task_t*)((char*)entry - offsetof(task_t, timer)), ETIMEDOUT);
+}
+
+// Runs until cancelled, as a cooperative long task would
+static int run_until_cancelled(void *data) {
+    (void)data;
+    uint64_t give_up = task_now_ns() + 2000000000ULL;
+    while (!task_cancelled(thread_pool_current_task()) && task_now_ns() < give_up) {
+    }
+    return -1;
+}
+
+static void test_timeout(void) {
+    timer_wheel_t *timers = timer_wheel_create(TIMER_WHEEL_DEFAULT_TICK_MS, on_timeout, NULL);
+    task_queue_t *queue = task_queue_create(16);
+    thread_pool_t *pool = thread_pool_create(1, queue);
+    thread_pool_set_timer_wheel(pool, timers);
+    thread_pool_start(pool);
+    
+    task_future_t *future = task_future_create(NULL, true);
+    task_t *task = task_create("timeout", TASK_PRIORITY_NORMAL, NULL, 0, run_until_cancelled, NULL);
+    task->data_free = NULL;
+    task->timeout_ns = TEST_TIMEOUT_MS * 1000000ULL;
+    task->future = future;
+    thread_pool_submit(pool, task);
+    
+    task_future_wait(future);
+    expect_outcome("timed out while running", future, TASK_STATUS_CANCELLED, ETIMEDOUT);
+    task_future_release(future);
+    
+    thread_pool_shutdown(pool);
+    thread_pool_destroy(pool);
+    task_queue_destroy(queue);
+    timer_wheel_destroy(timers);
+}
+
+static void test_destroyed_unrun(const char *name, task_status_t status, int error,
+                                 task_status_t expected, int expected_error) {
+    task_future_t *future = task_future_create(NULL, true);
+    task_t *task = task_create(name, TASK_PRIORITY_NORMAL, NULL, 0, NULL, NULL);
+    task->data_free = NULL;
+    task->future = future;
+    task->status = status;
+    task->error = error;
+    task_destroy(task);
+    
+    expect_outcome(name, future, expected, expected_error);
+    task_future_release(future);
+}
+
+int main(void) {
+    test_timeout();
+    test_destroyed_unrun("set aside at shutdown", TASK_STATUS_CANCELLED, ESHUTDOWN,
+                         TASK_STATUS_CANCELLED, ESHUTDOWN);
+    test_destroyed_unrun("cancelled while queued", TASK_STATUS_CANCELLED, 0,
+                         TASK_STATUS_CANCELLED, ECANCELED);
+    test_destroyed_unrun("destroyed before it ran", TASK_STATUS_PENDING, 0,
+                         TASK_STATUS_FAILED, ECANCELED);
+    
+    return failures ? 1 : 0;
+}
+
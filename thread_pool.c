@@ -4,42 +4,405 @@
 #include <unistd.h>
 #include <errno.h>
 
+// Worker the calling thread belongs to, if any. Lets thread_pool_submit()
+// and thread_pool_release() keep tasks spawned or released by a running
+// task on the spawning worker.
+static _Thread_local thread_pool_worker_t *current_worker = NULL;
+
+// Task whose execute_callback is running on the calling thread
+static _Thread_local task_t *current_task = NULL;
+
+static bool is_expired(const task_t *task, uint64_t now) {
+    return task->deadline_ns != 0 && now > task->deadline_ns;
+}
+
+// Worker counters have a single writer, so a plain load/store pair will do
+static void bump(_Atomic uint64_t *counter, uint64_t delta) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + delta,
+                          memory_order_relaxed);
+}
+
+static void count_finished(thread_pool_worker_t *worker, const task_t *task) {
+    switch (task->status) {
+        case TASK_STATUS_COMPLETED:
+            bump(&worker->completed, 1);
+            break;
+        case TASK_STATUS_CANCELLED:
+            bump(task->error == ETIMEDOUT ? &worker->timed_out : &worker->cancelled, 1);
+            break;
+        default:
+            bump(&worker->failed, 1);
+            break;
+    }
+}
+
+// A task that failed after being cancelled reports why instead
+static task_status_t failed_status(task_t *task) {
+    int reason = task_cancelled(task);
+    if (!reason) return TASK_STATUS_FAILED;
+    
+    task->error = reason;
+    return TASK_STATUS_CANCELLED;
+}
+
+// Nobody is waiting for the result any more; skip the work
+static void drop_expired(thread_pool_worker_t *worker, task_t *task) {
+    task->status = TASK_STATUS_EXPIRED;
+    bump(&worker->expired, 1);
+    task_destroy(task);
+}
+
+// Cancelled while still queued; O(1) here instead of a search of the queue
+static void drop_cancelled(thread_pool_worker_t *worker, task_t *task) {
+    task->status = TASK_STATUS_CANCELLED;
+    task->error = task_cancelled(task);
+    count_finished(worker, task);
+    task_destroy(task);
+}
+
+static void arm_timeout(thread_pool_t *pool, task_t *task) {
+    if (pool->timers && task->timeout_ns) {
+        timer_wheel_arm(pool->timers, &task->timer, task->start_ns + task->timeout_ns);
+    }
+}
+
+// A callback's time is visible from its start (busy_since_ns), not only
+// once it ends, so stats see a long task as busy while it runs. Ending
+// moves the time into busy_ns under busy_seq, which readers retry on, so
+// it is never counted twice or lost in between.
+static void busy_begin(thread_pool_worker_t *worker, uint64_t start) {
+    atomic_store_explicit(&worker->busy_since_ns, start, memory_order_relaxed);
+}
+
+static void busy_end(thread_pool_worker_t *worker, uint64_t start, uint64_t end) {
+    uint64_t seq = atomic_load_explicit(&worker->busy_seq, memory_order_relaxed);
+    atomic_store_explicit(&worker->busy_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    bump(&worker->busy_ns, end - start);
+    atomic_store_explicit(&worker->busy_since_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&worker->busy_seq, seq + 2, memory_order_release);
+}
+
+// After this the wheel's callback is done with the task
+static void disarm_timeout(thread_pool_t *pool, task_t *task) {
+    if (pool->timers && task->timeout_ns) {
+        timer_wheel_disarm(pool->timers, &task->timer);
+    }
+}
+
+static void run_task(thread_pool_worker_t *worker, task_t *task) {
+    task->status = TASK_STATUS_RUNNING;
+    task->start_ns = task_now_ns();
+    busy_begin(worker, task->start_ns);
+    arm_timeout(worker->pool, task);
+    
+    int result = -1;
+    if (task->execute_callback) {
+        current_task = task;
+        result = task->execute_callback(task->data);
+        current_task = NULL;
+    }
+    disarm_timeout(worker->pool, task);
+    task->status = (result == 0) ? TASK_STATUS_COMPLETED : failed_status(task);
+    
+    task->end_ns = task_now_ns();
+    busy_end(worker, task->start_ns, task->end_ns);
+    count_finished(worker, task);
+    task_latency_record(worker->latency, task);
+    task_destroy(task);
+}
+
+static void run_batch(thread_pool_worker_t *worker, task_t **batch, size_t count) {
+    thread_pool_t *pool = worker->pool;
+    uint64_t now = task_now_ns();
+    
+    // Companions may have expired or been cancelled while the batch was filling
+    size_t live = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (is_expired(batch[i], now)) {
+            drop_expired(worker, batch[i]);
+        } else if (task_cancelled(batch[i])) {
+            drop_cancelled(worker, batch[i]);
+        } else {
+            batch[live++] = batch[i];
+        }
+    }
+    if (live == 0) return;
+    count = live;
+    
+    task_batcher_t *batcher = pool->batcher;
+    for (size_t i = 0; i < count; i++) {
+        batch[i]->status = TASK_STATUS_RUNNING;
+        batch[i]->start_ns = now;
+        arm_timeout(pool, batch[i]);
+    }
+    
+    // The callback settles individual tasks; the rest follow the batch result
+    busy_begin(worker, now);
+    int result = batch[0]->batch_callback(batch, count);
+    task_batcher_record(batcher, count);
+    
+    uint64_t end = task_now_ns();
+    busy_end(worker, now, end);
+    for (size_t i = 0; i < count; i++) {
+        disarm_timeout(pool, batch[i]);
+        if (batch[i]->status == TASK_STATUS_RUNNING) {
+            batch[i]->status = (result == 0) ? TASK_STATUS_COMPLETED : TASK_STATUS_FAILED;
+        }
+        if (batch[i]->status == TASK_STATUS_FAILED) {
+            batch[i]->status = failed_status(batch[i]);
+        }
+        batch[i]->end_ns = end;
+        count_finished(worker, batch[i]);
+        task_latency_record(worker->latency, batch[i]);
+        task_destroy(batch[i]);
+    }
+}
+
+static void dispatch_task(thread_pool_worker_t *worker, task_t *task) {
+    // Tasks the batcher pulled are already stamped
+    uint64_t now = task_now_ns();
+    if (!task->dequeue_ns) {
+        task->dequeue_ns = now;
+    }
+    
+    if (is_expired(task, now)) {
+        drop_expired(worker, task);
+        return;
+    }
+    if (task_cancelled(task)) {
+        drop_cancelled(worker, task);
+        return;
+    }
+    
+    // Tasks with a footprint start only as the budget allows. One set aside
+    // earlier may start in this one's place; it holds its reservation, and
+    // dispatching it again drops it if it expired or was cancelled meanwhile.
+    if (task->memory_bytes && !task->memory_budget && worker->pool->memory_budget) {
+        task_t *admitted = memory_budget_admit(worker->pool->memory_budget, task);
+        if (admitted != task) {
+            if (admitted) {
+                dispatch_task(worker, admitted);
+            }
+            return;
+        }
+    }
+    
+    task_batcher_t *batcher = worker->pool->batcher;
+    if (!task_batcher_accepts(batcher, task)) {
+        run_task(worker, task);
+        return;
+    }
+    
+    task_t *batch[TASK_BATCH_MAX_SIZE];
+    size_t count = task_batcher_collect(batcher, worker->pool->task_queue, task,
+                                        batch, &worker->deferred);
+    run_batch(worker, batch, count);
+}
+
+// Headroom a finished task gave back may let a set-aside task start on an
+// idle worker: one wakeup per release, not a stampede after every task
+static void wake_parked(thread_pool_t *pool) {
+    size_t releases = memory_budget_take_releases(pool->memory_budget);
+    if (releases > 0) {
+        event_count_notify_many(&pool->task_queue->not_empty, (int)releases);
+    }
+}
+
+// Idle workers stay while tasks are set aside, since the last running one
+// to finish lets any of them start
+static bool drained(thread_pool_t *pool) {
+    return atomic_load(&pool->task_queue->shutdown) && memory_budget_waiting(pool->memory_budget) == 0;
+}
+
+// memory_budget_take(); taking the last set-aside task after shutdown
+// lets the idle workers that stayed for it exit
+static task_t* take_parked(thread_pool_t *pool) {
+    task_t *task = memory_budget_take(pool->memory_budget);
+    if (task && drained(pool)) {
+        event_count_notify_all(&pool->task_queue->not_empty);
+    }
+    return task;
+}
+
+static task_t* take_deferred(thread_pool_worker_t *worker) {
+    task_t *task = worker->deferred;
+    if (task) {
+        worker->deferred = task->next;
+        task->next = NULL;
+    }
+    return task;
+}
+
+// True when the worker was retired and now commits to exiting; one
+// revived by thread_pool_add_worker() first keeps running. Only called
+// with nothing deferred or queued locally, so no task is stranded.
+static bool claim_exit(thread_pool_worker_t *worker) {
+    if (atomic_load_explicit(&worker->state, memory_order_relaxed) != THREAD_POOL_WORKER_RETIRING) {
+        return false;
+    }
+    int expected = THREAD_POOL_WORKER_RETIRING;
+    return atomic_compare_exchange_strong(&worker->state, &expected, THREAD_POOL_WORKER_EXITED);
+}
+
+// task_queue_dequeue() for elastic pools and pools with a memory budget:
+// also gives up once the worker is retired, between tasks rather than only
+// when the queue runs dry, and takes set-aside tasks that fit first
+static task_t* dequeue_or_retire(thread_pool_worker_t *worker) {
+    thread_pool_t *pool = worker->pool;
+    task_queue_t *queue = pool->task_queue;
+    
+    for (;;) {
+        if (claim_exit(worker)) return NULL;
+        
+        task_t *task = take_parked(pool);
+        if (!task) task = task_queue_try_dequeue(queue);
+        if (task) return task;
+        
+        uint32_t key = event_count_prepare(&queue->not_empty);
+        
+        task = take_parked(pool);
+        if (!task) task = task_queue_try_dequeue(queue);
+        if (task) {
+            event_count_cancel(&queue->not_empty);
+            return task;
+        }
+        if (drained(pool) || claim_exit(worker)) {
+            event_count_cancel(&queue->not_empty);
+            return NULL;
+        }
+        
+        event_count_wait(&queue->not_empty, key);
+    }
+}
+
 static void* worker_thread(void *arg) {
-    thread_pool_t *pool = (thread_pool_t*)arg;
+    thread_pool_worker_t *worker = (thread_pool_worker_t*)arg;
+    thread_pool_t *pool = worker->pool;
+    
+    current_worker = worker;
     
     while (true) {
-        pthread_mutex_lock(&pool->mutex);
+        task_t *task = take_deferred(worker);
         
-        while (task_queue_is_empty(pool->task_queue) && !pool->shutdown) {
-            pthread_cond_wait(&pool->cond, &pool->mutex);
+        // Parks inside the queue while idle; NULL once shut down and
+        // drained, or retired
+        if (!task) {
+            task = (pool->elastic || pool->memory_budget) ? dequeue_or_retire(worker)
+                                                          : task_queue_dequeue(pool->task_queue);
         }
+        if (!task) break;
         
-        if (pool->shutdown && task_queue_is_empty(pool->task_queue)) {
-            pthread_mutex_unlock(&pool->mutex);
-            break;
+        dispatch_task(worker, task);
+        wake_parked(pool);
+    }
+    
+    current_worker = NULL;
+    return NULL;
+}
+
+static uint64_t next_random(thread_pool_worker_t *worker) {
+    // xorshift64
+    uint64_t x = worker->rng_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    worker->rng_state = x;
+    return x;
+}
+
+static task_t* steal_task(thread_pool_worker_t *worker) {
+    thread_pool_t *pool = worker->pool;
+    size_t n = pool->num_threads;
+    if (n < 2) return NULL;
+    
+    // Visit every other worker once, starting from a random victim
+    size_t start = (size_t)(next_random(worker) % n);
+    for (size_t i = 0; i < n; i++) {
+        size_t victim = (start + i) % n;
+        if (victim == worker->index) continue;
+        
+        task_t *task = work_deque_steal(&pool->workers[victim].deque);
+        if (task) return task;
+    }
+    
+    return NULL;
+}
+
+static task_t* find_task(thread_pool_worker_t *worker) {
+    thread_pool_t *pool = worker->pool;
+    task_t *task;
+    
+    // Tasks the batcher set aside were dequeued before anything still queued
+    if ((task = take_deferred(worker)) != NULL) {
+        return task;
+    }
+    // Set-aside tasks that now fit were dequeued before anything queued
+    if ((task = take_parked(pool)) != NULL) {
+        return task;
+    }
+    
+    // Urgent injected work goes ahead of anything queued locally
+    if ((task = task_queue_try_dequeue_min(pool->task_queue, TASK_PRIORITY_HIGH)) != NULL) {
+        return task;
+    }
+    if ((task = work_deque_take(&worker->deque)) != NULL) {
+        return task;
+    }
+    if ((task = task_queue_try_dequeue(pool->task_queue)) != NULL) {
+        return task;
+    }
+    
+    return steal_task(worker);
+}
+
+static void* stealing_worker_thread(void *arg) {
+    thread_pool_worker_t *worker = (thread_pool_worker_t*)arg;
+    thread_pool_t *pool = worker->pool;
+    task_queue_t *queue = pool->task_queue;
+    
+    current_worker = worker;
+    
+    while (true) {
+        if (!worker->deferred && work_deque_size(&worker->deque) == 0 && claim_exit(worker)) break;
+        
+        task_t *task = find_task(worker);
+        if (task) {
+            dispatch_task(worker, task);
+            wake_parked(pool);
+            continue;
         }
         
-        pthread_mutex_unlock(&pool->mutex);
+        // Idle workers park on the injection queue's event count; local
+        // pushes in thread_pool_submit() ring the same one.
+        uint32_t key = event_count_prepare(&queue->not_empty);
         
-        task_t *task = task_queue_dequeue(pool->task_queue);
+        task = find_task(worker);
         if (task) {
-            task->status = TASK_STATUS_RUNNING;
-            
-            if (task->execute_callback) {
-                int result = task->execute_callback(task->data);
-                task->status = (result == 0) ? TASK_STATUS_COMPLETED : TASK_STATUS_FAILED;
-            } else {
-                task->status = TASK_STATUS_FAILED;
-            }
-            
-            task_destroy(task);
+            event_count_cancel(&queue->not_empty);
+            dispatch_task(worker, task);
+            wake_parked(pool);
+            continue;
+        }
+        // Nothing local or deferred is left behind by either exit
+        if (drained(pool) || claim_exit(worker)) {
+            event_count_cancel(&queue->not_empty);
+            break;
         }
+        
+        event_count_wait(&queue->not_empty, key);
     }
     
+    current_worker = NULL;
     return NULL;
 }
 
 thread_pool_t* thread_pool_create(size_t num_threads, task_queue_t *queue) {
+    return thread_pool_create_ex(num_threads, queue, THREAD_POOL_MODE_SHARED_QUEUE);
+}
+
+thread_pool_t* thread_pool_create_ex(size_t num_threads, task_queue_t *queue,
+                                     thread_pool_mode_t mode) {
     if (num_threads == 0 || !queue) return NULL;
     
     thread_pool_t *pool = (thread_pool_t*)malloc(sizeof(thread_pool_t));
@@ -51,18 +414,72 @@ thread_pool_t* thread_pool_create(size_t num_threads, task_queue_t *queue) {
         return NULL;
     }
     
-    pool->num_threads = num_threads;
-    pool->task_queue = queue;
-    pool->shutdown = false;
+    pool->workers = (thread_pool_worker_t*)calloc(num_threads, sizeof(thread_pool_worker_t));
+    if (!pool->workers) {
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
     
-    if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+    pool->latency = (task_latency_t*)calloc(num_threads, sizeof(task_latency_t));
+    if (!pool->latency) {
+        free(pool->workers);
         free(pool->threads);
         free(pool);
         return NULL;
     }
     
-    if (pthread_cond_init(&pool->cond, NULL) != 0) {
-        pthread_mutex_destroy(&pool->mutex);
+    for (size_t i = 0; i < num_threads; i++) {
+        thread_pool_worker_t *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->rng_state = 0x9E3779B97F4A7C15ULL * (i + 1);
+        worker->latency = &pool->latency[i];
+        atomic_init(&worker->completed, 0);
+        atomic_init(&worker->failed, 0);
+        atomic_init(&worker->expired, 0);
+        atomic_init(&worker->cancelled, 0);
+        atomic_init(&worker->timed_out, 0);
+        atomic_init(&worker->chained, 0);
+        atomic_init(&worker->busy_ns, 0);
+        atomic_init(&worker->busy_since_ns, 0);
+        atomic_init(&worker->busy_seq, 0);
+        atomic_init(&worker->state, THREAD_POOL_WORKER_UNUSED);
+        worker->joinable = false;
+        
+        if (mode == THREAD_POOL_MODE_WORK_STEALING &&
+            work_deque_init(&worker->deque, WORK_DEQUE_CAPACITY) != 0) {
+            for (size_t j = 0; j < i; j++) {
+                work_deque_destroy(&pool->workers[j].deque);
+            }
+            free(pool->latency);
+            free(pool->workers);
+            free(pool->threads);
+            free(pool);
+            return NULL;
+        }
+    }
+    
+    pool->num_threads = num_threads;
+    pool->min_threads = num_threads;
+    pool->initial_threads = num_threads;
+    atomic_init(&pool->active_threads, 0);
+    pool->elastic = false;
+    pool->mode = mode;
+    pool->task_queue = queue;
+    pool->batcher = NULL;
+    pool->timers = NULL;
+    pool->placement = NULL;
+    pool->memory_budget = NULL;
+    pool->start_ns = 0;
+    pool->shutdown = false;
+    
+    if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+        for (size_t i = 0; i < num_threads; i++) {
+            work_deque_destroy(&pool->workers[i].deque);
+        }
+        free(pool->latency);
+        free(pool->workers);
         free(pool->threads);
         free(pool);
         return NULL;
@@ -71,34 +488,241 @@ thread_pool_t* thread_pool_create(size_t num_threads, task_queue_t *queue) {
     return pool;
 }
 
+static int start_worker(thread_pool_t *pool, size_t index) {
+    void *(*entry)(void *) = (pool->mode == THREAD_POOL_MODE_WORK_STEALING)
+                             ? stealing_worker_thread : worker_thread;
+    thread_pool_worker_t *worker = &pool->workers[index];
+    
+    atomic_store(&worker->state, THREAD_POOL_WORKER_RUNNING);
+    if (pthread_create(&pool->threads[index], NULL, entry, worker) != 0) {
+        atomic_store(&worker->state, THREAD_POOL_WORKER_UNUSED);
+        return -1;
+    }
+    worker->joinable = true;
+    
+    // Best effort: a worker that cannot be pinned still runs
+    cpu_plan_pin_worker(pool->placement, index, pool->threads[index]);
+    return 0;
+}
+
 int thread_pool_start(thread_pool_t *pool) {
     if (!pool) return -1;
     
-    for (size_t i = 0; i < pool->num_threads; i++) {
-        if (pthread_create(&pool->threads[i], NULL, worker_thread, pool) != 0) {
+    pool->start_ns = task_now_ns();
+    
+    for (size_t i = 0; i < pool->initial_threads; i++) {
+        if (start_worker(pool, i) != 0) {
             // Cleanup already created threads
             pool->shutdown = true;
-            pthread_cond_broadcast(&pool->cond);
+            task_queue_shutdown(pool->task_queue);
             for (size_t j = 0; j < i; j++) {
                 pthread_join(pool->threads[j], NULL);
+                pool->workers[j].joinable = false;
             }
             return -1;
         }
+        atomic_store(&pool->active_threads, i + 1);
     }
     
     return 0;
 }
 
+void thread_pool_set_elastic(thread_pool_t *pool, size_t min_threads, size_t initial_threads) {
+    if (!pool) return;
+    
+    if (min_threads == 0) min_threads = 1;
+    if (min_threads > pool->num_threads) min_threads = pool->num_threads;
+    if (initial_threads < min_threads) initial_threads = min_threads;
+    if (initial_threads > pool->num_threads) initial_threads = pool->num_threads;
+    
+    pool->elastic = true;
+    pool->min_threads = min_threads;
+    pool->initial_threads = initial_threads;
+}
+
+int thread_pool_add_worker(thread_pool_t *pool) {
+    if (!pool || !pool->elastic) return -1;
+    
+    pthread_mutex_lock(&pool->mutex);
+    size_t index = atomic_load(&pool->active_threads);
+    if (pool->shutdown || index >= pool->num_threads) {
+        pthread_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+    
+    // A worker still winding down is simply told to stay; one that has
+    // exited is joined and its slot started afresh
+    thread_pool_worker_t *worker = &pool->workers[index];
+    int expected = THREAD_POOL_WORKER_RETIRING;
+    if (!atomic_compare_exchange_strong(&worker->state, &expected, THREAD_POOL_WORKER_RUNNING)) {
+        if (worker->joinable) {
+            pthread_join(pool->threads[index], NULL);
+            worker->joinable = false;
+        }
+        if (start_worker(pool, index) != 0) {
+            pthread_mutex_unlock(&pool->mutex);
+            return -1;
+        }
+    }
+    atomic_store(&pool->active_threads, index + 1);
+    
+    pthread_mutex_unlock(&pool->mutex);
+    return 0;
+}
+
+int thread_pool_retire_worker(thread_pool_t *pool) {
+    if (!pool || !pool->elastic) return -1;
+    
+    pthread_mutex_lock(&pool->mutex);
+    size_t active = atomic_load(&pool->active_threads);
+    if (pool->shutdown || active <= pool->min_threads) {
+        pthread_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+    atomic_store(&pool->workers[active - 1].state, THREAD_POOL_WORKER_RETIRING);
+    atomic_store(&pool->active_threads, active - 1);
+    pthread_mutex_unlock(&pool->mutex);
+    
+    // Wake it if parked; the others find nothing and park again
+    event_count_notify_all(&pool->task_queue->not_empty);
+    return 0;
+}
+
+size_t thread_pool_active_threads(thread_pool_t *pool) {
+    if (!pool) return 0;
+    return atomic_load_explicit(&pool->active_threads, memory_order_relaxed);
+}
+
+void thread_pool_set_placement(thread_pool_t *pool, const cpu_plan_t *plan) {
+    if (!pool) return;
+    pool->placement = plan;
+}
+
+void thread_pool_set_batcher(thread_pool_t *pool, task_batcher_t *batcher) {
+    if (!pool) return;
+    pool->batcher = batcher;
+}
+
+void thread_pool_set_timer_wheel(thread_pool_t *pool, timer_wheel_t *timers) {
+    if (!pool) return;
+    pool->timers = timers;
+}
+
+void thread_pool_set_memory_budget(thread_pool_t *pool, memory_budget_t *budget) {
+    if (!pool) return;
+    pool->memory_budget = budget;
+}
+
+int thread_pool_submit(thread_pool_t *pool, task_t *task) {
+    if (!pool || !task) return -1;
+    
+    // Tasks spawned from inside a running task stay on that worker
+    thread_pool_worker_t *worker = current_worker;
+    task->enqueue_ns = task_now_ns();
+    if (worker && worker->pool == pool && pool->mode == THREAD_POOL_MODE_WORK_STEALING &&
+        work_deque_push(&worker->deque, task) == 0) {
+        event_count_notify_one(&pool->task_queue->not_empty);
+        return 0;
+    }
+    
+    return task_queue_enqueue(pool->task_queue, task);
+}
+
+int thread_pool_release(thread_pool_t *pool, task_t *task, bool chain) {
+    if (!pool || !task) return -1;
+    
+    thread_pool_worker_t *worker = current_worker;
+    if (!worker || worker->pool != pool) {
+        return thread_pool_submit(pool, task);
+    }
+    if (!chain && thread_pool_submit(pool, task) == 0) {
+        return 0;
+    }
+    
+    // Next on this worker, ahead of anything deferred: a chain's input is
+    // still in this core's cache, and a fan-out that found no room is
+    // still never lost
+    task->enqueue_ns = task_now_ns();
+    task->next = worker->deferred;
+    worker->deferred = task;
+    if (chain) {
+        bump(&worker->chained, 1);
+    }
+    return 0;
+}
+
+task_t* thread_pool_current_task(void) {
+    return current_task;
+}
+
+size_t thread_pool_local_size(thread_pool_t *pool) {
+    if (!pool || pool->mode != THREAD_POOL_MODE_WORK_STEALING) return 0;
+    
+    size_t total = 0;
+    for (size_t i = 0; i < pool->num_threads; i++) {
+        total += work_deque_size(&pool->workers[i].deque);
+    }
+    return total;
+}
+
+uint64_t thread_pool_expired_count(thread_pool_t *pool) {
+    if (!pool) return 0;
+    
+    uint64_t total = 0;
+    for (size_t i = 0; i < pool->num_threads; i++) {
+        total += atomic_load_explicit(&pool->workers[i].expired, memory_order_relaxed);
+    }
+    return total;
+}
+
+int thread_pool_get_worker_stats(thread_pool_t *pool, size_t index,
+                                 thread_pool_worker_stats_t *stats) {
+    if (!pool || !stats || index >= pool->num_threads) return -1;
+    
+    thread_pool_worker_t *worker = &pool->workers[index];
+    stats->completed = atomic_load_explicit(&worker->completed, memory_order_relaxed);
+    stats->failed = atomic_load_explicit(&worker->failed, memory_order_relaxed);
+    stats->expired = atomic_load_explicit(&worker->expired, memory_order_relaxed);
+    stats->cancelled = atomic_load_explicit(&worker->cancelled, memory_order_relaxed);
+    stats->timed_out = atomic_load_explicit(&worker->timed_out, memory_order_relaxed);
+    stats->chained = atomic_load_explicit(&worker->chained, memory_order_relaxed);
+    
+    uint64_t seq, since;
+    do {
+        seq = atomic_load_explicit(&worker->busy_seq, memory_order_acquire);
+        stats->busy_ns = atomic_load_explicit(&worker->busy_ns, memory_order_relaxed);
+        since = atomic_load_explicit(&worker->busy_since_ns, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || atomic_load_explicit(&worker->busy_seq, memory_order_relaxed) != seq);
+    
+    uint64_t now = task_now_ns();
+    if (since && now > since) stats->busy_ns += now - since;
+    uint64_t elapsed = pool->start_ns ? now - pool->start_ns : 0;
+    stats->idle_ns = elapsed > stats->busy_ns ? elapsed - stats->busy_ns : 0;
+    return 0;
+}
+
+void thread_pool_get_latency(thread_pool_t *pool, latency_snapshot_t *snapshot) {
+    if (!pool || !snapshot) return;
+    uint64_t elapsed = pool->start_ns ? task_now_ns() - pool->start_ns : 0;
+    task_latency_snapshot(pool->latency, pool->num_threads, elapsed, snapshot);
+}
+
 void thread_pool_shutdown(thread_pool_t *pool) {
     if (!pool || pool->shutdown) return;
     
     pthread_mutex_lock(&pool->mutex);
     pool->shutdown = true;
-    pthread_cond_broadcast(&pool->cond);
     pthread_mutex_unlock(&pool->mutex);
     
+    // Workers drain whatever is still queued, then see the shutdown
+    task_queue_shutdown(pool->task_queue);
+    
+    // No worker starts once shutdown is set, so joinable is settled
     for (size_t i = 0; i < pool->num_threads; i++) {
+        if (!pool->workers[i].joinable) continue;
         pthread_join(pool->threads[i], NULL);
+        pool->workers[i].joinable = false;
     }
 }
 
@@ -107,8 +731,13 @@ void thread_pool_destroy(thread_pool_t *pool) {
     
     thread_pool_shutdown(pool);
     
+    for (size_t i = 0; i < pool->num_threads; i++) {
+        work_deque_destroy(&pool->workers[i].deque);
+    }
+    
     pthread_mutex_destroy(&pool->mutex);
-    pthread_cond_destroy(&pool->cond);
+    free(pool->latency);
+    free(pool->workers);
     free(pool->threads);
     free(pool);
 }
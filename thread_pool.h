@@ -2,23 +2,132 @@
 #define THREAD_POOL_H
 
 #include "task_queue.h"
+#include "work_deque.h"
+#include "task_batcher.h"
+#include "task_latency.h"
+#include "cpu_topology.h"
+#include "memory_budget.h"
 #include <pthread.h>
 #include <stdbool.h>
 
+typedef enum {
+    THREAD_POOL_MODE_SHARED_QUEUE = 0,  // all workers dequeue from task_queue
+    THREAD_POOL_MODE_WORK_STEALING = 1  // per-worker deques + shared injection queue
+} thread_pool_mode_t;
+
+// Lifecycle of a worker slot in an elastic pool
+enum {
+    THREAD_POOL_WORKER_UNUSED = 0,  // no thread yet
+    THREAD_POOL_WORKER_RUNNING,
+    THREAD_POOL_WORKER_RETIRING,    // exits once idle, unless revived first
+    THREAD_POOL_WORKER_EXITED       // returned, waits to be joined
+};
+
+typedef struct thread_pool thread_pool_t;
+
 typedef struct {
+    work_deque_t deque;
+    thread_pool_t *pool;
+    size_t index;
+    uint64_t rng_state;
+    task_t *deferred;               // dequeued while batching, runs next
+    task_latency_t *latency;        // this worker's slot in pool->latency
+    _Atomic int state;              // THREAD_POOL_WORKER_*
+    bool joinable;                  // thread created and not yet joined; under pool->mutex
+    // Written only by this worker, summed by readers
+    _Atomic uint64_t completed;
+    _Atomic uint64_t failed;
+    _Atomic uint64_t expired;       // dropped past their deadline
+    _Atomic uint64_t cancelled;     // cancelled, queued or running
+    _Atomic uint64_t timed_out;     // stopped after overrunning timeout_ns
+    _Atomic uint64_t chained;       // dependents run here right after their parent
+    _Atomic uint64_t busy_ns;       // time spent in task and batch callbacks
+    _Atomic uint64_t busy_since_ns; // start of the callback running now, 0 between
+    _Atomic uint64_t busy_seq;      // odd while busy_ns and busy_since_ns change together
+    char pad[CACHE_LINE_SIZE];      // keeps the next worker off these lines
+} thread_pool_worker_t;
+
+typedef struct {
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t expired;
+    uint64_t cancelled;
+    uint64_t timed_out;
+    uint64_t chained;
+    uint64_t busy_ns;               // includes the callback running now
+    uint64_t idle_ns;               // time since thread_pool_start() not busy
+} thread_pool_worker_stats_t;
+
+// An elastic pool runs between min_threads and num_threads workers. Slots
+// below active_threads are running; the rest are unused, retiring or
+// exited, and thread_pool_add_worker() takes the lowest one back.
+struct thread_pool {
     pthread_t *threads;
-    size_t num_threads;
+    thread_pool_worker_t *workers;
+    size_t num_threads;             // worker slots; the most that can run
+    size_t min_threads;
+    size_t initial_threads;         // started by thread_pool_start()
+    _Atomic size_t active_threads;
+    bool elastic;
+    thread_pool_mode_t mode;
     task_queue_t *task_queue;
+    task_batcher_t *batcher;        // optional, not owned
+    timer_wheel_t *timers;          // optional, not owned; times tasks with a timeout_ns
+    const cpu_plan_t *placement;    // optional, not owned; workers are pinned at start
+    memory_budget_t *memory_budget; // optional, not owned; gates tasks with a memory_bytes
+    task_latency_t *latency;        // one recorder per worker
+    uint64_t start_ns;              // thread_pool_start() time, for throughput
     bool shutdown;
     pthread_mutex_t mutex;
-    pthread_cond_t cond;
-} thread_pool_t;
+};
 
 thread_pool_t* thread_pool_create(size_t num_threads, task_queue_t *queue);
+thread_pool_t* thread_pool_create_ex(size_t num_threads, task_queue_t *queue,
+                                     thread_pool_mode_t mode);
 void thread_pool_destroy(thread_pool_t *pool);
 int thread_pool_start(thread_pool_t *pool);
+// Route batchable tasks through batcher; call before thread_pool_start()
+void thread_pool_set_batcher(thread_pool_t *pool, task_batcher_t *batcher);
+// Arm a timer on timers for every task with a timeout_ns while it runs;
+// the wheel's callback decides what expiry does. Call before
+// thread_pool_start().
+void thread_pool_set_timer_wheel(thread_pool_t *pool, timer_wheel_t *timers);
+// Pin workers as plan places them; call before thread_pool_start()
+void thread_pool_set_placement(thread_pool_t *pool, const cpu_plan_t *plan);
+// Start tasks with a memory_bytes only as budget has room for them (see
+// memory_budget.h); the rest are set aside while smaller ones run. A batch
+// runs on its first task's reservation. Call before thread_pool_start().
+void thread_pool_set_memory_budget(thread_pool_t *pool, memory_budget_t *budget);
+// Start only initial_threads workers and let thread_pool_add_worker() and
+// thread_pool_retire_worker() move between min_threads and num_threads;
+// call before thread_pool_start()
+void thread_pool_set_elastic(thread_pool_t *pool, size_t min_threads, size_t initial_threads);
+// Starts (or revives) one worker; -1 at num_threads, after shutdown or if
+// the pool is not elastic
+int thread_pool_add_worker(thread_pool_t *pool);
+// Asks the newest worker to exit after its current task (and any it
+// queued locally); never waits for it. -1 at min_threads, after shutdown
+// or if the pool is not elastic.
+int thread_pool_retire_worker(thread_pool_t *pool);
+size_t thread_pool_active_threads(thread_pool_t *pool);
 void thread_pool_shutdown(thread_pool_t *pool);
 bool thread_pool_is_shutdown(thread_pool_t *pool);
+int thread_pool_submit(thread_pool_t *pool, task_t *task);
+// Queues a dependent whose parents finished (see task_graph.h). Released
+// by a task on one of this pool's workers, a chain link runs next on that
+// worker, and any other dependent does too if there is no room to queue
+// it; neither fails. Elsewhere this is thread_pool_submit().
+int thread_pool_release(thread_pool_t *pool, task_t *task, bool chain);
+size_t thread_pool_local_size(thread_pool_t *pool);
+uint64_t thread_pool_expired_count(thread_pool_t *pool);
+// Counters of worker index; safe while workers run. -1 if index is out of range.
+int thread_pool_get_worker_stats(thread_pool_t *pool, size_t index,
+                                 thread_pool_worker_stats_t *stats);
+// Merges every worker's latency histograms; safe while workers run
+void thread_pool_get_latency(thread_pool_t *pool, latency_snapshot_t *snapshot);
+
+// Task being executed by the calling worker thread, NULL outside a task
+task_t* thread_pool_current_task(void);
 
 #endif // THREAD_POOL_H
 
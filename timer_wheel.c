@@ -0,0 +1,172 @@
+#include "timer_wheel.h"
+#include <stdlib.h>
+#include <time.h>
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void unlink_entry(timer_wheel_entry_t *entry) {
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->prev = entry->next = NULL;
+    entry->armed = false;
+}
+
+// Fires what is due in the slot of current_tick
+static void process_tick_locked(timer_wheel_t *wheel) {
+    timer_wheel_entry_t *head = &wheel->slots[wheel->current_tick & SLOT_MASK];
+    timer_wheel_entry_t *entry = head->next;
+    while (entry != head) {
+        timer_wheel_entry_t *next = entry->next;
+        if (entry->rounds == 0) {
+            unlink_entry(entry);
+            wheel->armed--;
+            atomic_fetch_add_explicit(&wheel->fired, 1, memory_order_relaxed);
+            wheel->callback(entry, wheel->ctx);
+        } else {
+            entry->rounds--;
+        }
+        entry = next;
+    }
+    wheel->current_tick++;
+}
+
+static void* wheel_thread(void *arg) {
+    timer_wheel_t *wheel = (timer_wheel_t*)arg;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    while (wheel->running) {
+        uint64_t now_tick = (now_ns() - wheel->start_ns) / wheel->tick_ns;
+        if (wheel->armed == 0) {
+            // Nothing to fire: skip ahead and sleep until something is armed
+            wheel->current_tick = now_tick + 1;
+            pthread_cond_wait(&wheel->cond, &wheel->mutex);
+            continue;
+        }
+        while (wheel->current_tick <= now_tick && wheel->armed > 0) {
+            process_tick_locked(wheel);
+        }
+        
+        // Sleep to the start of the next tick
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t due = wheel->start_ns + wheel->current_tick * wheel->tick_ns;
+        uint64_t now = now_ns();
+        uint64_t ns = (uint64_t)deadline.tv_nsec + (due > now ? due - now : 0);
+        deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+        deadline.tv_nsec = (long)(ns % 1000000000ULL);
+        pthread_cond_timedwait(&wheel->cond, &wheel->mutex, &deadline);
+    }
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return NULL;
+}
+
+timer_wheel_t* timer_wheel_create(uint32_t tick_ms, timer_wheel_callback_t callback, void *ctx) {
+    if (!callback) return NULL;
+    
+    timer_wheel_t *wheel = (timer_wheel_t*)calloc(1, sizeof(timer_wheel_t));
+    if (!wheel) return NULL;
+    
+    for (size_t i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        wheel->slots[i].prev = wheel->slots[i].next = &wheel->slots[i];
+    }
+    wheel->tick_ns = (uint64_t)(tick_ms ? tick_ms : TIMER_WHEEL_DEFAULT_TICK_MS) * 1000000ULL;
+    wheel->start_ns = now_ns();
+    wheel->callback = callback;
+    wheel->ctx = ctx;
+    wheel->running = true;
+    atomic_init(&wheel->fired, 0);
+    
+    if (pthread_mutex_init(&wheel->mutex, NULL) != 0) {
+        free(wheel);
+        return NULL;
+    }
+    if (pthread_cond_init(&wheel->cond, NULL) != 0) {
+        pthread_mutex_destroy(&wheel->mutex);
+        free(wheel);
+        return NULL;
+    }
+    if (pthread_create(&wheel->thread, NULL, wheel_thread, wheel) != 0) {
+        pthread_cond_destroy(&wheel->cond);
+        pthread_mutex_destroy(&wheel->mutex);
+        free(wheel);
+        return NULL;
+    }
+    
+    return wheel;
+}
+
+void timer_wheel_destroy(timer_wheel_t *wheel) {
+    if (!wheel) return;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    wheel->running = false;
+    pthread_cond_signal(&wheel->cond);
+    pthread_mutex_unlock(&wheel->mutex);
+    pthread_join(wheel->thread, NULL);
+    
+    pthread_cond_destroy(&wheel->cond);
+    pthread_mutex_destroy(&wheel->mutex);
+    free(wheel);
+}
+
+void timer_wheel_arm(timer_wheel_t *wheel, timer_wheel_entry_t *entry, uint64_t expires_ns) {
+    if (!wheel || !entry) return;
+    
+    // Round up so the entry never fires before expires_ns
+    uint64_t offset = expires_ns > wheel->start_ns ? expires_ns - wheel->start_ns : 0;
+    uint64_t tick = (offset + wheel->tick_ns - 1) / wheel->tick_ns;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    if (entry->armed) {
+        unlink_entry(entry);
+        wheel->armed--;
+    }
+    if (tick < wheel->current_tick) tick = wheel->current_tick;
+    entry->rounds = (tick - wheel->current_tick) / TIMER_WHEEL_SLOTS;
+    
+    timer_wheel_entry_t *head = &wheel->slots[tick & SLOT_MASK];
+    entry->prev = head->prev;
+    entry->next = head;
+    head->prev->next = entry;
+    head->prev = entry;
+    entry->armed = true;
+    if (wheel->armed++ == 0) {
+        pthread_cond_signal(&wheel->cond);
+    }
+    pthread_mutex_unlock(&wheel->mutex);
+}
+
+bool timer_wheel_disarm(timer_wheel_t *wheel, timer_wheel_entry_t *entry) {
+    if (!wheel || !entry) return false;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    bool was_armed = entry->armed;
+    if (was_armed) {
+        unlink_entry(entry);
+        wheel->armed--;
+    }
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return was_armed;
+}
+
+size_t timer_wheel_armed(timer_wheel_t *wheel) {
+    if (!wheel) return 0;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    size_t armed = wheel->armed;
+    pthread_mutex_unlock(&wheel->mutex);
+    return armed;
+}
+
+uint64_t timer_wheel_fired(timer_wheel_t *wheel) {
+    return wheel ? atomic_load_explicit(&wheel->fired, memory_order_relaxed) : 0;
+}
+
@@ -0,0 +1,59 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_SLOTS 512           // power of two
+#define TIMER_WHEEL_DEFAULT_TICK_MS 10
+
+typedef struct timer_wheel_entry timer_wheel_entry_t;
+
+// Runs on the wheel thread with the wheel locked, so it must be quick and
+// must not arm or disarm timers itself
+typedef void (*timer_wheel_callback_t)(timer_wheel_entry_t *entry, void *ctx);
+
+// Embedded in whatever it times; the owner recovers itself with offsetof
+struct timer_wheel_entry {
+    timer_wheel_entry_t *prev;
+    timer_wheel_entry_t *next;
+    uint64_t rounds;                    // full turns left before it fires
+    bool armed;
+};
+
+// Hashed timing wheel: arming and disarming are O(1) list operations on
+// the slot the expiry hashes to, and each tick walks one slot. Expiries
+// past one turn wait out whole rounds in their slot. Resolution is one
+// tick; a timer never fires early.
+typedef struct {
+    timer_wheel_entry_t slots[TIMER_WHEEL_SLOTS];  // list heads
+    uint64_t tick_ns;
+    uint64_t start_ns;
+    uint64_t current_tick;              // next tick to process; under mutex
+    size_t armed;                       // under mutex
+    timer_wheel_callback_t callback;
+    void *ctx;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                // stop wakes the thread
+    bool running;
+    _Atomic uint64_t fired;
+} timer_wheel_t;
+
+// Starts the wheel thread; callback runs for every entry that expires
+timer_wheel_t* timer_wheel_create(uint32_t tick_ms, timer_wheel_callback_t callback, void *ctx);
+// Stops the thread; entries still armed are forgotten without firing
+void timer_wheel_destroy(timer_wheel_t *wheel);
+// Fires entry at expires_ns (task_now_ns() time) or on the first tick
+// after. An armed entry is moved.
+void timer_wheel_arm(timer_wheel_t *wheel, timer_wheel_entry_t *entry, uint64_t expires_ns);
+// false if entry already fired or was never armed. Once this returns the
+// callback is not running for entry and never will.
+bool timer_wheel_disarm(timer_wheel_t *wheel, timer_wheel_entry_t *entry);
+size_t timer_wheel_armed(timer_wheel_t *wheel);
+uint64_t timer_wheel_fired(timer_wheel_t *wheel);
+
+#endif // TIMER_WHEEL_H
+
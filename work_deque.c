@@ -0,0 +1,90 @@
+#include "work_deque.h"
+#include <stdlib.h>
+
+int work_deque_init(work_deque_t *deque, size_t capacity) {
+    if (!deque || capacity == 0 || (capacity & (capacity - 1)) != 0) return -1;
+    
+    deque->buffer = (_Atomic(task_t*)*)malloc(sizeof(*deque->buffer) * capacity);
+    if (!deque->buffer) return -1;
+    
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&deque->buffer[i], NULL);
+    }
+    deque->mask = (int64_t)capacity - 1;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    
+    return 0;
+}
+
+void work_deque_destroy(work_deque_t *deque) {
+    if (!deque) return;
+    
+    free(deque->buffer);
+    deque->buffer = NULL;
+}
+
+int work_deque_push(work_deque_t *deque, task_t *task) {
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    
+    if (b - t > deque->mask) {
+        return -1; // Full
+    }
+    
+    atomic_store_explicit(&deque->buffer[b & deque->mask], task, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+    
+    return 0;
+}
+
+task_t* work_deque_take(work_deque_t *deque) {
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    
+    if (t > b) {
+        // Empty; restore bottom
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    
+    task_t *task = atomic_load_explicit(&deque->buffer[b & deque->mask], memory_order_relaxed);
+    if (t == b) {
+        // Last element: race thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            task = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+    
+    return task;
+}
+
+task_t* work_deque_steal(work_deque_t *deque) {
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    
+    if (t >= b) {
+        return NULL;
+    }
+    
+    task_t *task = atomic_load_explicit(&deque->buffer[t & deque->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL; // Lost the race to another thief or the owner
+    }
+    
+    return task;
+}
+
+size_t work_deque_size(work_deque_t *deque) {
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    return (b > t) ? (size_t)(b - t) : 0;
+}
@@ -0,0 +1,29 @@
+#ifndef WORK_DEQUE_H
+#define WORK_DEQUE_H
+
+#include "task_queue.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define WORK_DEQUE_CAPACITY 1024
+
+// Chase-Lev work-stealing deque. The owning worker pushes and takes at
+// the bottom (LIFO, cache-hot); other workers steal from the top (FIFO).
+// Capacity is fixed; callers fall back to the shared queue when full.
+typedef struct {
+    _Atomic int64_t top;
+    char pad0[CACHE_LINE_SIZE - sizeof(int64_t)];
+    _Atomic int64_t bottom;
+    char pad1[CACHE_LINE_SIZE - sizeof(int64_t)];
+    _Atomic(task_t*) *buffer;
+    int64_t mask;
+} work_deque_t;
+
+int work_deque_init(work_deque_t *deque, size_t capacity);
+void work_deque_destroy(work_deque_t *deque);
+int work_deque_push(work_deque_t *deque, task_t *task);     // owner only
+task_t* work_deque_take(work_deque_t *deque);               // owner only
+task_t* work_deque_steal(work_deque_t *deque);              // any thread
+size_t work_deque_size(work_deque_t *deque);
+
+#endif // WORK_DEQUE_H